@@ -207,7 +207,10 @@ class GSObject(object):
                   'shoot_accuracy' : float,
                   'allowed_flux_variation' : float,
                   'range_division_for_extrema' : int,
-                  'small_fraction_of_flux' : float
+                  'small_fraction_of_flux' : float,
+                  'single_precision_fft' : bool,
+                  'gaussian_mixture' : bool,
+                  'choose_draw_method' : bool
                 }
     def __init__(self, obj):
         # This guarantees that all GSObjects have an SBProfile
@@ -572,6 +575,65 @@ class GSObject(object):
         kpos = galsim.utilities.parse_pos_args(args,kwargs,'kx','ky')
         return self.SBProfile.kValue(kpos)
 
+    def xValueMany(self, x, y):
+        """Returns the values of the object at many positions in real space.
+
+        This is equivalent to calling xValue() for each position (x[i], y[i]), but it is
+        much faster when there are many positions, since the loop is done in C++.  The
+        positions do not need to be on a regular grid.
+
+        As for xValue(), this is only available if `obj.isAnalyticX() == True`.
+
+        @param x        An array of x positions.
+        @param y        An array of y positions, with the same shape as x.
+
+        @returns a numpy array with the same shape as x of the surface brightness values.
+        """
+        x = np.array(x, dtype=float)
+        y = np.array(y, dtype=float)
+        if x.shape != y.shape:
+            raise ValueError("x and y must have the same shape")
+        val = np.empty(x.size, dtype=float)
+        self.SBProfile.xValueMany(x.ravel(), y.ravel(), val)
+        return val.reshape(x.shape)
+
+    def kValueMany(self, kx, ky):
+        """Returns the values of the object at many positions in k space.
+
+        This is equivalent to calling kValue() for each position (kx[i], ky[i]), but it is
+        much faster when there are many positions, since the loop is done in C++.
+
+        @param kx       An array of kx positions.
+        @param ky       An array of ky positions, with the same shape as kx.
+
+        @returns a complex numpy array with the same shape as kx of the fourier amplitudes.
+        """
+        kx = np.array(kx, dtype=float)
+        ky = np.array(ky, dtype=float)
+        if kx.shape != ky.shape:
+            raise ValueError("kx and ky must have the same shape")
+        val = np.empty(kx.size, dtype=complex)
+        self.SBProfile.kValueMany(kx.ravel(), ky.ravel(), val)
+        return val.reshape(kx.shape)
+
+    def simplify(self):
+        """Returns an equivalent object that is faster to draw.
+
+        Profiles built up from many transformations, sums and convolutions can end up with many
+        levels of nesting, each of which adds some work for every pixel that is drawn.  This
+        method makes an equivalent profile with fewer levels: consecutive transformations are
+        combined, flux scalings are folded into the profiles they scale where possible, and
+        Gaussians that are convolved together are replaced by a single Gaussian.
+
+        The result describes the same surface brightness profile, but its stepK() and maxK()
+        values may differ from the original, so a drawn image can have a different default
+        size or use a different FFT size.  The result is a plain GSObject, so methods specific
+        to the original class (e.g. getSigma()) are not available.
+
+        @returns the simplified object.
+        """
+        return GSObject(self.SBProfile.simplify())
+
     def withFlux(self, flux):
         """Create a version of the current object with a different flux.
 
@@ -903,8 +965,8 @@ class GSObject(object):
             shape = (0,0)
         return shape
 
-    def _fix_center(self, shape, offset, use_true_center, reverse):
-        # Note: this assumes self is in terms of image coordinates.
+    def _center_offset(self, shape, offset, use_true_center):
+        # Get the total shift to apply to the profile in image coordinates.
         if use_true_center:
             # For even-sized images, the SBProfile draw function centers the result in the
             # pixel just up and right of the real center.  So shift it back to make sure it really
@@ -915,6 +977,11 @@ class GSObject(object):
             if shape[1] % 2 == 0: dx -= 0.5
             if shape[0] % 2 == 0: dy -= 0.5
             offset = galsim.PositionD(dx,dy)
+        return offset
+
+    def _fix_center(self, shape, offset, use_true_center, reverse):
+        # Note: this assumes self is in terms of image coordinates.
+        offset = self._center_offset(shape, offset, use_true_center)
 
         # For InterpolatedImage offsets, we apply the offset in the opposite direction.
         if reverse:
@@ -956,7 +1023,7 @@ class GSObject(object):
     def drawImage(self, image=None, nx=None, ny=None, bounds=None, scale=None, wcs=None, dtype=None,
                   method='auto', gain=1., wmult=1., add_to_image=False, use_true_center=True,
                   offset=None, n_photons=0., rng=None, max_extra_noise=0., poisson_flux=None,
-                  setup_only=False, dx=None):
+                  setup_only=False, dx=None, n_threads=1):
         """Draws an Image of the object.
 
         The drawImage() method is used to draw an Image of the current object using one of several
@@ -1046,12 +1113,16 @@ class GSObject(object):
                         has already been convolved by the pixel, so you would not want to do so
                         again.  Note: The multiplication by the pixel area gets the flux
                         normalization right for the above use case.  cf. `method = 'sb'`.
+                        If `gsparams.choose_draw_method` is set, a profile that can also be
+                        drawn with an FFT is drawn that way when it is predicted to be faster.
+                        See GSObject.chooseDrawMethod().
 
             'sb'        This is a lot like 'no_pixel', except that the image values will simply be
                         the sampled object profile's surface brightness, not multiplied by the
                         pixel area.  This does not correspond to any real observing scenario, but
                         it could be useful if you want to view the surface brightness profile of an
-                        object directly, without including the pixel integration.
+                        object directly, without including the pixel integration.  As for
+                        'no_pixel', an FFT may be used if `gsparams.choose_draw_method` is set.
 
         Normally, the flux of the object should be equal to the sum of all the pixel values in the
         image, less some small amount of flux that may fall off the edge of the image (assuming you
@@ -1191,6 +1262,14 @@ class GSObject(object):
                             is set up correctly.  This is used internally by GalSim, but there
                             may be cases where the user will want the same functionality.
                             [default: False]
+        @param n_threads    The number of threads to use when shooting photons and binning
+                            them into the image.  `n_threads <= 0` means to use as many threads
+                            as are available.  The photons are shot in independent batches,
+                            each with its own random number stream derived from `rng`, so the
+                            drawn image is the same for any value of `n_threads`.  (When
+                            `max_extra_noise > 0`, the photons are always shot serially.)  This
+                            is only relevant for `method='phot'`.  Multiple threads are only
+                            used if GalSim was compiled with OpenMP. [default: 1]
 
         @returns the drawn Image.
         """
@@ -1259,6 +1338,8 @@ class GSObject(object):
                 raise ValueError("max_extra_noise is only relevant for method='phot'")
             if poisson_flux is not None:
                 raise ValueError("poisson_flux is only relevant for method='phot'")
+            if n_threads != 1:
+                raise ValueError("n_threads is only relevant for method='phot'")
 
         # Check that the user isn't convolving by a Pixel already.  This is almost always an error.
         if method == 'auto' and isinstance(self, galsim.Convolution):
@@ -1278,6 +1359,46 @@ class GSObject(object):
             (nx is not None or ny is not None or bounds is not None)):
             raise ValueError("Must provide scale if providing nx,ny or bounds")
 
+        prof, image, local_wcs = self._prepare_draw(
+            image, nx, ny, bounds, scale, wcs, dtype, method, offset, use_true_center, wmult,
+            add_to_image)
+
+        if setup_only:
+            image.added_flux = 0.
+            return image
+
+        # For surface brightness normalization, scale gain by the pixel area.
+        if method == 'sb':
+            gain *= local_wcs.pixelArea()
+
+        # Making a view of the image lets us change the center without messing up the original.
+        imview = image.view()
+        imview.setCenter(0,0)
+
+        if method == 'phot':
+            try:
+                image.added_flux = prof.SBProfile.drawShoot(
+                    imview.image, n_photons, uniform_deviate, gain, max_extra_noise,
+                    poisson_flux, add_to_image, int(n_threads))
+            except RuntimeError:
+                # Give some extra explanation as a warning, then raise the original exception
+                # so the traceback shows as much detail as possible.
+                import warnings
+                warnings.warn(
+                    "Unable to draw this GSObject with method='phot'.  Perhaps it is a "+
+                    "Deconvolve or is a compound including one or more Deconvolve objects.")
+                raise
+        else:
+            image.added_flux = prof.SBProfile.draw(imview.image, gain, wmult)
+
+        return image
+
+    def _prepare_draw(self, image, nx, ny, bounds, scale, wcs, dtype, method, offset,
+                      use_true_center, wmult, add_to_image):
+        """Do the setup for drawImage that is common to all drawing methods.
+
+        @returns prof, image, local_wcs, where prof is the profile to draw in image coordinates.
+        """
         # Figure out what wcs we are going to use.
         wcs = self._determine_wcs(scale, wcs, image)
 
@@ -1308,35 +1429,137 @@ class GSObject(object):
         image = prof._setup_image(image, nx, ny, bounds, wmult, add_to_image, dtype)
         image.wcs = wcs
 
-        if setup_only:
-            image.added_flux = 0.
-            return image
+        return prof, image, local_wcs
 
-        # For surface brightness normalization, scale gain by the pixel area.
-        if method == 'sb':
-            gain *= local_wcs.pixelArea()
+    def drawImageOffsets(self, images, offsets, method='fft', use_true_center=True, gain=1.,
+                         wmult=1., add_to_image=False):
+        """Draw the object onto several images, each with a different offset, using FFTs.
 
-        # Making a view of the image lets us change the center without messing up the original.
-        imview = image.view()
-        imview.setCenter(0,0)
+        This is equivalent to calling
 
-        if method == 'phot':
-            try:
-                image.added_flux = prof.SBProfile.drawShoot(
-                    imview.image, n_photons, uniform_deviate, gain, max_extra_noise,
-                    poisson_flux, add_to_image)
-            except RuntimeError:
-                # Give some extra explanation as a warning, then raise the original exception
-                # so the traceback shows as much detail as possible.
-                import warnings
-                warnings.warn(
-                    "Unable to draw this GSObject with method='phot'.  Perhaps it is a "+
-                    "Deconvolve or is a compound including one or more Deconvolve objects.")
-                raise
-        else:
-            image.added_flux = prof.SBProfile.draw(imview.image, gain, wmult)
+            >>> for image, offset in zip(images, offsets):
+            ...     obj.drawImage(image, method=method, offset=offset, ...)
 
-        return image
+        but the k-space values of the profile are only calculated once, rather than once for each
+        image.  Each offset just multiplies them by a phase before the FFT.  This is much faster
+        when drawing the same object at many sub-pixel offsets, e.g. for dithered exposures or
+        for tests of centroid biases.
+
+        Only the FFT drawing methods are available, so `method` must be either 'fft' (the default)
+        or 'no_pixel'.  The images must already exist with dtype numpy.float32 or numpy.float64,
+        and they must all have the same local wcs at the location of the object.  Images of the
+        same size share a single calculation of the k-space values.
+
+        @param images           A list of the images to draw on.
+        @param offsets          A list of offsets, one per image, with the same meaning as the
+                                `offset` parameter of drawImage().
+        @param method           Either 'fft' or 'no_pixel'. [default: 'fft']
+        @param use_true_center  See drawImage(). [default: True]
+        @param gain             The number of photons per ADU. [default: 1]
+        @param wmult            See drawImage(). [default: 1]
+        @param add_to_image     Whether to add to the existing images rather than clear them out
+                                before drawing. [default: False]
+
+        @returns the list of images.  As with drawImage(), each has an attribute `added_flux`.
+        """
+        images = list(images)
+        offsets = [ self._parse_offset(offset) for offset in offsets ]
+        if len(offsets) != len(images):
+            raise ValueError("images and offsets must have the same length")
+        if method not in ['fft', 'no_pixel']:
+            raise ValueError("Invalid method name = %s"%method)
+        gain = float(gain)
+        if gain <= 0.:
+            raise ValueError("Invalid gain <= 0.")
+        wmult = float(wmult)
+        if wmult <= 0:
+            raise ValueError("Invalid wmult <= 0.")
+
+        # Group the images by dtype, since each one uses a different C++ function.
+        shifts = { np.float32 : [], np.float64 : [] }
+        views = { np.float32 : [], np.float64 : [] }
+        index = { np.float32 : [], np.float64 : [] }
+        prof = None
+        for i, (image, offset) in enumerate(zip(images, offsets)):
+            if not isinstance(image, galsim.Image) or image.dtype not in views:
+                raise ValueError("images must be a list of float32 or float64 Images")
+            if not image.bounds.isDefined() or image.wcs is None:
+                raise ValueError("images must have defined bounds and wcs")
+            local_wcs = self._local_wcs(image.wcs, image, offset, use_true_center)
+            if prof is None:
+                # The profile in image coordinates, which is the same for all the images.
+                first_wcs = local_wcs
+                prof = local_wcs.toImage(self)
+                if method == 'fft':
+                    prof = galsim.Convolve(prof, galsim.Pixel(scale = 1.0), real_space=False)
+            elif local_wcs != first_wcs:
+                raise ValueError("images must all have the same local wcs")
+            shift = prof._center_offset(image.array.shape, offset, use_true_center)
+            image = prof._setup_image(image, None, None, None, wmult, add_to_image, None)
+            imview = image.view()
+            imview.setCenter(0,0)
+            shifts[image.dtype].append(shift)
+            views[image.dtype].append(imview.image)
+            index[image.dtype].append(i)
+
+        draw_offsets = { np.float32 : _galsim.FourierDrawOffsetsF,
+                         np.float64 : _galsim.FourierDrawOffsetsD }
+        for dtype in views:
+            if len(views[dtype]) == 0: continue
+            fluxes = draw_offsets[dtype](prof.SBProfile, shifts[dtype], views[dtype], gain, wmult)
+            for i, flux in zip(index[dtype], fluxes):
+                images[i].added_flux = flux
+        return images
+
+    def chooseDrawMethod(self, image, method='auto', offset=None, use_true_center=True,
+                         wmult=1., n_photons=0., allow_phot=False):
+        """Predict the fastest way to draw the object onto an image.
+
+        When a profile can be drawn either directly in real space or with an FFT, drawImage()
+        normally draws it in real space.  If `gsparams.choose_draw_method` is set, it instead
+        uses whichever one is predicted to be faster.  This function returns that prediction
+        along with the predicted cost of each way of drawing, which is useful for logging or for
+        deciding whether to use photon shooting.
+
+        The cost of each method is predicted from the number of pixels in the image, the size of
+        the FFT that would be needed, the complexity of the profile (e.g. how many components it
+        has and whether it uses real-space convolution) and, for photon shooting, the number of
+        photons.  The coefficients of the model can be measured on the current machine with
+        galsim.utilities.calibrate_draw_cost().
+
+        Only methods that are accurate enough are considered.  The FFT is not used in place of
+        drawing in real space for profiles with hard edges or real-space convolutions.  Photon
+        shooting adds noise to the image, so it is only considered if `allow_phot` is True.
+
+        @param image        The image that would be drawn on.  It must have defined bounds.
+        @param method       The method that would be passed to drawImage().  This determines
+                            whether the profile is convolved by the pixel.  It cannot be 'phot'.
+                            [default: 'auto']
+        @param offset       See drawImage(). [default: None]
+        @param use_true_center  See drawImage(). [default: True]
+        @param wmult        See drawImage(). [default: 1]
+        @param n_photons    The number of photons for photon shooting.  0 means to use the same
+                            number as drawImage() with method='phot'. [default: 0]
+        @param allow_phot   Whether photon shooting may be chosen. [default: False]
+
+        @returns a dict with the chosen `method`, which is one of 'plainDraw', 'fourierDraw' or
+                 'drawShoot', the predicted time in seconds for each of those three (or None
+                 if it is not allowed), the FFT size `NFT` and the number of photons `N`.
+        """
+        if method not in ['auto', 'fft', 'real_space', 'no_pixel', 'sb']:
+            raise ValueError("Invalid method name = %s"%method)
+        if image is None or not image.bounds.isDefined():
+            raise ValueError("image must have defined bounds")
+        wmult = float(wmult)
+        if wmult <= 0:
+            raise ValueError("Invalid wmult <= 0.")
+        prof, image, local_wcs = self._prepare_draw(
+            image, None, None, None, None, None, None, method, offset, use_true_center, wmult,
+            True)
+        imview = image.view()
+        imview.setCenter(0,0)
+        return prof.SBProfile.chooseDrawMethod(imview.bounds, wmult, bool(allow_phot),
+                                               float(n_photons))
 
     def drawKImage(self, re=None, im=None, nx=None, ny=None, bounds=None, scale=None, dtype=None,
                    gain=1., wmult=1., add_to_image=False, dk=None):
@@ -1472,6 +1695,83 @@ class GSObject(object):
     def __ne__(self, other): return not self.__eq__(other)
     def __hash__(self): return hash(("galsim.GSObject", self.SBProfile))
 
+def drawImageMany(objs, images, method='fft', offsets=None, use_true_center=True, gain=1.,
+                  wmult=1., add_to_image=False):
+    """Draw many GSObjects onto postage stamps using Fourier transforms.
+
+    This is equivalent to calling
+
+        >>> for obj, image, offset in zip(objs, images, offsets):
+        ...     obj.drawImage(image, method=method, offset=offset, ...)
+
+    but it is faster when there are many small stamps to draw.  The profiles that need the same
+    size of FFT are grouped together, and their FFTs are done in batches, which saves a lot of
+    the overhead of doing each one separately.
+
+    Only the FFT drawing methods are available, so `method` must be either 'fft' (the default)
+    or 'no_pixel'.  In the latter case, the profiles are still drawn using an FFT, even if they
+    could be drawn directly in real space.  The images must already exist (with a defined
+    `scale` or `wcs`) and have dtype numpy.float32 or numpy.float64.
+
+    @param objs             A list of the GSObjects to draw.
+    @param images           A list of the images to draw them on, one per object.
+    @param method           Either 'fft' or 'no_pixel'. [default: 'fft']
+    @param offsets          An optional list of offsets, one per object, with the same meaning
+                            as the `offset` parameter of drawImage(). [default: None]
+    @param use_true_center  See drawImage(). [default: True]
+    @param gain             The number of photons per ADU. [default: 1]
+    @param wmult            See drawImage(). [default: 1]
+    @param add_to_image     Whether to add to the existing images rather than clear them out
+                            before drawing. [default: False]
+
+    @returns the list of images.  As with drawImage(), each has an attribute `added_flux`.
+    """
+    objs = list(objs)
+    images = list(images)
+    if len(objs) != len(images):
+        raise ValueError("objs and images must have the same length")
+    if offsets is None:
+        offsets = [None] * len(objs)
+    else:
+        offsets = list(offsets)
+        if len(offsets) != len(objs):
+            raise ValueError("objs and offsets must have the same length")
+    if method not in ['fft', 'no_pixel']:
+        raise ValueError("Invalid method name = %s"%method)
+    gain = float(gain)
+    if gain <= 0.:
+        raise ValueError("Invalid gain <= 0.")
+    wmult = float(wmult)
+    if wmult <= 0:
+        raise ValueError("Invalid wmult <= 0.")
+
+    # Group the stamps by dtype, since each one uses a different C++ function.
+    profs = { np.float32 : [], np.float64 : [] }
+    views = { np.float32 : [], np.float64 : [] }
+    index = { np.float32 : [], np.float64 : [] }
+    for i, (obj, image, offset) in enumerate(zip(objs, images, offsets)):
+        if not isinstance(obj, GSObject):
+            raise TypeError("objs must be a list of GSObjects")
+        if not isinstance(image, galsim.Image) or image.dtype not in profs:
+            raise ValueError("images must be a list of float32 or float64 Images")
+        prof, image, local_wcs = obj._prepare_draw(
+            image, None, None, None, None, None, None, method, offset, use_true_center, wmult,
+            add_to_image)
+        imview = image.view()
+        imview.setCenter(0,0)
+        profs[image.dtype].append(prof.SBProfile)
+        views[image.dtype].append(imview.image)
+        index[image.dtype].append(i)
+
+    draw_many = { np.float32 : _galsim.FourierDrawManyF, np.float64 : _galsim.FourierDrawManyD }
+    for dtype in profs:
+        if len(profs[dtype]) == 0: continue
+        fluxes = draw_many[dtype](profs[dtype], views[dtype], gain, wmult)
+        for i, flux in zip(index[dtype], fluxes):
+            images[i].added_flux = flux
+    return images
+
+
 # Pickling an SBProfile is a bit tricky, since it's a base class for lots of other classes.
 # Normally, we'll know what the derived class is, so we can just use the pickle stuff that is
 # appropriate for that.  But if we get a SBProfile back from say the getObj() method of
@@ -2485,6 +2785,7 @@ class Sersic(GSObject):
         >>> n = sersic_obj.getN()
         >>> r0 = sersic_obj.getScaleRadius()
         >>> hlr = sersic_obj.getHalfLightRadius()
+        >>> err = sersic_obj.getMixtureError()
     """
     _req_params = { "n" : float }
     _opt_params = { "flux" : float, "trunc" : float, "flux_untruncated" : bool }
@@ -2519,6 +2820,13 @@ class Sersic(GSObject):
         """
         return self.SBProfile.getTrunc()
 
+    def getMixtureError(self):
+        """Return the maximum error in the enclosed flux fraction at any radius of the Gaussian
+        mixture that represents this profile when `gsparams.gaussian_mixture` is set, or 0 if the
+        profile is not represented by a Gaussian mixture.
+        """
+        return self.SBProfile.getMixtureError()
+
     @property
     def n(self): return self.getN()
     @property
@@ -2593,6 +2901,7 @@ class Exponential(GSObject):
 
         >>> r0 = exp_obj.getScaleRadius()
         >>> hlr = exp_obj.getHalfLightRadius()
+        >>> err = exp_obj.getMixtureError()
     """
     _req_params = {}
     _opt_params = { "flux" : float }
@@ -2629,6 +2938,13 @@ class Exponential(GSObject):
         #  (re / r0) = ln[(re / r0) + 1] + ln(2)
         return self.SBProfile.getScaleRadius() * Exponential._hlr_factor
 
+    def getMixtureError(self):
+        """Return the maximum error in the enclosed flux fraction at any radius of the Gaussian
+        mixture that represents this profile when `gsparams.gaussian_mixture` is set, or 0 if
+        it is not set.
+        """
+        return self.SBProfile.getMixtureError()
+
     @property
     def scale_radius(self): return self.getScaleRadius()
     @property
@@ -2700,6 +3016,7 @@ class DeVaucouleurs(GSObject):
 
         >>> r0 = devauc_obj.getScaleRadius()
         >>> hlr = devauc_obj.getHalfLightRadius()
+        >>> err = devauc_obj.getMixtureError()
     """
     _req_params = {}
     _opt_params = { "flux" : float, "trunc" : float, "flux_untruncated" : bool }
@@ -2727,6 +3044,13 @@ class DeVaucouleurs(GSObject):
         """
         return self.SBProfile.getTrunc()
 
+    def getMixtureError(self):
+        """Return the maximum error in the enclosed flux fraction at any radius of the Gaussian
+        mixture that represents this profile when `gsparams.gaussian_mixture` is set, or 0 if the
+        profile is not represented by a Gaussian mixture.
+        """
+        return self.SBProfile.getMixtureError()
+
     @property
     def scale_radius(self): return self.getScaleRadius()
     @property
@@ -2991,6 +3315,33 @@ range_division_for_extrema  The number of parts into which to split a range to b
 small_fraction_of_flux      When photon shooting, intervals with less than this fraction of
                             probability are considered ok to use with the dominant-sampling
                             algorithm. [default: 1.e-4]
+single_precision_fft        Whether to do the Fourier transforms for drawing with method='fft'
+                            in single precision.  This is about twice as fast and uses less
+                            memory, but the resulting images only have float32 accuracy, i.e.
+                            relative errors of order 1.e-7 of the peak value.  This is normally
+                            fine for float32 images.  (It requires GalSim to have been built with
+                            the single-precision FFTW library; otherwise the transforms are still
+                            done in double precision.) [default: False]
+gaussian_mixture            Whether to represent untruncated Sersic and Exponential profiles by
+                            precomputed mixtures of 10 Gaussians.  A convolution of such a
+                            profile with a Gaussian or a sum of Gaussians is then itself a sum
+                            of Gaussians, which is drawn without any FFTs when the convolution
+                            has this set in its gsparams (which it takes from its first item by
+                            default).  This needs method='no_pixel' (e.g. with a PSF that
+                            already includes the pixel response), since the Pixel that the other
+                            methods convolve by is not a Gaussian.  Sersic
+                            profiles outside the range 0.55 <= n <= 6 are not approximated.  The
+                            maximum error in the enclosed flux fraction at any radius is below
+                            5.e-4 for n <= 2, 1.e-3 for n <= 3, 2.e-3 for n <= 4 and 4.e-3 for
+                            n <= 6.  Use obj.getMixtureError() to get the value for a particular
+                            profile. [default: False]
+choose_draw_method          Whether drawImage() may use an FFT rather than drawing directly in
+                            real space for a profile that can be drawn either way (e.g. with
+                            method='no_pixel'), if that is predicted to be faster.  See
+                            GSObject.chooseDrawMethod().  The FFT can add some aliasing and
+                            folding, so the images may differ slightly from the default ones, and
+                            the choice may depend on the machine if the cost model has been
+                            measured with galsim.utilities.calibrate_draw_cost(). [default: False]
 """
 
 _galsim.GSParams.__getinitargs__ = lambda self: (
@@ -3000,7 +3351,9 @@ _galsim.GSParams.__getinitargs__ = lambda self: (
         self.realspace_relerr, self.realspace_abserr,
         self.integration_relerr, self.integration_abserr,
         self.shoot_accuracy, self.allowed_flux_variation,
-        self.range_division_for_extrema, self.small_fraction_of_flux)
+        self.range_division_for_extrema, self.small_fraction_of_flux,
+        self.single_precision_fft, self.gaussian_mixture, self.choose_draw_method)
 _galsim.GSParams.__repr__ = lambda self: \
-        'galsim.GSParams(%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r)'%self.__getinitargs__()
+        'galsim.GSParams(%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r,%r)'%(
+            self.__getinitargs__())
 _galsim.GSParams.__hash__ = lambda self: hash(repr(self))
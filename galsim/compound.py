@@ -262,6 +262,11 @@ class Convolution(galsim.GSObject):
                             edges.]
     @param gsparams         An optional GSParams argument.  See the docstring for GSParams for
                             details. [default: None]
+    @param shared           An optional list of the objects being convolved whose k-space values
+                            should be saved and reused by other convolutions of the same profile,
+                            e.g. a PSF that is convolved with many galaxies.  See
+                            galsim.utilities.set_kgrid_cache_budget() for details.
+                            [default: None]
 
     Note: if `gsparams` is unspecified (or None), then the Convolution instance inherits the same
     GSParams as the first item in the list.  Also, note that parameters related to the Fourier-
@@ -295,6 +300,7 @@ class Convolution(galsim.GSObject):
         # them have hard edges, then we use real-space convolution.
         real_space = kwargs.pop("real_space", None)
         gsparams = kwargs.pop("gsparams", None)
+        shared = kwargs.pop("shared", None)
         self._gsparams = gsparams
 
         # Make sure there is nothing left in the dict.
@@ -371,14 +377,31 @@ class Convolution(galsim.GSObject):
                 else:
                     noise = noise.convolvedWith(galsim.Convolve(others))
 
+        if shared is not None:
+            # Use the matching items of args, so their SBProfiles are the same ones.  (Allow
+            # equal objects too, which is what we get from eval(repr(conv)).)
+            shared_args = []
+            for obj in shared:
+                match = [ obj2 for obj2 in args if obj2 is obj ] or [ obj2 for obj2 in args
+                                                                      if obj2 == obj ]
+                if not match:
+                    raise ValueError("shared objects must be among the objects being convolved")
+                shared_args.append(match[0])
+            shared = shared_args
+
         # Save the construction parameters (as they are at this point) as attributes so they
         # can be inspected later if necessary.
         self._real_space = real_space
         self._obj_list = args
+        self._shared = shared
 
         # Then finally initialize the SBProfile using the objects' SBProfiles.
         SBList = [ obj.SBProfile for obj in args ]
-        sbp = galsim._galsim.SBConvolve(SBList, real_space, gsparams)
+        if shared:
+            SBShared = [ obj.SBProfile for obj in shared ]
+            sbp = galsim._galsim.SBConvolve(SBList, real_space, gsparams, SBShared)
+        else:
+            sbp = galsim._galsim.SBConvolve(SBList, real_space, gsparams)
         galsim.GSObject.__init__(self, sbp)
         if noise is not None:
             self.noise = noise
@@ -398,8 +421,11 @@ class Convolution(galsim.GSObject):
         return hash(("galsim.Convolution", tuple(self._obj_list), self._real_space, self._gsparams))
 
     def __repr__(self):
-        return 'galsim.Convolution(%r, real_space=%r, gsparams=%r)'%(
+        s = 'galsim.Convolution(%r, real_space=%r, gsparams=%r'%(
                 self.obj_list, self.real_space, self._gsparams)
+        if self._shared:
+            s += ', shared=%r'%self._shared
+        return s + ')'
 
     def __str__(self):
         str_list = [ str(obj) for obj in self.obj_list ]
@@ -416,7 +442,8 @@ class Convolution(galsim.GSObject):
 
     def __setstate__(self, d):
         self.__dict__ = d
-        self.__init__(self._obj_list, real_space=self._real_space, gsparams=self._gsparams)
+        self.__init__(self._obj_list, real_space=self._real_space, gsparams=self._gsparams,
+                      shared=d.get('_shared'))
 
 
 _galsim.SBConvolve.__getinitargs__ = lambda self: (
@@ -1070,3 +1070,241 @@ def structure_function(image):
     thetas = np.arange(0., 2*np.pi, 100)  # Average over these angles.
 
     return lambda r: 2*(tab(0.0, 0.0) - np.mean(tab(r*np.cos(thetas), r*np.sin(thetas))))
+
+
+def set_table_cache_dir(dir):
+    """Set the directory to use for the on-disk cache of profile lookup tables.
+
+    Some profiles (currently Sersic, Spergel and Kolmogorov) need to do a fair amount of numerical
+    work to set up the lookup tables they use.  GalSim caches these in memory, but each new
+    process normally has to redo the calculation.  If a cache directory is set, the tables are
+    also saved in that directory, so later processes can just read them back in.  This is
+    especially helpful when running many worker processes that all draw similar profiles.
+
+    The default directory is taken from the environment variable GALSIM_TABLE_CACHE_DIR.  If that
+    is not set, the on-disk cache is not used.
+
+    The cached values are tied to the GalSim version, so there is no need to clear the directory
+    after upgrading.
+
+    @param dir      The directory to use.  It will be created if necessary.  Use None or ''
+                    to turn off the on-disk cache.
+    """
+    if dir is None:
+        dir = ''
+    galsim._galsim.SetTableCacheDir(str(dir))
+
+
+def get_table_cache_dir():
+    """Get the directory used for the on-disk cache of profile lookup tables.
+
+    See set_table_cache_dir() for details.
+
+    @returns the directory, or None if the on-disk cache is not being used.
+    """
+    dir = galsim._galsim.GetTableCacheDir()
+    return dir if dir != '' else None
+
+
+def get_table_cache_stats():
+    """Get the usage statistics of the on-disk cache of profile lookup tables.
+
+    See set_table_cache_dir() for details about the cache.  Nothing is counted while the
+    on-disk cache is turned off.
+
+    @returns a dict with the following items:
+                hits        The number of tables that were read from the cache.
+                misses      The number of tables that were looked for but not found.
+                writes      The number of tables that were written to the cache.
+    """
+    return galsim._galsim.GetTableCacheStats()
+
+
+def reset_table_cache_stats():
+    """Reset the usage statistics reported by get_table_cache_stats() to zero.
+    """
+    galsim._galsim.ResetTableCacheStats()
+
+
+def get_cache_stats():
+    """Get the usage statistics of GalSim's in-memory caches of profile information.
+
+    Several profiles (Sersic, Spergel, Kolmogorov, Airy, Exponential, truncated Moffat) cache
+    the results of their setup calculations, keyed by their shape parameters and GSParams.
+    This function reports how well these caches are working, which can help in deciding
+    whether a cache is large enough for a given simulation.
+
+    @returns a dict, keyed by the name of each cache (e.g. 'sersic'), whose values are dicts
+             with the following items:
+                hits        The number of lookups that found an existing entry.
+                misses      The number of lookups that had to build a new entry.
+                waits       The number of lookups that waited for another thread to finish
+                            building the same entry.
+                evictions   The number of entries removed to make room for new ones.
+                build_time  The total time spent building new entries, in seconds.
+                size        The number of entries currently in the cache.
+                max_size    The maximum number of entries the cache will hold.
+             For the 'kgrid' cache (see set_kgrid_cache_budget()), size and max_size are
+             in bytes.
+    """
+    return galsim._galsim.GetCacheStats()
+
+
+def reset_cache_stats():
+    """Reset the usage statistics reported by get_cache_stats() to zero.
+
+    The cached values themselves are kept.
+    """
+    galsim._galsim.ResetCacheStats()
+
+
+def fftw_measure(N):
+    """Have FFTW find the fastest way to do the FFTs of an NxN image.
+
+    GalSim keeps the FFTW plans it uses for its Fourier transforms, so each one is only made once
+    per process.  Normally these are made quickly with FFTW's "estimate" mode, unless FFTW already
+    has wisdom about a better plan.  This function has FFTW measure the speed of several
+    alternatives for both directions of an NxN transform, which can take a few seconds, and then
+    uses the fastest one for the rest of the process.
+
+    The results can be saved with export_fftw_wisdom() and read back in by later processes with
+    import_fftw_wisdom() or the environment variable GALSIM_FFTW_WISDOM.
+
+    Note that GalSim's FFTs are always square, and N is always a power of 2 or 3 times a power of 2.
+
+    @param N        The size of the transforms to measure.
+    """
+    galsim._galsim.FFTWMeasure(int(N))
+
+
+def import_fftw_wisdom(file_name):
+    """Read FFTW wisdom from a file written by export_fftw_wisdom().
+
+    Any plans GalSim has already made are replaced, so subsequent FFTs use the new wisdom.
+    If the environment variable GALSIM_FFTW_WISDOM is set, the file it names is imported
+    automatically the first time GalSim does an FFT.
+
+    @param file_name    The name of the file to read.
+    """
+    if not galsim._galsim.FFTWImportWisdom(str(file_name)):
+        raise IOError("Unable to read FFTW wisdom from %s"%file_name)
+
+
+def export_fftw_wisdom(file_name):
+    """Write the current FFTW wisdom to a file.
+
+    This includes the results of any calls to fftw_measure(), as well as any wisdom that was
+    imported from another file.
+
+    @param file_name    The name of the file to write.
+    """
+    if not galsim._galsim.FFTWExportWisdom(str(file_name)):
+        raise IOError("Unable to write FFTW wisdom to %s"%file_name)
+
+
+def set_fft_threads(n_threads):
+    """Set the number of threads GalSim uses for large FFTs.
+
+    When drawing with method='fft', most of the time for large images is spent in the Fourier
+    transforms.  For transforms of size 512 and larger, these can be split among several
+    threads, so a single large drawImage call can use all the cores of a machine.  Smaller
+    transforms always use a single thread, since the overhead is not worth it.
+
+    The same number of threads is also used to evaluate the profile on the k-space (or x-space)
+    grid before the transform, which is often just as expensive for complicated profiles.  The
+    grid is split into blocks of rows, which are filled in parallel for grids with at least 128
+    rows.
+
+    This is a process-wide setting.  The default is 1.  It requires GalSim to have been compiled
+    with OpenMP; otherwise the transforms always use a single thread.
+
+    @param n_threads    The number of threads to use.  `n_threads <= 0` means to use as many
+                        threads as are available.
+    """
+    galsim._galsim.SetFFTThreads(int(n_threads))
+
+
+def get_fft_threads():
+    """Get the number of threads GalSim uses for large FFTs.
+
+    See set_fft_threads() for details.
+    """
+    return galsim._galsim.GetFFTThreads()
+
+
+def set_kgrid_cache_budget(nbytes):
+    """Set the maximum memory used to save the k-space values of shared convolution components.
+
+    When a component of a Convolution is marked as shared (e.g.
+    `galsim.Convolve(gal, psf, shared=[psf])`), its values on each k-space grid it is drawn on
+    are saved, keyed by the profile and the grid.  Convolutions of the same profile with other
+    objects reuse those values when they need the same grid, rather than evaluating the profile
+    again.  When the saved grids use more than this much memory, the least recently used ones
+    are removed.
+
+    This is a process-wide setting.  The default is 256 MB.  Setting it to 0 turns off the
+    caching.  The usage of the cache is reported as 'kgrid' by get_cache_stats(), where its
+    size and max_size are in bytes.
+
+    @param nbytes       The maximum memory to use, in bytes.
+    """
+    galsim._galsim.SetKGridCacheBudget(int(nbytes))
+
+
+def get_kgrid_cache_budget():
+    """Get the maximum memory used to save the k-space values of shared convolution components.
+
+    See set_kgrid_cache_budget() for details.
+    """
+    return galsim._galsim.GetKGridCacheBudget()
+
+
+def clear_kgrid_cache():
+    """Remove all the saved k-space values of shared convolution components.
+
+    See set_kgrid_cache_budget() for details.
+    """
+    galsim._galsim.ClearKGridCache()
+
+
+def get_draw_cost_model():
+    """Get the coefficients of the cost model used to choose how to draw profiles.
+
+    When a profile could be drawn either directly in real space or with an FFT, and its
+    gsparams has `choose_draw_method` set, drawImage() uses whichever is predicted to be
+    faster.  See GSObject.chooseDrawMethod() for how the prediction is made.  The coefficients
+    are returned as a dict with these items, each a time in seconds:
+
+        xvalue      One real-space value of a simple profile like a Gaussian.
+        kvalue      One k-space value of a simple profile.
+        fft         One unit of N^2 log2(N) of an NxN FFT.
+        shoot       One photon shot from a simple profile.
+
+    There is also an item `calibrated`, which says whether the values were measured by
+    calibrate_draw_cost() rather than being the defaults.
+    """
+    return galsim._galsim.GetDrawCostModel()
+
+
+def set_draw_cost_model(xvalue, kvalue, fft, shoot):
+    """Set the coefficients of the cost model used to choose how to draw profiles.
+
+    See get_draw_cost_model() for the meaning of the parameters.
+    """
+    galsim._galsim.SetDrawCostModel(float(xvalue), float(kvalue), float(fft), float(shoot))
+
+
+def calibrate_draw_cost(force=False):
+    """Measure the coefficients of the cost model used to choose how to draw profiles.
+
+    The default coefficients are typical values for a current CPU.  This function times each
+    kind of drawing of a Gaussian on this machine, which takes a fraction of a second, and uses
+    the results from then on.  The measurement is only done the first time this is called,
+    unless `force` is True.
+
+    @param force        Whether to repeat the measurement if it has already been done.
+                        [default: False]
+
+    @returns the measured coefficients as a dict.  See get_draw_cost_model().
+    """
+    return galsim._galsim.CalibrateDrawCost(bool(force))
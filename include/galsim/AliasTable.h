@@ -0,0 +1,199 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#ifndef GalSim_AliasTable_H
+#define GalSim_AliasTable_H
+
+#include <vector>
+#include <cmath>
+#include <cassert>
+#include "Std.h"
+
+namespace galsim {
+
+    /**
+     * @brief Class to make random draws among objects with known probabilities in O(1) time
+     *
+     * This is a drop-in alternative to ProbabilityTree, using Walker's alias method (with
+     * Vose's construction) rather than a binary tree.  As there, the class is derived from a
+     * vector of objects of any type FluxData that has a `getFlux()` call, and the absolute value
+     * of `getFlux()` is the relative probability of selecting that member.
+     *
+     * Each of the N members gets a bin of width 1/N in [0,1).  Bin i holds member i with
+     * probability `_prob[i]` and some other member `_alias[i]` otherwise.  So `find()` is just
+     * an array lookup and a comparison, regardless of how many members there are or how
+     * unevenly the probability is spread among them.  `findMany()` does the same thing for a
+     * whole block of random numbers at once, which lets the compiler unroll and pipeline
+     * the loop.
+     *
+     * To use the class, append your members using the std::vector methods.  Then call
+     * `buildTable()`, optionally specifying a minimum level of flux for members to be
+     * selectable (default is that any non-zero member can be selected).
+     */
+    template <class FluxData>
+    class AliasTable :
+        //! @cond  This keeps doxygen from adding vector to our list of classes.
+        private std::vector<FluxData>
+        //! @endcond
+    {
+        typedef typename std::vector<FluxData>::const_iterator CVecIter;
+    public:
+        using std::vector<FluxData>::size;
+        using std::vector<FluxData>::begin;
+        using std::vector<FluxData>::end;
+        using std::vector<FluxData>::push_back;
+        using std::vector<FluxData>::insert;
+        using std::vector<FluxData>::empty;
+        using std::vector<FluxData>::clear;
+
+        /// @brief Constructor - nothing to do.
+        AliasTable() : _totalAbsFlux(0.) {}
+
+        /**
+         * @brief Choose a member based on a uniform deviate
+         *
+         * The parameter unitRandom must be a uniform deviate in [0,1) interval.
+         * On output this parameter is replaced by another uniform deviate in [0,1), which is
+         * independent of which member was selected.  This matches the behavior of
+         * ProbabilityTree::find(), so the value may be used to place the draw within the
+         * winning member.
+         *
+         * @param[in,out] unitRandom On input, a random number between 0 and 1.  On output,
+         *               holds a new uniform deviate.
+         * @returns Pointer to the selected member.
+         */
+        const FluxData* find(double& unitRandom) const
+        {
+            assert(!_prob.empty());
+            const int n = _prob.size();
+            double x = unitRandom * n;
+            // Note: Don't need floor here, since x is positive, so floor is superfluous.
+            int i = int(x);
+            if (i >= n) i = n-1;  // Just in case of rounding errors.
+            double frac = x - i;
+            const double p = _prob[i];
+            if (frac < p) {
+                unitRandom = frac / p;
+                return &(*this)[i];
+            } else {
+                unitRandom = (frac - p) / (1.-p);
+                return &(*this)[_alias[i]];
+            }
+        }
+
+        /**
+         * @brief Choose members for a block of uniform deviates.
+         *
+         * This is equivalent to calling `find()` for each of the n values in unitRandom.
+         *
+         * @param[in,out] unitRandom On input, n random numbers between 0 and 1.  On output,
+         *               n new uniform deviates.
+         * @param[out] chosen Pointers to the selected members.
+         * @param[in] n   The number of values to process.
+         */
+        void findMany(double* unitRandom, const FluxData** chosen, int n) const
+        {
+            assert(!_prob.empty());
+            const int nelem = _prob.size();
+            const double* prob = &_prob[0];
+            const int* alias = &_alias[0];
+            const FluxData* data = &(*this)[0];
+            for (int k=0; k<n; ++k) {
+                double x = unitRandom[k] * nelem;
+                int i = int(x);
+                if (i >= nelem) i = nelem-1;
+                double frac = x - i;
+                const double p = prob[i];
+                const bool keep = frac < p;
+                unitRandom[k] = keep ? frac / p : (frac - p) / (1.-p);
+                chosen[k] = data + (keep ? i : alias[i]);
+            }
+        }
+
+        /**
+         * @brief Construct the alias table from current vector elements.
+         * @param[in] threshold Elements that have flux <= this value are never selected.
+         */
+        void buildTable(double threshold=0.)
+        {
+            dbg<<"buildTable\n";
+            assert(!empty());
+            const int nelem = size();
+            dbg<<"N elements to build table with = "<<nelem<<std::endl;
+
+            // Figure out what the total absolute flux is
+            std::vector<double> scaled(nelem);
+            _totalAbsFlux = 0.;
+            for (int i=0; i<nelem; ++i) {
+                double f = std::abs((*this)[i].getFlux());
+                scaled[i] = f > threshold ? f : 0.;
+                _totalAbsFlux += scaled[i];
+            }
+            dbg<<"totalAbsFlux = "<<_totalAbsFlux<<std::endl;
+            assert(_totalAbsFlux > 0.);
+            for (int i=0; i<nelem; ++i) scaled[i] *= nelem / _totalAbsFlux;
+
+            // Vose's algorithm: repeatedly pair an under-full bin with an over-full one,
+            // topping up the former with probability from the latter.
+            _prob.resize(nelem);
+            _alias.resize(nelem);
+            std::vector<int> small, large;
+            small.reserve(nelem);
+            large.reserve(nelem);
+            for (int i=0; i<nelem; ++i) {
+                if (scaled[i] < 1.) small.push_back(i);
+                else large.push_back(i);
+            }
+            while (!small.empty() && !large.empty()) {
+                int s = small.back(); small.pop_back();
+                int l = large.back();
+                _prob[s] = scaled[s];
+                _alias[s] = l;
+                scaled[l] = (scaled[l] + scaled[s]) - 1.;
+                if (scaled[l] < 1.) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // Whatever is left is full, up to rounding errors.
+            for (size_t k=0; k<large.size(); ++k) {
+                _prob[large[k]] = 1.;
+                _alias[large[k]] = large[k];
+            }
+            for (size_t k=0; k<small.size(); ++k) {
+                xdbg<<"Leftover small bin "<<small[k]<<" has "<<scaled[small[k]]<<std::endl;
+                _prob[small[k]] = 1.;
+                _alias[small[k]] = small[k];
+            }
+            dbg<<"Done buildTable\n";
+        }
+
+        /// @brief Return the total absolute flux of the selectable members.
+        double getTotalAbsFlux() const { return _totalAbsFlux; }
+
+    private:
+
+        double _totalAbsFlux; ///< Stored total unnormalized probability
+        std::vector<double> _prob; ///< Probability of keeping member i when bin i is chosen
+        std::vector<int> _alias; ///< Member to use when member i is not kept
+    };
+
+} // end namespace galsim
+
+#endif
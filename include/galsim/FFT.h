@@ -59,7 +59,9 @@
 
 #include <stdexcept>
 #include <deque>
+#include <vector>
 #include <complex>
+#include <string>
 #define BOOST_NO_CXX11_SMART_PTR
 #include <boost/shared_ptr.hpp>
 
@@ -196,7 +198,86 @@ namespace galsim {
      */
     int goodFFTSize(int input);
 
+    /**
+     * @brief Have FFTW measure the fastest way to do the transforms of an NxN KTable or XTable.
+     *
+     * KTable and XTable keep a process-wide cache of FFTW plans, keyed by the size,
+     * direction and memory alignment of the transform, so each plan is only made once.
+     * Normally these plans are made with FFTW_ESTIMATE, unless FFTW already has wisdom about
+     * a better plan, since measuring takes much longer than a single transform.  This
+     * function does the measurement for both directions of an NxN transform and replaces
+     * the cached plans with the measured ones.  The results are also kept in FFTW's wisdom,
+     * so they can be saved with fftwExportWisdom().
+     */
+    void fftwMeasure(int N);
+
+    /**
+     * @brief Read FFTW wisdom from a file.
+     *
+     * Any existing plans are retired, so subsequent transforms use the new wisdom.
+     * If the environment variable GALSIM_FFTW_WISDOM is set, the file it names is imported
+     * automatically the first time a plan is needed.
+     *
+     * @returns whether the file was read successfully.
+     */
+    bool fftwImportWisdom(const std::string& file_name);
+
+    /**
+     * @brief Write the current FFTW wisdom to a file.
+     *
+     * @returns whether the file was written successfully.
+     */
+    bool fftwExportWisdom(const std::string& file_name);
+
+    /**
+     * @brief Destroy all the cached FFTW plans.
+     *
+     * If other threads are doing transforms, the plans are destroyed when the last of
+     * them finishes.
+     */
+    void fftwClearPlans();
+
+    /**
+     * @brief Set the number of threads to use for large KTable and XTable transforms.
+     *
+     * For N >= 512, the 2D transforms are done as a series of 1D transforms of the rows and
+     * columns, which are split among this many threads.  Smaller transforms always use a
+     * single thread.  The default is 1.  nthreads <= 0 means to use as many threads as are
+     * available.  This requires GalSim to be compiled with OpenMP; otherwise it is always 1.
+     *
+     * The same number of threads is used to fill the k- and x-space grids before the
+     * transforms (cf. SBProfileImpl::fillKGrid), which are split into blocks of rows.
+     */
+    void setFFTThreads(int nthreads);
+
+    /// @brief Get the number of threads used for large KTable and XTable transforms.
+    int getFFTThreads();
+
     class XTable;
+    class XTableF;
+
+    /**
+     * @brief The partial sums that KTable and XTable reuse between calls to interpolate()
+     * with a separable interpolant.
+     *
+     * Each table keeps one of these internally, which it doesn't use inside an OpenMP
+     * parallel region, since it can't be shared among threads.  Code that interpolates
+     * many points from several threads at once can give each thread its own cache and
+     * use the versions of interpolate() that take one.  A cache should only be used with
+     * one table, and it must be cleared if the table changes.
+     */
+    template <typename T>
+    struct InterpolationCache
+    {
+        InterpolationCache() : startY(0), x(0.), interp(0) {}
+        void clear() { sums.clear(); xwt.clear(); }
+
+        std::deque<T> sums;  // Sums over rows, for sequential rows starting at startY.
+        std::vector<double> xwt;  // Interpolant weights in x.
+        int startY;
+        double x;  // The x value (in units of the grid spacing) for these sums.
+        const InterpolantXY* interp;  // The interpolant used for these sums.
+    };
 
     /**
      * @brief KTable is a class holding the k-space representation of a real function.
@@ -252,6 +333,41 @@ namespace galsim {
          */
         void transform(XTable& xt) const;
 
+        /**
+         * @brief Fourier transform several KTables of the same size from k to x at once.
+         *
+         * This is equivalent to calling transform() for each of the KTables, but the FFTs are
+         * all done together with a single FFTW plan, which is faster for many small tables.
+         * If several threads are set with setFFTThreads(), the tables are instead split among
+         * the threads.
+         *
+         * @param[in] kt    The KTables to transform.  They must all have the same N.
+         * @param[out] xt   The results in real space.
+         */
+        static void transformMany(const std::vector<boost::shared_ptr<KTable> >& kt,
+                                  std::vector<boost::shared_ptr<XTable> >& xt);
+
+        /**
+         * @brief Fourier transform from (complex) k to x in single precision.
+         *
+         * The k values are converted to single precision, and the transform is done with the
+         * single-precision FFTW library, which is about twice as fast and uses half the
+         * memory of transform().  If GalSim was built without single-precision FFTW, the
+         * transform is done in double precision and the result converted to float.
+         */
+        boost::shared_ptr<XTableF> transformFloat() const;
+
+        /**
+         * @brief Fourier transform from (complex) k to x, calculating only some of the rows.
+         *
+         * This is the same as transform(xt), but only the rows iymin <= iy <= iymax of xt are
+         * calculated.  The other rows are left as they were.  The transform is done as 1D
+         * transforms along the columns followed by 1D transforms of just the rows that are
+         * needed, so it is faster than the full transform when only a small part of the
+         * result is needed.
+         */
+        void transform(XTable& xt, int iymin, int iymax) const;
+
         /// Have FFTW develop "wisdom" on doing this kind of transform
         void fftwMeasure() const;
 
@@ -268,6 +384,10 @@ namespace galsim {
         /// interpolate to k=(kx, ky) - WILL wrap k values to fill interpolant kernel
         std::complex<double> interpolate(double kx, double ky, const Interpolant2d& interp) const;
 
+        /// Same, but use the given cache rather than the internal one.
+        std::complex<double> interpolate(double kx, double ky, const Interpolant2d& interp,
+                                         InterpolationCache<std::complex<double> >& cache) const;
+
         /// Set the value of a grid point ix,iy (k = (ix*dk, iy*dk)) to a given value.
         void kSet(int ix, int iy, std::complex<double> value);
 
@@ -280,10 +400,7 @@ namespace galsim {
 
         /// Clear any cached values that had been set from previous passes.
         void clearCache() const 
-        {
-            _cache.clear(); 
-            _xwt.clear();
-        }
+        { _cache.clear(); }
 
         /// this += scalar*rhs
         void accumulate(const KTable& rhs, double scalar=1.); 
@@ -298,6 +415,15 @@ namespace galsim {
         /// be raised to even value.  In other words, aliases the data.
         boost::shared_ptr<KTable> wrap(int Nout) const;
 
+        /**
+         * Add the values at ix = ix1..ix2-1 of row iy of a larger table of size Nin into
+         * this one, aliasing them the same way wrap() does.  Calling this for every row
+         * of a table is equivalent to accumulating its wrap(getN()), but the larger table
+         * never has to exist all at once.
+         */
+        void accumulateWrapped(const std::complex<double>* vals, int ix1, int ix2,
+                               int Nin, int iy);
+
         /// Get the size of the table.
         int getN() const { return _N; }
         /// Get the pixel spacing of the table
@@ -363,12 +489,12 @@ namespace galsim {
 
         int wrapKValue(double k) const;  // wrap floor(k) to be within [-N/2,N/2-1]
 
-        // Objects used to accelerate interpolation with separable interpolants:
-        mutable std::deque<std::complex<double> > _cache;
-        mutable std::vector<double> _xwt;
-        mutable int _cacheStartY;
-        mutable double _cacheX;
-        mutable const InterpolantXY* _cacheInterp;
+        // Write the input array for the k->x FFT to t, which must have N*(N/2+1) elements.
+        template <typename T>
+        void fillTransformArray(std::complex<T>* t) const;
+
+        // Used to accelerate interpolation with separable interpolants:
+        mutable InterpolationCache<std::complex<double> > _cache;
 
         friend class XTable; 
     };
@@ -435,6 +561,10 @@ namespace galsim {
         /// interpolate to (x,y) - will NOT wrap the x data around +-N/2
         double interpolate(double x, double y, const Interpolant2d& interp) const;
 
+        /// Same, but use the given cache rather than the internal one.
+        double interpolate(double x, double y, const Interpolant2d& interp,
+                           InterpolationCache<double>& cache) const;
+
         /// Set the value of a grid point ix,iy ((x,y) = (ix*dk, iy*dk)) to a given value.
         void xSet(int ix, int iy, double value);
 
@@ -443,10 +573,7 @@ namespace galsim {
 
         /// Clear any cached values that had been set from previous passes.
         void clearCache() const 
-        {
-            _cache.clear(); 
-            _xwt.clear();
-        }
+        { _cache.clear(); }
 
         /// this += scalar*rhs
         void accumulate(const XTable& rhs, double scalar=1.); 
@@ -507,12 +634,41 @@ namespace galsim {
         void check_array() const {}
 #endif
 
-        // Objects used to accelerate interpolation with separable interpolants:
-        mutable std::deque<double> _cache;
-        mutable std::vector<double> _xwt;
-        mutable double _cacheX;
-        mutable int _cacheStartY;
-        mutable const InterpolantXY* _cacheInterp;
+        // Used to accelerate interpolation with separable interpolants:
+        mutable InterpolationCache<double> _cache;
+
+        friend class KTable;
+    };
+
+    /**
+     * @brief A single-precision table of real-space values, as made by KTable::transformFloat.
+     *
+     * This only has the functionality needed to read out the results of the transform.
+     * The layout is the same as for XTable.
+     */
+    class XTableF
+    {
+    public:
+        XTableF(int N, double dx);
+
+        /// Get value at grid point (x,y) = (ix*dx, iy*dx)
+        float xval(int ix, int iy) const
+        { return _array[(iy+_No2)*_N + ix+_No2]; }
+
+        /// Get the size of the table.
+        int getN() const { return _N; }
+        /// Get the pixel spacing of the table
+        double getDx() const { return _dx; }
+
+        /// Allow the ability to directly access the array.
+        float* getArray() { return _array.get(); }
+        const float* getArray() const { return _array.get(); }
+
+    private:
+        FFTW_Array<float> _array; //hold the values.
+        int _N; // Size in each dimension.
+        int _No2; // N/2
+        double _dx; // x-space increment
 
         friend class KTable;
     };
@@ -86,6 +86,15 @@ namespace galsim {
          *                            convolution).
          * @param integration_abserr  Target absolute accuracy for integrals (other than real-space
          *                            convolution).
+         * @param single_precision_fft  Whether to do the FFTs for fourierDraw in single
+         *                            precision, which is faster and uses less memory.
+         * @param gaussian_mixture    Whether to represent untruncated Sersic and Exponential
+         *                            profiles by precomputed mixtures of Gaussians.  This is
+         *                            approximate (cf. SBSersic::getMixtureError()), but it
+         *                            makes their convolutions with Gaussians analytic.
+         * @param choose_draw_method  Whether SBProfile::draw may use fourierDraw instead of
+         *                            plainDraw for a profile that can be drawn either way, if
+         *                            SBProfile::chooseDrawMethod() predicts that to be faster.
          *
          * The Photon Shooting relevant params are:
          *
@@ -117,7 +126,10 @@ namespace galsim {
                  double _shoot_accuracy,
                  double _allowed_flux_variation,
                  int _range_division_for_extrema,
-                 double _small_fraction_of_flux);
+                 double _small_fraction_of_flux,
+                 bool _single_precision_fft=false,
+                 bool _gaussian_mixture=false,
+                 bool _choose_draw_method=false);
 
         /**
          * A reasonable set of default values
@@ -141,7 +153,11 @@ namespace galsim {
             shoot_accuracy(1.e-5),
             allowed_flux_variation(0.81),
             range_division_for_extrema(32),
-            small_fraction_of_flux(1.e-4)
+            small_fraction_of_flux(1.e-4),
+
+            single_precision_fft(false),
+            gaussian_mixture(false),
+            choose_draw_method(false)
             {}
 
         bool operator==(const GSParams& rhs) const;
@@ -169,6 +185,10 @@ namespace galsim {
         int range_division_for_extrema;
         double small_fraction_of_flux;
 
+        bool single_precision_fft;
+        bool gaussian_mixture;
+        bool choose_draw_method;
+
     };
 
     std::ostream& operator<<(std::ostream& os, const GSParams& gsp);
@@ -0,0 +1,185 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#ifndef GalSim_Hankel_H
+#define GalSim_Hankel_H
+
+#include <vector>
+#include <cmath>
+#include <string>
+#include <stdexcept>
+#include "Table.h"
+
+namespace galsim {
+
+    // All code between the @cond and @endcond is excluded from Doxygen documentation
+    //! @cond
+
+    /// @brief Exception class thrown by HankelTransform
+    class HankelError : public std::runtime_error
+    {
+    public:
+        HankelError(const std::string m) : std::runtime_error("Hankel transform error: "+m) {}
+    };
+
+    //! @endcond
+
+    namespace sbp {
+        // The coarsest spacing in log(r) that HankelTransform starts from, and the largest
+        // number of points it will use before giving up on reaching the requested accuracy.
+        const double hankel_initial_dlogr = 0.05;
+        const int hankel_max_size = 1<<20;
+    }
+
+    /**
+     * @brief A fast Hankel transform of order 0, for building the lookup tables of radial
+     * profiles.
+     *
+     * HankelTransform calculates
+     *
+     *     F(k) = int_0^inf f(r) J0(kr) r dr
+     *
+     * for all k in [kmin, kmax] at once with the FFTLog algorithm (Talman, 1978, J. Comp. Phys.
+     * 29, 35; Hamilton, 2000, MNRAS 312, 257).  f is sampled on a grid uniform in log(r), which
+     * covers both [rmin, rmax] and [1/kmax, 1/kmin], and is treated as periodic in log(r).
+     * Then the transform on the matching grid in log(k) takes two FFTs, so it is O(N log N)
+     * for the whole table, rather than an adaptive integral for each k.  The result is stored
+     * in a spline table in log(k).
+     *
+     * r f(r) should be negligible (compared to the required accuracy) at rmin and above rmax.
+     * If f is truncated at rmax, i.e. it drops discontinuously to 0 there, then set
+     * `truncated`.  In that case c0 + c1 (rmax^2-r^2) is subtracted from f inside rmax, with
+     * c0 and c1 chosen to remove both the jump and the change in slope at rmax, and its
+     * transform, which is analytic, is added back in operator().  Otherwise the FFTLog result
+     * would only converge very slowly with the grid spacing.
+     *
+     * The accuracy is controlled by halving the grid spacing until the values at all the grid
+     * points in [kmin, kmax] change by less than `accuracy` (absolute).  The samples of f from
+     * the coarser grids are reused, so this costs at most twice the final number of calls to f.
+     * getError() returns the size of the last change.  If the accuracy is not reached by the
+     * time the grid has sbp::hankel_max_size points, a HankelError is thrown.  (With the
+     * default GSParams, the profiles that use this need at most a few times 10^4 points.)
+     */
+    class HankelTransform
+    {
+    public:
+        /**
+         * @brief Calculate the Hankel transform of `func` for k in [kmin, kmax].
+         *
+         * @param[in] func       A function object with double operator()(double r).
+         * @param[in] rmin       Lower limit of the range in r that is needed.
+         * @param[in] rmax       Upper limit of the range in r, where f is truncated if
+         *                       `truncated` is true.
+         * @param[in] truncated  Whether f jumps to 0 at rmax.
+         * @param[in] kmin       Minimum k for which to calculate F(k).
+         * @param[in] kmax       Maximum k for which to calculate F(k).
+         * @param[in] accuracy   Required absolute accuracy of F(k).
+         */
+        template <typename F>
+        HankelTransform(const F& func, double rmin, double rmax, bool truncated,
+                        double kmin, double kmax, double accuracy);
+
+        /**
+         * @brief The value of F(k).
+         *
+         * k should be in [kmin, kmax].  Below kmin, the smooth part is taken to be constant, and
+         * above kmax, it is taken to be 0.
+         */
+        double operator()(double k) const;
+
+        /// @brief The estimated absolute error of F(k).
+        double getError() const { return _error; }
+
+    private:
+
+        bool _truncated; ///< Whether f is truncated at rmax.
+        double _rmax;   ///< The truncation radius, if any.
+        double _c0;     ///< The jump in f at rmax that was subtracted (0 if not truncated).
+        double _c1;     ///< The coefficient of (rmax^2-r^2) that was subtracted.
+        double _error;  ///< The estimated error.
+        Table<double,double> _table;  ///< The transform of the smooth part, vs log(k).
+
+        // The pieces of the constructor that don't depend on F, in Hankel.cpp.
+        static void initGrid(double rmin, double rmax, double kmin, double kmax,
+                             double& logr_c, double& dlogr, int& N);
+        static void transform(std::vector<double>& a, double dlogr);
+        static double compare(const std::vector<double>& coarse, const std::vector<double>& fine,
+                              double logr_c, double dlogr, double kmin, double kmax);
+        void buildTable(const std::vector<double>& ft, double logr_c, double dlogr,
+                        double kmin, double kmax);
+        static void throwNotConverged(double error, double accuracy, int N);
+
+        // r times the part of f that is transformed numerically.
+        template <typename F>
+        double sample(const F& func, double r) const
+        {
+            if (!_truncated) return r * func(r);
+            else if (r >= _rmax) return 0.;
+            else return r * (func(r) - _c0 - _c1 * (_rmax*_rmax - r*r));
+        }
+    };
+
+    template <typename F>
+    HankelTransform::HankelTransform(const F& func, double rmin, double rmax, bool truncated,
+                                     double kmin, double kmax, double accuracy) :
+        _truncated(truncated), _rmax(rmax), _c0(0.), _c1(0.), _error(0.),
+        _table(Table<double,double>::spline)
+    {
+        if (_truncated) {
+            // Use a one-sided, second order estimate of f'(rmax).
+            double h = 1.e-4 * rmax;
+            double f0 = func(rmax);
+            double df = (3.*f0 - 4.*func(rmax-h) + func(rmax-2.*h)) / (2.*h);
+            _c0 = f0;
+            _c1 = -df / (2.*rmax);
+        }
+
+        // The grid is r_n = exp(logr_c + (n-N/2) dlogr) for n = 0..N-1.
+        double logr_c, dlogr;
+        int N;
+        initGrid(rmin, rmax, kmin, kmax, logr_c, dlogr, N);
+        std::vector<double> a(N);
+        for (int n=0; n<N; ++n) a[n] = sample(func, std::exp(logr_c + (n-N/2)*dlogr));
+        std::vector<double> ft(a);
+        transform(ft, dlogr);
+
+        std::vector<double> prev;
+        do {
+            // Halve the spacing.  The old points are every other point of the new grid.
+            prev.swap(ft);
+            std::vector<double> a2(2*N);
+            for (int n=0; n<N; ++n) {
+                a2[2*n] = a[n];
+                a2[2*n+1] = sample(func, std::exp(logr_c + (n-N/2+0.5)*dlogr));
+            }
+            a.swap(a2);
+            N *= 2;
+            dlogr /= 2.;
+            ft = a;
+            transform(ft, dlogr);
+            _error = compare(prev, ft, logr_c, dlogr, kmin, kmax);
+        } while (_error > accuracy && N < sbp::hankel_max_size);
+        if (_error > accuracy) throwNotConverged(_error, accuracy, N);
+
+        buildTable(ft, logr_c, dlogr, kmin, kmax);
+    }
+
+}
+
+#endif
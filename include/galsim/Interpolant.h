@@ -146,7 +146,7 @@ namespace galsim {
          * @returns Integral of positive portions of kernel
          */
         virtual double getPositiveFlux() const 
-        { checkSampler(); return _sampler->getPositiveFlux(); }
+        { readySampler(); return _sampler->getPositiveFlux(); }
 
         /**
          * @brief Return the (absolute value of) integral of the negative portions of the kernel
@@ -157,7 +157,7 @@ namespace galsim {
          * @returns Integral of abs value of negative portions of kernel
          */
         virtual double getNegativeFlux() const 
-        { checkSampler(); return _sampler->getNegativeFlux(); }
+        { readySampler(); return _sampler->getNegativeFlux(); }
 
         /**
          * @brief Return array of displacements drawn from this kernel.  
@@ -173,7 +173,7 @@ namespace galsim {
          * @returns a PhotonArray containing the vector of displacements for interpolation kernel.
          */
         virtual boost::shared_ptr<PhotonArray> shoot(int N, UniformDeviate ud) const 
-        { checkSampler(); return _sampler->shoot(N, ud); }
+        { readySampler(); return _sampler->shoot(N, ud); }
 
         virtual std::string makeStr() const =0;
 
@@ -185,6 +185,16 @@ namespace galsim {
         // Class that draws photons from this Interpolant
         mutable boost::shared_ptr<OneDimensionalDeviate> _sampler;  
 
+        // Make sure the sampler exists before using it.  Photons may be shot from several
+        // threads at once, so only one of them is allowed to build the sampler.
+        void readySampler() const
+        {
+#ifdef _OPENMP
+#pragma omp critical (galsim_interpolant_sampler)
+#endif
+            checkSampler();
+        }
+
         // Allocate photon sampler and do all of its pre-calculations
         virtual void checkSampler() const 
         {
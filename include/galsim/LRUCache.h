@@ -22,8 +22,16 @@
 
 #include <list>
 #include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/tuple/tuple_comparison.hpp>  // Need this for t1 < t2
+#include "Stopwatch.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace galsim {
 
@@ -77,6 +85,53 @@ namespace galsim {
         }
     };
 
+    /// @brief Usage statistics for an LRUCache.
+    struct LRUCacheStats
+    {
+        LRUCacheStats() : hits(0), misses(0), waits(0), evictions(0), build_time(0.) {}
+
+        long hits;          ///< Number of lookups that found an existing value.
+        long misses;        ///< Number of lookups that had to build a new value.
+        long waits;         ///< Number of lookups that waited for another thread to build it.
+        long evictions;     ///< Number of values removed to make room for new ones.
+        double build_time;  ///< Total time spent building new values, in seconds.
+    };
+
+    /**
+     * @brief Non-template base class of LRUCache, so all the caches can be listed together.
+     *
+     * Each LRUCache with a name registers itself on construction, and the list of them is
+     * available from getRegistry().  This is how the Python layer reports the statistics of
+     * all the profile caches.
+     */
+    class LRUCacheBase
+    {
+    public:
+        LRUCacheBase(const std::string& name);
+        virtual ~LRUCacheBase();
+
+        /// @brief The name of this cache, e.g. "sersic".
+        const std::string& getName() const { return _name; }
+
+        /// @brief The current usage statistics.
+        virtual LRUCacheStats getStats() const =0;
+
+        /// @brief Reset the usage statistics to zero.
+        virtual void resetStats() =0;
+
+        /// @brief The number of values currently in the cache.
+        virtual size_t size() const =0;
+
+        /// @brief The maximum number of values saved in the cache.
+        virtual size_t maxSize() const =0;
+
+        /// @brief All the named caches.
+        static const std::vector<LRUCacheBase*>& getRegistry();
+
+    private:
+        std::string _name;
+    };
+
     /** 
      * @brief Least Recently Used Cache
      *
@@ -100,62 +155,172 @@ namespace galsim {
      *
      * At most nmax items will be saved in the cache.
      *
+     * get() may be called from several threads at once.  The cache's lock is only held while
+     * looking up or updating the list of values, not while building a new Value.  If a thread
+     * asks for a Value that another thread is already building, it waits for that build to
+     * finish rather than building its own copy.
      */
     template <typename Key, typename Value>
-    class LRUCache
+    class LRUCache : public LRUCacheBase
     {
     public:
         /**
          * @brief Constructor
          *
          * @param[in] nmax  How many values to save in the cache.
+         * @param[in] name  A name for the cache, used when reporting statistics.
          */
-        LRUCache(size_t nmax) : _nmax(nmax) {}
+        LRUCache(size_t nmax, const std::string& name="") : LRUCacheBase(name), _nmax(nmax)
+        {
+#ifdef _OPENMP
+            omp_init_lock(&_lock);
+#endif
+        }
 
         /**
          * @brief Destructor
          *
          * Delete all items stored in the cache.
          */
-        ~LRUCache() {}
+        ~LRUCache()
+        {
+#ifdef _OPENMP
+            omp_destroy_lock(&_lock);
+#endif
+        }
 
         boost::shared_ptr<Value> get(const Key& key)
         {
+            lock();
             assert(_entries.size() == _cache.size());
             MapIter iter = _cache.find(key);
             if (iter != _cache.end()) {
                 // Item is cached.
                 // Move it to the front of the list.
-                if (iter != _cache.begin()) 
-                    _entries.splice(_entries.begin(), _entries, iter->second);
-                // Return the item's value
-                assert(_entries.size() == _cache.size());
-                return iter->second->second;
+                _entries.splice(_entries.begin(), _entries, iter->second);
+                boost::shared_ptr<Slot> slot = iter->second->second;
+                if (slot->value) {
+                    // Return the item's value
+                    ++_stats.hits;
+                    unlock();
+                    return slot->value;
+                }
+                // Another thread is building this value.  Wait for it to finish.
+                ++_stats.waits;
+                unlock();
+                slot->wait();
+                if (slot->value) return slot->value;
+                // The other thread's build failed.  Try again ourselves, which will
+                // most likely raise the same exception here.
+                return get(key);
             } else {
                 // Item is not cached.
-                // Make a new one.
-                boost::shared_ptr<Value> value(LRUCacheHelper<Value,Key>::NewValue(key));
+                ++_stats.misses;
                 // Remove items from the cache as necessary.
-                while (_entries.size() >= _nmax) {
+                while (_entries.size() >= _nmax && !_entries.empty()) {
                     bool erased = _cache.erase(_entries.back().first);
                     assert(erased);
                     _entries.pop_back();
+                    ++_stats.evictions;
                 }
-                // Add the new value to the front.
-                _entries.push_front(Entry(key,value));
+                // Add a placeholder for the new value to the front, so other threads
+                // asking for the same key will wait for us.
+                boost::shared_ptr<Slot> slot(new Slot());
+                _entries.push_front(Entry(key,slot));
                 // Also put it in the cache
                 _cache[key] = _entries.begin();
-                // Return the new value
                 assert(_entries.size() == _cache.size());
+                unlock();
+
+                // Make a new one.
+                boost::shared_ptr<Value> value;
+                Stopwatch timer;
+                timer.start();
+                try {
+                    value.reset(LRUCacheHelper<Value,Key>::NewValue(key));
+                } catch (...) {
+                    // Remove the placeholder, so the next request tries again.
+                    lock();
+                    iter = _cache.find(key);
+                    if (iter != _cache.end() && iter->second->second == slot) {
+                        _entries.erase(iter->second);
+                        _cache.erase(iter);
+                    }
+                    unlock();
+                    slot->done();
+                    throw;
+                }
+                timer.stop();
+                lock();
+                slot->value = value;
+                _stats.build_time += timer;
+                unlock();
+                slot->done();
+                // Return the new value
                 return value;
             }
         }
 
+        LRUCacheStats getStats() const
+        {
+            lock();
+            LRUCacheStats stats = _stats;
+            unlock();
+            return stats;
+        }
+
+        void resetStats()
+        {
+            lock();
+            _stats = LRUCacheStats();
+            unlock();
+        }
+
+        size_t size() const
+        {
+            lock();
+            size_t n = _entries.size();
+            unlock();
+            return n;
+        }
+
+        size_t maxSize() const { return _nmax; }
+
     private:
 
+        LRUCache(const LRUCache& rhs); ///< Hide the copy constructor.
+        void operator=(const LRUCache& rhs); ///< Hide assignment operator.
+
+        // A value in the cache, which is empty while it is being built.
+        // While it is being built, the building thread holds its lock.
+        struct Slot
+        {
+            boost::shared_ptr<Value> value;
+#ifdef _OPENMP
+            omp_lock_t building;
+            Slot() { omp_init_lock(&building); omp_set_lock(&building); }
+            ~Slot() { omp_destroy_lock(&building); }
+            void done() { omp_unset_lock(&building); }
+            void wait() { omp_set_lock(&building); omp_unset_lock(&building); }
+#else
+            void done() {}
+            void wait() {}
+#endif
+        };
+
+#ifdef _OPENMP
+        void lock() const { omp_set_lock(&_lock); }
+        void unlock() const { omp_unset_lock(&_lock); }
+        mutable omp_lock_t _lock;
+#else
+        void lock() const {}
+        void unlock() const {}
+#endif
+
         size_t _nmax;
+        LRUCacheStats _stats;
 
-        typedef std::pair<Key, boost::shared_ptr<Value> > Entry;
+        typedef std::pair<Key, boost::shared_ptr<Slot> > Entry;
         std::list<Entry> _entries;
 
         typedef typename std::list<Entry>::iterator ListIter;
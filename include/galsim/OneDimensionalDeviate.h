@@ -25,7 +25,7 @@
 #include <functional>
 #include "Random.h"
 #include "PhotonArray.h"
-#include "ProbabilityTree.h"
+#include "AliasTable.h"
 #include "SBProfile.h"
 #include "Std.h"
 
@@ -193,9 +193,11 @@ namespace galsim {
      * predictable.  This code does this by first dividing the domain of the function into
      * `Interval` objects, with known integrated (absolute) flux in each.  To shoot a photon, a
      * UniformDeviate is selected and scaled to represent the cumulative flux that should exist
-     * within the position of the photon.  The class first uses the binary-search feature built into
-     * the Standard Library `set` container to locate the `Interval` that will contain the photon.
-     * Then it asks the `Interval` to decide where within the `Interval` to place the photon.  As
+     * within the position of the photon.  The class first uses an `AliasTable` to locate the
+     * `Interval` that will contain the photon in constant time.  Then it asks the `Interval` to
+     * decide where within the `Interval` to place the photon.  Photons are processed in blocks:
+     * the uniform deviates for a block are drawn first, then the `Interval`s are all selected,
+     * and finally the positions within them are drawn.  As
      * noted in the `Interval` docstring, this can be done either by rejection sampling, or - if the
      * range of FluxDensity values within an interval is small - by simply adjusting the flux to
      * account for deviations from uniform flux density within the interval.
@@ -248,7 +250,7 @@ namespace galsim {
     private:
 
         const FluxDensity& _fluxDensity; // Function being sampled
-        ProbabilityTree<Interval> _pt; // Binary tree of intervals for photon shooting
+        AliasTable<Interval> _pt; // Alias table of intervals for photon shooting
         double _positiveFlux; // Stored total positive flux
         double _negativeFlux; // Stored total negative flux
         const bool _isRadial; // True for 2d axisymmetric function, false for 1d function
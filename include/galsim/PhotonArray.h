@@ -41,6 +41,11 @@ namespace galsim {
      * absolute value so that noise statistics can be estimated by counting number of positive 
      * and negative photons.
      * This class holds the code that allows its flux to be added to a surface-brightness Image.
+     *
+     * The x, y and flux values are stored as three separate arrays, which all live in a
+     * single aligned memory block.  These blocks are taken from (and returned to) a shared
+     * pool, so the many PhotonArrays of the same size that are made during a drawShoot call
+     * reuse the same memory rather than each allocating new storage.
      */
     class PhotonArray 
     {
@@ -50,7 +55,7 @@ namespace galsim {
          *
          * @param[in] N Size of desired array.
          */
-        explicit PhotonArray(int N): _x(N,0.), _y(N,0.), _flux(N,0.), _is_correlated(false) {}
+        explicit PhotonArray(int N);
 
         /** 
          * @brief Construct from three vectors.  Exception if vector sizes do not match.
@@ -61,23 +66,27 @@ namespace galsim {
          */
         PhotonArray(std::vector<double>& vx, std::vector<double>& vy, std::vector<double>& vflux);
 
+        /// Copy constructor makes a deep copy of the photons.
+        PhotonArray(const PhotonArray& rhs);
+
+        /// Assignment makes a deep copy of the photons.
+        PhotonArray& operator=(const PhotonArray& rhs);
+
+        /// Destructor returns the memory to the pool.
+        ~PhotonArray();
+
         /**
          * @brief Accessor for array size
          *
          * @returns Array size
          */
-        int size() const { return _x.size(); }
+        int size() const { return _N; }
 
         /** @brief reserve space in arrays for future elements
          *
          * @param[in] N number of elements to reserve space for.
          */
-        void reserve(int N) 
-        {
-            _x.reserve(N);
-            _y.reserve(N);
-            _flux.reserve(N);
-        }
+        void reserve(int N);
 
         /**
          * @brief Set characteristics of a photon
@@ -196,11 +205,18 @@ namespace galsim {
          * surface brightness, so photons' fluxes are divided by image pixel area.
          * Photons past the edges of the image are discarded.
          *
+         * If nthreads != 1 and GalSim was compiled with OpenMP, the binning is split across
+         * threads by stripes of image rows.  Each thread only adds the photons that land in its
+         * own rows, and it adds them in their original order, so the result is bit-for-bit
+         * identical to the serial calculation regardless of the number of threads used.
+         *
          * @param[in] target the Image to which the photons' flux will be added.
+         * @param[in] nthreads The number of threads to use.  nthreads <= 0 means to use as
+         *                     many threads as OpenMP makes available. [default: 1]
          * @returns The total flux of photons the landed inside the image bounds.
          */
         template <class T>
-        double addTo(ImageView<T>& target) const;
+        double addTo(ImageView<T>& target, int nthreads=1) const;
 
         /**
          * @brief Declare that the photons in this array are correlated.
@@ -212,11 +228,29 @@ namespace galsim {
          */
         bool isCorrelated() const { return _is_correlated; }
 
+        /**
+         * @brief Free all of the memory currently held in the pool of photon buffers.
+         *
+         * This is not normally necessary, but may be useful after a very large drawShoot call
+         * to give the memory back to the system.
+         */
+        static void clearPool();
+
     private:
-        std::vector<double> _x;      // Vector holding x coords of photons
-        std::vector<double> _y;      // Vector holding y coords of photons
-        std::vector<double> _flux;   // Vector holding flux of photons
-        bool _is_correlated;          // Are the photons correlated?
+        template <class T>
+        double addToParallel(ImageView<T>& target, int nthreads) const;
+
+        // Get a block of memory with room for (at least) N photons and point _x, _y, _flux
+        // into it.  The current contents (up to _N photons) are preserved.
+        void allocate(int N);
+
+        int _N;                 // Number of photons
+        int _capacity;          // Number of photons for which there is room in _block
+        char* _block;           // The memory block from the pool
+        double* _x;             // Array holding x coords of photons
+        double* _y;             // Array holding y coords of photons
+        double* _flux;          // Array holding flux of photons
+        bool _is_correlated;    // Are the photons correlated?
     };
 
 } // end namespace galsim
@@ -190,6 +190,18 @@ namespace galsim {
          */
         virtual void seed(long lseed);
 
+        /**
+         * @brief Re-seed the PRNG using all 64 bits of key.
+         *
+         * seed(lseed) only uses 32 bits of lseed, so different seeds can give the same
+         * sequence.  This fills the whole state of the generator from a stream of values
+         * started at key, so distinct keys always give distinct sequences.  Unlike seed(lseed),
+         * key == 0 is not special.
+         *
+         * Note that this will reseed all Deviates currently sharing the RNG with this one.
+         */
+        void seed64(unsigned long long key);
+
         /**
          * @brief Like seed(lseed), but severs the relationship between other Deviates.
          *
@@ -76,6 +76,26 @@ namespace galsim {
 
         bool isAxisymmetric() const { return _allAxisymmetric; }
         bool hasHardEdges() const { return _anyHardEdges; }
+        double xValueCost() const
+        {
+            double cost = 0.;
+            for (ConstIter pptr = _plist.begin(); pptr!=_plist.end(); ++pptr)
+                cost += GetImpl(*pptr)->xValueCost();
+            return cost;
+        }
+        double kValueCost() const
+        {
+            double cost = 0.;
+            for (ConstIter pptr = _plist.begin(); pptr!=_plist.end(); ++pptr)
+                cost += GetImpl(*pptr)->kValueCost();
+            return cost;
+        }
+        bool preferRealSpace() const
+        {
+            for (ConstIter pptr = _plist.begin(); pptr!=_plist.end(); ++pptr)
+                if (GetImpl(*pptr)->preferRealSpace()) return true;
+            return false;
+        }
         bool isAnalyticX() const { return _allAnalyticX; }
         bool isAnalyticK() const { return _allAnalyticK; }
 
@@ -134,6 +154,9 @@ namespace galsim {
         typedef std::list<SBProfile>::iterator Iter;
         typedef std::list<SBProfile>::const_iterator ConstIter;
 
+        bool simplify(SBProfile& result) const;
+        bool getGaussianSum(std::list<SBProfile>& terms) const;
+
         std::string serialize() const;
 
     private:
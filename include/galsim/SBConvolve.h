@@ -27,6 +27,15 @@
 
 namespace galsim {
 
+    namespace sbp {
+
+        // The largest number of Gaussians that simplify() will make when it distributes a
+        // convolution over sums of Gaussians.  Beyond this, an FFT is usually faster than
+        // evaluating all the terms at every pixel.
+        const int max_gaussian_mixture_terms = 200;
+
+    }
+
     // Defined in RealSpaceConvolve.cpp
     double RealSpaceConvolve(
         const SBProfile& p1, const SBProfile& p2, const Position<double>& pos, double flux,
@@ -72,13 +81,22 @@ namespace galsim {
         /**
          * @brief Constructor, list of inputs.
          *
+         * Any of the items in slist that are also in shared have their k values saved in a
+         * cache (see SetKGridCacheBudget()) each time they are drawn.  Later convolutions of
+         * the same profile (e.g. the same PSF convolved with many galaxies) reuse these values
+         * when they are drawn on the same k grid.  Shared items that are themselves an
+         * SBConvolve are kept as a single item, rather than being merged into this list.
+         *
          * @param[in] slist       Input: list of SBProfiles.
          * @param[in] real_space  Do convolution in real space?
          * @param[in] gsparams    GSParams object storing constants that control the accuracy of
          *                        image operations and rendering, if different from the default.
+         * @param[in] shared      Items of slist whose k values should be cached.
+         *                        [default: none]
          */
         SBConvolve(const std::list<SBProfile>& slist, bool real_space,
-                   const GSParamsPtr& gsparams);
+                   const GSParamsPtr& gsparams,
+                   const std::list<SBProfile>& shared=std::list<SBProfile>());
 
         /// @brief Copy constructor.
         SBConvolve(const SBConvolve& rhs);
@@ -101,6 +119,21 @@ namespace galsim {
         void operator=(const SBConvolve& rhs);
     };
 
+    /**
+     * @brief Set the maximum memory in bytes used by the cache of shared k grids.
+     *
+     * The cache holds the k values of the SBConvolve items marked as shared, keyed by the
+     * serialization of the profile and the k grid.  When it is full, the least recently used
+     * grids are removed.  Setting it to 0 turns off the caching.  The default is 256 MB.
+     */
+    void SetKGridCacheBudget(size_t nbytes);
+
+    /// @brief Get the maximum memory in bytes used by the cache of shared k grids.
+    size_t GetKGridCacheBudget();
+
+    /// @brief Remove all the saved k grids from the cache.
+    void ClearKGridCache();
+
     // A special case of a convolution of a profile with itself, which allows for some 
     // efficiency gains over SBConvolve(s,s)
     class SBAutoConvolve : public SBProfile
@@ -30,13 +30,13 @@ namespace galsim {
     public:
 
         SBConvolveImpl(const std::list<SBProfile>& slist, bool real_space,
-                       const GSParamsPtr& gsparams);
+                       const GSParamsPtr& gsparams, const std::list<SBProfile>& shared);
         ~SBConvolveImpl() {}
 
         std::list<SBProfile> getObjs() const { return _plist; }
         bool isRealSpace() const { return _real_space; }
 
-        void add(const SBProfile& rhs);
+        void add(const SBProfile& rhs, bool shared=false);
 
         // Do the real-space convolution to calculate this.
         double xValue(const Position<double>& p) const;
@@ -46,6 +46,9 @@ namespace galsim {
         bool isAxisymmetric() const { return _isStillAxisymmetric; }
         bool hasHardEdges() const { return false; }
         bool isAnalyticX() const { return _real_space; }
+        double xValueCost() const;
+        double kValueCost() const;
+        bool preferRealSpace() const { return _real_space; }
         bool isAnalyticK() const { return true; }    // convolvees must all meet this
         double maxK() const { return _minMaxK; }
         double stepK() const { return _netStepK; }
@@ -121,6 +124,8 @@ namespace galsim {
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
 
+        bool simplify(SBProfile& result) const;
+
         std::string serialize() const;
 
     private:
@@ -128,6 +133,9 @@ namespace galsim {
         typedef std::list<SBProfile>::const_iterator ConstIter;
 
         std::list<SBProfile> _plist; ///< list of profiles to convolve
+        /// A hash of serialize() of the items of _plist whose k values are cached, made once
+        /// here rather than for each fill, or 0 for the others.
+        std::vector<unsigned long long> _cache_keys;
         double _x0; ///< Centroid position in x.
         double _y0; ///< Centroid position in y.
         bool _isStillAxisymmetric; ///< Is output SBProfile shape still circular?
@@ -142,6 +150,21 @@ namespace galsim {
 
         void initialize();
 
+        // Fill val with the product of the component k values, in tiles of rows that are
+        // small enough to stay in cache.  If jzero >= 0, the components are called with
+        // izero = 0 and this jzero, and dkxy, dkyx are ignored.  Otherwise they are called
+        // with the general kx = kx0 + i dkx + j dkxy, ky = ky0 + i dkyx + j dky.
+        void fillKValueTiles(tmv::MatrixView<std::complex<double> > val,
+                             double kx0, double dkx, double dkxy,
+                             double ky0, double dky, double dkyx, int jzero) const;
+
+        // Fill val with the k values of one component, with the same arguments as a tile.
+        // This is what fills a shared component's grid when it isn't in the cache.
+        static void fillItemKValue(const SBProfile& item,
+                                   tmv::MatrixView<std::complex<double> > val,
+                                   double kx0, double dkx, double dkxy,
+                                   double ky0, double dky, double dkyx, int jzero);
+
         // Copy constructor and op= are undefined.
         SBConvolveImpl(const SBConvolveImpl& rhs);
         void operator=(const SBConvolveImpl& rhs);
@@ -166,6 +189,9 @@ namespace galsim {
         bool isAxisymmetric() const { return _adaptee.isAxisymmetric(); }
         bool hasHardEdges() const { return false; }
         bool isAnalyticX() const { return _real_space; }
+        double xValueCost() const;
+        double kValueCost() const;
+        bool preferRealSpace() const { return _real_space; }
         bool isAnalyticK() const { return true; }
         double maxK() const { return _adaptee.maxK(); }
         double stepK() const { return _adaptee.stepK() / sqrt(2.); }
@@ -222,6 +248,9 @@ namespace galsim {
         bool isAxisymmetric() const { return _adaptee.isAxisymmetric(); }
         bool hasHardEdges() const { return false; }
         bool isAnalyticX() const { return _real_space; }
+        double xValueCost() const;
+        double kValueCost() const;
+        bool preferRealSpace() const { return _real_space; }
         bool isAnalyticK() const { return true; }
         double maxK() const { return _adaptee.maxK(); }
         double stepK() const { return _adaptee.stepK() / sqrt(2.); }
@@ -40,6 +40,9 @@ namespace galsim {
      * Surface brightness profile with I(r) propto exp[-r/r_0] for some scale-length r_0.  This is a
      * special case of the Sersic profile, but is given a separate class since the Fourier transform
      * has closed form and can be generated without lookup tables.
+     *
+     * If `gsparams->gaussian_mixture` is set, the profile is instead represented by the n=1
+     * Gaussian mixture from MakeSersicGaussianMixture.
      */
     class SBExponential : public SBProfile 
     {
@@ -65,6 +68,13 @@ namespace galsim {
         /// @brief Returns the scale radius of the Exponential profile.
         double getScaleRadius() const;
 
+        /**
+         * @brief Returns the maximum error in the enclosed flux fraction at any radius of the
+         * Gaussian mixture that represents the profile, or 0 if gsparams->gaussian_mixture is
+         * not set.
+         */
+        double getMixtureError() const;
+
     protected:
 
         class SBExponentialImpl;
@@ -124,6 +124,7 @@ namespace galsim {
 
         double getFlux() const { return _flux; }
         double getScaleRadius() const { return _r0; }
+        double getMixtureError() const { return _mixture_err; }
 
         boost::shared_ptr<PhotonArray> shoot(int N, UniformDeviate ud) const;
 
@@ -140,6 +141,19 @@ namespace galsim {
         void fillKValue(tmv::MatrixView<std::complex<double> > val,
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
+
+        bool foldFluxScaling(double fluxScaling, SBProfile& result) const;
+
+        // In Gaussian mixture mode, everything is delegated to the mixture.
+        bool simplify(SBProfile& result) const
+        { if (_use_mixture) result = _mixture; return _use_mixture; }
+        double xValueCost() const
+        { return _use_mixture ? GetImpl(_mixture)->xValueCost() : 1.; }
+        double kValueCost() const
+        { return _use_mixture ? GetImpl(_mixture)->kValueCost() : 1.; }
 
         std::string serialize() const;
 
@@ -156,6 +170,10 @@ namespace galsim {
 
         const boost::shared_ptr<ExponentialInfo> _info;
 
+        bool _use_mixture;   ///< True if the profile is represented by a Gaussian mixture.
+        SBProfile _mixture;  ///< The Gaussian mixture, if _use_mixture.
+        double _mixture_err; ///< The error of the Gaussian mixture, if _use_mixture.
+
         // Copy constructor and op= are undefined.
         SBExponentialImpl(const SBExponentialImpl& rhs);
         void operator=(const SBExponentialImpl& rhs);
@@ -46,6 +46,7 @@ namespace galsim {
         // Of course, this could have hard edges, but since we can't use this
         // in a real-space convolution anyway, just return false here.
         bool hasHardEdges() const { return false; }
+        double kValueCost() const { return 1. + GetImpl(_adaptee)->kValueCost(); }
 
         bool isAnalyticX() const { return false; }
         bool isAnalyticK() const { return true; }
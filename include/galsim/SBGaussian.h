@@ -68,6 +68,23 @@ namespace galsim {
         void operator=(const SBGaussian& rhs);
     };
 
+    /**
+     * @brief Make a profile for an elliptical Gaussian.
+     *
+     * The result is an SBGaussian if the covariance matrix is isotropic and the center is
+     * (0,0), and otherwise an SBTransform of one.
+     *
+     * @param[in] flux     Total flux.
+     * @param[in] cxx      Covariance matrix element <x^2>.
+     * @param[in] cxy      Covariance matrix element <xy>.
+     * @param[in] cyy      Covariance matrix element <y^2>.
+     * @param[in] cen      Center of the profile.
+     * @param[in] gsparams GSParams object storing constants that control the accuracy of image
+     *                     operations and rendering, if different from the default.
+     */
+    SBProfile MakeEllipticalGaussian(double flux, double cxx, double cxy, double cyy,
+                                     const Position<double>& cen, const GSParamsPtr& gsparams);
+
 }
 
 #endif
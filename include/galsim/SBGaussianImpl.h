@@ -76,6 +76,14 @@ namespace galsim {
         void fillKValue(tmv::MatrixView<std::complex<double> > val,
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
+
+        bool foldFluxScaling(double fluxScaling, SBProfile& result) const;
+
+        bool getGaussian(double& flux, double& cxx, double& cxy, double& cyy,
+                         Position<double>& cen) const;
 
         std::string serialize() const;
 
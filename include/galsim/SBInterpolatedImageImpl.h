@@ -68,6 +68,9 @@ namespace galsim {
         // are found by interpolation of a table:
         bool isAnalyticX() const { return true; }
         bool isAnalyticK() const { return true; }
+        // Each value is a sum over the footprint of the interpolant.
+        double xValueCost() const { return _xInterp->ixrange() * _xInterp->ixrange(); }
+        double kValueCost() const { return _kInterp->ixrange() * _kInterp->ixrange(); }
         Position<double> centroid() const;
         double getFlux() const { return _flux; }
 
@@ -219,6 +222,7 @@ namespace galsim {
         // a table.  We do not currently implement xValue for real-space interpolation.
         bool isAnalyticX() const { return false; }
         bool isAnalyticK() const { return true; }
+        double kValueCost() const { return _kInterp->ixrange() * _kInterp->ixrange(); }
         Position<double> centroid() const;
         double getFlux() const { return _flux; }
         boost::shared_ptr<PhotonArray> shoot(int N, UniformDeviate u) const
@@ -85,6 +85,9 @@ namespace galsim {
 
         TableDD _radial;  ///< Lookup table for Fourier transform of MTF.
 
+        /// Calculate _radial and _stepk.
+        void buildRadial(const GSParamsPtr& gsparams);
+
         ///< Class that can sample radial distribution
         boost::shared_ptr<OneDimensionalDeviate> _sampler;
     };
@@ -27,6 +27,13 @@
 
 namespace galsim {
 
+    namespace sbp {
+
+        // How many truncated Moffat profiles to save in the cache
+        const int max_moffat_cache = 100;
+
+    }
+
     /**
      * @brief Surface Brightness for the Moffat Profile (an approximate description of ground-based
      * PSFs).
@@ -22,9 +22,53 @@
 
 #include "SBProfileImpl.h"
 #include "SBMoffat.h"
+#include "LRUCache.h"
 
 namespace galsim {
 
+    /**
+     * @brief A private class that caches the Fourier transform of a truncated Moffat profile.
+     *
+     * The transform of a truncated Moffat has to be done numerically.  It only depends on
+     * beta, the truncation radius in units of rD, and the GSParams, so profiles that share
+     * these values can share the same lookup table.
+     */
+    class MoffatInfo
+    {
+    public:
+        /// @brief Constructor
+        MoffatInfo(double beta, double maxRrD, const GSParamsPtr& gsparams);
+
+        /// @brief Destructor
+        ~MoffatInfo() {}
+
+        /**
+         * @brief Returns the value of the fourier transform, normalized to 1 at k=0.
+         *
+         * The input `ksq` should be (k_actual^2 * rD^2).
+         */
+        double kValue(double ksq) const;
+
+        /// @brief The last k (in units of 1/rD) with kValue > maxk_threshold.
+        double maxK() const;
+
+    private:
+
+        MoffatInfo(const MoffatInfo& rhs); ///< Hide the copy constructor.
+        void operator=(const MoffatInfo& rhs); ///<Hide assignment operator.
+
+        double _beta;        ///< Moffat beta parameter.
+        double _maxRrD;      ///< Truncation radius in units of rD.
+        const GSParamsPtr _gsparams; ///< The GSParams object.
+        double _fluxFactor;  ///< Integral of total flux in terms of 'rD' units.
+
+        Table<double,double> _ft;  ///< Lookup table for Fourier transform of Moffat.
+        double _maxk; ///< Maximum k with kValue > maxk_threshold
+
+        /// Setup the FT Table.
+        void buildFT();
+    };
+
     class SBMoffat::SBMoffatImpl : public SBProfileImpl
     {
     public:
@@ -90,6 +134,11 @@ namespace galsim {
         void fillKValue(tmv::MatrixView<std::complex<double> > val,
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
+
+        bool foldFluxScaling(double fluxScaling, SBProfile& result) const;
 
         std::string serialize() const;
 
@@ -110,17 +159,19 @@ namespace galsim {
         double _maxRrD_sq;
         double _maxR_sq;
 
-        mutable Table<double,double> _ft;  ///< Lookup table for Fourier transform of Moffat.
+        /// Info object with the Fourier transform of a truncated Moffat.
+        boost::shared_ptr<MoffatInfo> _info;
 
         mutable double _re; ///< Stores the half light radius if set or calculated post-setting.
         mutable double _stepk;
         mutable double _maxk; ///< Maximum k with kValue > 1.e-3
 
-        double (*_pow_beta)(double x, double beta);
+        typedef double (*PowFunc)(double x, double beta);
+        PowFunc _pow_beta;
         double (SBMoffatImpl::*_kV)(double ksq) const;
 
-        /// Setup the FT Table.
-        void setupFT() const;
+        // Convert an array of rsq values (in units of rD^2) in place to xValues.
+        void xValueFromRsq(double* val, int n) const;
 
         // These are the (unnormalized) kValue functions for untruncated Moffats
         double kV_15(double ksq) const;
@@ -144,6 +195,13 @@ namespace galsim {
         static double pow_4(double x, double ) { double xsq=x*x; return xsq*xsq; }
         static double pow_gen(double x, double beta) { return std::pow(x,beta); }
 
+        // Pick the fastest of the above that is accurate for the given beta.
+        static PowFunc ChoosePowBeta(double beta, const GSParams& gsparams);
+
+        static LRUCache<boost::tuple<double, double, GSParamsPtr>, MoffatInfo> cache;
+
+        friend class MoffatInfo;
+
         // Copy constructor and op= are undefined.
         SBMoffatImpl(const SBMoffatImpl& rhs);
         void operator=(const SBMoffatImpl& rhs);
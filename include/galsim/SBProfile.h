@@ -48,6 +48,15 @@
 
 namespace galsim {
 
+    class KTable;
+
+    namespace sbp {
+
+        // The maximum total number of FFT pixels to transform in one batch in fourierDrawMany
+        const int max_fourier_batch_pixels = 1<<22;
+
+    }
+
     // All code between the @cond and @endcond is excluded from Doxygen documentation
     //! @cond
 
@@ -60,6 +69,64 @@ namespace galsim {
 
     //! @endcond
 
+    /**
+     * @brief The coefficients of the cost model that SBProfile::chooseDrawMethod() uses to
+     * predict how long each way of drawing a profile will take.
+     *
+     * Each coefficient is the time in seconds for one unit of work:
+     *
+     *     xvalue   One real-space value of a simple profile like a Gaussian (cf. plainDraw).
+     *     kvalue   One k-space value of a simple profile (cf. fourierDraw).
+     *     fft      One NFT^2 log2(NFT) unit of an FFT of size NFT x NFT.
+     *     shoot    One photon shot from a simple profile and added to the image (cf. drawShoot).
+     *
+     * The default values are typical of a current CPU.  CalibrateDrawCost() measures them on
+     * the machine being used.
+     */
+    struct DrawCostModel
+    {
+        DrawCostModel() :
+            xvalue(2.e-8), kvalue(3.e-8), fft(2.e-9), shoot(1.e-7), calibrated(false) {}
+
+        double xvalue;
+        double kvalue;
+        double fft;
+        double shoot;
+        bool calibrated;  ///< Whether the values were measured by CalibrateDrawCost().
+    };
+
+    /// @brief Set the cost model used by SBProfile::chooseDrawMethod().
+    void SetDrawCostModel(const DrawCostModel& model);
+
+    /// @brief Get the cost model used by SBProfile::chooseDrawMethod().
+    DrawCostModel GetDrawCostModel();
+
+    /**
+     * @brief Measure the coefficients of the cost model on this machine, and use them from now
+     * on.
+     *
+     * This times each way of drawing a Gaussian, which takes a fraction of a second.  It is only
+     * done the first time this function is called, unless force is true.  Later calls just
+     * return the measured values.
+     */
+    DrawCostModel CalibrateDrawCost(bool force=false);
+
+    /// @brief The decision made by SBProfile::chooseDrawMethod(), with the predicted costs.
+    struct DrawMethodChoice
+    {
+        enum Method { PLAIN, FOURIER, SHOOT };
+
+        Method method;          ///< The cheapest of the allowed methods.
+        double plain_cost;      ///< Predicted seconds for plainDraw, or -1 if not allowed.
+        double fourier_cost;    ///< Predicted seconds for fourierDraw, or -1 if not allowed.
+        double shoot_cost;      ///< Predicted seconds for drawShoot, or -1 if not allowed.
+        int NFT;                ///< The size of FFT that fourierDraw would use, or 0.
+        double N;               ///< The number of photons that drawShoot would shoot, or 0.
+
+        /// @brief The name of the chosen method: "plainDraw", "fourierDraw" or "drawShoot".
+        std::string getMethodName() const;
+    };
+
     class SBTransform;
 
     /**
@@ -157,6 +224,47 @@ namespace galsim {
          */
         std::complex<double> kValue(const Position<double>& k) const;
 
+        /**
+         * @brief Return values of SBProfile at many 2D positions in real space.
+         *
+         * This is equivalent to calling xValue() for each position, but it avoids a virtual
+         * function call per point, and many profiles implement it with a simple loop that the
+         * compiler can vectorize.  The positions do not need to be on a regular grid.
+         *
+         * @param[in] x     Array of n x positions.
+         * @param[in] y     Array of n y positions.
+         * @param[out] val  Array of n values to be filled.
+         * @param[in] n     The number of positions.
+         */
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+
+        /**
+         * @brief Return values of SBProfile at many 2D positions in k space.
+         *
+         * This is equivalent to calling kValue() for each position.  cf. xValueMany().
+         *
+         * @param[in] kx    Array of n kx positions.
+         * @param[in] ky    Array of n ky positions.
+         * @param[out] val  Array of n values to be filled.
+         * @param[in] n     The number of positions.
+         */
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
+
+        /**
+         * @brief Return an equivalent profile that is faster to evaluate.
+         *
+         * The returned profile describes the same surface brightness, but with fewer levels of
+         * SBTransform, SBAdd and SBConvolve.  Nested transformations are combined, flux
+         * scalings are folded into the profiles they scale where possible, and Gaussians that
+         * are convolved together are replaced by a single (possibly sheared and shifted)
+         * Gaussian.  If nothing can be simplified, this returns a copy of the profile itself.
+         *
+         * The maxK() and stepK() values of the result can differ from the original, so drawing
+         * it may use a different FFT size.
+         */
+        SBProfile simplify() const;
+
         //@{
         /**
          *  @brief Define the range over which the profile is not trivially zero.
@@ -387,6 +495,12 @@ namespace galsim {
          *                         Poisson statistics for `N` samples
          * @param[in] add_to_image Whether to add flux to the existing image rather than draw
          *                         an image from scratch.
+         * @param[in] nthreads The number of threads to use for shooting the photons and
+         *                     binning them into the image.  nthreads <= 0 means to use as many
+         *                     threads as are available.  When max_extra_noise == 0, the
+         *                     photons are shot in independent batches, each with its own
+         *                     random number stream seeded from `ud`, so the output image is
+         *                     the same for any value of nthreads.  [default: 1]
          * @returns The total flux of photons the landed inside the image bounds.
          *
          * Note: N is input as a double so that very large values of N don't have to
@@ -396,7 +510,8 @@ namespace galsim {
         template <typename T>
         double drawShoot(
             ImageView<T> image, double N, UniformDeviate ud, double gain,
-            double max_extra_noise, bool poisson_flux, bool add_to_image) const;
+            double max_extra_noise, bool poisson_flux, bool add_to_image,
+            int nthreads=1) const;
 
 
         /**
@@ -405,7 +520,9 @@ namespace galsim {
          * The image will be drawn on the provided ImageView, although for an FFT draw method,
          * the k-image may be calculated internally on a larger grid to avoid folding.
          * The default draw() routines decide internally whether image can be drawn directly
-         * in real space or needs to be done via FFT from k space.
+         * in real space or needs to be done via FFT from k space.  If both are possible,
+         * plainDraw is used, unless gsparams->choose_draw_method is set, in which case the
+         * one that chooseDrawMethod() predicts to be faster is used.
          *
          * The image is not cleared out before drawing.  So this profile will be added to anything
          * already on the input image.
@@ -419,6 +536,32 @@ namespace galsim {
         template <typename T>
         double draw(ImageView<T> image, double gain, double wmult) const;
 
+        /**
+         * @brief Choose the fastest way to draw the SBProfile onto an image with the given bounds.
+         *
+         * The time for each method is predicted from the number of pixels in the image, the size
+         * of the FFT that fourierDraw would need, the complexity of the profile (the number of
+         * components, real-space convolution integrals, etc.) and, for photon shooting, the
+         * number of photons.  The coefficients of the cost model are those of
+         * GetDrawCostModel().
+         *
+         * Only the methods that are accurate enough are considered.  plainDraw requires
+         * isAnalyticX() and fourierDraw requires isAnalyticK().  fourierDraw is not used instead
+         * of plainDraw for profiles that have hard edges or are real-space convolutions, since
+         * those are better drawn in real space.  drawShoot adds Poisson noise to the image, so it
+         * is only considered if allow_shoot is true.
+         *
+         * @param[in] bounds       The bounds of the image to draw.
+         * @param[in] wmult        The wmult value to use for fourierDraw.
+         * @param[in] allow_shoot  Whether drawShoot may be chosen. [default: false]
+         * @param[in] N            The number of photons to shoot.  0 means to use the same number
+         *                         as drawShoot would for N = 0. [default: 0]
+         *
+         * @returns the chosen method and the predicted cost of each one.
+         */
+        DrawMethodChoice chooseDrawMethod(const Bounds<int>& bounds, double wmult,
+                                          bool allow_shoot=false, double N=0.) const;
+
         /**
          * @brief Draw an image of the SBProfile in real space forcing the use of real methods
          * where we have a formula for x values.
@@ -456,6 +599,49 @@ namespace galsim {
         template <typename T>
         double fourierDraw(ImageView<T> image, double gain, double wmult) const;
 
+        /**
+         * @brief Draw several SBProfiles in real space via Fourier transforms.
+         *
+         * This is equivalent to calling profs[i].fourierDraw(images[i], gain, wmult) for each
+         * i, but the profiles that need the same size of FFT are grouped together, and their
+         * transforms are done in batches with a single FFTW plan.  This is faster when drawing
+         * many small postage stamps.
+         *
+         * @param[in] profs      The profiles to draw.
+         * @param[in,out] images The images to draw them on (any of ImageViewF, ImageViewD).
+         * @param[in] gain       Number of photons per ADU.
+         * @param[in] wmult      If desired, a scaling to make intermediate images larger than
+         *                       normal.
+         *
+         * @returns the summed flux of each image.
+         */
+        template <typename T>
+        static std::vector<double> fourierDrawMany(
+            const std::vector<SBProfile>& profs, const std::vector<ImageView<T> >& images,
+            double gain, double wmult);
+
+        /**
+         * @brief Draw the SBProfile at several offsets in real space via Fourier transforms.
+         *
+         * This is equivalent to calling shift(offsets[i]).fourierDraw(images[i], gain, wmult)
+         * for each i, but the k values of the unshifted profile are only calculated once for
+         * each size of FFT.  Each offset then just needs its phases exp(-i k.offset) applied
+         * before the FFT, which is much faster than filling the k values again when the profile
+         * is expensive to evaluate (e.g. a convolution of a galaxy with a PSF).
+         *
+         * @param[in] offsets    The offsets at which to draw the profile.
+         * @param[in,out] images The images to draw them on (any of ImageViewF, ImageViewD).
+         * @param[in] gain       Number of photons per ADU.
+         * @param[in] wmult      If desired, a scaling to make intermediate images larger than
+         *                       normal.
+         *
+         * @returns the summed flux of each image.
+         */
+        template <typename T>
+        std::vector<double> fourierDrawOffsets(
+            const std::vector<Position<double> >& offsets,
+            const std::vector<ImageView<T> >& images, double gain, double wmult) const;
+
         /**
          * @brief Draw an image of the SBProfile in k space.
          *
@@ -540,6 +726,10 @@ namespace galsim {
         // Protected static class to access pimpl of one SBProfile object from another one.
         static SBProfileImpl* GetImpl(const SBProfile& rhs);
 
+        // Helpers for fourierDraw, fourierDrawMany and fourierDrawOffsets.
+        void getFourierDrawSize(const Bounds<int>& b, double wmult, int& NFT, int& Nk) const;
+        boost::shared_ptr<KTable> makeFourierDrawKTable(int NFT, int Nk) const;
+
         boost::shared_ptr<SBProfileImpl> _pimpl;
     };
 
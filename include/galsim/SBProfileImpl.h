@@ -25,6 +25,10 @@
 #include "integ/Int.h"
 #include "TMV.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace galsim {
 
     class SBProfile::SBProfileImpl
@@ -35,7 +39,7 @@ namespace galsim {
         SBProfileImpl(const GSParamsPtr& _gsparams);
 
         // Virtual destructor
-        virtual ~SBProfileImpl() {}
+        virtual ~SBProfileImpl();
 
         // Pure virtual functions:
         virtual double xValue(const Position<double>& p) const =0;
@@ -72,6 +76,12 @@ namespace galsim {
                                 double kx0, double dkx, double dkxy,
                                 double ky0, double dky, double dkyx) const;
 
+        // Calculate xValues and kValues at n arbitrary positions (x[i],y[i]).
+        // Again, if these aren't overridden, xValue or kValue will be called for each position.
+        virtual void xValueMany(const double* x, const double* y, double* val, int n) const;
+        virtual void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                                int n) const;
+
         virtual double maxK() const =0;
         virtual double stepK() const =0;
         virtual bool isAxisymmetric() const =0;
@@ -97,6 +107,36 @@ namespace galsim {
 
         virtual double getNegativeFlux() const { return getFlux()>0. ? 0. : -getFlux(); }
 
+        // Support for SBProfile::simplify().  If there is a simpler equivalent profile, set
+        // result to that and return true.  Otherwise return false.
+        virtual bool simplify(SBProfile& /*result*/) const { return false; }
+
+        // If the profile can be remade with its flux multiplied by fluxScaling, set result to
+        // that and return true.  simplify() uses this to fold flux scalings into the leaves.
+        virtual bool foldFluxScaling(double /*fluxScaling*/, SBProfile& /*result*/) const
+        { return false; }
+
+        // If the profile is an elliptical Gaussian, set its flux, covariance matrix and center
+        // and return true.  simplify() uses this to combine Gaussians in convolutions.
+        virtual bool getGaussian(double& /*flux*/, double& /*cxx*/, double& /*cxy*/,
+                                 double& /*cyy*/, Position<double>& /*cen*/) const
+        { return false; }
+
+        // If the profile is a sum of elliptical Gaussians, append the summands to terms and
+        // return true.  simplify() uses this to distribute convolutions over Gaussian mixtures.
+        virtual bool getGaussianSum(std::list<SBProfile>& /*terms*/) const { return false; }
+
+        // Support for SBProfile::chooseDrawMethod().  The cost of one xValue or kValue relative
+        // to that of a simple analytic profile like a Gaussian.  Compound profiles add up the
+        // costs of their components.
+        virtual double xValueCost() const { return 1.; }
+        virtual double kValueCost() const { return 1.; }
+
+        // Whether to draw the profile in real space if possible, even if an FFT would be faster.
+        // This is true for profiles with hard edges, and for real-space convolutions, which are
+        // usually requested because an FFT would not be accurate.
+        virtual bool preferRealSpace() const { return hasHardEdges(); }
+
         // Utility for drawing into Image data structures.
         // returns flux integral
         template <typename T>
@@ -105,6 +145,17 @@ namespace galsim {
         // Utility for drawing a k grid into FFT data structures
         void fillKGrid(KTable& kt) const;
 
+        // The same, but alias the k values of a table of size Nk > kt.getN() down to kt.
+        // This gives the same result as fillKGrid on a KTable of size Nk followed by
+        // wrap(kt.getN()), but only a block of the larger table is in memory at a time.
+        void fillKGrid(KTable& kt, int Nk) const;
+
+        // Fill each of the tables kt[k] with the k values of this profile shifted by
+        // offsets[k].  The unshifted values are only calculated once, and each table gets them
+        // times the phases exp(-i k.offsets[k]).  Nk has the same meaning as for fillKGrid.
+        void fillKGrids(const std::vector<boost::shared_ptr<KTable> >& kt,
+                        const std::vector<Position<double> >& offsets, int Nk) const;
+
         // Utility for drawing an x grid into FFT data structures
         void fillXGrid(XTable& xt) const;
 
@@ -129,7 +180,29 @@ namespace galsim {
                                 double kx0, double dkx, int nkx1,
                                 double ky0, double dky, int nky1) const;
 
+        // Helper functions for axisymmetric profiles whose kValue is expensive (e.g. a
+        // spline lookup or a special function).  kValue is tabulated on a 1D grid in |k|
+        // whose spacing is set by kvalue_accuracy, and the values on the 2D grid are
+        // interpolated from that with local cubics.  The table is kept with the profile and
+        // only extended when a grid needs larger |k|, so it is made once rather than for
+        // every fill.  The arguments are as for the two fillKValue functions, the first with
+        // izero = jzero = 0.  They return false without doing anything if the grid is too
+        // small for this to be worth doing.
+        bool fillKValueRadial(tmv::MatrixView<std::complex<double> > val,
+                              double kx0, double dkx, double ky0, double dky) const;
+        bool fillKValueRadial(tmv::MatrixView<std::complex<double> > val,
+                              double kx0, double dkx, double dkxy,
+                              double ky0, double dky, double dkyx) const;
+
     private:
+        // The table used by fillKValueRadial, and a lock for building or extending it.
+        class RadialKTable;
+        boost::shared_ptr<const RadialKTable> getRadialKTable(double kmax) const;
+        mutable boost::shared_ptr<const RadialKTable> _radial_ktab;
+#ifdef _OPENMP
+        mutable omp_lock_t _radial_ktab_lock;
+#endif
+
         // Copy constructor and op= are undefined.
         SBProfileImpl(const SBProfileImpl& rhs);
         void operator=(const SBProfileImpl& rhs);
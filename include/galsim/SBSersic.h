@@ -38,6 +38,15 @@ namespace galsim {
         // How many Sersic profiles to save in the cache
         const int max_sersic_cache = 100;
 
+        // Range of Sersic index n covered by the Gaussian mixture approximation.
+        const double minimum_mixture_n = 0.55;
+        const double maximum_mixture_n = 6.0;
+
+        // Approximate spacing in log(n) of the table that untruncated Sersic profiles are
+        // interpolated from, and how many of these tables (one per GSParams) to save.
+        const double sersic_table_dlogn = 0.05;
+        const int max_sersic_table_cache = 5;
+
     }
 
     /**
@@ -78,6 +87,17 @@ namespace galsim {
      * (SBDeVaucouleurs), n=1 (SBExponential), n=0.5 (SBGaussian).  These special cases use several
      * simplifications in all calculations, whereas for general n, the Fourier transform must be
      * treated numerically.
+     *
+     * The numerical Fourier transform of an untruncated profile is not computed for every n.
+     * Instead it is interpolated in n from a table of profiles spaced by about 5% in n, which is
+     * built as needed (and saved in the on-disk table cache, if any).  So are the half-light
+     * radius, the radii that set stepK and the photon-shooting radii.  Truncated profiles are
+     * still computed for their exact n and trunc.
+     *
+     * If `gsparams->gaussian_mixture` is set, an untruncated Sersic profile with
+     * 0.55 <= n <= 6 is instead represented by a sum of Gaussians (cf. MakeSersicGaussianMixture).
+     * Its convolutions with Gaussians are then analytic.  getMixtureError() reports the accuracy
+     * of the approximation.
      */
     class SBSersic : public SBProfile
     {
@@ -126,6 +146,13 @@ namespace galsim {
         /// @brief Returns the truncation radius
         double getTrunc() const;
 
+        /**
+         * @brief Returns the maximum error in the enclosed flux fraction at any radius of the
+         * Gaussian mixture that represents the profile, or 0 if the profile is not represented
+         * by a Gaussian mixture.
+         */
+        double getMixtureError() const;
+
     protected:
 
         class SBSersicImpl;
@@ -164,6 +191,25 @@ namespace galsim {
             SBSersic(4., size, rType, flux, trunc, flux_untruncated, gsparams) {}
     };
 
+    /**
+     * @brief Make a sum of Gaussians that approximates an untruncated Sersic profile.
+     *
+     * The amplitudes and variances of 10 Gaussians are tabulated as a function of n, and
+     * linearly interpolated between the tabulated values.  The mixture has exactly the given
+     * flux.  The maximum error in its enclosed flux fraction at any radius is below 5.e-4 for
+     * n <= 2, 1.e-3 for n <= 3, 2.e-3 for n <= 4 and 4.e-3 for n <= 6.
+     *
+     * @param[in] n        Sersic index.  Must be in the range 0.55 <= n <= 6.
+     * @param[in] re       Half-light radius of the Sersic profile.
+     * @param[in] flux     Flux.
+     * @param[in] gsparams GSParams object storing constants that control the accuracy of image
+     *                     operations and rendering, if different from the default.
+     * @param[out] error   The maximum error in the enclosed flux fraction at any radius.
+     * @returns the sum of Gaussians as an SBAdd.
+     */
+    SBProfile MakeSersicGaussianMixture(double n, double re, double flux,
+                                        const GSParamsPtr& gsparams, double& error);
+
 }
 
 #endif
@@ -24,17 +24,28 @@
 #include "SBSersic.h"
 #include "LRUCache.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace galsim {
 
+    class SersicTable;
+
     /// @brief A private class that caches the needed parameters for each Sersic index `n`.
     class SersicInfo
     {
     public:
-        /// @brief Constructor
-        SersicInfo(double n, double trunc, const GSParamsPtr& gsparams);
+        /**
+         * @brief Constructor
+         *
+         * Untruncated profiles take their Fourier transform, flux radii and photons from the
+         * shared SersicTable for these gsparams, unless `use_table` is false.
+         */
+        SersicInfo(double n, double trunc, const GSParamsPtr& gsparams, bool use_table=true);
 
         /// @brief Destructor: deletes photon-shooting classes if necessary
-        ~SersicInfo() {}
+        ~SersicInfo();
 
         /**
          * @brief Returns the unnormalized real space value of the Sersic function.
@@ -44,6 +55,13 @@ namespace galsim {
          */
         double xValue(double rsq) const;
 
+        /**
+         * @brief Calculate xValue for an array of rsq values at once.
+         *
+         * On input, val[i] holds rsq for each point.  On output, it holds xValue(rsq).
+         */
+        void xValueMany(double* val, int n) const;
+
         /**
          * @brief Returns the unnormalized value of the fourier transform.
          *
@@ -108,6 +126,10 @@ namespace galsim {
         mutable double _flux;    ///< Flux relative to the untruncated profile.
 
         // Parameters for the Hankel transform:
+        mutable bool _ft_ready;  ///< Whether buildFT has been done.
+#ifdef _OPENMP
+        mutable omp_lock_t _ft_lock;  ///< Only one thread may do buildFT.
+#endif
         mutable Table<double,double> _ft;  ///< Lookup table for Fourier transform.
         mutable double _kderiv2; ///< Quadratic dependence of F near k=0.
         mutable double _kderiv4; ///< Quartic dependence of F near k=0.
@@ -120,10 +142,70 @@ namespace galsim {
         mutable boost::shared_ptr<FluxDensity> _radial;
         mutable boost::shared_ptr<OneDimensionalDeviate> _sampler;
 
+        /// The table to interpolate from, if any.
+        boost::shared_ptr<SersicTable> _table;
+
         // Helper functions used internally:
+        void checkFT() const;
         void buildFT() const;
         void calculateHLR() const;
         double calculateMissingFluxRadius(double missing_flux_frac) const;
+        double refineMissingFluxZ(double z, double missing_flux_frac) const;
+    };
+
+    /**
+     * @brief A private class with untruncated Sersic profiles on a grid of n, from which
+     * SersicInfo interpolates the profiles at other n.
+     *
+     * The nodes are uniformly spaced in log(n) over the full allowed range of n, and values are
+     * interpolated with a cubic Lagrange polynomial through the four nearest nodes.  Quantities
+     * are interpolated at fixed k*re and fixed enclosed flux, where they vary smoothly with n.
+     * With nodes spaced by 0.05 in log(n), the interpolation itself changes the Fourier
+     * transform by less than 2.e-7 (compared with direct integrals).  The node profiles are
+     * built with half the kvalue_accuracy of the gsparams, so that their errors, together with
+     * those of the table in k that SersicInfo makes from the interpolated values, stay within
+     * kvalue_accuracy.  Each node is only set up when it is first needed, and its Hankel
+     * transform goes through TableCache.
+     */
+    class SersicTable
+    {
+    public:
+        SersicTable(const GSParamsPtr& gsparams);
+        ~SersicTable() {}
+
+        /// @brief The Fourier transform of a unit-flux profile with index `n`, at k = kre/re.
+        double kValue(double n, double kre) const;
+
+        /**
+         * @brief Returns log(z), where z = (r/r0)^(1/n) and r encloses a fraction
+         * 1/(1+exp(-s)) of the flux of the profile with index `n`.
+         */
+        double logFluxRadius(double n, double s) const;
+
+        /// @brief Get the (shared) table for the given gsparams.
+        static boost::shared_ptr<SersicTable> get(const GSParamsPtr& gsparams);
+
+    private:
+
+        SersicTable(const SersicTable& rhs); ///< Hide the copy constructor.
+        void operator=(const SersicTable& rhs); ///<Hide assignment operator.
+
+        GSParamsPtr _gsparams; ///< The GSParams of the node profiles.
+        int _nnode;            ///< Number of nodes.
+        double _logn_min;      ///< log(n) of the first node.
+        double _dlogn;         ///< Spacing of the nodes in log(n).
+
+        // The node profiles and, for each, log(z) as a function of s = log(f/(1-f)),
+        // where f is the enclosed flux fraction.  Both are built when first needed.
+        mutable std::vector<boost::shared_ptr<SersicInfo> > _nodes;
+        mutable std::vector<boost::shared_ptr<Table<double,double> > > _radii;
+
+        void getWeights(double n, int& i0, double* w) const;
+        double getNodeN(int i) const;
+        const SersicInfo& getNode(int i) const;
+        const Table<double,double>& getRadii(int i) const;
+
+        static LRUCache<GSParamsPtr, SersicTable> cache;
     };
 
     class SBSersic::SBSersicImpl : public SBProfileImpl
@@ -186,6 +268,16 @@ namespace galsim {
         double getScaleRadius() const { return _r0; }
         /// @brief Returns the truncation radius
         double getTrunc() const { return _trunc; }
+        /// @brief Returns the error of the Gaussian mixture approximation (0 if not used)
+        double getMixtureError() const { return _mixture_err; }
+
+        // In Gaussian mixture mode, everything is delegated to the mixture.
+        bool simplify(SBProfile& result) const
+        { if (_use_mixture) result = _mixture; return _use_mixture; }
+        double xValueCost() const
+        { return _use_mixture ? GetImpl(_mixture)->xValueCost() : 1.; }
+        double kValueCost() const
+        { return _use_mixture ? GetImpl(_mixture)->kValueCost() : 1.; }
 
         // Overrides for better efficiency
         void fillXValue(tmv::MatrixView<double> val,
@@ -200,6 +292,9 @@ namespace galsim {
         void fillKValue(tmv::MatrixView<std::complex<double> > val,
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
 
         std::string serialize() const;
 
@@ -221,6 +316,10 @@ namespace galsim {
 
         boost::shared_ptr<SersicInfo> _info; ///< Points to info structure for this n,trunc
 
+        bool _use_mixture;   ///< True if the profile is represented by a Gaussian mixture.
+        SBProfile _mixture;  ///< The Gaussian mixture, if _use_mixture.
+        double _mixture_err; ///< The error of the Gaussian mixture, if _use_mixture.
+
         // Copy constructor and op= are undefined.
         SBSersicImpl(const SBSersicImpl& rhs);
         void operator=(const SBSersicImpl& rhs);
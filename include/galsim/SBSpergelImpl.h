@@ -102,6 +102,9 @@ namespace galsim {
         // Classes used for photon shooting
         mutable boost::shared_ptr<FluxDensity> _radial;
         mutable boost::shared_ptr<OneDimensionalDeviate> _sampler;
+
+        // Helper functions used internally:
+        void calculateRadii() const;  ///< Calculate _stepk and _re.
     };
 
     class SBSpergel::SBSpergelImpl : public SBProfileImpl
@@ -40,6 +40,9 @@ namespace galsim {
 
         bool isAxisymmetric() const { return _stillIsAxisymmetric; }
         bool hasHardEdges() const { return _adaptee.hasHardEdges(); }
+        double xValueCost() const { return 1. + GetImpl(_adaptee)->xValueCost(); }
+        double kValueCost() const { return 1. + GetImpl(_adaptee)->kValueCost(); }
+        bool preferRealSpace() const { return GetImpl(_adaptee)->preferRealSpace(); }
         bool isAnalyticX() const { return _adaptee.isAnalyticX(); }
         bool isAnalyticK() const { return _adaptee.isAnalyticK(); }
 
@@ -92,6 +95,14 @@ namespace galsim {
         void fillKValue(tmv::MatrixView<std::complex<double> > val,
                         double kx0, double dkx, double dkxy,
                         double ky0, double dky, double dkyx) const;
+        void xValueMany(const double* x, const double* y, double* val, int n) const;
+        void kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                        int n) const;
+
+        bool simplify(SBProfile& result) const;
+        bool getGaussian(double& flux, double& cxx, double& cxy, double& cyy,
+                         Position<double>& cen) const;
+        bool getGaussianSum(std::list<SBProfile>& terms) const;
 
         std::string serialize() const;
 
@@ -188,5 +188,52 @@ private:
     bool _running;
 };
 
+namespace galsim {
+
+    // Several classes calculate some values the first time they are needed, with a flag to
+    // say whether that has been done.  When other threads may check the flag while one of
+    // them is doing the calculation (in a critical section), use these to read and set it.
+    inline bool ReadReadyFlag(const bool& flag)
+    {
+        bool ready;
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp atomic read seq_cst
+        ready = flag;
+#elif defined(_OPENMP)
+#pragma omp critical (galsim_ready_flag)
+        ready = flag;
+#else
+        ready = flag;
+#endif
+        return ready;
+    }
+
+    inline void SetReadyFlag(bool& flag)
+    {
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp atomic write seq_cst
+        flag = true;
+#elif defined(_OPENMP)
+#pragma omp critical (galsim_ready_flag)
+        flag = true;
+#else
+        flag = true;
+#endif
+    }
+
+    // A 64-bit FNV-1a hash of a string.  It is fast and spreads similar strings well, but it
+    // is not cryptographic, so users should either check the full string on a match or
+    // tolerate the (very rare) collisions.
+    inline unsigned long long HashString(const std::string& s)
+    {
+        unsigned long long h = 14695981039346656037ULL;
+        for (size_t i=0; i<s.size(); ++i) {
+            h ^= (unsigned char)(s[i]);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+}
 
 #endif
@@ -0,0 +1,117 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#ifndef GalSim_TableCache_H
+#define GalSim_TableCache_H
+
+#include <string>
+#include <vector>
+#include "GSParams.h"
+
+namespace galsim {
+
+    /// @brief The usage statistics of the TableCache, as returned by TableCache::getStats().
+    struct TableCacheStats
+    {
+        TableCacheStats() : hits(0), misses(0), writes(0) {}
+        long hits;      ///< The number of reads that found a matching file.
+        long misses;    ///< The number of reads that did not.
+        long writes;    ///< The number of tables successfully written.
+    };
+
+    /**
+     * @brief A persistent on-disk cache for precomputed profile tables.
+     *
+     * Some profiles (e.g. Sersic, Spergel, Kolmogorov) need to do a fair amount of numerical
+     * work to set up the lookup tables they use.  Within a process, these are cached in
+     * memory by an LRUCache, but each new process has to redo the calculation.  If a
+     * cache directory is set, the results are also saved in files in that directory, so
+     * other processes (e.g. the many workers of a large simulation run) can just read them
+     * back in.
+     *
+     * The cache directory is taken from the environment variable GALSIM_TABLE_CACHE_DIR,
+     * or it can be set explicitly with setDir().  If it is empty (the default), the disk
+     * cache is not used.
+     *
+     * Each entry is a flat array of doubles stored in its own file.  The file starts with a
+     * short header giving the file format version, the version of the table layout used by
+     * the caller and the full key, followed by the data as native doubles.  Files are read
+     * with mmap, and they are written to a temporary file which is then renamed, so several
+     * processes can safely share the same directory.  The key includes the GalSim version,
+     * so results from other versions are never used.  Within a version, each caller passes
+     * its own table version, which should be incremented whenever the layout or the
+     * algorithm used to compute the table changes.
+     *
+     * Failures to read or write the cache are not errors; the values are just calculated
+     * as normal.
+     */
+    class TableCache
+    {
+    public:
+        /// @brief Set the directory to use for the cache.  An empty string disables it.
+        static void setDir(const std::string& dir);
+
+        /// @brief Get the current cache directory.
+        static std::string getDir();
+
+        /**
+         * @brief Read the data stored for a given key.
+         *
+         * @param[in] kind    A short name for the kind of table, e.g. "sersic".
+         * @param[in] version The version of the table layout.  Files written with a
+         *                    different version are ignored.
+         * @param[in] key     The full key, including the profile parameters and makeKey().
+         * @param[out] data   The stored data, if found.
+         * @returns whether the key was found.
+         */
+        static bool read(const std::string& kind, int version, const std::string& key,
+                         std::vector<double>& data);
+
+        /**
+         * @brief Store the data for a given key.
+         *
+         * @param[in] kind    A short name for the kind of table, e.g. "sersic".
+         * @param[in] version The version of the table layout.
+         * @param[in] key     The full key, including the profile parameters and makeKey().
+         * @param[in] data    The data to store.
+         */
+        static void write(const std::string& kind, int version, const std::string& key,
+                          const std::vector<double>& data);
+
+        /// @brief Get the number of hits, misses and writes since the last resetStats().
+        static TableCacheStats getStats();
+
+        /// @brief Reset the statistics returned by getStats() to zero.
+        static void resetStats();
+
+        /**
+         * @brief Make the part of a key that describes the GSParams.
+         *
+         * The values are written at full precision, so different GSParams always give
+         * different keys.  The caller should prepend the profile parameters (also at full
+         * precision) to make the full key.  The flags that only select how a profile is
+         * drawn (single_precision_fft, gaussian_mixture, choose_draw_method) do not affect
+         * any of the tables, so they are left out.
+         */
+        static std::string makeKey(const GSParams& gsparams);
+    };
+
+}
+
+#endif
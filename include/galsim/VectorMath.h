@@ -0,0 +1,53 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#ifndef GalSim_VectorMath_H
+#define GalSim_VectorMath_H
+
+namespace galsim {
+namespace math {
+
+    /**
+     * @brief Vectorized versions of some elementary functions.
+     *
+     * The inner loops of the fillXValue functions for the analytic profiles spend most of
+     * their time in std::exp and std::pow, which the compiler cannot vectorize, since they
+     * are calls into libm.  These functions compute the same things for a whole array at
+     * once, using loops with no function calls or branches, so the compiler can use SIMD
+     * instructions for them.  When compiled with gcc on x86-64 Linux, they are built for
+     * several instruction sets (AVX-512, AVX2, and the baseline SSE2), and the best one for
+     * the current machine is chosen at run time.
+     *
+     * The results are accurate to a few ulp, so they may be used as drop-in replacements
+     * for the libm functions.  This includes the denormal results of ExpMany for
+     * -745.13 < x < -708 and of LogMany for denormal x.
+     *
+     * In all cases, the input and output arrays may be the same.
+     */
+
+    /// @brief Set y[i] = exp(x[i]) for i = 0..n-1.
+    void ExpMany(const double* x, double* y, int n);
+
+    /// @brief Set y[i] = log(x[i]) for i = 0..n-1.
+    void LogMany(const double* x, double* y, int n);
+
+}
+}
+
+#endif
@@ -34,11 +34,17 @@ namespace galsim {
 
         // This will be wrapped as a Python constructor; it accepts an arbitrary Python iterable.
         static SBConvolve* construct(const bp::object& iterable, bool real_space,
-                                     boost::shared_ptr<GSParams> gsparams) 
+                                     boost::shared_ptr<GSParams> gsparams,
+                                     const bp::object& shared)
         {
             bp::stl_input_iterator<SBProfile> begin(iterable), end;
             std::list<SBProfile> plist(begin, end);
-            return new SBConvolve(plist, real_space, gsparams);
+            std::list<SBProfile> slist;
+            if (shared.ptr() != Py_None) {
+                bp::stl_input_iterator<SBProfile> sbegin(shared), send;
+                slist.assign(sbegin, send);
+            }
+            return new SBConvolve(plist, real_space, gsparams, slist);
         }
 
         static bp::list getObjs(const SBConvolve& sbp)
@@ -58,12 +64,19 @@ namespace galsim {
                 .def("__init__", bp::make_constructor(
                         &construct, bp::default_call_policies(), 
                         (bp::arg("slist"), bp::arg("real_space")=false,
-                         bp::arg("gsparams")=bp::object()))
+                         bp::arg("gsparams")=bp::object(), bp::arg("shared")=bp::object()))
                 )
                 .def(bp::init<const SBConvolve&>())
                 .def("getObjs", getObjs)
                 .def("isRealSpace", &SBConvolve::isRealSpace)
                 ;
+
+            bp::def("SetKGridCacheBudget", &SetKGridCacheBudget, bp::arg("nbytes"),
+                    "Set the maximum memory in bytes used by the cache of shared k grids.");
+            bp::def("GetKGridCacheBudget", &GetKGridCacheBudget,
+                    "Get the maximum memory in bytes used by the cache of shared k grids.");
+            bp::def("ClearKGridCache", &ClearKGridCache,
+                    "Remove all the saved k grids from the cache.");
         }
 
     };
@@ -40,6 +40,7 @@ namespace galsim {
                 )
                 .def(bp::init<const SBExponential &>())
                 .def("getScaleRadius", &SBExponential::getScaleRadius)
+                .def("getMixtureError", &SBExponential::getMixtureError)
                 .enable_pickling()
                 ;
         }
@@ -29,6 +29,9 @@
 #include "SBProfile.h"
 #include "SBTransform.h"
 #include "FFT.h"  // For goodFFTSize
+#include "TableCache.h"
+#include "LRUCache.h"
+#include "NumpyHelper.h"
 
 namespace bp = boost::python;
 
@@ -41,7 +44,7 @@ namespace galsim {
             bp::class_<GSParams, boost::shared_ptr<GSParams> > ("GSParams", bp::no_init)
                 .def(bp::init<
                     int, int, double, double, double, double, double, double, double, double,
-                    double, double, double, double, int, double>((
+                    double, double, double, double, int, double, bool, bool, bool>((
                         bp::arg("minimum_fft_size")=128,
                         bp::arg("maximum_fft_size")=4096,
                         bp::arg("folding_threshold")=5.e-3,
@@ -57,7 +60,10 @@ namespace galsim {
                         bp::arg("shoot_accuracy")=1.e-5,
                         bp::arg("allowed_flux_variation")=0.81,
                         bp::arg("range_division_for_extrema")=32,
-                        bp::arg("small_fraction_of_flux")=1.e-4)
+                        bp::arg("small_fraction_of_flux")=1.e-4,
+                        bp::arg("single_precision_fft")=false,
+                        bp::arg("gaussian_mixture")=false,
+                        bp::arg("choose_draw_method")=false)
                     )
                 )
                 .def_readonly("minimum_fft_size", &GSParams::minimum_fft_size)
@@ -76,6 +82,9 @@ namespace galsim {
                 .def_readonly("allowed_flux_variation", &GSParams::allowed_flux_variation)
                 .def_readonly("range_division_for_extrema", &GSParams::range_division_for_extrema)
                 .def_readonly("small_fraction_of_flux", &GSParams::small_fraction_of_flux)
+                .def_readonly("single_precision_fft", &GSParams::single_precision_fft)
+                .def_readonly("gaussian_mixture", &GSParams::gaussian_mixture)
+                .def_readonly("choose_draw_method", &GSParams::choose_draw_method)
                 .def(bp::self == bp::other<GSParams>())
                 .enable_pickling()
                 ;
@@ -101,16 +110,19 @@ namespace galsim {
             wrapper
                 .def("drawShoot",
                      (double (SBProfile::*)(ImageView<U>, double, UniformDeviate,
-                                            double, double, bool, bool)
+                                            double, double, bool, bool, int)
                       const)&SBProfile::drawShoot,
                      (bp::arg("image"), bp::arg("N")=0., bp::arg("ud"),
                       bp::arg("gain")=1., bp::arg("max_extra_noise")=0.,
-                      bp::arg("poisson_flux")=true, bp::arg("add_to_image")=false),
+                      bp::arg("poisson_flux")=true, bp::arg("add_to_image")=false,
+                      bp::arg("nthreads")=1),
                      "Draw object into existing image using photon shooting.\n"
                      "\n"
                      "Setting optional integer arg poissonFlux != 0 allows profile flux to vary\n"
                      "according to Poisson statistics for N samples.\n"
                      "\n"
+                     "Setting nthreads != 1 bins the photons using multiple threads.\n"
+                     "\n"
                      "Returns total flux of photons that landed inside image bounds.")
                 .def("draw",
                      (double (SBProfile::*)(ImageView<U>, double, double) const)&SBProfile::draw,
@@ -124,6 +136,42 @@ namespace galsim {
                 ;
         }
 
+        static void xValueMany(const SBProfile& sbp, const bp::object& x, const bp::object& y,
+                               const bp::object& val)
+        {
+            const double* xvec = GetNumpyArrayData<double>(x.ptr());
+            const double* yvec = GetNumpyArrayData<double>(y.ptr());
+            double* valvec = GetNumpyArrayData<double>(val.ptr());
+            int n = GetNumpyArrayDim(x.ptr(), 0);
+            sbp.xValueMany(xvec, yvec, valvec, n);
+        }
+
+        // Return the DrawMethodChoice as a dict, with None for the methods that aren't allowed.
+        static bp::dict chooseDrawMethod(const SBProfile& sbp, const Bounds<int>& bounds,
+                                         double wmult, bool allow_shoot, double N)
+        {
+            DrawMethodChoice choice = sbp.chooseDrawMethod(bounds, wmult, allow_shoot, N);
+            bp::dict d;
+            d["method"] = choice.getMethodName();
+            d["plainDraw"] = choice.plain_cost >= 0. ? bp::object(choice.plain_cost) : bp::object();
+            d["fourierDraw"] =
+                choice.fourier_cost >= 0. ? bp::object(choice.fourier_cost) : bp::object();
+            d["drawShoot"] = choice.shoot_cost >= 0. ? bp::object(choice.shoot_cost) : bp::object();
+            d["NFT"] = choice.NFT;
+            d["N"] = choice.N;
+            return d;
+        }
+
+        static void kValueMany(const SBProfile& sbp, const bp::object& kx, const bp::object& ky,
+                               const bp::object& val)
+        {
+            const double* kxvec = GetNumpyArrayData<double>(kx.ptr());
+            const double* kyvec = GetNumpyArrayData<double>(ky.ptr());
+            std::complex<double>* valvec = GetNumpyArrayData<std::complex<double> >(val.ptr());
+            int n = GetNumpyArrayDim(kx.ptr(), 0);
+            sbp.kValueMany(kxvec, kyvec, valvec, n);
+        }
+
         static void wrap() {
             static char const * doc =
                 "\n"
@@ -171,6 +219,16 @@ namespace galsim {
                      "require an FFT to determine real-space values.")
                 .def("kValue", &SBProfile::kValue,
                      "Return value of SBProfile at a chosen 2d position in k-space.")
+                .def("xValueMany", &xValueMany, bp::args("x", "y", "val"),
+                     "Fill val with the values of SBProfile at the positions (x[i],y[i]).")
+                .def("kValueMany", &kValueMany, bp::args("kx", "ky", "val"),
+                     "Fill val with the k-space values of SBProfile at (kx[i],ky[i]).")
+                .def("chooseDrawMethod", &chooseDrawMethod,
+                     (bp::arg("bounds"), bp::arg("wmult")=1., bp::arg("allow_shoot")=false,
+                      bp::arg("N")=0.),
+                     "Return the fastest way to draw the SBProfile and the predicted costs.")
+                .def("simplify", &SBProfile::simplify,
+                     "Return an equivalent SBProfile that is faster to evaluate.")
                 .def("maxK", &SBProfile::maxK, "Value of k beyond which aliasing can be neglected")
                 .def("nyquistDx", &SBProfile::nyquistDx,
                      "Image pixel spacing that does not alias maxK")
@@ -205,6 +263,101 @@ namespace galsim {
     };
 
 
+    // Draw a list of SBProfiles on a list of ImageViews, returning a list of the added fluxes.
+    template <typename U>
+    static bp::list FourierDrawMany(const bp::object& profs, const bp::object& images,
+                                    double gain, double wmult)
+    {
+        bp::stl_input_iterator<SBProfile> pbegin(profs), pend;
+        std::vector<SBProfile> vprofs(pbegin, pend);
+        bp::stl_input_iterator<ImageView<U> > ibegin(images), iend;
+        std::vector<ImageView<U> > vimages(ibegin, iend);
+        std::vector<double> sums = SBProfile::fourierDrawMany(vprofs, vimages, gain, wmult);
+        bp::list l;
+        for (size_t i=0; i<sums.size(); ++i) l.append(sums[i]);
+        return l;
+    }
+
+    // Draw an SBProfile at a list of offsets on a list of ImageViews, returning a list of the
+    // added fluxes.
+    template <typename U>
+    static bp::list FourierDrawOffsets(const SBProfile& prof, const bp::object& offsets,
+                                       const bp::object& images, double gain, double wmult)
+    {
+        bp::stl_input_iterator<Position<double> > obegin(offsets), oend;
+        std::vector<Position<double> > voffsets(obegin, oend);
+        bp::stl_input_iterator<ImageView<U> > ibegin(images), iend;
+        std::vector<ImageView<U> > vimages(ibegin, iend);
+        std::vector<double> sums = prof.fourierDrawOffsets(voffsets, vimages, gain, wmult);
+        bp::list l;
+        for (size_t i=0; i<sums.size(); ++i) l.append(sums[i]);
+        return l;
+    }
+
+    // Return a dict of dicts with the usage statistics of each of the profile caches.
+    static bp::dict GetCacheStats()
+    {
+        bp::dict result;
+        const std::vector<LRUCacheBase*>& registry = LRUCacheBase::getRegistry();
+        for (size_t i=0; i<registry.size(); ++i) {
+            LRUCacheStats stats = registry[i]->getStats();
+            bp::dict d;
+            d["hits"] = stats.hits;
+            d["misses"] = stats.misses;
+            d["waits"] = stats.waits;
+            d["evictions"] = stats.evictions;
+            d["build_time"] = stats.build_time;
+            d["size"] = registry[i]->size();
+            d["max_size"] = registry[i]->maxSize();
+            result[registry[i]->getName()] = d;
+        }
+        return result;
+    }
+
+    // Return a dict with the usage statistics of the on-disk table cache.
+    static bp::dict GetTableCacheStats()
+    {
+        TableCacheStats stats = TableCache::getStats();
+        bp::dict d;
+        d["hits"] = stats.hits;
+        d["misses"] = stats.misses;
+        d["writes"] = stats.writes;
+        return d;
+    }
+
+    static bp::dict DrawCostModelToDict(const DrawCostModel& model)
+    {
+        bp::dict d;
+        d["xvalue"] = model.xvalue;
+        d["kvalue"] = model.kvalue;
+        d["fft"] = model.fft;
+        d["shoot"] = model.shoot;
+        d["calibrated"] = model.calibrated;
+        return d;
+    }
+
+    static bp::dict GetDrawCostModelDict()
+    { return DrawCostModelToDict(GetDrawCostModel()); }
+
+    static bp::dict CalibrateDrawCostDict(bool force)
+    { return DrawCostModelToDict(CalibrateDrawCost(force)); }
+
+    static void SetDrawCostModelValues(double xvalue, double kvalue, double fft, double shoot)
+    {
+        DrawCostModel model;
+        model.xvalue = xvalue;
+        model.kvalue = kvalue;
+        model.fft = fft;
+        model.shoot = shoot;
+        SetDrawCostModel(model);
+    }
+
+    static void ResetCacheStats()
+    {
+        const std::vector<LRUCacheBase*>& registry = LRUCacheBase::getRegistry();
+        for (size_t i=0; i<registry.size(); ++i) registry[i]->resetStats();
+    }
+
     void pyExportSBProfile()
     {
         PySBProfile::wrap();
@@ -212,6 +365,51 @@ namespace galsim {
 
         bp::def("goodFFTSize", &goodFFTSize, (bp::arg("input_size")),
                 "Round up to the next larger 2^n or 3x2^n.");
+        bp::def("FFTWMeasure", &fftwMeasure, (bp::arg("N")),
+                "Measure the fastest FFTW plans for NxN transforms.");
+        bp::def("FFTWImportWisdom", &fftwImportWisdom, (bp::arg("file_name")),
+                "Read FFTW wisdom from a file.");
+        bp::def("FFTWExportWisdom", &fftwExportWisdom, (bp::arg("file_name")),
+                "Write the current FFTW wisdom to a file.");
+        bp::def("FFTWClearPlans", &fftwClearPlans,
+                "Destroy all the cached FFTW plans.");
+        bp::def("SetFFTThreads", &setFFTThreads, (bp::arg("nthreads")),
+                "Set the number of threads to use for large FFTs.");
+        bp::def("GetFFTThreads", &getFFTThreads,
+                "Get the number of threads used for large FFTs.");
+        bp::def("SetTableCacheDir", &TableCache::setDir, (bp::arg("dir")),
+                "Set the directory for the on-disk cache of profile tables.");
+        bp::def("GetTableCacheDir", &TableCache::getDir,
+                "Get the directory for the on-disk cache of profile tables.");
+        bp::def("GetTableCacheStats", &GetTableCacheStats,
+                "Get the usage statistics of the on-disk cache of profile tables.");
+        bp::def("ResetTableCacheStats", &TableCache::resetStats,
+                "Reset the usage statistics of the on-disk cache of profile tables.");
+        bp::def("FourierDrawManyF", &FourierDrawMany<float>,
+                (bp::arg("profs"), bp::arg("images"), bp::arg("gain")=1., bp::arg("wmult")=1.),
+                "Draw a list of SBProfiles on a list of images using batched FFTs.");
+        bp::def("FourierDrawManyD", &FourierDrawMany<double>,
+                (bp::arg("profs"), bp::arg("images"), bp::arg("gain")=1., bp::arg("wmult")=1.),
+                "Draw a list of SBProfiles on a list of images using batched FFTs.");
+        bp::def("FourierDrawOffsetsF", &FourierDrawOffsets<float>,
+                (bp::arg("prof"), bp::arg("offsets"), bp::arg("images"), bp::arg("gain")=1.,
+                 bp::arg("wmult")=1.),
+                "Draw an SBProfile at a list of offsets on a list of images using FFTs.");
+        bp::def("FourierDrawOffsetsD", &FourierDrawOffsets<double>,
+                (bp::arg("prof"), bp::arg("offsets"), bp::arg("images"), bp::arg("gain")=1.,
+                 bp::arg("wmult")=1.),
+                "Draw an SBProfile at a list of offsets on a list of images using FFTs.");
+        bp::def("GetDrawCostModel", &GetDrawCostModelDict,
+                "Get the coefficients of the cost model used to choose how to draw profiles.");
+        bp::def("SetDrawCostModel", &SetDrawCostModelValues,
+                (bp::arg("xvalue"), bp::arg("kvalue"), bp::arg("fft"), bp::arg("shoot")),
+                "Set the coefficients of the cost model used to choose how to draw profiles.");
+        bp::def("CalibrateDrawCost", &CalibrateDrawCostDict, (bp::arg("force")=false),
+                "Measure the coefficients of the draw cost model on this machine.");
+        bp::def("GetCacheStats", &GetCacheStats,
+                "Get the usage statistics of the profile caches.");
+        bp::def("ResetCacheStats", &ResetCacheStats,
+                "Reset the usage statistics of the profile caches.");
     }
 
 } // namespace galsim
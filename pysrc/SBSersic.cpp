@@ -70,6 +70,7 @@ namespace galsim {
                 .def("getHalfLightRadius", &SBSersic::getHalfLightRadius)
                 .def("getScaleRadius", &SBSersic::getScaleRadius)
                 .def("getTrunc", &SBSersic::getTrunc)
+                .def("getMixtureError", &SBSersic::getMixtureError)
                 .enable_pickling()
                 ;
         }
@@ -113,6 +114,7 @@ namespace galsim {
                 .def("getHalfLightRadius", &SBDeVaucouleurs::getHalfLightRadius)
                 .def("getScaleRadius", &SBDeVaucouleurs::getScaleRadius)
                 .def("getTrunc", &SBDeVaucouleurs::getTrunc)
+                .def("getMixtureError", &SBDeVaucouleurs::getMixtureError)
                 ;
         }
     };
@@ -56,23 +56,29 @@ namespace galsim {
 
         int k, ell; // k and l are indices that refer to image pixel separation vectors in the 
                     // correlation func.
-        double x_k, y_ell; // physical vector separations in the correlation func, dx * k etc.
 
         tmv::SymMatrix<double, tmv::FortranStyle|tmv::Upper> cov = tmv::SymMatrix<
             double, tmv::FortranStyle|tmv::Upper>(covdim);
 
+        // Physical vector separations in the correlation func, dx * k etc.  We evaluate the
+        // values for each row of the upper triangle together with xValueMany.
+        std::vector<double> x_k(covdim), y_ell(covdim), val(covdim);
+
         for (int i=1; i<=covdim; i++){ // note that the Image indices use the FITS convention and 
                                        // start from 1!!
+            int n = covdim - i + 1;
             for (int j=i; j<=covdim; j++){
 
                 k = ((j - 1) / jdim) - ((i - 1) / idim);  // using integer division rules here
                 ell = ((j - 1) % jdim) - ((i - 1) % idim);
-                x_k = double(k) * dx;
-                y_ell = double(ell) * dx;
-                Position<double> p = Position<double>(x_k, y_ell);
-                cov(i, j) = sbp.xValue(p); // fill in the upper triangle with the correct value
+                x_k[j-i] = double(k) * dx;
+                y_ell[j-i] = double(ell) * dx;
 
             }
+            sbp.xValueMany(&x_k[0], &y_ell[0], &val[0], n);
+            for (int j=i; j<=covdim; j++){
+                cov(i, j) = val[j-i]; // fill in the upper triangle with the correct value
+            }
 
         }
         return cov;
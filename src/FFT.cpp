@@ -23,10 +23,20 @@
 
 #include <limits>
 #include <vector>
+#include <algorithm>
+#include <map>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 #include "FFT.h"
 #include "Std.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __SSE2__
 #include "xmmintrin.h"
 #endif
@@ -54,6 +64,449 @@ namespace galsim {
         return Nk;
     }
 
+    // The FFTW planner is not thread safe.  Only the fftw_execute functions are.  So all
+    // the code that makes or destroys plans, or touches FFTW's wisdom, is in critical sections
+    // named galsim_fftw_plan.  The functions in this anonymous namespace assume they are
+    // already in that critical section.
+    namespace {
+
+        // KtoX and XtoK are the full 2D transforms.  The others are the 1D pieces used for
+        // the threaded transforms: a block of howmany columns (the first dimension, which is
+        // done in place) or rows (the second dimension) of the NxN table.
+        // KtoXMany is a batch of howmany full 2D k->x transforms, stored one after another.
+        enum FFTKind { KtoX, XtoK, KtoXCols, KtoXRows, XtoKRows, XtoKCols, KtoXMany };
+
+        // A plan can be reused (with the fftw_execute_dft_* functions) on any arrays of the
+        // same size and alignment, so that is what we key the cache on:
+        // (N, kind, howmany, alignment of input, alignment of output)
+        // The 1D plans are executed at many different offsets into the arrays, so they are
+        // made with FFTW_UNALIGNED, and the alignments in the key are 0.
+        typedef boost::tuple<int,int,int,int,int> PlanKey;
+        typedef std::map<PlanKey,fftw_plan> PlanMap;
+
+        // The number of threads to use for the threaded transforms, and the smallest N for
+        // which they are used.  Below this, the overhead of the threads isn't worth it.
+        int fft_threads = 1;
+        const int min_threaded_fft_size = 512;
+
+        // The number of rows or columns each thread transforms at a time.
+        const int fft_block_size = 8;
+
+        PlanMap& PlanCache()
+        {
+            static PlanMap cache;
+            return cache;
+        }
+
+        // Plans that have been replaced, but which other threads may still be executing.
+        // These are destroyed as soon as no transforms are running.
+        std::vector<fftw_plan>& RetiredPlans()
+        {
+            static std::vector<fftw_plan> retired;
+            return retired;
+        }
+
+#ifdef USE_FFTWF
+        // The single-precision plans for KTable::transformFloat.  These are keyed the same
+        // way as the double-precision ones, but they are only ever k->x 2D transforms.
+        typedef std::map<PlanKey,fftwf_plan> FloatPlanMap;
+
+        FloatPlanMap& FloatPlanCache()
+        {
+            static FloatPlanMap cache;
+            return cache;
+        }
+
+        std::vector<fftwf_plan>& RetiredFloatPlans()
+        {
+            static std::vector<fftwf_plan> retired;
+            return retired;
+        }
+#endif
+
+        // The number of transforms that are using plans from the caches.  See PlanUser.
+        int transforms_in_flight = 0;
+
+        // Destroy the retired plans, unless some transform may still be executing them.
+        void DestroyRetiredPlans()
+        {
+            if (transforms_in_flight > 0) return;
+            std::vector<fftw_plan>& retired = RetiredPlans();
+            if (!retired.empty()) dbg<<"Destroy "<<retired.size()<<" retired plans"<<std::endl;
+            for (size_t i=0; i<retired.size(); ++i) fftw_destroy_plan(retired[i]);
+            retired.clear();
+#ifdef USE_FFTWF
+            std::vector<fftwf_plan>& fretired = RetiredFloatPlans();
+            for (size_t i=0; i<fretired.size(); ++i) fftwf_destroy_plan(fretired[i]);
+            fretired.clear();
+#endif
+        }
+
+        PlanKey MakePlanKey(FFTKind kind, int N, int howmany, void* in, void* out)
+        {
+            if (kind == KtoX || kind == XtoK || kind == KtoXMany)
+                return PlanKey(N, kind, howmany,
+                               fftw_alignment_of(reinterpret_cast<double*>(in)),
+                               fftw_alignment_of(reinterpret_cast<double*>(out)));
+            else
+                return PlanKey(N, kind, howmany, 0, 0);
+        }
+
+        fftw_plan MakePlan(FFTKind kind, int N, int howmany, void* in, void* out,
+                           unsigned flags)
+        {
+            fftw_complex* cin = reinterpret_cast<fftw_complex*>(in);
+            fftw_complex* cout = reinterpret_cast<fftw_complex*>(out);
+            double* rin = reinterpret_cast<double*>(in);
+            double* rout = reinterpret_cast<double*>(out);
+            const int No2p1 = N/2+1;
+            switch (kind) {
+              case KtoX:
+                   return fftw_plan_dft_c2r_2d(N, N, cin, rout, flags);
+              case XtoK:
+                   return fftw_plan_dft_r2c_2d(N, N, rin, cout, flags);
+              case KtoXCols:
+                   return fftw_plan_many_dft(1, &N, howmany, cin, 0, No2p1, 1,
+                                             cout, 0, No2p1, 1, FFTW_BACKWARD,
+                                             flags | FFTW_UNALIGNED);
+              case XtoKCols:
+                   return fftw_plan_many_dft(1, &N, howmany, cin, 0, No2p1, 1,
+                                             cout, 0, No2p1, 1, FFTW_FORWARD,
+                                             flags | FFTW_UNALIGNED);
+              case KtoXRows:
+                   return fftw_plan_many_dft_c2r(1, &N, howmany, cin, 0, 1, No2p1,
+                                                 rout, 0, 1, N, flags | FFTW_UNALIGNED);
+              case XtoKRows:
+                   return fftw_plan_many_dft_r2c(1, &N, howmany, rin, 0, 1, N,
+                                                 cout, 0, 1, No2p1, flags | FFTW_UNALIGNED);
+              case KtoXMany:
+                   {
+                       const int n[2] = { N, N };
+                       return fftw_plan_many_dft_c2r(2, n, howmany, cin, 0, 1, N*No2p1,
+                                                     rout, 0, 1, N*N, flags);
+                   }
+              default:
+                   return 0;
+            }
+        }
+
+        void RetireAllPlans()
+        {
+            PlanMap& cache = PlanCache();
+            for (PlanMap::iterator it=cache.begin(); it!=cache.end(); ++it)
+                RetiredPlans().push_back(it->second);
+            cache.clear();
+        }
+
+        bool ImportWisdom(const std::string& file_name)
+        {
+            dbg<<"Import FFTW wisdom from "<<file_name<<std::endl;
+            std::FILE* f = std::fopen(file_name.c_str(), "r");
+            if (!f) return false;
+            bool ok = fftw_import_wisdom_from_file(f);
+            std::fclose(f);
+            // Make new plans the next time they are needed, so they can use the new wisdom.
+            if (ok) {
+                RetireAllPlans();
+                DestroyRetiredPlans();
+            }
+            return ok;
+        }
+
+        // Import the wisdom file given by GALSIM_FFTW_WISDOM, if any, the first time through.
+        void ImportWisdomFromEnv()
+        {
+            static bool done = false;
+            if (done) return;
+            done = true;
+            const char* env = std::getenv("GALSIM_FFTW_WISDOM");
+            if (env) ImportWisdom(env);
+        }
+
+#ifdef USE_FFTWF
+        fftwf_plan GetFloatPlan(int N, std::complex<float>* in, float* out)
+        {
+            fftwf_plan plan = 0;
+            fftwf_complex* cin = reinterpret_cast<fftwf_complex*>(in);
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+            {
+                PlanKey key(N, KtoX, 0, fftwf_alignment_of(reinterpret_cast<float*>(in)),
+                            fftwf_alignment_of(out));
+                FloatPlanMap::iterator it = FloatPlanCache().find(key);
+                if (it != FloatPlanCache().end()) {
+                    plan = it->second;
+                } else {
+                    dbg<<"Make new float plan for N = "<<N<<std::endl;
+                    plan = fftwf_plan_dft_c2r_2d(N, N, cin, out,
+                                                 FFTW_MEASURE | FFTW_WISDOM_ONLY);
+                    if (!plan) plan = fftwf_plan_dft_c2r_2d(N, N, cin, out, FFTW_ESTIMATE);
+                    if (plan) FloatPlanCache()[key] = plan;
+                }
+            }
+            if (!plan) throw FFTInvalid();
+            return plan;
+        }
+#endif
+
+        // Get a plan from the cache, making it if necessary.  in and out are the arrays the
+        // plan will be used with.  They are not modified.
+        fftw_plan GetPlan(FFTKind kind, int N, int howmany, void* in, void* out)
+        {
+            fftw_plan plan = 0;
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+            {
+                ImportWisdomFromEnv();
+                PlanKey key = MakePlanKey(kind, N, howmany, in, out);
+                PlanMap::iterator it = PlanCache().find(key);
+                if (it != PlanCache().end()) {
+                    plan = it->second;
+                } else {
+                    // Use a measured plan if FFTW has wisdom about one, otherwise estimate.
+                    // Neither of these overwrites the arrays.
+                    dbg<<"Make new plan for N = "<<N<<", kind = "<<kind<<std::endl;
+                    plan = MakePlan(kind, N, howmany, in, out, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+                    if (!plan) plan = MakePlan(kind, N, howmany, in, out, FFTW_ESTIMATE);
+                    if (plan) PlanCache()[key] = plan;
+                }
+            }
+            if (!plan) throw FFTInvalid();
+            return plan;
+        }
+
+        // Make a measured plan and put it in the cache.  This overwrites the arrays.
+        void MeasurePlan(FFTKind kind, int N, int howmany, void* in, void* out)
+        {
+            fftw_plan plan = 0;
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+            {
+                ImportWisdomFromEnv();
+                plan = MakePlan(kind, N, howmany, in, out, FFTW_MEASURE);
+                if (plan) {
+                    PlanKey key = MakePlanKey(kind, N, howmany, in, out);
+                    PlanMap::iterator it = PlanCache().find(key);
+                    if (it != PlanCache().end()) {
+                        RetiredPlans().push_back(it->second);
+                        it->second = plan;
+                        DestroyRetiredPlans();
+                    } else {
+                        PlanCache()[key] = plan;
+                    }
+                }
+            }
+            if (!plan) throw FFTInvalid();
+        }
+
+        // A transform makes one of these before it gets its plans and keeps it until it has
+        // finished executing them.  While any exist, plans that are replaced in the cache
+        // are only retired.  The last one to finish destroys them.
+        class PlanUser
+        {
+        public:
+            PlanUser()
+            {
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+                ++transforms_in_flight;
+            }
+
+            ~PlanUser()
+            {
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+                {
+                    --transforms_in_flight;
+                    DestroyRetiredPlans();
+                }
+            }
+        };
+
+        // The number of threads to use for an NxN transform.
+        int NumFFTThreads(int N)
+        { return N >= min_threaded_fft_size ? fft_threads : 1; }
+
+        // The threaded transforms do the 2D transform as a series of 1D transforms, first
+        // along the columns and then along the rows for k->x, and the reverse for x->k.
+        // Each stage is split among the threads in blocks of fft_block_size rows or columns.
+        // The plans are all made up front, since the planner is not thread safe.
+        //
+        // k->x.  kin is the N x (N/2+1) complex input, which is overwritten.
+        //        xout is the N x N real output.
+        //        Only the output rows row1 <= i < row2 are calculated.  The column transforms
+        //        are needed for any output row, but the row transforms can be skipped.
+        void ThreadedKtoX(int N, std::complex<double>* kin, double* xout, int nthreads,
+                          int row1, int row2)
+        {
+            const int No2p1 = N/2+1;
+            const int ncolrem = No2p1 % fft_block_size;
+            const int nrowrem = (row2-row1) % fft_block_size;
+            fftw_plan cols = GetPlan(KtoXCols, N, fft_block_size, kin, kin);
+            fftw_plan cols_rem = ncolrem ? GetPlan(KtoXCols, N, ncolrem, kin, kin) : 0;
+            fftw_plan rows = GetPlan(KtoXRows, N, fft_block_size, kin, xout);
+            fftw_plan rows_rem = nrowrem ? GetPlan(KtoXRows, N, nrowrem, kin, xout) : 0;
+            const int ncolblock = (No2p1 + fft_block_size - 1) / fft_block_size;
+            const int nrowblock = (row2 - row1 + fft_block_size - 1) / fft_block_size;
+            dbg<<"ThreadedKtoX: N = "<<N<<", nthreads = "<<nthreads<<
+                ", rows = "<<row1<<".."<<row2<<std::endl;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int b=0; b<ncolblock; ++b) {
+                    const int j = b * fft_block_size;
+                    fftw_complex* c = reinterpret_cast<fftw_complex*>(kin + j);
+                    fftw_execute_dft(j + fft_block_size <= No2p1 ? cols : cols_rem, c, c);
+                }
+                // (The implicit barrier here means all the columns are done before the rows.)
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int b=0; b<nrowblock; ++b) {
+                    const int i = row1 + b * fft_block_size;
+                    fftw_complex* c = reinterpret_cast<fftw_complex*>(kin + i*No2p1);
+                    fftw_execute_dft_c2r(i + fft_block_size <= row2 ? rows : rows_rem,
+                                         c, xout + i*N);
+                }
+            }
+        }
+
+        // x->k.  xin is the N x N real input.  kout is the N x (N/2+1) complex output.
+        void ThreadedXtoK(int N, double* xin, std::complex<double>* kout, int nthreads)
+        {
+            const int No2p1 = N/2+1;
+            const int ncolrem = No2p1 % fft_block_size;
+            const int nrowrem = N % fft_block_size;
+            fftw_plan rows = GetPlan(XtoKRows, N, fft_block_size, xin, kout);
+            fftw_plan rows_rem = nrowrem ? GetPlan(XtoKRows, N, nrowrem, xin, kout) : 0;
+            fftw_plan cols = GetPlan(XtoKCols, N, fft_block_size, kout, kout);
+            fftw_plan cols_rem = ncolrem ? GetPlan(XtoKCols, N, ncolrem, kout, kout) : 0;
+            const int ncolblock = (No2p1 + fft_block_size - 1) / fft_block_size;
+            const int nrowblock = (N + fft_block_size - 1) / fft_block_size;
+            dbg<<"ThreadedXtoK: N = "<<N<<", nthreads = "<<nthreads<<std::endl;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int b=0; b<nrowblock; ++b) {
+                    const int i = b * fft_block_size;
+                    fftw_complex* c = reinterpret_cast<fftw_complex*>(kout + i*No2p1);
+                    fftw_execute_dft_r2c(i + fft_block_size <= N ? rows : rows_rem,
+                                         xin + i*N, c);
+                }
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for (int b=0; b<ncolblock; ++b) {
+                    const int j = b * fft_block_size;
+                    fftw_complex* c = reinterpret_cast<fftw_complex*>(kout + j);
+                    fftw_execute_dft(j + fft_block_size <= No2p1 ? cols : cols_rem, c, c);
+                }
+            }
+        }
+
+        // Measure all the 1D plans used by the threaded transforms.
+        // in and out are scratch arrays of the right sizes for the given direction.
+        void MeasureThreadedPlans(bool k_to_x, int N, void* in, void* out)
+        {
+            const int No2p1 = N/2+1;
+            const int ncolrem = No2p1 % fft_block_size;
+            const int nrowrem = N % fft_block_size;
+            // The column transforms are in place on the complex array.
+            void* c = k_to_x ? in : out;
+            FFTKind colkind = k_to_x ? KtoXCols : XtoKCols;
+            FFTKind rowkind = k_to_x ? KtoXRows : XtoKRows;
+            MeasurePlan(colkind, N, fft_block_size, c, c);
+            if (ncolrem) MeasurePlan(colkind, N, ncolrem, c, c);
+            MeasurePlan(rowkind, N, fft_block_size, in, out);
+            if (nrowrem) MeasurePlan(rowkind, N, nrowrem, in, out);
+        }
+
+    }
+
+    void setFFTThreads(int nthreads)
+    {
+#ifdef _OPENMP
+        if (nthreads <= 0) nthreads = omp_get_max_threads();
+#else
+        nthreads = 1;
+#endif
+        dbg<<"setFFTThreads "<<nthreads<<std::endl;
+        fft_threads = nthreads;
+    }
+
+    int getFFTThreads()
+    { return fft_threads; }
+
+    void fftwMeasure(int N)
+    {
+        KTable kt(N, 1.);
+        kt.fftwMeasure();
+        XTable xt(N, 1.);
+        xt.fftwMeasure();
+    }
+
+    bool fftwImportWisdom(const std::string& file_name)
+    {
+        bool ok;
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+        {
+            ImportWisdomFromEnv();
+            ok = ImportWisdom(file_name);
+        }
+        return ok;
+    }
+
+    bool fftwExportWisdom(const std::string& file_name)
+    {
+        bool ok = false;
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+        {
+            dbg<<"Export FFTW wisdom to "<<file_name<<std::endl;
+            std::FILE* f = std::fopen(file_name.c_str(), "w");
+            if (f) {
+                fftw_export_wisdom_to_file(f);
+                ok = (std::fclose(f) == 0);
+            }
+        }
+        return ok;
+    }
+
+    void fftwClearPlans()
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+        {
+            RetireAllPlans();
+#ifdef USE_FFTWF
+            FloatPlanMap& fcache = FloatPlanCache();
+            for (FloatPlanMap::iterator it=fcache.begin(); it!=fcache.end(); ++it)
+                RetiredFloatPlans().push_back(it->second);
+            fcache.clear();
+#endif
+            DestroyRetiredPlans();
+        }
+    }
+
     KTable::KTable(int N, double dk, std::complex<double> value) : _dk(dk), _invdk(1./dk)
     {
         if (N<=0) throw FFTError("KTable size <=0");
@@ -127,38 +580,45 @@ namespace galsim {
         Nout = 2*((Nout+1)/2);
         int Nouto2 = Nout>>1;
         boost::shared_ptr<KTable> out(new KTable(Nout, _dk, std::complex<double>(0.,0.)));
-        for (int iyin=-_No2; iyin<_No2; ++iyin) {
-            int iyout = iyin;
-            while (iyout < -Nouto2) iyout += Nout;
-            while (iyout >= Nouto2) iyout -= Nout;
-            int ixin = 0;
-            while (ixin < _No2) {
-                // number of points to accumulate without conjugation:
-                // Do points that do *not* need to be conjugated:
-                int nx = std::min(_No2-ixin+1, Nouto2+1);
-                const std::complex<double>* inptr = _array.get() + index(ixin,iyin);
-                std::complex<double>* outptr = out->_array.get() + out->index(0,iyout);
-                for (int i=0; i<nx; ++i) {
+        for (int iyin=-_No2; iyin<_No2; ++iyin)
+            out->accumulateWrapped(_array.get() + index(0,iyin), 0, _No2+1, _N, iyin);
+        return out;
+    }
+
+    void KTable::accumulateWrapped(const std::complex<double>* vals, int ix1, int ix2,
+                                   int Nin, int iyin)
+    {
+        clearCache(); // invalidate any stored interpolations
+        check_array();
+        const int Nino2 = Nin>>1;
+        int iyout = iyin;
+        while (iyout < -_No2) iyout += _N;
+        while (iyout >= _No2) iyout -= _N;
+        // The input ix values are folded in chunks of _No2+1 points, starting at ixc.
+        // Alternate chunks go forwards without conjugation and backwards (from ix = _No2
+        // at -iyout) with conjugation.  Note that the end points of the chunks are used twice.
+        bool conjugate = false;
+        for (int ixc=0; ixc < Nino2; ixc += _No2, conjugate = !conjugate) {
+            const int i1 = std::max(ix1, ixc);
+            const int i2 = std::min(ix2, std::min(ixc+_No2, Nino2)+1);
+            if (i1 >= i2) continue;
+            const std::complex<double>* inptr = vals + (i1-ix1);
+            if (!conjugate) {
+                std::complex<double>* outptr = _array.get() + index(i1-ixc, iyout);
+                for (int i=i1; i<i2; ++i) {
                     *outptr += *inptr;
                     ++inptr;
                     ++outptr;
                 }
-                ixin += Nouto2;
-                if (ixin >= _No2) break;
-                // Now do any points that *do* need conjugation
-                // such that output storage locations go backwards
-                inptr = _array.get() + index(ixin,iyin);
-                outptr = out->_array.get() + out->index(Nouto2, -iyout);
-                nx = std::min(_No2-ixin+1, Nouto2+1);
-                for (int i=0; i<nx; ++i) {
+            } else {
+                std::complex<double>* outptr = _array.get() + index(_No2-(i1-ixc), -iyout);
+                for (int i=i1; i<i2; ++i) {
                     *outptr += conj(*inptr);
                     ++inptr;
                     --outptr;
                 }
-                ixin += Nouto2;
             }
         }
-        return out;
     }
 
     boost::shared_ptr<XTable> XTable::wrap(int Nout) const 
@@ -299,6 +759,20 @@ namespace galsim {
     std::complex<double> KTable::interpolate(
         double kx, double ky, const Interpolant2d& interp) const 
     {
+#ifdef _OPENMP
+        // The cache can't be shared by several threads, so don't use it in a parallel region.
+        if (omp_in_parallel()) {
+            InterpolationCache<std::complex<double> > cache;
+            return interpolate(kx, ky, interp, cache);
+        }
+#endif
+        return interpolate(kx, ky, interp, _cache);
+    }
+
+    std::complex<double> KTable::interpolate(
+        double kx, double ky, const Interpolant2d& interp,
+        InterpolationCache<std::complex<double> >& cache) const
+    {
         dbg<<"Start KTable interpolate at "<<kx<<','<<ky<<std::endl;
         dbg<<"N = "<<_N<<std::endl;
         dbg<<"interp xrage = "<<interp.xrange()<<std::endl;
@@ -352,22 +826,22 @@ namespace galsim {
             // We have the opportunity to speed up the calculation by
             // re-using the sums over rows.  So we will keep a 
             // cache of them.
-            if (kx != _cacheX || ixy != _cacheInterp) {
-                clearCache();
-                _cacheX = kx;
-                _cacheInterp = ixy;
-            } else if (iyMax==iyMin+1 && !_cache.empty()) {
+            if (kx != cache.x || ixy != cache.interp) {
+                cache.clear();
+                cache.x = kx;
+                cache.interp = ixy;
+            } else if (iyMax==iyMin+1 && !cache.sums.empty()) {
                 // Special case for interpolation on a single iy value:
                 // See if we already have this row in cache:
-                int index = iyMin - _cacheStartY;
+                int index = iyMin - cache.startY;
                 if (index < 0) index += _N;
-                if (index < int(_cache.size()))
+                if (index < int(cache.sums.size()))
                     // We have it!
-                    return _cache[index];
+                    return cache.sums[index];
                 else
                     // Desired row not in cache - kill cache, continue as normal.
                     // (But don't clear xwt, since that's still good.)
-                    _cache.clear();
+                    cache.sums.clear();
             }
 
             const bool simple_xval = ixy->xrange() <= _Nd;
@@ -377,8 +851,8 @@ namespace galsim {
             if (nx<=0) nx += _N;
             dbg<<"nx = "<<nx<<std::endl;
             // This is also cached if possible.  It gets cleared when kx != cacheX above.
-            if (_xwt.empty()) {
-                _xwt.resize(nx);
+            if (cache.xwt.empty()) {
+                cache.xwt.resize(nx);
                 int ix = ixMin;
                 if (simple_xval) {
                     // Then simple xval is fine (and faster)
@@ -388,30 +862,30 @@ namespace galsim {
                     for (int i=0; i<nx; ++i, ++ix, ++arg) {
                         dbg<<"Call xval for arg = "<<arg<<std::endl;
                         if (arg > _halfNd) arg -= _Nd;
-                        _xwt[i] = ixy->xval1d(arg);
-                        dbg<<"xwt["<<i<<"] = "<<_xwt[i]<<std::endl;
+                        cache.xwt[i] = ixy->xval1d(arg);
+                        dbg<<"xwt["<<i<<"] = "<<cache.xwt[i]<<std::endl;
                     }
                 } else {
                     // Then might need to wrap to do the sum that's in xvalWrapped...
                     for (int i=0; i<nx; ++i, ++ix) {
                         dbg<<"Call xvalWrapped1d for ix-kx = "<<ix<<" - "<<kx<<" = "<<
                             ix-kx<<std::endl;
-                        _xwt[i] = ixy->xvalWrapped1d(ix-kx, _N);
-                        dbg<<"xwt["<<i<<"] = "<<_xwt[i]<<std::endl;
+                        cache.xwt[i] = ixy->xvalWrapped1d(ix-kx, _N);
+                        dbg<<"xwt["<<i<<"] = "<<cache.xwt[i]<<std::endl;
                     }
                 }
             } else {
-                assert(int(_xwt.size()) == nx);
+                assert(int(cache.xwt.size()) == nx);
             }
 
             // cache always holds sequential y values (with wrap).  Throw away
             // elements until we get to the one we need first
-            std::deque<std::complex<double> >::iterator nextSaved = _cache.begin();
-            while (nextSaved != _cache.end() && _cacheStartY != iyMin) {
-                _cache.pop_front();
-                ++_cacheStartY;
-                if (_cacheStartY >= _No2) _cacheStartY -= _N;
-                nextSaved = _cache.begin();
+            std::deque<std::complex<double> >::iterator nextSaved = cache.sums.begin();
+            while (nextSaved != cache.sums.end() && cache.startY != iyMin) {
+                cache.sums.pop_front();
+                ++cache.startY;
+                if (cache.startY >= _No2) cache.startY -= _N;
+                nextSaved = cache.sums.begin();
             }
 
             // Accumulate sum of 
@@ -432,7 +906,7 @@ namespace galsim {
                 if (iy >= _No2) iy -= _N;   // wrap iy if needed
                 dbg<<"ny = "<<ny<<", iy = "<<iy<<std::endl;
                 std::complex<double> sumy = 0.;
-                if (nextSaved != _cache.end()) {
+                if (nextSaved != cache.sums.end()) {
                     // This row is cached
                     sumy = *nextSaved;
                     ++nextSaved;
@@ -444,15 +918,15 @@ namespace galsim {
                     for (int i=0; i<nx; ++i, ++ix) {
                         if (ix > N/2) ix -= N; //check for wrap
                         dbg<<"i = "<<i<<", ix = "<<ix<<std::endl;
-                        dbg<<"xwt = "<<_xwt[i]<<", kval = "<<kval(ix,iy)<<std::endl;
-                        sumy += _xwt[i]*kval(ix,iy);
+                        dbg<<"xwt = "<<cache.xwt[i]<<", kval = "<<kval(ix,iy)<<std::endl;
+                        sumy += cache.xwt[i]*kval(ix,iy);
                         dbg<<"index = "<<index(ix,iy)<<", sumy -> "<<sumy<<std::endl;
                     }
 #else
 
                     // Faster way using ptrs, which doesn't need to do index(ix,iy) every time.
                     int count = nx;
-                    const double* xwt_it = &_xwt[0];
+                    const double* xwt_it = &cache.xwt[0];
                     // First do any initial negative ix values:
                     if (ix < 0) {
                         dbg<<"Some initial negative ix: ix = "<<ix<<std::endl;
@@ -486,12 +960,12 @@ namespace galsim {
                             //xwt_it += count;
                         }
                     }
-                    //xassert(xwt_it == &_xwt[0] + _xwt.size());
+                    //xassert(xwt_it == &cache.xwt[0] + cache.xwt.size());
 #endif
                     // Add to back of cache
-                    if (_cache.empty()) _cacheStartY = iy;
-                    _cache.push_back(sumy);
-                    nextSaved = _cache.end();
+                    if (cache.sums.empty()) cache.startY = iy;
+                    cache.sums.push_back(sumy);
+                    nextSaved = cache.sums.end();
                 }
                 if (simple_xval) {
                     if (arg > _halfNd) arg -= _Nd;
@@ -819,6 +1293,19 @@ namespace galsim {
     // x any y in physical units (to be divided by dx for indices)
     double XTable::interpolate(double x, double y, const Interpolant2d& interp) const 
     {
+#ifdef _OPENMP
+        // The cache can't be shared by several threads, so don't use it in a parallel region.
+        if (omp_in_parallel()) {
+            InterpolationCache<double> cache;
+            return interpolate(x, y, interp, cache);
+        }
+#endif
+        return interpolate(x, y, interp, _cache);
+    }
+
+    double XTable::interpolate(double x, double y, const Interpolant2d& interp,
+                               InterpolationCache<double>& cache) const
+    {
         xdbg << "interpolating " << x << " " << y << " " << std::endl;
         x *= _invdx;
         y *= _invdx;
@@ -854,61 +1341,61 @@ namespace galsim {
             // We have the opportunity to speed up the calculation by
             // re-using the sums over rows.  So we will keep a 
             // cache of them.
-            if (x != _cacheX || ixy != _cacheInterp) {
-                clearCache();
-                _cacheX = x;
-                _cacheInterp = ixy;
-            } else if (iyMax==iyMin && !_cache.empty()) {
+            if (x != cache.x || ixy != cache.interp) {
+                cache.clear();
+                cache.x = x;
+                cache.interp = ixy;
+            } else if (iyMax==iyMin && !cache.sums.empty()) {
                 // Special case for interpolation on a single iy value:
                 // See if we already have this row in cache:
-                int index = iyMin - _cacheStartY;
+                int index = iyMin - cache.startY;
                 if (index < 0) index += _N;
-                if (index < int(_cache.size())) 
+                if (index < int(cache.sums.size())) 
                     // We have it!
-                    return _cache[index];
+                    return cache.sums[index];
                 else
                     // Desired row not in cache - kill cache, continue as normal.
                     // (But don't clear xwt, since that's still good.)
-                    _cache.clear();
+                    cache.sums.clear();
             }
 
             // Build x factors for interpolant
             int nx = ixMax - ixMin + 1;
             // This is also cached if possible.  It gets cleared when kx != cacheX above.
-            if (_xwt.empty()) {
-                _xwt.resize(nx);
+            if (cache.xwt.empty()) {
+                cache.xwt.resize(nx);
                 for (int i=0; i<nx; ++i) 
-                    _xwt[i] = ixy->xval1d(i+ixMin-x);
+                    cache.xwt[i] = ixy->xval1d(i+ixMin-x);
             } else {
-                assert(int(_xwt.size()) == nx);
+                assert(int(cache.xwt.size()) == nx);
             }
 
             // cache always holds sequential y values (no wrap).  Throw away
             // elements until we get to the one we need first
-            std::deque<double>::iterator nextSaved = _cache.begin();
-            while (nextSaved != _cache.end() && _cacheStartY != iyMin) {
-                _cache.pop_front();
-                ++_cacheStartY;
-                nextSaved = _cache.begin();
+            std::deque<double>::iterator nextSaved = cache.sums.begin();
+            while (nextSaved != cache.sums.end() && cache.startY != iyMin) {
+                cache.sums.pop_front();
+                ++cache.startY;
+                nextSaved = cache.sums.begin();
             }
 
             for (int iy=iyMin; iy<=iyMax; ++iy) {
                 double sumy = 0.;
-                if (nextSaved != _cache.end()) {
+                if (nextSaved != cache.sums.end()) {
                     // This row is cached
                     sumy = *nextSaved;
                     ++nextSaved;
                 } else {
                     // Need to compute a new row's sum
                     const double* dptr = _array.get() + index(ixMin, iy);
-                    std::vector<double>::const_iterator xwt_it = _xwt.begin();
+                    std::vector<double>::const_iterator xwt_it = cache.xwt.begin();
                     int count = nx;
                     for(; count; --count) sumy += (*xwt_it++) * (*dptr++);
-                    xassert(xwt_it == _xwt.end());
+                    xassert(xwt_it == cache.xwt.end());
                     // Add to back of cache
-                    if (_cache.empty()) _cacheStartY = iy;
-                    _cache.push_back(sumy);
-                    nextSaved = _cache.end();
+                    if (cache.sums.empty()) cache.startY = iy;
+                    cache.sums.push_back(sumy);
+                    nextSaved = cache.sums.end();
                 }
                 sum += sumy * ixy->xval1d(iy-y);
             }
@@ -1015,14 +1502,11 @@ namespace galsim {
 
         XTable xt( _N, 2.*M_PI*_invNd*_invdk );
 
-        // Note: The fftw_execute function is the only thread-safe FFTW routine.
-        // So if we decide to go with some kind of multi-threading (rather than multi-process
-        // parallelism) all of the plan creation and destruction calls in this file 
-        // will need to be placed in critical blocks or the equivalent (mutex locks, etc.).
-        fftw_plan plan = fftw_plan_dft_c2r_2d(
-            _N, _N, t_array.get_fftw(), xt._array.get_fftw(), FFTW_MEASURE);
-        if (plan==NULL) throw FFTInvalid();
-        fftw_destroy_plan(plan);
+        // The measured plan replaces any cached plan for this transform.
+        if (NumFFTThreads(_N) > 1)
+            MeasureThreadedPlans(true, _N, t_array.get(), xt._array.get());
+        else
+            MeasurePlan(KtoX, _N, 0, t_array.get_fftw(), xt._array.get_fftw());
     }
 
     // Fourier transform from (complex) k to x:
@@ -1035,34 +1519,24 @@ namespace galsim {
         assert(_N==xt.getN());
 
         // We'll need a new k array because FFTW kills the k array in this
-        // operation.  Also, to put x=0 in center of array, we need to flop
-        // every other sign of k array, and need to scale.
+        // operation.
         dbg<<"Before make t_array"<<std::endl;
         FFTW_Array<std::complex<double> > t_array(_N*(_No2+1));
         dbg<<"After make t_array"<<std::endl;
-        double fac = _dk * _dk / (4*M_PI*M_PI);
-        long int ind=0;
-        dbg<<"t_array.size = "<<t_array.size()<<std::endl;
-        for (int iy=0; iy<_N; ++iy) {
-            dbg<<"ind = "<<ind<<std::endl;
-            for (int ix=0; ix<=_No2; ++ix) {
-                if ( (ix+iy)%2==0) t_array[ind]=fac * _array[ind];
-                else t_array[ind] = -fac* _array[ind];
-                ++ind;
-            }
-        }
+        fillTransformArray(t_array.get());
         dbg<<"After fill t_array"<<std::endl;
 
-        fftw_plan plan = fftw_plan_dft_c2r_2d(
-            _N, _N, t_array.get_fftw(), xt._array.get_fftw(), FFTW_ESTIMATE);
-        dbg<<"After make plan"<<std::endl;
-        if (plan==NULL) throw FFTInvalid();
-
         // Run the transform:
-        fftw_execute(plan);
+        PlanUser user;
+        const int nthreads = NumFFTThreads(_N);
+        if (nthreads > 1) {
+            ThreadedKtoX(_N, t_array.get(), xt._array.get(), nthreads, 0, _N);
+        } else {
+            fftw_plan plan = GetPlan(KtoX, _N, 0, t_array.get_fftw(), xt._array.get_fftw());
+            dbg<<"After get plan"<<std::endl;
+            fftw_execute_dft_c2r(plan, t_array.get_fftw(), xt._array.get_fftw());
+        }
         dbg<<"After exec plan"<<std::endl;
-        fftw_destroy_plan(plan);
-        dbg<<"After destroy plan"<<std::endl;
 
         xt._dx = 2.*M_PI*_invNd*_invdk;
         dbg<<"Done transform"<<std::endl;
@@ -1076,6 +1550,121 @@ namespace galsim {
         return xt;
     }
 
+    // Only calculate the rows iymin..iymax of the XTable.
+    void KTable::transform(XTable& xt, int iymin, int iymax) const
+    {
+        check_array();
+        assert(_N==xt.getN());
+        if (iymin < -_No2 || iymax >= _No2 || iymin > iymax)
+            FormatAndThrow<FFTError>() << "KTable::transform invalid rows " << iymin <<
+                ".." << iymax << " for N=" << _N;
+
+        FFTW_Array<std::complex<double> > t_array(_N*(_No2+1));
+        fillTransformArray(t_array.get());
+        // Always do this one as a series of 1D transforms, skipping the rows we don't need.
+        xt.clearCache();
+        PlanUser user;
+        ThreadedKtoX(_N, t_array.get(), xt._array.get(), NumFFTThreads(_N),
+                     iymin+_No2, iymax+_No2+1);
+
+        xt._dx = 2.*M_PI*_invNd*_invdk;
+        dbg<<"Done partial transform"<<std::endl;
+    }
+
+    // To put x=0 in center of array, we need to flop every other sign of k array,
+    // and need to scale.
+    template <typename T>
+    void KTable::fillTransformArray(std::complex<T>* t) const
+    {
+        double fac = _dk * _dk / (4*M_PI*M_PI);
+        long int ind=0;
+        for (int iy=0; iy<_N; ++iy) {
+            for (int ix=0; ix<=_No2; ++ix) {
+                if ( (ix+iy)%2==0) t[ind] = std::complex<T>(fac * _array[ind]);
+                else t[ind] = std::complex<T>(-fac * _array[ind]);
+                ++ind;
+            }
+        }
+    }
+
+    boost::shared_ptr<XTableF> KTable::transformFloat() const
+    {
+        check_array();
+        boost::shared_ptr<XTableF> xt(new XTableF(_N, 2.*M_PI*_invNd*_invdk));
+#ifdef USE_FFTWF
+        FFTW_Array<std::complex<float> > t_array(_N*(_No2+1));
+        fillTransformArray(t_array.get());
+        PlanUser user;
+        fftwf_plan plan = GetFloatPlan(_N, t_array.get(), xt->_array.get());
+        fftwf_execute_dft_c2r(plan, reinterpret_cast<fftwf_complex*>(t_array.get()),
+                              xt->_array.get());
+#else
+        // Without single-precision FFTW, do the transform in double precision.
+        XTable xtd(_N, xt->_dx);
+        transform(xtd);
+        const double* x = xtd.getArray();
+        std::copy(x, x+_N*_N, xt->_array.get());
+#endif
+        return xt;
+    }
+
+    XTableF::XTableF(int N, double dx) : _dx(dx)
+    {
+        if (N<=0) throw FFTError("XTableF size <=0");
+        _N = ((N+1)>>1)<<1; //Round size up to even.
+        _No2 = _N>>1;
+        _array.resize(_N*_N);
+    }
+
+    void KTable::transformMany(const std::vector<boost::shared_ptr<KTable> >& kt,
+                               std::vector<boost::shared_ptr<XTable> >& xt)
+    {
+        const int nk = kt.size();
+        dbg<<"Start transformMany for "<<nk<<" tables"<<std::endl;
+        xt.resize(nk);
+        if (nk == 0) return;
+        const int N = kt[0]->_N;
+        for (int i=0; i<nk; ++i) {
+            kt[i]->check_array();
+            if (kt[i]->_N != N)
+                throw FFTError("KTable::transformMany requires KTables of the same size");
+        }
+
+        // Copy all the tables into one big array, one after another.
+        const long ksize = long(N)*(N/2+1);
+        const long xsize = long(N)*N;
+        FFTW_Array<std::complex<double> > t_array(nk*ksize);
+        FFTW_Array<double> x_array(nk*xsize);
+        for (int i=0; i<nk; ++i) kt[i]->fillTransformArray(t_array.get() + i*ksize);
+
+        PlanUser user;
+        const int nthreads = std::min(getFFTThreads(), nk);
+        if (nthreads > 1) {
+            // Split the tables among the threads, using the plans for a single transform.
+            // Get these first, since the planner is not thread safe.
+            std::vector<fftw_plan> plans(nk);
+            for (int i=0; i<nk; ++i)
+                plans[i] = GetPlan(KtoX, N, 0, t_array.get() + i*ksize, x_array.get() + i*xsize);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+            for (int i=0; i<nk; ++i) {
+                fftw_complex* c = reinterpret_cast<fftw_complex*>(t_array.get() + i*ksize);
+                fftw_execute_dft_c2r(plans[i], c, x_array.get() + i*xsize);
+            }
+        } else {
+            fftw_plan plan = GetPlan(KtoXMany, N, nk, t_array.get_fftw(), x_array.get_fftw());
+            fftw_execute_dft_c2r(plan, t_array.get_fftw(), x_array.get_fftw());
+        }
+
+        for (int i=0; i<nk; ++i) {
+            xt[i].reset(new XTable(N, 2.*M_PI*kt[i]->_invNd*kt[i]->_invdk));
+            const double* x = x_array.get() + i*xsize;
+            std::copy(x, x+xsize, xt[i]->_array.get());
+        }
+        dbg<<"Done transformMany"<<std::endl;
+    }
+
     void XTable::fftwMeasure() const 
     {
         // Make a new copy of data array since measurement will overwrite:
@@ -1085,11 +1674,11 @@ namespace galsim {
 
         KTable kt( _N, 2.*M_PI*_invNd*_invdx );
 
-        fftw_plan plan = fftw_plan_dft_r2c_2d(
-            _N,_N, t_array.get_fftw(), kt._array.get_fftw(), FFTW_MEASURE);
-        if (plan==NULL) throw FFTInvalid();
-
-        fftw_destroy_plan(plan);
+        // The measured plan replaces any cached plan for this transform.
+        if (NumFFTThreads(_N) > 1)
+            MeasureThreadedPlans(false, _N, t_array.get(), kt._array.get());
+        else
+            MeasurePlan(XtoK, _N, 0, t_array.get_fftw(), kt._array.get_fftw());
     }
 
     // Fourier transform from x back to (complex) k:
@@ -1100,11 +1689,14 @@ namespace galsim {
         // Make a new copy of data array since measurement will overwrite:
         FFTW_Array<double> t_array = _array;
 
-        fftw_plan plan = fftw_plan_dft_r2c_2d(
-            _N,_N, t_array.get_fftw(), kt._array.get_fftw(), FFTW_ESTIMATE);
-        if (plan==NULL) throw FFTInvalid();
-        fftw_execute(plan);
-        fftw_destroy_plan(plan);
+        PlanUser user;
+        const int nthreads = NumFFTThreads(_N);
+        if (nthreads > 1) {
+            ThreadedXtoK(_N, t_array.get(), kt._array.get(), nthreads);
+        } else {
+            fftw_plan plan = GetPlan(XtoK, _N, 0, t_array.get_fftw(), kt._array.get_fftw());
+            fftw_execute_dft_r2c(plan, t_array.get_fftw(), kt._array.get_fftw());
+        }
 
         // Now scale the k spectrum and flip signs for x=0 in middle.
         double fac = _dx * _dx; 
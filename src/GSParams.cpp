@@ -36,7 +36,10 @@ namespace galsim {
                        double _shoot_accuracy,
                        double _allowed_flux_variation,
                        int _range_division_for_extrema,
-                       double _small_fraction_of_flux) :
+                       double _small_fraction_of_flux,
+                       bool _single_precision_fft,
+                       bool _gaussian_mixture,
+                       bool _choose_draw_method) :
         minimum_fft_size(_minimum_fft_size),
         maximum_fft_size(_maximum_fft_size),
         folding_threshold(_folding_threshold),
@@ -52,7 +55,10 @@ namespace galsim {
         shoot_accuracy(_shoot_accuracy),
         allowed_flux_variation(_allowed_flux_variation),
         range_division_for_extrema(_range_division_for_extrema),
-        small_fraction_of_flux(_small_fraction_of_flux)
+        small_fraction_of_flux(_small_fraction_of_flux),
+        single_precision_fft(_single_precision_fft),
+        gaussian_mixture(_gaussian_mixture),
+        choose_draw_method(_choose_draw_method)
     {}
 
     bool GSParams::operator==(const GSParams& rhs) const
@@ -79,6 +85,9 @@ namespace galsim {
         else if (allowed_flux_variation != rhs.allowed_flux_variation) return false;
         else if (range_division_for_extrema != rhs.range_division_for_extrema) return false;
         else if (small_fraction_of_flux != rhs.small_fraction_of_flux) return false;
+        else if (single_precision_fft != rhs.single_precision_fft) return false;
+        else if (gaussian_mixture != rhs.gaussian_mixture) return false;
+        else if (choose_draw_method != rhs.choose_draw_method) return false;
         else return true;
     }
 
@@ -117,6 +126,12 @@ namespace galsim {
         else if (range_division_for_extrema > rhs.range_division_for_extrema) return false;
         else if (small_fraction_of_flux < rhs.small_fraction_of_flux) return true;
         else if (small_fraction_of_flux > rhs.small_fraction_of_flux) return false;
+        else if (single_precision_fft < rhs.single_precision_fft) return true;
+        else if (single_precision_fft > rhs.single_precision_fft) return false;
+        else if (gaussian_mixture < rhs.gaussian_mixture) return true;
+        else if (gaussian_mixture > rhs.gaussian_mixture) return false;
+        else if (choose_draw_method < rhs.choose_draw_method) return true;
+        else if (choose_draw_method > rhs.choose_draw_method) return false;
         else return false;
     }
 
@@ -131,7 +146,10 @@ namespace galsim {
             << gsp.integration_relerr << "," << gsp.integration_abserr << ",  "
             << gsp.shoot_accuracy << "," 
             << gsp.allowed_flux_variation << "," << gsp.range_division_for_extrema << ","
-            << gsp.small_fraction_of_flux;
+            << gsp.small_fraction_of_flux << ",  "
+            << (gsp.single_precision_fft ? "True" : "False") << ","
+            << (gsp.gaussian_mixture ? "True" : "False") << ","
+            << (gsp.choose_draw_method ? "True" : "False");
         return os;
     }
 
@@ -0,0 +1,191 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+//#define DEBUGLOGGING
+
+#include <complex>
+#include <algorithm>
+#include <sstream>
+#include "Hankel.h"
+#include "FFT.h"
+#include "Std.h"
+
+namespace galsim {
+
+    namespace {
+
+        // log(Gamma(z)) for complex z with Re(z) > 0.  Shift z up to |z| >= 15 with the
+        // recurrence Gamma(z+1) = z Gamma(z), and then use the Stirling series.  We only ever
+        // need exp() of this, so the branch of the log doesn't matter.
+        std::complex<double> LogGamma(std::complex<double> z)
+        {
+            std::complex<double> shift = 0.;
+            while (std::abs(z) < 15.) {
+                shift -= std::log(z);
+                z += 1.;
+            }
+            std::complex<double> zinv = 1./z;
+            std::complex<double> zinv2 = zinv*zinv;
+            std::complex<double> series =
+                zinv * (1./12. - zinv2 * (1./360. - zinv2 * (1./1260. - zinv2 / 1680.)));
+            return (z-0.5)*std::log(z) - z + 0.5*std::log(2.*M_PI) + series + shift;
+        }
+
+        // The Mellin transform of J0 that FFTLog needs:
+        // int_0^inf x^(i w) J0(x) dx = 2^(i w) Gamma((1+i w)/2) / Gamma((1-i w)/2)
+        std::complex<double> MellinJ0(double w)
+        {
+            std::complex<double> iw(0., w);
+            return std::exp(iw * std::log(2.) + LogGamma(0.5*(1.+iw)) - LogGamma(0.5*(1.-iw)));
+        }
+
+        // An in-place, unnormalized forward FFT of length N.
+        void FFT1d(std::vector<std::complex<double> >& data)
+        {
+            fftw_complex* ptr = reinterpret_cast<fftw_complex*>(&data[0]);
+            fftw_plan plan;
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+            plan = fftw_plan_dft_1d(int(data.size()), ptr, ptr, FFTW_FORWARD, FFTW_ESTIMATE);
+            if (!plan) throw FFTInvalid();
+            fftw_execute(plan);
+#ifdef _OPENMP
+#pragma omp critical (galsim_fftw_plan)
+#endif
+            fftw_destroy_plan(plan);
+        }
+    }
+
+    void HankelTransform::initGrid(double rmin, double rmax, double kmin, double kmax,
+                                   double& logr_c, double& dlogr, int& N)
+    {
+        assert(rmin > 0. && rmax > rmin && kmin > 0. && kmax > kmin);
+        // The grid in k is k_j = exp(-logr_c + (j-N/2) dlogr), so it covers [kmin,kmax] if the
+        // grid in r covers [1/kmax, 1/kmin].
+        double lo = std::min(std::log(rmin), -std::log(kmax));
+        double hi = std::max(std::log(rmax), -std::log(kmin));
+        // Leave some room at the ends, where the results are affected by the wrapping around
+        // of the other end.
+        lo -= 2.;
+        hi += 2.;
+        logr_c = 0.5 * (lo+hi);
+        dlogr = sbp::hankel_initial_dlogr;
+        N = 2;
+        while (N * dlogr < hi-lo) N *= 2;
+        dbg<<"HankelTransform: r = "<<std::exp(lo)<<" .. "<<std::exp(hi);
+        dbg<<", initial N = "<<N<<std::endl;
+    }
+
+    // Replace a_n = r_n f(r_n) with k_j F(k_j), where r_n = exp(logr_c + (n-N/2) dlogr)
+    // and k_j = exp(-logr_c + (j-N/2) dlogr).
+    //
+    // Write a(r) as its Fourier series in log(r), a(r) = Sum_m c_m exp(i w_m (log(r)-logr_c)),
+    // with w_m = 2pi m/(N dlogr).  Then each term can be done analytically:
+    // k F(k) = int a(r) J0(kr) k dr
+    //        = Sum_m c_m exp(-i w_m (log(k)+logr_c)) int_0^inf x^(i w_m) J0(x) dx
+    // So it is an FFT to get the c_m, a multiplication, and another FFT to do the sum.
+    void HankelTransform::transform(std::vector<double>& a, double dlogr)
+    {
+        const int N = a.size();
+        dbg<<"HankelTransform: N = "<<N<<", dlogr = "<<dlogr<<std::endl;
+        std::vector<std::complex<double> > c(a.begin(), a.end());
+        FFT1d(c);
+        // Since the grids are centered on n = N/2, both the c_m and the final sum pick up
+        // factors of exp(i pi m) = (-1)^m, which cancel.  That leaves just the 1/N.
+        const double dw = 2.*M_PI / (N*dlogr);
+        for (int m=0; m<N; ++m) {
+            int mm = m <= N/2 ? m : m-N;
+            c[m] *= MellinJ0(mm*dw) / double(N);
+        }
+        // The Nyquist term should be real for the result to be real.
+        c[N/2] = c[N/2].real();
+        FFT1d(c);
+        for (int j=0; j<N; ++j) a[j] = c[j].real();
+    }
+
+    // The largest difference between two successive results for k in [kmin, kmax].
+    // fine has twice as many points as coarse, at half the spacing dlogr.
+    double HankelTransform::compare(
+        const std::vector<double>& coarse, const std::vector<double>& fine,
+        double logr_c, double dlogr, double kmin, double kmax)
+    {
+        const int N = fine.size();
+        double logkmin = std::log(kmin);
+        double logkmax = std::log(kmax);
+        double err = 0.;
+        for (int j=0; j<N; j+=2) {
+            double logk = -logr_c + (j-N/2) * dlogr;
+            if (logk < logkmin || logk > logkmax) continue;
+            double diff = std::abs(coarse[j/2] - fine[j]) * std::exp(-logk);
+            if (diff > err) err = diff;
+        }
+        dbg<<"HankelTransform: error = "<<err<<std::endl;
+        return err;
+    }
+
+    void HankelTransform::buildTable(const std::vector<double>& ft, double logr_c, double dlogr,
+                                     double kmin, double kmax)
+    {
+        const int N = ft.size();
+        // Include one more point at each end, so the table covers [kmin, kmax].
+        double logkmin = std::log(kmin) - dlogr;
+        double logkmax = std::log(kmax) + dlogr;
+        for (int j=0; j<N; ++j) {
+            double logk = -logr_c + (j-N/2) * dlogr;
+            if (logk < logkmin || logk > logkmax) continue;
+            _table.addEntry(logk, ft[j] * std::exp(-logk));
+        }
+    }
+
+    void HankelTransform::throwNotConverged(double error, double accuracy, int N)
+    {
+        std::ostringstream oss;
+        oss << "Unable to reach the required accuracy " << accuracy << " with " << N
+            << " points.  The last change was " << error << ".  "
+            << "Try a larger integration_abserr in the GSParams.";
+        throw HankelError(oss.str());
+    }
+
+    double HankelTransform::operator()(double k) const
+    {
+        double val;
+        double logk = std::log(k);
+        if (logk < _table.argMin()) val = _table(_table.argMin());
+        else if (logk > _table.argMax()) val = 0.;
+        else val = _table(logk);
+
+        if (_truncated) {
+            // Add back the transform of c0 + c1 (R^2-r^2) for r < R:
+            // int_0^R r J0(kr) dr = R J1(kR) / k
+            // int_0^R (R^2-r^2) r J0(kr) dr = 2 R^2 J2(kR) / k^2
+            double kR = k * _rmax;
+            double Rsq = _rmax * _rmax;
+            if (kR < 1.e-4) {
+                // Use the Taylor series of J1(x)/x and J2(x)/x^2 at small x.
+                double kRsq = kR*kR;
+                val += _c0 * Rsq * (0.5 - kRsq/16.) + _c1 * Rsq*Rsq * (0.25 - kRsq/48.);
+            } else {
+                val += _c0 * _rmax * j1(kR) / k + _c1 * 2. * Rsq * jn(2,kR) / (k*k);
+            }
+        }
+        return val;
+    }
+
+}
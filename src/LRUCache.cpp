@@ -0,0 +1,49 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#include "LRUCache.h"
+#include <algorithm>
+
+namespace galsim {
+
+    // The caches are mostly static objects, so this needs to be constructed on first use
+    // to be sure it exists before any of them register themselves.
+    static std::vector<LRUCacheBase*>& Registry()
+    {
+        static std::vector<LRUCacheBase*> registry;
+        return registry;
+    }
+
+    LRUCacheBase::LRUCacheBase(const std::string& name) : _name(name)
+    {
+        if (_name != "") Registry().push_back(this);
+    }
+
+    LRUCacheBase::~LRUCacheBase()
+    {
+        if (_name != "") {
+            std::vector<LRUCacheBase*>& registry = Registry();
+            registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+        }
+    }
+
+    const std::vector<LRUCacheBase*>& LRUCacheBase::getRegistry()
+    { return Registry(); }
+
+}
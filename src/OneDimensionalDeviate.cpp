@@ -315,8 +315,8 @@ namespace galsim {
             }
         }
         dbg<<"Total of "<<_pt.size()<<" intervals\n";
-        // Build the ProbabilityTree
-        _pt.buildTree();
+        // Build the AliasTable
+        _pt.buildTable();
     }
 
     boost::shared_ptr<PhotonArray> OneDimensionalDeviate::shoot(int N, UniformDeviate ud) const 
@@ -333,47 +333,66 @@ namespace galsim {
         double fluxPerPhoton = totalAbsoluteFlux / N;
         dbg<<"fluxPerPhoton = "<<fluxPerPhoton<<std::endl;
 
-        // For each photon, first decide which Interval it's in, then drawWithin the interval.
-        for (int i=0; i<N; i++) {
+        // Work through the photons in blocks.  For each block, first draw all the uniform
+        // deviates, then decide which Interval each photon is in, then drawWithin the intervals.
+        // Keeping the steps separate lets the Interval selection run as a tight loop over
+        // arrays rather than being interleaved with the random number generation.
+        const int block = 256;
+        double u[block];
+        double xu[block];
+        double yu[block];
+        const Interval* chosen[block];
+        for (int i0=0; i0<N; i0+=block) {
+            const int n = std::min(block, N-i0);
             if (_isRadial) {
 #ifdef USE_COS_SIN
-                double unitRandom = ud();
-                Interval* chosen = _pt.find(unitRandom);
-                // Now draw a radius from within selected interval
-                double radius, flux;
-                chosen->drawWithin(unitRandom, radius, flux, ud);
-                // Draw second ud to get azimuth 
-                double theta = 2.*M_PI*ud();
-                double sintheta, costheta;
-                (theta * radians).sincos(sintheta,costheta);
-                result->setPhoton(i, radius*costheta, radius*sintheta, flux*fluxPerPhoton);
+                for (int k=0; k<n; ++k) {
+                    u[k] = ud();
+                    // Draw second ud to get azimuth
+                    xu[k] = 2.*M_PI*ud();
+                }
+                _pt.findMany(u, chosen, n);
+                for (int k=0; k<n; ++k) {
+                    // Now draw a radius from within selected interval
+                    double radius, flux;
+                    chosen[k]->drawWithin(u[k], radius, flux, ud);
+                    double sintheta, costheta;
+                    (xu[k] * radians).sincos(sintheta,costheta);
+                    result->setPhoton(i0+k, radius*costheta, radius*sintheta, flux*fluxPerPhoton);
+                }
 #else
                 // Alternate method: doesn't need sin & cos but needs sqrt
-                // First get a point uniformly distributed in unit circle
-                double xu, yu, rsq;
-                do {
-                    xu = 2.*ud()-1.;
-                    yu = 2.*ud()-1.;
-                    rsq = xu*xu+yu*yu;
-                } while (rsq>=1. || rsq==0.);
-                // Now rsq is unit deviate from 0 to 1
-                double unitRandom = rsq;
-                const Interval* chosen = _pt.find(unitRandom);
-                // Now draw a radius from within selected interval
-                double radius, flux;
-                chosen->drawWithin(unitRandom, radius, flux, ud);
-                // Rescale x & y:
-                double rScale = radius / std::sqrt(rsq);
-                result->setPhoton(i, xu*rScale, yu*rScale, flux*fluxPerPhoton);
-#endif            
+                // First get points uniformly distributed in unit circle
+                for (int k=0; k<n; ++k) {
+                    double rsq;
+                    do {
+                        xu[k] = 2.*ud()-1.;
+                        yu[k] = 2.*ud()-1.;
+                        rsq = xu[k]*xu[k]+yu[k]*yu[k];
+                    } while (rsq>=1. || rsq==0.);
+                    // Now rsq is unit deviate from 0 to 1
+                    u[k] = rsq;
+                }
+                _pt.findMany(u, chosen, n);
+                for (int k=0; k<n; ++k) {
+                    // Now draw a radius from within selected interval
+                    double radius, flux;
+                    chosen[k]->drawWithin(u[k], radius, flux, ud);
+                    // Rescale x & y:
+                    double rScale = radius / std::sqrt(xu[k]*xu[k]+yu[k]*yu[k]);
+                    result->setPhoton(i0+k, xu[k]*rScale, yu[k]*rScale, flux*fluxPerPhoton);
+                }
+#endif
             } else {
                 // Simple 1d interpolation
-                double unitRandom = ud();
-                const Interval* chosen = _pt.find(unitRandom);
-                // Now draw an x from within selected interval
-                double x, flux;
-                chosen->drawWithin(unitRandom, x, flux, ud);
-                result->setPhoton(i, x, 0., flux*fluxPerPhoton);
+                for (int k=0; k<n; ++k) u[k] = ud();
+                _pt.findMany(u, chosen, n);
+                for (int k=0; k<n; ++k) {
+                    // Now draw an x from within selected interval
+                    double x, flux;
+                    chosen[k]->drawWithin(u[k], x, flux, ud);
+                    result->setPhoton(i0+k, x, 0., flux*fluxPerPhoton);
+                }
             }
         }
         dbg<<"OneDimentionalDeviate Realized flux = "<<result->getTotalFlux()<<std::endl;
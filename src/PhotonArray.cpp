@@ -26,6 +26,10 @@
 #include <numeric>
 #include "PhotonArray.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef DEBUGLOGGING
 #include <fstream>
 //std::ostream* dbgout = new std::ofstream("debug.out");
@@ -34,21 +38,191 @@
 
 namespace galsim {
 
+    namespace {
+
+        // The start of each photon buffer is aligned to this many bytes, which is enough for
+        // any of the current SIMD instruction sets.
+        const size_t photon_alignment = 64;
+
+        // Don't keep more than this many unused buffers in the pool.
+        const size_t max_pooled_buffers = 16;
+
+        // Capacities are rounded up to a power of 2 (but at least this much), so arrays made
+        // for successive batches of similar sizes can share the same buffers.
+        const int min_photon_capacity = 64;
+
+        int RoundCapacity(int N)
+        {
+            int capacity = min_photon_capacity;
+            while (capacity < N && capacity < (1<<29)) capacity *= 2;
+            // Keep each of the three arrays aligned if N is very large.
+            if (capacity < N) capacity = ((N+7)/8)*8;
+            return capacity;
+        }
+
+        size_t BlockSize(int capacity)
+        { return 3 * size_t(capacity) * sizeof(double) + photon_alignment; }
+
+        double* AlignedStart(char* block)
+        {
+            size_t addr = reinterpret_cast<size_t>(block);
+            size_t offset = (photon_alignment - addr % photon_alignment) % photon_alignment;
+            return reinterpret_cast<double*>(block + offset);
+        }
+
+        // A simple pool of memory blocks for PhotonArrays.  drawShoot makes many arrays of the
+        // same size (one or more per batch of photons), so getting their memory from here
+        // means that the allocations are only done once per drawShoot call (or not at all
+        // for repeated calls), rather than once per batch.
+        class PhotonPool
+        {
+        public:
+            ~PhotonPool() { clear(); }
+
+            char* get(int capacity)
+            {
+                char* block = 0;
+#ifdef _OPENMP
+#pragma omp critical (galsim_photon_pool)
+#endif
+                {
+                    for (size_t k=0; k<_free.size(); ++k) {
+                        if (_free[k].first == capacity) {
+                            block = _free[k].second;
+                            _free[k] = _free.back();
+                            _free.pop_back();
+                            break;
+                        }
+                    }
+                }
+                if (!block) {
+                    xdbg<<"PhotonPool: new block with capacity "<<capacity<<std::endl;
+                    block = new char[BlockSize(capacity)];
+                }
+                return block;
+            }
+
+            void put(char* block, int capacity)
+            {
+                bool kept = false;
+#ifdef _OPENMP
+#pragma omp critical (galsim_photon_pool)
+#endif
+                {
+                    if (_free.size() < max_pooled_buffers) {
+                        _free.push_back(std::make_pair(capacity, block));
+                        kept = true;
+                    }
+                }
+                if (!kept) delete [] block;
+            }
+
+            void clear()
+            {
+#ifdef _OPENMP
+#pragma omp critical (galsim_photon_pool)
+#endif
+                {
+                    for (size_t k=0; k<_free.size(); ++k) delete [] _free[k].second;
+                    _free.clear();
+                }
+            }
+
+        private:
+            std::vector<std::pair<int,char*> > _free;
+        };
+
+        PhotonPool& GetPhotonPool()
+        {
+            static PhotonPool pool;
+            return pool;
+        }
+
+    }
+
+    void PhotonArray::clearPool()
+    { GetPhotonPool().clear(); }
+
+    PhotonArray::PhotonArray(int N) :
+        _N(0), _capacity(0), _block(0), _x(0), _y(0), _flux(0), _is_correlated(false)
+    {
+        allocate(N);
+        _N = N;
+        std::fill(_x, _x+_N, 0.);
+        std::fill(_y, _y+_N, 0.);
+        std::fill(_flux, _flux+_N, 0.);
+    }
+
     PhotonArray::PhotonArray(
         std::vector<double>& vx, std::vector<double>& vy, std::vector<double>& vflux) :
-        _is_correlated(false)
+        _N(0), _capacity(0), _block(0), _x(0), _y(0), _flux(0), _is_correlated(false)
     {
         if (vx.size() != vy.size() || vx.size() != vflux.size())
             throw std::runtime_error("Size mismatch of input vectors to PhotonArray");
-        _x = vx;
-        _y = vy;
-        _flux = vflux;
+        allocate(vx.size());
+        _N = vx.size();
+        std::copy(vx.begin(), vx.end(), _x);
+        std::copy(vy.begin(), vy.end(), _y);
+        std::copy(vflux.begin(), vflux.end(), _flux);
+    }
+
+    PhotonArray::PhotonArray(const PhotonArray& rhs) :
+        _N(0), _capacity(0), _block(0), _x(0), _y(0), _flux(0),
+        _is_correlated(rhs._is_correlated)
+    {
+        allocate(rhs._N);
+        _N = rhs._N;
+        std::copy(rhs._x, rhs._x+_N, _x);
+        std::copy(rhs._y, rhs._y+_N, _y);
+        std::copy(rhs._flux, rhs._flux+_N, _flux);
+    }
+
+    PhotonArray& PhotonArray::operator=(const PhotonArray& rhs)
+    {
+        if (this == &rhs) return *this;
+        _N = 0;  // So allocate doesn't bother copying the current values.
+        allocate(rhs._N);
+        _N = rhs._N;
+        std::copy(rhs._x, rhs._x+_N, _x);
+        std::copy(rhs._y, rhs._y+_N, _y);
+        std::copy(rhs._flux, rhs._flux+_N, _flux);
+        _is_correlated = rhs._is_correlated;
+        return *this;
+    }
+
+    PhotonArray::~PhotonArray()
+    {
+        if (_block) GetPhotonPool().put(_block, _capacity);
+    }
+
+    void PhotonArray::allocate(int N)
+    {
+        if (N <= _capacity) return;
+        int capacity = RoundCapacity(N);
+        char* block = GetPhotonPool().get(capacity);
+        double* x = AlignedStart(block);
+        double* y = x + capacity;
+        double* flux = y + capacity;
+        if (_N > 0) {
+            std::copy(_x, _x+_N, x);
+            std::copy(_y, _y+_N, y);
+            std::copy(_flux, _flux+_N, flux);
+        }
+        if (_block) GetPhotonPool().put(_block, _capacity);
+        _block = block;
+        _capacity = capacity;
+        _x = x;
+        _y = y;
+        _flux = flux;
     }
 
+    void PhotonArray::reserve(int N)
+    { allocate(N); }
+
     double PhotonArray::getTotalFlux() const 
     {
         double total = 0.;
-        return std::accumulate(_flux.begin(), _flux.end(), total);
+        return std::accumulate(_flux, _flux+_N, total);
     }
 
     void PhotonArray::setTotalFlux(double flux) 
@@ -60,35 +234,24 @@ namespace galsim {
 
     void PhotonArray::scaleFlux(double scale)
     {
-        for (std::vector<double>::size_type i=0; i<_flux.size(); i++) {
-            _flux[i] *= scale;
-        }
+        for (int i=0; i<_N; i++) _flux[i] *= scale;
     }
 
     void PhotonArray::scaleXY(double scale)
     {
-        for (std::vector<double>::size_type i=0; i<_x.size(); i++) {
-            _x[i] *= scale;
-        }
-        for (std::vector<double>::size_type i=0; i<_y.size(); i++) {
-            _y[i] *= scale;
-        }
+        for (int i=0; i<_N; i++) _x[i] *= scale;
+        for (int i=0; i<_N; i++) _y[i] *= scale;
     }
 
     void PhotonArray::append(const PhotonArray& rhs) 
     {
         if (rhs.size()==0) return;      // Nothing needed for empty RHS.
         int oldSize = size();
-        int finalSize = oldSize + rhs.size();
-        _x.resize(finalSize);
-        _y.resize(finalSize);
-        _flux.resize(finalSize);
-        std::vector<double>::iterator destination=_x.begin()+oldSize;
-        std::copy(rhs._x.begin(), rhs._x.end(), destination);
-        destination=_y.begin()+oldSize;
-        std::copy(rhs._y.begin(), rhs._y.end(), destination);
-        destination=_flux.begin()+oldSize;
-        std::copy(rhs._flux.begin(), rhs._flux.end(), destination);
+        allocate(oldSize + rhs.size());
+        std::copy(rhs._x, rhs._x+rhs._N, _x+oldSize);
+        std::copy(rhs._y, rhs._y+rhs._N, _y+oldSize);
+        std::copy(rhs._flux, rhs._flux+rhs._N, _flux+oldSize);
+        _N = oldSize + rhs._N;
     }
 
     void PhotonArray::convolve(const PhotonArray& rhs, UniformDeviate ud) 
@@ -102,17 +265,11 @@ namespace galsim {
         if (rhs.size() != N) 
             throw std::runtime_error("PhotonArray::convolve with unequal size arrays");
         // Add x coordinates:
-        std::vector<double>::iterator lIter = _x.begin();
-        std::vector<double>::const_iterator rIter = rhs._x.begin();
-        for ( ; lIter!=_x.end(); ++lIter, ++rIter) *lIter += *rIter;
+        for (int i=0; i<N; ++i) _x[i] += rhs._x[i];
         // Add y coordinates:
-        lIter = _y.begin();
-        rIter = rhs._y.begin();
-        for ( ; lIter!=_y.end(); ++lIter, ++rIter) *lIter += *rIter;
+        for (int i=0; i<N; ++i) _y[i] += rhs._y[i];
         // Multiply fluxes, with a factor of N needed:
-        lIter = _flux.begin();
-        rIter = rhs._flux.begin();
-        for ( ; lIter!=_flux.end(); ++lIter, ++rIter) *lIter *= *rIter*N;
+        for (int i=0; i<N; ++i) _flux[i] *= rhs._flux[i]*N;
 
         // If rhs was correlated, then the output will be correlated.
         // This is ok, but we need to mark it as such.
@@ -161,8 +318,11 @@ namespace galsim {
         }
     }
 
+    // Below this many photons, the extra bookkeeping of the parallel binning isn't worth it.
+    static const int min_photons_for_parallel_addto = 10000;
+
     template <class T>
-    double PhotonArray::addTo(ImageView<T>& target) const 
+    double PhotonArray::addTo(ImageView<T>& target, int nthreads) const 
     {
         Bounds<int> b = target.getBounds();
 
@@ -170,6 +330,11 @@ namespace galsim {
             throw std::runtime_error("Attempting to PhotonArray::addTo an Image with"
                                      " undefined Bounds");
 
+#if defined(_OPENMP) && !defined(DEBUGLOGGING)
+        if (nthreads != 1 && size() >= min_photons_for_parallel_addto)
+            return addToParallel(target, nthreads);
+#endif
+
         // Factor to turn flux into surface brightness in an Image pixel
         dbg<<"In PhotonArray::addTo\n";
         dbg<<"bounds = "<<b<<std::endl;
@@ -224,8 +389,92 @@ namespace galsim {
         return addedFlux;
     }
 
+    template <class T>
+    double PhotonArray::addToParallel(ImageView<T>& target, int nthreads) const 
+    {
+#ifdef _OPENMP
+        if (nthreads <= 0) nthreads = omp_get_max_threads();
+#endif
+        dbg<<"In PhotonArray::addToParallel with nthreads = "<<nthreads<<"\n";
+        const Bounds<int> b = target.getBounds();
+        const int ymin = b.getYMin();
+        const int ny = b.getYMax() - ymin + 1;
+        const int N = size();
+
+        // The rows are split into nthreads stripes, and each thread adds the photons that land
+        // in one stripe.  No two threads ever write to the same pixel, so no locks or atomics
+        // are required.  To avoid every thread scanning all the photons, they are first
+        // bucketed by stripe with a counting sort that keeps them in their original order, so
+        // each pixel receives its photons in the same order as in the serial version.
+        // The photons are split into nthreads chunks for the counting and bucketing.
+        const int nt = std::max(nthreads, 1);
+        std::vector<int> ix(N);
+        std::vector<int> iy(N);
+        std::vector<int> stripe(N);
+        std::vector<int> count(nt*nt, 0);  // count[c*nt+s] = photons in chunk c and stripe s
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+        for (int c=0; c<nt; ++c) {
+            const int i1 = int((long(N) * c) / nt);
+            const int i2 = int((long(N) * (c+1)) / nt);
+            for (int i=i1; i<i2; ++i) {
+                ix[i] = int(floor(_x[i] + 0.5));
+                iy[i] = int(floor(_y[i] + 0.5));
+                if (b.includes(ix[i],iy[i])) {
+                    stripe[i] = int((long(iy[i]-ymin) * nt) / ny);
+                    ++count[c*nt+stripe[i]];
+                } else {
+                    stripe[i] = -1;
+                }
+            }
+        }
+
+        // Turn the counts into the starting positions of each (stripe, chunk) in the sorted
+        // order.  Stripe s runs from start[s] to start[s+1].
+        std::vector<int> start(nt+1);
+        int pos = 0;
+        for (int s=0; s<nt; ++s) {
+            start[s] = pos;
+            for (int c=0; c<nt; ++c) {
+                int n = count[c*nt+s];
+                count[c*nt+s] = pos;
+                pos += n;
+            }
+        }
+        start[nt] = pos;
+
+        std::vector<int> order(pos);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+        for (int c=0; c<nt; ++c) {
+            const int i1 = int((long(N) * c) / nt);
+            const int i2 = int((long(N) * (c+1)) / nt);
+            for (int i=i1; i<i2; ++i) {
+                if (stripe[i] >= 0) order[count[c*nt+stripe[i]]++] = i;
+            }
+        }
+
+        // The total added flux is summed serially in photon order, so it doesn't depend on
+        // the number of threads either.
+        double addedFlux = 0.;
+        for (int i=0; i<N; ++i) if (stripe[i] >= 0) addedFlux += _flux[i];
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+#endif
+        for (int s=0; s<nt; ++s) {
+            for (int k=start[s]; k<start[s+1]; ++k) {
+                const int i = order[k];
+                target(ix[i],iy[i]) += _flux[i];
+            }
+        }
+        return addedFlux;
+    }
+
     // instantiate template functions for expected image types
-    template double PhotonArray::addTo(ImageView<float>& image) const;
-    template double PhotonArray::addTo(ImageView<double>& image) const;
+    template double PhotonArray::addTo(ImageView<float>& image, int nthreads) const;
+    template double PhotonArray::addTo(ImageView<double>& image, int nthreads) const;
 
 }
@@ -88,6 +88,27 @@ namespace galsim {
         clearCache();
     }
 
+    void BaseDeviate::seed64(unsigned long long key)
+    {
+        // Fill the state from a splitmix64 stream.  Its first value is a bijection of key.
+        // x[0] only contributes its top bit to the state of the Mersenne Twister, so the
+        // 64-bit values start at x[1].
+        const int n = rng_type::state_size;
+        std::vector<unsigned int> state(n, 0);
+        for (int i=1; i<n; i+=2) {
+            key += 0x9e3779b97f4a7c15ULL;
+            unsigned long long z = key;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            z ^= z >> 31;
+            state[i] = (unsigned int)(z & 0xffffffffULL);
+            if (i+1 < n) state[i+1] = (unsigned int)(z >> 32);
+        }
+        std::vector<unsigned int>::iterator it = state.begin();
+        _rng->seed(it, state.end());
+        clearCache();
+    }
+
     // Next two functions shamelessly stolen from
     // http://stackoverflow.com/questions/236129/split-a-string-in-c
     std::vector<std::string>& split(const std::string& s, char delim,
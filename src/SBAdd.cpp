@@ -54,6 +54,35 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBAdd::SBAddImpl::simplify(SBProfile& result) const
+    {
+        // The SBAdd constructor flattens any summands that simplify to an SBAdd.
+        std::list<SBProfile> slist;
+        bool changed = false;
+        for (ConstIter sptr = _plist.begin(); sptr!=_plist.end(); ++sptr) {
+            slist.push_back(sptr->simplify());
+            if (GetImpl(slist.back()) != GetImpl(*sptr)) changed = true;
+        }
+        if (slist.size() == 1) result = slist.front();
+        else if (changed) result = SBAdd(slist, gsparams);
+        else return false;
+        return true;
+    }
+
+    bool SBAdd::SBAddImpl::getGaussianSum(std::list<SBProfile>& terms) const
+    {
+        // Summands may be Gaussians or sums of Gaussians themselves (e.g. a sheared one).
+        std::list<SBProfile> all_terms;
+        double flux, cxx, cxy, cyy;
+        Position<double> cen;
+        for (ConstIter sptr = _plist.begin(); sptr!=_plist.end(); ++sptr) {
+            if (GetImpl(*sptr)->getGaussian(flux,cxx,cxy,cyy,cen)) all_terms.push_back(*sptr);
+            else if (!GetImpl(*sptr)->getGaussianSum(all_terms)) return false;
+        }
+        terms.insert(terms.end(),all_terms.begin(),all_terms.end());
+        return true;
+    }
+
     SBAdd::SBAddImpl::SBAddImpl(const std::list<SBProfile>& slist,
                                 const GSParamsPtr& gsparams) :
         SBProfileImpl(gsparams ? gsparams : GetImpl(slist.front())->gsparams)
@@ -224,8 +253,10 @@ namespace galsim {
         double totalAbsoluteFlux = getPositiveFlux() + getNegativeFlux();
         double fluxPerPhoton = totalAbsoluteFlux / N;
 
-        // Initialize the output array
+        // Initialize the output array.  Reserve room for all N photons so the appends below
+        // don't need to reallocate.
         boost::shared_ptr<PhotonArray> result(new PhotonArray(0));
+        result->reserve(N);
 
         double remainingAbsoluteFlux = totalAbsoluteFlux;
         int remainingN = N;
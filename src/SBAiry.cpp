@@ -102,7 +102,7 @@ namespace galsim {
     }
 
     LRUCache< std::pair<double, GSParamsPtr>, AiryInfo > SBAiry::SBAiryImpl::cache(
-        sbp::max_airy_cache);
+        sbp::max_airy_cache, "airy");
 
     // This is a scale-free version of the Airy radial function.
     // Input radius is in units of lambda/D.  Output normalized
@@ -189,6 +189,7 @@ namespace galsim {
             fillKValueQuadrant(val,kx0,dkx,izero,ky0,dky,jzero);
         } else {
             xdbg<<"Non-Quadrant\n";
+            if (fillKValueRadial(val,kx0,dkx,ky0,dky)) return;
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
@@ -245,6 +246,7 @@ namespace galsim {
         dbg<<"SBAiry fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
+        if (fillKValueRadial(val,kx0,dkx,dkxy,ky0,dky,dkyx)) return;
         assert(val.stepi() == 1);
         assert(val.canLinearize());
         const int m = val.colsize();
@@ -386,7 +388,12 @@ namespace galsim {
     boost::shared_ptr<PhotonArray> AiryInfo::shoot(
         int N, UniformDeviate u) const
     {
-        // Use the OneDimensionalDeviate to sample from scale-free distribution
+        // Use the OneDimensionalDeviate to sample from scale-free distribution.
+        // The sampler is built on first use.  drawShoot may call this from several threads
+        // at once, so only let one of them build it.
+#ifdef _OPENMP
+#pragma omp critical (galsim_airy_sampler)
+#endif
         checkSampler();
         assert(_sampler.get());
         return _sampler->shoot(N, u);
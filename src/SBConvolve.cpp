@@ -22,6 +22,12 @@
 #include "SBConvolve.h"
 #include "SBConvolveImpl.h"
 #include "SBTransform.h"
+#include "SBGaussian.h"
+#include "SBAdd.h"
+#include "LRUCache.h"
+#include <vector>
+#include <sstream>
+#include <limits>
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -32,8 +38,8 @@
 namespace galsim {
 
     SBConvolve::SBConvolve(const std::list<SBProfile>& slist, bool real_space,
-                           const GSParamsPtr& gsparams) :
-        SBProfile(new SBConvolveImpl(slist,real_space,gsparams)) {}
+                           const GSParamsPtr& gsparams, const std::list<SBProfile>& shared) :
+        SBProfile(new SBConvolveImpl(slist,real_space,gsparams,shared)) {}
 
     SBConvolve::SBConvolve(const SBConvolve& rhs) : SBProfile(rhs) {}
 
@@ -63,17 +69,125 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBConvolve::SBConvolveImpl::simplify(SBProfile& result) const
+    {
+        // Gaussians convolve to a Gaussian whose flux is the product of the fluxes, and
+        // whose covariance and center are the sums of theirs.  Collect them all into one,
+        // which goes where the first one was.
+        // Shared items are left as they are, so their cached k values stay valid.
+        // If the other items are all sums of Gaussians (e.g. Gaussian mixture approximations
+        // to a galaxy and a PSF), the convolution is distributed over the sums to make a sum
+        // of Gaussians.
+        std::list<SBProfile> slist, shared;
+        std::vector<std::list<SBProfile> > gsums;
+        bool all_gaussian = true;
+        long nterms = 1;
+        Iter gptr = slist.end();
+        int ngauss = 0;
+        double gflux = 1., gcxx = 0., gcxy = 0., gcyy = 0.;
+        Position<double> gcen;
+        bool changed = false;
+        int k = 0;
+        for (ConstIter pptr = _plist.begin(); pptr != _plist.end(); ++pptr, ++k) {
+            if (_cache_keys[k] != 0) {
+                slist.push_back(*pptr);
+                shared.push_back(*pptr);
+                all_gaussian = false;
+                continue;
+            }
+            SBProfile p = pptr->simplify();
+            if (GetImpl(p) != GetImpl(*pptr)) changed = true;
+            double flux, cxx, cxy, cyy;
+            Position<double> cen;
+            if (GetImpl(p)->getGaussian(flux,cxx,cxy,cyy,cen)) {
+                gflux *= flux;
+                gcxx += cxx;
+                gcxy += cxy;
+                gcyy += cyy;
+                gcen += cen;
+                if (++ngauss == 1) gptr = slist.insert(slist.end(),p);
+            } else {
+                slist.push_back(p);
+                std::list<SBProfile> terms;
+                if (GetImpl(p)->getGaussianSum(terms)) {
+                    gsums.push_back(terms);
+                    nterms *= terms.size();
+                } else {
+                    all_gaussian = false;
+                }
+            }
+        }
+        if (all_gaussian && !gsums.empty() && nterms <= sbp::max_gaussian_mixture_terms) {
+            dbg<<"Distributing convolution over "<<gsums.size()<<" sums of Gaussians, "
+                <<"making "<<nterms<<" terms"<<std::endl;
+            // Start with the combination of the single Gaussians (a delta function if none)
+            // and convolve with each sum in turn.
+            std::vector<double> flux(1,gflux), cxx(1,gcxx), cxy(1,gcxy), cyy(1,gcyy);
+            std::vector<Position<double> > cen(1,gcen);
+            for (size_t i=0; i<gsums.size(); ++i) {
+                std::vector<double> flux2, cxx2, cxy2, cyy2;
+                std::vector<Position<double> > cen2;
+                for (ConstIter tptr = gsums[i].begin(); tptr != gsums[i].end(); ++tptr) {
+                    double f, xx, xy, yy;
+                    Position<double> c;
+                    GetImpl(*tptr)->getGaussian(f,xx,xy,yy,c);
+                    for (size_t j=0; j<flux.size(); ++j) {
+                        flux2.push_back(flux[j] * f);
+                        cxx2.push_back(cxx[j] + xx);
+                        cxy2.push_back(cxy[j] + xy);
+                        cyy2.push_back(cyy[j] + yy);
+                        cen2.push_back(cen[j] + c);
+                    }
+                }
+                flux.swap(flux2);
+                cxx.swap(cxx2);
+                cxy.swap(cxy2);
+                cyy.swap(cyy2);
+                cen.swap(cen2);
+            }
+            std::list<SBProfile> terms;
+            for (size_t j=0; j<flux.size(); ++j)
+                terms.push_back(MakeEllipticalGaussian(flux[j],cxx[j],cxy[j],cyy[j],cen[j],
+                                                       gsparams));
+            result = SBAdd(terms,gsparams);
+            return true;
+        }
+        if (ngauss > 1) {
+            dbg<<"Combining "<<ngauss<<" Gaussians in convolution"<<std::endl;
+            *gptr = MakeEllipticalGaussian(gflux,gcxx,gcxy,gcyy,gcen,gsparams);
+            changed = true;
+        }
+        // The SBConvolve constructor flattens any components that simplified to an SBConvolve.
+        if (slist.size() == 1) result = slist.front();
+        else if (changed) result = SBConvolve(slist,_real_space,gsparams,shared);
+        else return false;
+        return true;
+    }
+
     SBConvolve::SBConvolveImpl::SBConvolveImpl(const std::list<SBProfile>& slist, bool real_space,
-                                               const GSParamsPtr& gsparams) :
+                                               const GSParamsPtr& gsparams,
+                                               const std::list<SBProfile>& shared) :
         SBProfileImpl(gsparams ? gsparams : GetImpl(slist.front())->gsparams),
         _real_space(real_space)
     {
-        for (ConstIter sptr = slist.begin(); sptr!=slist.end(); ++sptr)
-            add(*sptr);
+        for (ConstIter sptr = slist.begin(); sptr!=slist.end(); ++sptr) {
+            bool is_shared = false;
+            for (ConstIter s2 = shared.begin(); s2!=shared.end(); ++s2)
+                if (GetImpl(*s2) == GetImpl(*sptr)) is_shared = true;
+            add(*sptr, is_shared);
+        }
         initialize();
     }
 
-    void SBConvolve::SBConvolveImpl::add(const SBProfile& rhs)
+    // The hash of a shared item's serialization, which identifies it in the KGridCache.
+    // (0 is kept to mean an item that isn't shared.)
+    static unsigned long long HashItem(const SBProfile& item)
+    {
+        unsigned long long h = HashString(item.serialize());
+        return h == 0 ? 1 : h;
+    }
+
+    void SBConvolve::SBConvolveImpl::add(const SBProfile& rhs, bool shared)
     {
         dbg<<"Start SBConvolveImpl::add.  Adding item # "<<_plist.size()+1<<std::endl;
 
@@ -85,7 +199,15 @@ namespace galsim {
             dynamic_cast<const SBAutoConvolve::SBAutoConvolveImpl*>(p);
         const SBAutoCorrelate::SBAutoCorrelateImpl* sbc3 =
             dynamic_cast<const SBAutoCorrelate::SBAutoCorrelateImpl*>(p);
-        if (sbc) {
+        if (shared) {
+            dbg<<"  (Item is shared.)"<<std::endl;
+            if (!rhs.isAnalyticK() && !_real_space)
+                throw SBError("SBConvolve requires members to be analytic in k");
+            if (!rhs.isAnalyticX() && _real_space)
+                throw SBError("Real-space SBConvolve requires members to be analytic in x");
+            _plist.push_back(rhs);
+            _cache_keys.push_back(HashItem(rhs));
+        } else if (sbc) {
             dbg<<"  (Item is really "<<sbc->_plist.size()<<" items.)"<<std::endl;
             // If rhs is an SBConvolve, copy its list here
             for (ConstIter pptr = sbc->_plist.begin(); pptr!=sbc->_plist.end(); ++pptr) {
@@ -95,6 +217,7 @@ namespace galsim {
                     throw SBError("Real_space SBConvolve requires members to be analytic in x");
                 _plist.push_back(*pptr);
             }
+            _cache_keys.insert(_cache_keys.end(),sbc->_cache_keys.begin(),sbc->_cache_keys.end());
         } else if (sbc2) {
             dbg<<"  (Item is really AutoConvolve.)"<<std::endl;
             // If rhs is an SBAutoConvolve, put two of its item here:
@@ -105,6 +228,7 @@ namespace galsim {
                 throw SBError("Real_space SBConvolve requires members to be analytic in x");
             _plist.push_back(obj);
             _plist.push_back(obj);
+            _cache_keys.resize(_plist.size());
         } else if (sbc3) {
             dbg<<"  (Item is really AutoCorrelate items.)"<<std::endl;
             // If rhs is an SBAutoCorrelate, put its item and 180 degree rotated verion here:
@@ -116,12 +240,14 @@ namespace galsim {
             _plist.push_back(obj);
             SBProfile temp = obj.rotate(180. * degrees);
             _plist.push_back(temp);
+            _cache_keys.resize(_plist.size());
         } else {
             if (!rhs.isAnalyticK() && !_real_space)
                 throw SBError("SBConvolve requires members to be analytic in k");
             if (!rhs.isAnalyticX() && _real_space)
                 throw SBError("Real-space SBConvolve requires members to be analytic in x");
             _plist.push_back(rhs);
+            _cache_keys.push_back(0);
         }
     }
 
@@ -171,6 +297,26 @@ namespace galsim {
             throw SBError("Real-space integration of more than 2 profiles is not implemented.");
     }
 
+    // The real-space integrals typically need a few hundred evaluations of the integrand
+    // for each xValue.
+    static const double real_space_integrand_evals = 300.;
+
+    double SBConvolve::SBConvolveImpl::xValueCost() const
+    {
+        double cost = 0.;
+        for (ConstIter pptr = _plist.begin(); pptr != _plist.end(); ++pptr)
+            cost += GetImpl(*pptr)->xValueCost();
+        return _plist.size() > 1 ? real_space_integrand_evals * cost : cost;
+    }
+
+    double SBConvolve::SBConvolveImpl::kValueCost() const
+    {
+        double cost = 0.;
+        for (ConstIter pptr = _plist.begin(); pptr != _plist.end(); ++pptr)
+            cost += GetImpl(*pptr)->kValueCost();
+        return cost;
+    }
+
     std::complex<double> SBConvolve::SBConvolveImpl::kValue(const Position<double>& k) const
     {
         ConstIter pptr = _plist.begin();
@@ -180,6 +326,338 @@ namespace galsim {
         return kv;
     }
 
+    // The key of a grid in the KGridCache: the item's hash, and the arguments of the
+    // fillKValue call that made it (with jzero < 0 for the general affine version).
+    struct KGridKey
+    {
+        unsigned long long item;
+        int m, n, jzero;
+        double kx0, dkx, dkxy, ky0, dky, dkyx;
+
+        bool operator<(const KGridKey& rhs) const
+        {
+            if (item != rhs.item) return item < rhs.item;
+            if (m != rhs.m) return m < rhs.m;
+            if (n != rhs.n) return n < rhs.n;
+            if (jzero != rhs.jzero) return jzero < rhs.jzero;
+            if (kx0 != rhs.kx0) return kx0 < rhs.kx0;
+            if (dkx != rhs.dkx) return dkx < rhs.dkx;
+            if (dkxy != rhs.dkxy) return dkxy < rhs.dkxy;
+            if (ky0 != rhs.ky0) return ky0 < rhs.ky0;
+            if (dky != rhs.dky) return dky < rhs.dky;
+            return dkyx < rhs.dkyx;
+        }
+    };
+
+    // A cache of the k values of shared SBConvolve items, keyed by the item and the k grid.
+    // The total size of the saved grids is kept under a budget in bytes by removing the least
+    // recently used ones.  Unlike the other caches, the size and maxSize reported in the
+    // cache statistics are in bytes.  As for LRUCache, if a thread asks for a grid that
+    // another thread is already filling, it waits for that one rather than filling its own.
+    class KGridCache : public LRUCacheBase
+    {
+    public:
+        typedef tmv::Matrix<std::complex<double> > Grid;
+
+        KGridCache(size_t budget) : LRUCacheBase("kgrid"), _budget(budget), _bytes(0)
+        {
+#ifdef _OPENMP
+            omp_init_lock(&_lock);
+#endif
+        }
+
+        ~KGridCache()
+        {
+#ifdef _OPENMP
+            omp_destroy_lock(&_lock);
+#endif
+        }
+
+        // The function that fills a grid, which is SBConvolveImpl::fillItemKValue.
+        typedef void (*FillFunction)(const SBProfile&, tmv::MatrixView<std::complex<double> >,
+                                     double, double, double, double, double, double, int);
+
+        // Get the grid for key, filling it with the k values of prof if it isn't saved.
+        boost::shared_ptr<const Grid> get(const KGridKey& key, const SBProfile& prof,
+                                          FillFunction fill_func)
+        {
+            const size_t nbytes = size_t(key.m) * key.n * sizeof(std::complex<double>)
+                + sizeof(Entry) + sizeof(KGridKey);
+            lock();
+            MapIter iter = _cache.find(key);
+            if (iter != _cache.end()) {
+                _entries.splice(_entries.begin(), _entries, iter->second);
+                boost::shared_ptr<Slot> slot = iter->second->slot;
+                if (slot->grid) {
+                    ++_stats.hits;
+                    unlock();
+                    return slot->grid;
+                }
+                // Another thread is filling this grid.  Wait for it to finish.
+                ++_stats.waits;
+                unlock();
+                slot->wait();
+                if (slot->grid) return slot->grid;
+                // The other thread's fill failed.  Try again ourselves, which will
+                // most likely raise the same exception here.
+                return get(key, prof, fill_func);
+            }
+            ++_stats.misses;
+            if (nbytes > _budget) {
+                // Too big to save, so just fill it.
+                unlock();
+                return fill(key, prof, fill_func);
+            }
+            // Add a placeholder for the grid, so other threads asking for it will wait for us.
+            makeRoom(_budget - nbytes);
+            boost::shared_ptr<Slot> slot(new Slot());
+            _entries.push_front(Entry(key,slot,nbytes));
+            _cache[key] = _entries.begin();
+            _bytes += nbytes;
+            unlock();
+
+            boost::shared_ptr<const Grid> grid;
+            Stopwatch timer;
+            timer.start();
+            try {
+                grid = fill(key, prof, fill_func);
+            } catch (...) {
+                // Remove the placeholder, so the next request tries again.
+                lock();
+                iter = _cache.find(key);
+                if (iter != _cache.end() && iter->second->slot == slot) remove(iter);
+                unlock();
+                slot->done();
+                throw;
+            }
+            timer.stop();
+            lock();
+            slot->grid = grid;
+            _stats.build_time += timer;
+            unlock();
+            slot->done();
+            return grid;
+        }
+
+        void setBudget(size_t budget)
+        {
+            lock();
+            _budget = budget;
+            makeRoom(budget);
+            unlock();
+        }
+
+        size_t getBudget() const { return _budget; }
+
+        void clear()
+        {
+            lock();
+            _entries.clear();
+            _cache.clear();
+            _bytes = 0;
+            unlock();
+        }
+
+        LRUCacheStats getStats() const
+        {
+            lock();
+            LRUCacheStats stats = _stats;
+            unlock();
+            return stats;
+        }
+
+        void resetStats()
+        {
+            lock();
+            _stats = LRUCacheStats();
+            unlock();
+        }
+
+        size_t size() const
+        {
+            lock();
+            size_t nbytes = _bytes;
+            unlock();
+            return nbytes;
+        }
+
+        size_t maxSize() const { return _budget; }
+
+    private:
+        // A saved grid, which is empty while it is being filled.
+        // While it is being filled, the filling thread holds its lock.
+        struct Slot
+        {
+            boost::shared_ptr<const Grid> grid;
+#ifdef _OPENMP
+            omp_lock_t filling;
+            Slot() { omp_init_lock(&filling); omp_set_lock(&filling); }
+            ~Slot() { omp_destroy_lock(&filling); }
+            void done() { omp_unset_lock(&filling); }
+            void wait() { omp_set_lock(&filling); omp_unset_lock(&filling); }
+#else
+            void done() {}
+            void wait() {}
+#endif
+        };
+
+        struct Entry
+        {
+            Entry(const KGridKey& k, const boost::shared_ptr<Slot>& s, size_t nb) :
+                key(k), slot(s), nbytes(nb) {}
+            KGridKey key;
+            boost::shared_ptr<Slot> slot;
+            size_t nbytes;
+        };
+
+        typedef std::list<Entry>::iterator ListIter;
+        typedef std::map<KGridKey, ListIter>::iterator MapIter;
+
+        static boost::shared_ptr<const Grid> fill(const KGridKey& key, const SBProfile& prof,
+                                                  FillFunction fill_func)
+        {
+            boost::shared_ptr<Grid> grid(new Grid(key.m,key.n));
+            fill_func(prof,grid->view(),key.kx0,key.dkx,key.dkxy,key.ky0,key.dky,key.dkyx,
+                      key.jzero);
+            return grid;
+        }
+
+        // Only call these while holding the lock.
+        void remove(MapIter iter)
+        {
+            _bytes -= iter->second->nbytes;
+            _entries.erase(iter->second);
+            _cache.erase(iter);
+        }
+
+        // Remove the least recently used grids until at most nbytes are used.
+        void makeRoom(size_t nbytes)
+        {
+            while (_bytes > nbytes && !_entries.empty()) {
+                _bytes -= _entries.back().nbytes;
+                _cache.erase(_entries.back().key);
+                _entries.pop_back();
+                ++_stats.evictions;
+            }
+        }
+
+#ifdef _OPENMP
+        void lock() const { omp_set_lock(&_lock); }
+        void unlock() const { omp_unset_lock(&_lock); }
+        mutable omp_lock_t _lock;
+#else
+        void lock() const {}
+        void unlock() const {}
+#endif
+
+        size_t _budget;
+        size_t _bytes;
+        LRUCacheStats _stats;
+
+        std::list<Entry> _entries;
+        std::map<KGridKey, ListIter> _cache;
+    };
+
+    static KGridCache kgrid_cache(256 << 20);
+
+    void SetKGridCacheBudget(size_t nbytes) { kgrid_cache.setBudget(nbytes); }
+    size_t GetKGridCacheBudget() { return kgrid_cache.getBudget(); }
+    void ClearKGridCache() { kgrid_cache.clear(); }
+
+    // Each thread keeps scratch space for the tiles of SBConvolve::fillKValue between calls,
+    // so drawing many stamps doesn't allocate new matrices for each one.
+    static std::vector<std::complex<double> >* conv_scratch = 0;
+#ifdef _OPENMP
+#pragma omp threadprivate(conv_scratch)
+#endif
+
+    // Takes this thread's scratch space for the length of a fillKValue call.  A nested call
+    // (e.g. for a convolution inside a transformation inside a convolution) gets its own.
+    class ConvolveScratch
+    {
+    public:
+        ConvolveScratch(size_t n)
+        {
+            if (!conv_scratch) conv_scratch = new std::vector<std::complex<double> >();
+            _buf.swap(*conv_scratch);
+            if (_buf.size() < n) _buf.resize(n);
+        }
+        ~ConvolveScratch() { _buf.swap(*conv_scratch); }
+        std::complex<double>* get() { return &_buf[0]; }
+    private:
+        std::vector<std::complex<double> > _buf;
+    };
+
+    // The product is done in tiles with about this many elements.  With the two tiles
+    // for the running product and the next component, this is 1 MB.
+    static const int conv_tile_size = 32768;
+
+    void SBConvolve::SBConvolveImpl::fillItemKValue(
+        const SBProfile& item, tmv::MatrixView<std::complex<double> > val,
+        double kx0, double dkx, double dkxy, double ky0, double dky, double dkyx, int jzero)
+    {
+        if (jzero >= 0)
+            GetImpl(item)->fillKValue(val,kx0,dkx,0,ky0,dky,jzero);
+        else
+            GetImpl(item)->fillKValue(val,kx0,dkx,dkxy,ky0,dky,dkyx);
+    }
+
+    void SBConvolve::SBConvolveImpl::fillKValueTiles(
+        tmv::MatrixView<std::complex<double> > val,
+        double kx0, double dkx, double dkxy, double ky0, double dky, double dkyx,
+        int jzero) const
+    {
+        const int m = val.colsize();
+        const int n = val.rowsize();
+        const int mb = std::max(1, std::min(m, conv_tile_size / n));
+        xdbg<<"fillKValueTiles: m,n = "<<m<<','<<n<<", tile rows = "<<mb<<std::endl;
+
+        // Get the values of the shared items for the whole grid from the cache, or fill them
+        // and add them to the cache.
+        std::vector<boost::shared_ptr<const KGridCache::Grid> > cached(_plist.size());
+        if (kgrid_cache.getBudget() > 0) {
+            int k = 0;
+            for (ConstIter pptr = _plist.begin(); pptr != _plist.end(); ++pptr, ++k) {
+                if (_cache_keys[k] == 0) continue;
+                KGridKey key = { _cache_keys[k], m, n, jzero, kx0, dkx, dkxy, ky0, dky, dkyx };
+                cached[k] = kgrid_cache.get(key,*pptr,&fillItemKValue);
+            }
+        }
+
+        ConvolveScratch scratch(2*mb*n);
+
+        for (int i1=0; i1<m; i1+=mb) {
+            const int nb = std::min(mb, m-i1);
+            std::complex<double>* pa = scratch.get();
+            std::complex<double>* pb = pa + nb*n;
+            tmv::MatrixView<std::complex<double> > a(pa,nb,n,1,nb,tmv::NonConj);
+            tmv::MatrixView<std::complex<double> > b(pb,nb,n,1,nb,tmv::NonConj);
+            const double x0 = kx0 + i1*dkx;
+            const double y0 = ky0 + i1*dkyx;
+            int k = 0;
+            for (ConstIter pptr = _plist.begin(); pptr != _plist.end(); ++pptr, ++k) {
+                if (cached[k]) {
+                    const std::complex<double>* ck = cached[k]->cptr() + i1;
+                    const int stepk = cached[k]->stepj();
+                    for (int j=0; j<n; ++j, ck+=stepk) {
+                        std::complex<double>* aj = pa + j*nb;
+                        if (pptr == _plist.begin()) for (int i=0; i<nb; ++i) aj[i] = ck[i];
+                        else for (int i=0; i<nb; ++i) aj[i] *= ck[i];
+                    }
+                    continue;
+                }
+                tmv::MatrixView<std::complex<double> > c = pptr == _plist.begin() ? a : b;
+                if (jzero >= 0)
+                    GetImpl(*pptr)->fillKValue(c,x0,dkx,0,ky0,dky,jzero);
+                else
+                    GetImpl(*pptr)->fillKValue(c,x0,dkx,dkxy,y0,dky,dkyx);
+                if (pptr != _plist.begin())
+                    for (int i=0; i<nb*n; ++i) pa[i] *= pb[i];
+            }
+            val.rowRange(i1,i1+nb) = a;
+        }
+    }
+
     void SBConvolve::SBConvolveImpl::fillKValue(tmv::MatrixView<std::complex<double> > val,
                                                 double kx0, double dkx, int izero,
                                                 double ky0, double dky, int jzero) const
@@ -187,15 +665,30 @@ namespace galsim {
         dbg<<"SBConvolve fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<", izero = "<<izero<<std::endl;
         dbg<<"ky = "<<ky0<<" + j * "<<dky<<", jzero = "<<jzero<<std::endl;
-        ConstIter pptr = _plist.begin();
-        assert(pptr != _plist.end());
-        GetImpl(*pptr)->fillKValue(val,kx0,dkx,izero,ky0,dky,jzero);
-        if (++pptr != _plist.end()) {
-            tmv::Matrix<std::complex<double> > val2(val.colsize(),val.rowsize());
-            for (; pptr != _plist.end(); ++pptr) {
-                GetImpl(*pptr)->fillKValue(val2.view(),kx0,dkx,izero,ky0,dky,jzero);
-                val = ElemProd(val,val2);
-            }
+        assert(!_plist.empty());
+        if (_plist.size() == 1) {
+            GetImpl(_plist.front())->fillKValue(val,kx0,dkx,izero,ky0,dky,jzero);
+            return;
+        }
+        if (izero == 0 || !isAxisymmetric()) {
+            // The tiles are blocks of rows, so they can't pass izero on to the components.
+            // They still get jzero, and each component decides whether it can use it.
+            fillKValueTiles(val,kx0,dkx,0.,ky0,dky,0.,jzero);
+            return;
+        }
+        // All the components are axisymmetric (and so not shifted), so the product is
+        // symmetric in kx.  Fill the larger side of kx = 0 in tiles and reflect it onto the
+        // other side.
+        const int m = val.colsize();
+        const int n = val.rowsize();
+        const int m1 = izero;
+        const int m2 = m - izero - 1;
+        if (m2 >= m1) {
+            fillKValueTiles(val.rowRange(izero,m),0.,dkx,0.,ky0,dky,0.,jzero);
+            val.subMatrix(izero-1,-1,0,n,-1,1) = val.rowRange(izero+1,izero+m1+1);
+        } else {
+            fillKValueTiles(val.rowRange(0,izero+1),kx0,dkx,0.,ky0,dky,0.,jzero);
+            val.rowRange(izero+1,m) = val.subMatrix(izero-1,izero-m2-1,0,n,-1,1);
         }
     }
 
@@ -206,16 +699,12 @@ namespace galsim {
         dbg<<"SBConvolve fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
-        ConstIter pptr = _plist.begin();
-        assert(pptr != _plist.end());
-        GetImpl(*pptr)->fillKValue(val,kx0,dkx,dkxy,ky0,dky,dkyx);
-        if (++pptr != _plist.end()) {
-            tmv::Matrix<std::complex<double> > val2(val.colsize(),val.rowsize());
-            for (; pptr != _plist.end(); ++pptr) {
-                GetImpl(*pptr)->fillKValue(val2.view(),kx0,dkx,dkxy,ky0,dky,dkyx);
-                val = ElemProd(val,val2);
-            }
+        assert(!_plist.empty());
+        if (_plist.size() == 1) {
+            GetImpl(_plist.front())->fillKValue(val,kx0,dkx,dkxy,ky0,dky,dkyx);
+            return;
         }
+        fillKValueTiles(val,kx0,dkx,dkxy,ky0,dky,dkyx,-1);
     }
 
     double SBConvolve::SBConvolveImpl::getPositiveFlux() const
@@ -311,6 +800,12 @@ namespace galsim {
     double SBAutoConvolve::SBAutoConvolveImpl::xValue(const Position<double>& pos) const
     { return RealSpaceConvolve(_adaptee,_adaptee,pos,getFlux(),this->gsparams); }
 
+    double SBAutoConvolve::SBAutoConvolveImpl::xValueCost() const
+    { return 2. * real_space_integrand_evals * GetImpl(_adaptee)->xValueCost(); }
+
+    double SBAutoConvolve::SBAutoConvolveImpl::kValueCost() const
+    { return GetImpl(_adaptee)->kValueCost(); }
+
     void SBAutoConvolve::SBAutoConvolveImpl::fillKValue(tmv::MatrixView<std::complex<double> > val,
                                                         double kx0, double dkx, int izero,
                                                         double ky0, double dky, int jzero) const
@@ -404,6 +899,13 @@ namespace galsim {
         return RealSpaceConvolve(_adaptee,temp,pos,getFlux(),this->gsparams);
     }
 
+    // The rotated adaptee used by xValue is an extra level of transformation.
+    double SBAutoCorrelate::SBAutoCorrelateImpl::xValueCost() const
+    { return real_space_integrand_evals * (1. + 2. * GetImpl(_adaptee)->xValueCost()); }
+
+    double SBAutoCorrelate::SBAutoCorrelateImpl::kValueCost() const
+    { return GetImpl(_adaptee)->kValueCost(); }
+
     void SBAutoCorrelate::SBAutoCorrelateImpl::fillKValue(
         tmv::MatrixView<std::complex<double> > val,
         double kx0, double dkx, int izero,
@@ -21,6 +21,8 @@
 
 #include "SBExponential.h"
 #include "SBExponentialImpl.h"
+#include "SBSersic.h"
+#include "VectorMath.h"
 
 // Define this variable to find azimuth (and sometimes radius within a unit disc) of 2d photons by
 // drawing a uniform deviate for theta, instead of drawing 2 deviates for a point on the unit
@@ -63,6 +65,12 @@ namespace galsim {
         return static_cast<const SBExponentialImpl&>(*_pimpl).getScaleRadius();
     }
 
+    double SBExponential::getMixtureError() const
+    {
+        assert(dynamic_cast<const SBExponentialImpl*>(_pimpl.get()));
+        return static_cast<const SBExponentialImpl&>(*_pimpl).getMixtureError();
+    }
+
     std::string SBExponential::SBExponentialImpl::serialize() const
     {
         std::ostringstream oss(" ");
@@ -72,14 +80,22 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBExponential::SBExponentialImpl::foldFluxScaling(double fluxScaling,
+                                                           SBProfile& result) const
+    {
+        result = SBExponential(_r0, _flux * fluxScaling, gsparams);
+        return true;
+    }
+
     LRUCache<GSParamsPtr, ExponentialInfo> SBExponential::SBExponentialImpl::cache(
-        sbp::max_exponential_cache);
+        sbp::max_exponential_cache, "exponential");
 
     SBExponential::SBExponentialImpl::SBExponentialImpl(
         double r0, double flux, const GSParamsPtr& gsparams) :
         SBProfileImpl(gsparams),
         _flux(flux), _r0(r0), _r0_sq(_r0*_r0), _inv_r0(1./r0), _inv_r0_sq(_inv_r0*_inv_r0),
-        _info(cache.get(this->gsparams.duplicate()))
+        _info(cache.get(this->gsparams.duplicate())),
+        _use_mixture(this->gsparams->gaussian_mixture), _mixture_err(0.)
     {
         // For large k, we clip the result of kValue to 0.
         // We do this when the correct answer is less than kvalue_accuracy.
@@ -100,23 +116,32 @@ namespace galsim {
         dbg<<"_ksq_max = "<<_ksq_max<<std::endl;
         dbg<<"_ksq_min = "<<_ksq_min<<std::endl;
         dbg<<"_norm = "<<_norm<<std::endl;
+
+        if (_use_mixture) {
+            // half-light radius = 1.6783469900166605 * r0
+            _mixture = MakeSersicGaussianMixture(1., 1.6783469900166605 * _r0, _flux,
+                                                 this->gsparams, _mixture_err);
+            dbg<<"Using Gaussian mixture with error "<<_mixture_err<<std::endl;
+        }
         dbg<<"maxK() = "<<maxK()<<std::endl;
         dbg<<"stepK() = "<<stepK()<<std::endl;
     }
 
     double SBExponential::SBExponentialImpl::maxK() const
-    { return _info->maxK() * _inv_r0; }
+    { return _use_mixture ? _mixture.maxK() : _info->maxK() * _inv_r0; }
     double SBExponential::SBExponentialImpl::stepK() const
-    { return _info->stepK() * _inv_r0; }
+    { return _use_mixture ? _mixture.stepK() : _info->stepK() * _inv_r0; }
 
     double SBExponential::SBExponentialImpl::xValue(const Position<double>& p) const
     {
+        if (_use_mixture) return _mixture.xValue(p);
         double r = sqrt(p.x * p.x + p.y * p.y);
         return _norm * std::exp(-r * _inv_r0);
     }
 
     std::complex<double> SBExponential::SBExponentialImpl::kValue(const Position<double>& k) const
     {
+        if (_use_mixture) return _mixture.kValue(k);
         double ksq = (k.x*k.x + k.y*k.y)*_r0_sq;
 
         if (ksq < _ksq_min) {
@@ -128,10 +153,38 @@ namespace galsim {
         }
     }
 
+    void SBExponential::SBExponentialImpl::xValueMany(const double* x, const double* y,
+                                                      double* val, int n) const
+    {
+        if (_use_mixture) { _mixture.xValueMany(x,y,val,n); return; }
+        for (int i=0;i<n;++i) val[i] = -sqrt(x[i]*x[i] + y[i]*y[i]) * _inv_r0;
+        math::ExpMany(val, val, n);
+        for (int i=0;i<n;++i) val[i] *= _norm;
+    }
+
+    void SBExponential::SBExponentialImpl::kValueMany(const double* kx, const double* ky,
+                                                      std::complex<double>* val, int n) const
+    {
+        if (_use_mixture) { _mixture.kValueMany(kx,ky,val,n); return; }
+        for (int i=0;i<n;++i) {
+            double ksq = (kx[i]*kx[i] + ky[i]*ky[i])*_r0_sq;
+            if (ksq < _ksq_min) {
+                val[i] = _flux*(1. - 1.5*ksq*(1. - 1.25*ksq));
+            } else {
+                double temp = 1. + ksq;
+                val[i] = _flux / (temp * sqrt(temp));
+            }
+        }
+    }
+
     void SBExponential::SBExponentialImpl::fillXValue(tmv::MatrixView<double> val,
                                                       double x0, double dx, int izero,
                                                       double y0, double dy, int jzero) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillXValue(val,x0,dx,izero,y0,dy,jzero);
+            return;
+        }
         dbg<<"SBExponential fillXValue\n";
         dbg<<"x = "<<x0<<" + i * "<<dx<<", izero = "<<izero<<std::endl;
         dbg<<"y = "<<y0<<" + j * "<<dy<<", jzero = "<<jzero<<std::endl;
@@ -143,7 +196,6 @@ namespace galsim {
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
-            typedef tmv::VIt<double,1,tmv::NonConj> It;
 
             x0 *= _inv_r0;
             dx *= _inv_r0;
@@ -153,9 +205,10 @@ namespace galsim {
             for (int j=0;j<n;++j,y0+=dy) {
                 double x = x0;
                 double ysq = y0*y0;
-                It valit = val.col(j).begin();
-                for (int i=0;i<m;++i,x+=dx)
-                    *valit++ = _norm * std::exp(-sqrt(x*x + ysq));
+                double* valj = val.col(j).ptr();
+                for (int i=0;i<m;++i,x+=dx) valj[i] = -sqrt(x*x + ysq);
+                math::ExpMany(valj, valj, m);
+                for (int i=0;i<m;++i) valj[i] *= _norm;
             }
         }
     }
@@ -164,6 +217,10 @@ namespace galsim {
                                                       double kx0, double dkx, int izero,
                                                       double ky0, double dky, int jzero) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillKValue(val,kx0,dkx,izero,ky0,dky,jzero);
+            return;
+        }
         dbg<<"SBExponential fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<", izero = "<<izero<<std::endl;
         dbg<<"ky = "<<ky0<<" + j * "<<dky<<", jzero = "<<jzero<<std::endl;
@@ -205,6 +262,10 @@ namespace galsim {
                                                       double x0, double dx, double dxy,
                                                       double y0, double dy, double dyx) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillXValue(val,x0,dx,dxy,y0,dy,dyx);
+            return;
+        }
         dbg<<"SBExponential fillXValue\n";
         dbg<<"x = "<<x0<<" + i * "<<dx<<" + j * "<<dxy<<std::endl;
         dbg<<"y = "<<y0<<" + i * "<<dyx<<" + j * "<<dy<<std::endl;
@@ -212,7 +273,6 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
-        typedef tmv::VIt<double,1,tmv::NonConj> It;
 
         x0 *= _inv_r0;
         dx *= _inv_r0;
@@ -221,11 +281,13 @@ namespace galsim {
         dy *= _inv_r0;
         dyx *= _inv_r0;
 
-        It valit = val.linearView().begin();
         for (int j=0;j<n;++j,x0+=dxy,y0+=dy) {
             double x = x0;
             double y = y0;
-            for (int i=0;i<m;++i,x+=dx,y+=dyx) *valit++ = _norm * std::exp(-sqrt(x*x + y*y));
+            double* valj = val.col(j).ptr();
+            for (int i=0;i<m;++i,x+=dx,y+=dyx) valj[i] = -sqrt(x*x + y*y);
+            math::ExpMany(valj, valj, m);
+            for (int i=0;i<m;++i) valj[i] *= _norm;
         }
     }
 
@@ -233,6 +295,10 @@ namespace galsim {
                                                       double kx0, double dkx, double dkxy,
                                                       double ky0, double dky, double dkyx) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillKValue(val,kx0,dkx,dkxy,ky0,dky,dkyx);
+            return;
+        }
         dbg<<"SBExponential fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
@@ -326,6 +392,7 @@ namespace galsim {
     {
         dbg<<"Exponential shoot: N = "<<N<<std::endl;
         dbg<<"Target flux = "<<getFlux()<<std::endl;
+        if (_use_mixture) return GetImpl(_mixture)->shoot(N,u);
 #ifdef USE_NEWTON_RAPHSON
         // The cumulative distribution of flux is 1-(1+r)exp(-r).
         // Here is a way to solve for r by an initial guess followed
@@ -21,6 +21,8 @@
 
 #include "SBGaussian.h"
 #include "SBGaussianImpl.h"
+#include "SBTransform.h"
+#include "VectorMath.h"
 
 // Define this variable to find azimuth (and sometimes radius within a unit disc) of 2d photons by
 // drawing a uniform deviate for theta, instead of drawing 2 deviates for a point on the unit
@@ -64,6 +66,48 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBGaussian::SBGaussianImpl::foldFluxScaling(double fluxScaling,
+                                                     SBProfile& result) const
+    {
+        result = SBGaussian(_sigma, _flux * fluxScaling, gsparams);
+        return true;
+    }
+
+    bool SBGaussian::SBGaussianImpl::getGaussian(double& flux, double& cxx, double& cxy,
+                                                 double& cyy, Position<double>& cen) const
+    {
+        flux = _flux;
+        cxx = cyy = _sigma_sq;
+        cxy = 0.;
+        cen = Position<double>(0., 0.);
+        return true;
+    }
+
+    SBProfile MakeEllipticalGaussian(double flux, double cxx, double cxy, double cyy,
+                                     const Position<double>& cen, const GSParamsPtr& gsparams)
+    {
+        dbg<<"MakeEllipticalGaussian: flux = "<<flux<<", cov = "<<cxx<<','<<cxy<<','<<cyy;
+        dbg<<", cen = "<<cen<<std::endl;
+        // Treat the covariance as isotropic if it is within rounding errors of being so,
+        // since that is a lot faster to draw.
+        const double tr = cxx + cyy;
+        const double tol = 1.e-12 * tr;
+        if (std::abs(cxy) <= tol && std::abs(cxx-cyy) <= tol) {
+            SBGaussian g(std::sqrt(0.5*tr), flux, gsparams);
+            if (cen.x == 0. && cen.y == 0.) return g;
+            else return SBTransform(g, 1., 0., 0., 1., cen, 1., gsparams);
+        }
+        // Otherwise use a unit-determinant transformation L of a circular Gaussian with
+        // sigma^4 = det(C), where L L^T = C / sigma^2.  L is the symmetric square root,
+        // sqrt(C) = (C + sqrt(det) I) / sqrt(tr + 2 sqrt(det)).
+        const double sqrtdet = std::sqrt(cxx*cyy - cxy*cxy);
+        const double sigma = std::sqrt(sqrtdet);
+        const double norm = 1. / (sigma * std::sqrt(tr + 2.*sqrtdet));
+        SBGaussian g(sigma, flux, gsparams);
+        return SBTransform(g, (cxx+sqrtdet)*norm, cxy*norm, cxy*norm, (cyy+sqrtdet)*norm,
+                           cen, 1., gsparams);
+    }
+
     SBGaussian::SBGaussianImpl::SBGaussianImpl(double sigma, double flux,
                                                const GSParamsPtr& gsparams) :
         SBProfileImpl(gsparams),
@@ -129,6 +173,28 @@ namespace galsim {
         }
     }
 
+    void SBGaussian::SBGaussianImpl::xValueMany(const double* x, const double* y, double* val,
+                                                int n) const
+    {
+        for (int i=0;i<n;++i) val[i] = -0.5 * (x[i]*x[i] + y[i]*y[i]) * _inv_sigma_sq;
+        math::ExpMany(val, val, n);
+        for (int i=0;i<n;++i) val[i] *= _norm;
+    }
+
+    void SBGaussian::SBGaussianImpl::kValueMany(const double* kx, const double* ky,
+                                                std::complex<double>* val, int n) const
+    {
+        for (int i=0;i<n;++i) {
+            double ksq = (kx[i]*kx[i]+ky[i]*ky[i])*_sigma_sq;
+            if (ksq > _ksq_max)
+                val[i] = 0.;
+            else if (ksq < _ksq_min)
+                val[i] = _flux*(1. - 0.5*ksq*(1. - 0.25*ksq));
+            else
+                val[i] = _flux * std::exp(-0.5*ksq);
+        }
+    }
+
     void SBGaussian::SBGaussianImpl::fillXValue(tmv::MatrixView<double> val,
                                                 double x0, double dx, int izero,
                                                 double y0, double dy, int jzero) const
@@ -209,7 +275,6 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
-        typedef tmv::VIt<double,1,tmv::NonConj> It;
 
         x0 *= _inv_sigma;
         dx *= _inv_sigma;
@@ -218,12 +283,13 @@ namespace galsim {
         dy *= _inv_sigma;
         dyx *= _inv_sigma;
 
-        It valit = val.linearView().begin();
         for (int j=0;j<n;++j,x0+=dxy,y0+=dy) {
             double x = x0;
             double y = y0;
-            for (int i=0;i<m;++i,x+=dx,y+=dyx)
-                *valit++ = _norm * std::exp( -0.5 * (x*x + y*y) );
+            double* valj = val.col(j).ptr();
+            for (int i=0;i<m;++i,x+=dx,y+=dyx) valj[i] = -0.5 * (x*x + y*y);
+            math::ExpMany(valj, valj, m);
+            for (int i=0;i<m;++i) valj[i] *= _norm;
         }
     }
 
@@ -248,17 +314,22 @@ namespace galsim {
         dkyx *= _sigma;
 
         It valit = val.linearView().begin();
+        std::vector<double> ksq(m), gauss(m);
         for (int j=0;j<n;++j,kx0+=dkxy,ky0+=dky) {
             double kx = kx0;
             double ky = ky0;
             for (int i=0;i<m;++i,kx+=dkx,ky+=dkyx) {
-                double ksq = kx*kx + ky*ky;
-                if (ksq > _ksq_max) {
+                ksq[i] = kx*kx + ky*ky;
+                gauss[i] = -0.5*ksq[i];
+            }
+            math::ExpMany(&gauss[0], &gauss[0], m);
+            for (int i=0;i<m;++i) {
+                if (ksq[i] > _ksq_max) {
                     *valit++ = 0.;
-                } else if (ksq < _ksq_min) {
-                    *valit++ = _flux * (1. - 0.5*ksq*(1. - 0.25*ksq));
+                } else if (ksq[i] < _ksq_min) {
+                    *valit++ = _flux * (1. - 0.5*ksq[i]*(1. - 0.25*ksq[i]));
                 } else {
-                    *valit++ =  _flux * std::exp(-0.5*ksq);
+                    *valit++ =  _flux * gauss[i];
                 }
             }
         }
@@ -220,10 +220,16 @@ namespace galsim {
     void SBInterpolatedImage::SBInterpolatedImageImpl::checkK() const
     {
         // Conduct FFT
-        if (_ktab.get()) return;
-        _ktab = _xtab->transform();
-        dbg<<"Built ktab\n";
-        dbg<<"ktab size = "<<_ktab->getN()<<", scale = "<<_ktab->getDk()<<std::endl;
+        // The fill functions may call this from several threads at once, so the check
+        // also has to be inside the critical section.
+#ifdef _OPENMP
+#pragma omp critical (galsim_interpolatedimage_ktab)
+#endif
+        if (!_ktab.get()) {
+            _ktab = _xtab->transform();
+            dbg<<"Built ktab\n";
+            dbg<<"ktab size = "<<_ktab->getN()<<", scale = "<<_ktab->getDk()<<std::endl;
+        }
     }
 
     void SBInterpolatedImage::SBInterpolatedImageImpl::fillXValue(
@@ -237,6 +243,8 @@ namespace galsim {
         assert(val.stepi() == 1);
         const int m = val.colsize();
         const int n = val.rowsize();
+        // Use our own interpolation cache, so this can be called from several threads at once.
+        InterpolationCache<double> cache;
 
         if (dynamic_cast<const InterpolantXY*> (_xInterp.get())) {
             // If the interpolant is separable, the XTable interpolation routine
@@ -245,7 +253,7 @@ namespace galsim {
             for (int i=0;i<m;++i,x0+=dx) {
                 double y = y0;
                 RMIt valit = val.row(i).begin();
-                for (int j=0;j<n;++j,y+=dy) *valit++ = _xtab->interpolate(x0, y, *_xInterp);
+                for (int j=0;j<n;++j,y+=dy) *valit++ = _xtab->interpolate(x0, y, *_xInterp, cache);
             }
         } else {
             // Otherwise, just do the values in storage order
@@ -253,7 +261,7 @@ namespace galsim {
             for (int j=0;j<n;++j,y0+=dy) {
                 double x = x0;
                 CMIt valit = val.col(j).begin();
-                for (int i=0;i<m;++i,x+=dx) *valit++ = _xtab->interpolate(x, y0, *_xInterp);
+                for (int i=0;i<m;++i,x+=dx) *valit++ = _xtab->interpolate(x, y0, *_xInterp, cache);
             }
         }
     }
@@ -270,6 +278,8 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
+        // Use our own interpolation cache, so this can be called from several threads at once.
+        InterpolationCache<double> cache;
         typedef tmv::VIt<double,1,tmv::NonConj> It;
 
         It valit = val.linearView().begin();
@@ -277,7 +287,7 @@ namespace galsim {
             double x = x0;
             double y = y0;
             for (int i=0;i<m;++i,x+=dx,y+=dyx) {
-                *valit++ = _xtab->interpolate(x, y, *_xInterp);
+                *valit++ = _xtab->interpolate(x, y, *_xInterp, cache);
             }
         }
     }
@@ -293,6 +303,8 @@ namespace galsim {
         assert(val.stepi() == 1);
         const int m = val.colsize();
         const int n = val.rowsize();
+        // Use our own interpolation cache, so this can be called from several threads at once.
+        InterpolationCache<std::complex<double> > cache;
         checkK();
 
         // Assign zeros for range that has |u| > maxu
@@ -346,7 +358,7 @@ namespace galsim {
                     uyit = uy.begin();
                     RMIt valit = val.row(i,j1,j2).begin();
                     for (int j=j1;j<j2;++j,ky+=dky) {
-                        *valit++ = *uxit * *uyit++ * _ktab->interpolate(kx0, ky, *kInterpXY);
+                        *valit++ = *uxit * *uyit++ * _ktab->interpolate(kx0, ky, *kInterpXY, cache);
                     }
                 }
             } else {
@@ -357,7 +369,8 @@ namespace galsim {
                     RMIt valit = val.row(i,j1,j2).begin();
                     for (int j=j1;j<j2;++j,ky+=dky) {
                         double xKernelTransform = _xInterp->uval(*uxit, *uyit++);
-                        *valit++ = xKernelTransform * _ktab->interpolate(kx0, ky, *kInterpXY);
+                        *valit++ = xKernelTransform *
+                            _ktab->interpolate(kx0, ky, *kInterpXY, cache);
                     }
                 }
             }
@@ -376,7 +389,7 @@ namespace galsim {
                     uxit = ux.begin();
                     CMIt valit = val.col(j,i1,i2).begin();
                     for (int i=i1;i<i2;++i,kx+=dkx) {
-                        *valit++ = *uxit++ * *uyit * _ktab->interpolate(kx, ky0, *_kInterp);
+                        *valit++ = *uxit++ * *uyit * _ktab->interpolate(kx, ky0, *_kInterp, cache);
                     }
                 }
             } else {
@@ -387,7 +400,7 @@ namespace galsim {
                     CMIt valit = val.col(j,i1,i2).begin();
                     for (int i=i1;i<i2;++i,kx+=dkx) {
                         double xKernelTransform = _xInterp->uval(*uxit++, *uyit);
-                        *valit++ = xKernelTransform * _ktab->interpolate(kx, ky0, *_kInterp);
+                        *valit++ = xKernelTransform * _ktab->interpolate(kx, ky0, *_kInterp, cache);
                     }
                 }
             }
@@ -406,6 +419,8 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
+        // Use our own interpolation cache, so this can be called from several threads at once.
+        InterpolationCache<std::complex<double> > cache;
         typedef tmv::VIt<std::complex<double>,1,tmv::NonConj> It;
         checkK();
 
@@ -427,7 +442,7 @@ namespace galsim {
                     *valit++ = 0.;
                 } else {
                     double xKernelTransform = _xInterp->uval(ux, uy);
-                    *valit++ = xKernelTransform * _ktab->interpolate(kx, ky, *_kInterp);
+                    *valit++ = xKernelTransform * _ktab->interpolate(kx, ky, *_kInterp, cache);
                 }
             }
         }
@@ -749,6 +764,11 @@ namespace galsim {
         dbg<<"InterpolatedImage shoot: N = "<<N<<std::endl;
         dbg<<"Target flux = "<<getFlux()<<std::endl;
         assert(N>=0);
+        // drawShoot may shoot from several threads at once, so only let one of them build
+        // the photon tree.
+#ifdef _OPENMP
+#pragma omp critical (galsim_interpolatedimage_shoot)
+#endif
         checkReadyToShoot();
         /* The pixel coordinates are stored by cumulative absolute flux in
          * a C++ standard-libary set, so the inversion is done with a binary
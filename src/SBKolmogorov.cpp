@@ -21,6 +21,8 @@
 
 #include "SBKolmogorov.h"
 #include "SBKolmogorovImpl.h"
+#include "TableCache.h"
+#include "Hankel.h"
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -63,7 +65,7 @@ namespace galsim {
     }
 
     LRUCache<GSParamsPtr, KolmogorovInfo> SBKolmogorov::SBKolmogorovImpl::cache(
-        sbp::max_kolmogorov_cache);
+        sbp::max_kolmogorov_cache, "kolmogorov");
 
     // The "magic" number 2.992934 below comes from the standard form of the Kolmogorov spectrum
     // from Racine, 1996 PASP, 108, 699 (who in turn is quoting Fried, 1966, JOSA, 56, 1372):
@@ -154,6 +156,7 @@ namespace galsim {
             fillKValueQuadrant(val,kx0,dkx,izero,ky0,dky,jzero);
         } else {
             xdbg<<"Non-Quadrant\n";
+            if (fillKValueRadial(val,kx0,dkx,ky0,dky)) return;
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
@@ -211,6 +214,7 @@ namespace galsim {
         dbg<<"SBKolmogorov fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
+        if (fillKValueRadial(val,kx0,dkx,dkxy,ky0,dky,dkyx)) return;
         assert(val.stepi() == 1);
         assert(val.canLinearize());
         const int m = val.colsize();
@@ -246,6 +250,15 @@ namespace galsim {
     double KolmogorovInfo::kValue(double ksq) const
     { return exp(-std::pow(ksq,5./6.)); }
 
+    // The Kolmogorov profile in k space, which buildRadial Hankel transforms.
+    class KolmKValue : public std::unary_function<double,double>
+    {
+    public:
+        double operator()(double k) const
+        { return std::exp(-std::pow(k, 5./3.)); }
+    };
+
+#ifdef SOLVE_FWHM_HLR
     // Integrand class for the Hankel transform of Kolmogorov
     class KolmIntegrand : public std::unary_function<double,double>
     {
@@ -276,7 +289,6 @@ namespace galsim {
         const GSParamsPtr& _gsparams;
     };
 
-#ifdef SOLVE_FWHM_HLR
     // XValue - target  (used for solving for fwhm)
     class KolmTargetValue : public std::unary_function<double,double>
     {
@@ -328,6 +340,10 @@ namespace galsim {
     };
 #endif
 
+    // The version of the layout of the radial table in the on-disk cache.  Increment this
+    // whenever the layout or the calculation of the table changes.
+    static const int kolmogorov_table_version = 2;
+
     // Constructor to initialize Kolmogorov constants and xvalue lookup table
     KolmogorovInfo::KolmogorovInfo(const GSParamsPtr& gsparams) :
         _radial(TableDD::spline)
@@ -339,8 +355,32 @@ namespace galsim {
         _maxk = std::pow(-std::log(gsparams->kvalue_accuracy),3./5.);
         dbg<<"maxK = "<<_maxk<<std::endl;
 
-        // Build the table for the radial function.
+        // Build the table for the radial function, unless another process has already
+        // saved it in the on-disk cache.
+        std::string key = TableCache::makeKey(*gsparams);
+        std::vector<double> cached;
+        if (TableCache::read("kolmogorov", kolmogorov_table_version, key, cached) &&
+            cached.size() > 1 && (cached.size() - 1) % 2 == 0) {
+            dbg<<"Using cached radial table\n";
+            const int nentry = (int(cached.size()) - 1) / 2;
+            _stepk = cached[0];
+            for (int i=0; i<nentry; ++i) _radial.addEntry(cached[1+i], cached[1+nentry+i]);
+        } else {
+            buildRadial(gsparams);
+            cached.push_back(_stepk);
+            cached.insert(cached.end(), _radial.getArgs().begin(), _radial.getArgs().end());
+            cached.insert(cached.end(), _radial.getVals().begin(), _radial.getVals().end());
+            TableCache::write("kolmogorov", kolmogorov_table_version, key, cached);
+        }
 
+        // Next, set up the sampler for photon shooting
+        std::vector<double> range(2,0.);
+        range[1] = _radial.argMax();
+        _sampler.reset(new OneDimensionalDeviate(_radial, range, true, gsparams));
+    }
+
+    void KolmogorovInfo::buildRadial(const GSParamsPtr& gsparams)
+    {
         // Start with f(0), which is analytic:
         // According to Wolfram Alpha:
         // Integrate[k*exp(-k^5/3),{k,0,infinity}] = 3/5 Gamma(6/5)
@@ -364,10 +404,20 @@ namespace galsim {
         double thresh1 = (1.-gsparams->folding_threshold) / (2.*M_PI*dr);
         double thresh2 = (1.-gsparams->folding_threshold/5.) / (2.*M_PI*dr);
         double R = 0., hlr = 0.;
-        // Continue until accumulate 0.999 of the flux
-        KolmXValue xval_func(gsparams);
 
-        for (double r = dr; sum < thresh2; r += dr) {
+        // Do the Hankel transform for all r at once.  In k, go out to where exp(-k^5/3) is
+        // well below integration_abserr.  In r, the tail is f(r) ~= 0.9/(2pi) r^(-11/3), so the
+        // flux outside r is about 0.54 r^(-5/3).  Go to twice the radius where that is
+        // folding_threshold/5, which should be well past where the loop below stops.
+        double maxk = std::pow(-std::log(0.01 * gsparams->integration_abserr), 3./5.);
+        double maxr = 2. * std::pow(3. / gsparams->folding_threshold, 3./5.);
+        dbg<<"Hankel transform for k <= "<<maxk<<", r <= "<<maxr<<std::endl;
+        HankelTransform xval_func(KolmKValue(), 1.e-10, maxk, false, dr, maxr,
+                                  gsparams->integration_abserr);
+        dbg<<"Hankel transform error = "<<xval_func.getError()<<std::endl;
+
+        // Continue until accumulate 0.999 of the flux
+        for (double r = dr; sum < thresh2 && r < maxr; r += dr) {
             val = xval_func(r) / (2.*M_PI);
             xdbg<<"f("<<r<<") = "<<val<<std::endl;
             _radial.addEntry(r,val);
@@ -388,11 +438,6 @@ namespace galsim {
         dbg<<"stepk = "<<_stepk<<std::endl;
         dbg<<"sum*2*pi*dr = "<<sum*2.*M_PI*dr<<"   (should ~= 0.999)\n";
 
-        // Next, set up the sampler for photon shooting
-        std::vector<double> range(2,0.);
-        range[1] = _radial.argMax();
-        _sampler.reset(new OneDimensionalDeviate(_radial, range, true, gsparams));
-
 #ifdef SOLVE_FWHM_HLR
         // Improve upon the conversion between lam_over_r0 and fwhm:
         KolmTargetValue fwhm_func(0.55090124543985636638457099311149824 / 2., gsparams);
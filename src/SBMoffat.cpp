@@ -24,12 +24,13 @@
 #define BOOST_NO_CXX11_SMART_PTR
 #include <boost/math/special_functions/bessel.hpp>
 #include <boost/math/special_functions/gamma.hpp>
+#include <limits>
 
 #include "SBMoffat.h"
 #include "SBMoffatImpl.h"
-#include "integ/Int.h"
 #include "Solve.h"
-#include "bessel/Roots.h"
+#include "Hankel.h"
+#include "VectorMath.h"
 
 // Define this variable to find azimuth (and sometimes radius within a unit disc) of 2d photons by
 // drawing a uniform deviate for theta, instead of drawing 2 deviates for a point on the unit
@@ -49,6 +50,9 @@
 
 namespace galsim {
 
+    LRUCache<boost::tuple<double, double, GSParamsPtr>, MoffatInfo> SBMoffat::SBMoffatImpl::cache(
+        sbp::max_moffat_cache, "moffat");
+
     SBMoffat::SBMoffat(double beta, double size, RadiusType rType, double trunc, double flux,
                        const GSParamsPtr& gsparams) :
         SBProfile(new SBMoffatImpl(beta, size, rType, trunc, flux, gsparams)) {}
@@ -97,6 +101,14 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBMoffat::SBMoffatImpl::foldFluxScaling(double fluxScaling,
+                                                 SBProfile& result) const
+    {
+        result = SBMoffat(_beta, _rD, SBMoffat::SCALE_RADIUS, _trunc, _flux * fluxScaling,
+                          gsparams);
+        return true;
+    }
+
 
     class MoffatScaleRadiusFunc
     {
@@ -179,7 +191,6 @@ namespace galsim {
                                          const GSParamsPtr& gsparams) :
         SBProfileImpl(gsparams),
         _beta(beta), _flux(flux), _trunc(trunc),
-        _ft(Table<double,double>::spline),
         _re(0.), // initially set to zero, may be updated by size or getHalfLightRadius().
         _stepk(0.), // calculated by stepK() and stored.
         _maxk(0.) // calculated by maxK() and stored.
@@ -247,23 +258,12 @@ namespace galsim {
         dbg << "Moffat rD " << _rD << " fluxFactor " << _fluxFactor
             << " norm " << _norm << " maxR " << _maxR << std::endl;
 
-        if (std::abs(_beta-1) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_1;
-        else if (std::abs(_beta-1.5) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_15;
-        else if (std::abs(_beta-2) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_2;
-        else if (std::abs(_beta-2.5) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_25;
-        else if (std::abs(_beta-3) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_3;
-        else if (std::abs(_beta-3.5) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_35;
-        else if (std::abs(_beta-4) < this->gsparams->xvalue_accuracy)
-            _pow_beta = &SBMoffatImpl::pow_4;
-        else _pow_beta = &SBMoffatImpl::pow_gen;
-
-        if (_trunc > 0.) _kV = &SBMoffatImpl::kV_trunc;
+        _pow_beta = ChoosePowBeta(_beta, *this->gsparams);
+
+        if (_trunc > 0.) {
+            _kV = &SBMoffatImpl::kV_trunc;
+            _info = cache.get(boost::make_tuple(_beta, _maxRrD, this->gsparams.duplicate()));
+        }
         else if (std::abs(_beta-1.5) < this->gsparams->kvalue_accuracy)
             _kV = &SBMoffatImpl::kV_15;
         else if (std::abs(_beta-2) < this->gsparams->kvalue_accuracy)
@@ -282,6 +282,27 @@ namespace galsim {
         }
     }
 
+    SBMoffat::SBMoffatImpl::PowFunc SBMoffat::SBMoffatImpl::ChoosePowBeta(
+        double beta, const GSParams& gsparams)
+    {
+        if (std::abs(beta-1) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_1;
+        else if (std::abs(beta-1.5) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_15;
+        else if (std::abs(beta-2) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_2;
+        else if (std::abs(beta-2.5) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_25;
+        else if (std::abs(beta-3) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_3;
+        else if (std::abs(beta-3.5) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_35;
+        else if (std::abs(beta-4) < gsparams.xvalue_accuracy)
+            return &SBMoffatImpl::pow_4;
+        else
+            return &SBMoffatImpl::pow_gen;
+    }
+
     double SBMoffat::SBMoffatImpl::getHalfLightRadius() const
     {
         // Done here since _re depends on _fluxFactor and thus requires _rD in advance, so this
@@ -306,6 +327,41 @@ namespace galsim {
         return _knorm * (this->*_kV)(ksq);
     }
 
+    void SBMoffat::SBMoffatImpl::xValueMany(const double* x, const double* y, double* val,
+                                            int n) const
+    {
+        for (int i=0;i<n;++i) val[i] = (x[i]*x[i] + y[i]*y[i])*_inv_rD_sq;
+        xValueFromRsq(val, n);
+    }
+
+    void SBMoffat::SBMoffatImpl::xValueFromRsq(double* val, int n) const
+    {
+        if (_pow_beta == &SBMoffatImpl::pow_gen) {
+            // (1+rsq)^-beta = exp(-beta log(1+rsq)).
+            // Points beyond maxR get 1+rsq = inf, which comes out as 0.
+            const double inf = std::numeric_limits<double>::infinity();
+            for (int i=0;i<n;++i) val[i] = val[i] > _maxRrD_sq ? inf : 1. + val[i];
+            math::LogMany(val, val, n);
+            for (int i=0;i<n;++i) val[i] *= -_beta;
+            math::ExpMany(val, val, n);
+            for (int i=0;i<n;++i) val[i] *= _norm;
+        } else {
+            for (int i=0;i<n;++i) {
+                double rsq = val[i];
+                val[i] = rsq > _maxRrD_sq ? 0. : _norm / _pow_beta(1.+rsq, _beta);
+            }
+        }
+    }
+
+    void SBMoffat::SBMoffatImpl::kValueMany(const double* kx, const double* ky,
+                                            std::complex<double>* val, int n) const
+    {
+        for (int i=0;i<n;++i) {
+            double ksq = (kx[i]*kx[i] + ky[i]*ky[i])*_rD_sq;
+            val[i] = _knorm * (this->*_kV)(ksq);
+        }
+    }
+
     double SBMoffat::SBMoffatImpl::kV_15(double ksq) const
     {
         double k = sqrt(ksq);
@@ -361,11 +417,7 @@ namespace galsim {
     }
 
     double SBMoffat::SBMoffatImpl::kV_trunc(double ksq) const
-    {
-        setupFT();
-        if (ksq > _ft.argMax()) return 0.;
-        else return _ft(ksq);
-    }
+    { return _info->kValue(ksq); }
 
     void SBMoffat::SBMoffatImpl::fillXValue(tmv::MatrixView<double> val,
                                             double x0, double dx, int izero,
@@ -382,7 +434,6 @@ namespace galsim {
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
-            typedef tmv::VIt<double,1,tmv::NonConj> It;
 
             x0 *= _inv_rD;
             dx *= _inv_rD;
@@ -392,12 +443,9 @@ namespace galsim {
             for (int j=0;j<n;++j,y0+=dy) {
                 double x = x0;
                 double ysq = y0*y0;
-                It valit = val.col(j).begin();
-                for (int i=0;i<m;++i,x+=dx) {
-                    double rsq = x*x + ysq;
-                    if (rsq > _maxRrD_sq) *valit++ = 0.;
-                    else *valit++ = _norm / _pow_beta(1.+rsq, _beta);
-                }
+                double* valj = val.col(j).ptr();
+                for (int i=0;i<m;++i,x+=dx) valj[i] = x*x + ysq;
+                xValueFromRsq(valj, m);
             }
         }
     }
@@ -414,6 +462,7 @@ namespace galsim {
             fillKValueQuadrant(val,kx0,dkx,izero,ky0,dky,jzero);
         } else {
             xdbg<<"Non-Quadrant\n";
+            if (fillKValueRadial(val,kx0,dkx,ky0,dky)) return;
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
@@ -447,7 +496,6 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
-        typedef tmv::VIt<double,1,tmv::NonConj> It;
 
         x0 *= _inv_rD;
         dx *= _inv_rD;
@@ -456,15 +504,12 @@ namespace galsim {
         dy *= _inv_rD;
         dyx *= _inv_rD;
 
-        It valit = val.linearView().begin();
         for (int j=0;j<n;++j,x0+=dxy,y0+=dy) {
             double x = x0;
             double y = y0;
-            for (int i=0;i<m;++i,x+=dx,y+=dyx) {
-                double rsq = x*x + y*y;
-                if (rsq > _maxRrD_sq) *valit++ = 0.;
-                else *valit++ = _norm / _pow_beta(1.+rsq, _beta);
-            }
+            double* valj = val.col(j).ptr();
+            for (int i=0;i<m;++i,x+=dx,y+=dyx) valj[i] = x*x + y*y;
+            xValueFromRsq(valj, m);
         }
     }
 
@@ -475,6 +520,7 @@ namespace galsim {
         dbg<<"SBMoffat fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
+        if (fillKValueRadial(val,kx0,dkx,dkxy,ky0,dky,dkyx)) return;
         assert(val.stepi() == 1);
         assert(val.canLinearize());
         const int m = val.colsize();
@@ -530,9 +576,9 @@ namespace galsim {
                     dbg<<"_maxk = "<<_maxk<<std::endl;
                 }
             } else {
-                // _maxk is determined during setupFT() as the last k value to have a
-                // kValue > 1.e-3.
-                setupFT();
+                // _maxk is determined by the MoffatInfo as the last k value to have a
+                // kValue > maxk_threshold.
+                _maxk = _info->maxK();
             }
         }
         return _maxk*_inv_rD;
@@ -569,32 +615,53 @@ namespace galsim {
         return _stepk;
     }
 
-    // Integrand class for the Hankel transform of Moffat
-    class MoffatIntegrand : public std::unary_function<double,double>
+    // The radial profile of a Moffat, which MoffatInfo::buildFT Hankel transforms.
+    class MoffatRadial : public std::unary_function<double,double>
     {
     public:
-        MoffatIntegrand(double beta, double k, double (*pb)(double, double)) :
-            _beta(beta), _k(k), _pow_beta(pb) {}
+        MoffatRadial(double beta, double (*pb)(double, double)) :
+            _beta(beta), _pow_beta(pb) {}
         double operator()(double r) const
-        { return r/_pow_beta(1.+r*r, _beta)*j0(_k*r); }
+        { return 1./_pow_beta(1.+r*r, _beta); }
 
     private:
         double _beta;
-        double _k;
         double (*_pow_beta)(double x, double beta);
     };
 
-    void SBMoffat::SBMoffatImpl::setupFT() const
+    MoffatInfo::MoffatInfo(double beta, double maxRrD, const GSParamsPtr& gsparams) :
+        _beta(beta), _maxRrD(maxRrD), _gsparams(gsparams),
+        _fluxFactor(1. - std::pow(1.+maxRrD*maxRrD, (1.-beta))),
+        _ft(Table<double,double>::spline), _maxk(0.)
     {
-        assert(_trunc > 0.);
-        if (_ft.size() > 0) return;
+        dbg<<"Start MoffatInfo constructor for beta = "<<_beta<<std::endl;
+        dbg<<"maxRrD = "<<_maxRrD<<std::endl;
+        assert(_maxRrD > 0.);
+        // Build the table here, rather than when it is first used, so the MoffatInfo
+        // is never modified once the cache hands it out, and several threads can use it
+        // at the same time.
+        buildFT();
+    }
+
+    double MoffatInfo::kValue(double ksq) const
+    {
+        if (ksq > _ft.argMax()) return 0.;
+        else return _ft(ksq);
+    }
 
+    double MoffatInfo::maxK() const
+    { return _maxk; }
+
+    void MoffatInfo::buildFT()
+    {
         // Do a Hankel transform and store the results in a lookup table.
+        SBMoffat::SBMoffatImpl::PowFunc pow_beta =
+            SBMoffat::SBMoffatImpl::ChoosePowBeta(_beta, *_gsparams);
 
         double prefactor = 2. * (_beta-1.) / (_fluxFactor);
 
         // Along the way, find the last k that has a kValue > 1.e-3
-        double maxk_val = this->gsparams->maxk_threshold;
+        double maxk_val = _gsparams->maxk_threshold;
         dbg<<"Looking for maxk_val = "<<maxk_val<<std::endl;
         // Keep going until at least 5 in a row have kvalues below kvalue_accuracy.
         // (It's oscillatory, so want to make sure not to stop at a zero crossing.)
@@ -605,41 +672,27 @@ namespace galsim {
         // conservative for Sersic, but I haven't investigated here.)
         // 10 h^4 <= kvalue_accuracy
         // h = (kvalue_accuracy/10)^0.25
-        double dk = gsparams->table_spacing * sqrt(sqrt(gsparams->kvalue_accuracy / 10.));
+        double dk = _gsparams->table_spacing * sqrt(sqrt(_gsparams->kvalue_accuracy / 10.));
         dbg<<"dk = "<<dk<<std::endl;
+
+        // Do the whole Hankel transform at once, rather than an integral for each k.
+        // MoffatInfo is only used for truncated profiles, so it always has the edge at _maxRrD.
+        HankelTransform hankel(MoffatRadial(_beta, pow_beta), 1.e-10, _maxRrD, true, dk, 50.,
+                               _gsparams->integration_abserr);
+        dbg<<"Hankel transform error = "<<hankel.getError()<<std::endl;
+
         int n_below_thresh = 0;
         // Don't go past k = 50
         for(double k=0.; k < 50; k += dk) {
-
-            MoffatIntegrand I(_beta, k, _pow_beta);
-
-#ifdef DEBUGLOGGING
-            std::ostream* integ_dbgout = verbose_level >= 3 ? dbgout : 0;
-            integ::IntRegion<double> reg(0, _maxRrD, integ_dbgout);
-#else
-            integ::IntRegion<double> reg(0, _maxRrD);
-#endif
-
-            // Add explicit splits at first several roots of J0.
-            // This tends to make the integral more accurate.
-            for (int s=1; s<=10; ++s) {
-                double root = bessel::getBesselRoot0(s);
-                if (root > k * _maxRrD) break;
-                reg.addSplit(root/k);
-            }
-
-            double val = integ::int1d(
-                I, reg,
-                this->gsparams->integration_relerr,
-                this->gsparams->integration_abserr);
-            val *= prefactor;
+            // The normalization makes the value at k=0 exactly 1.
+            double val = (k == 0.) ? 1. : prefactor * hankel(k);
 
             xdbg<<"ft("<<k<<") = "<<val<<std::endl;
             _ft.addEntry(k*k, val);
 
             if (std::abs(val) > maxk_val) _maxk = k;
 
-            if (std::abs(val) > this->gsparams->kvalue_accuracy) n_below_thresh = 0;
+            if (std::abs(val) > _gsparams->kvalue_accuracy) n_below_thresh = 0;
             else ++n_below_thresh;
             if (n_below_thresh == 5) break;
         }
@@ -23,8 +23,16 @@
 
 #include "SBProfile.h"
 #include "SBTransform.h"
+#include "SBGaussian.h"
 #include "SBProfileImpl.h"
 #include "FFT.h"
+#include "Stopwatch.h"
+
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -94,6 +102,27 @@ namespace galsim {
         return _pimpl->kValue(k);
     }
 
+    void SBProfile::xValueMany(const double* x, const double* y, double* val, int n) const
+    {
+        assert(_pimpl.get());
+        _pimpl->xValueMany(x,y,val,n);
+    }
+
+    void SBProfile::kValueMany(const double* kx, const double* ky, std::complex<double>* val,
+                               int n) const
+    {
+        assert(_pimpl.get());
+        _pimpl->kValueMany(kx,ky,val,n);
+    }
+
+    SBProfile SBProfile::simplify() const
+    {
+        assert(_pimpl.get());
+        SBProfile result;
+        if (_pimpl->simplify(result)) return result;
+        else return *this;
+    }
+
     void SBProfile::getXRange(double& xmin, double& xmax, std::vector<double>& splits) const
     {
         assert(_pimpl.get());
@@ -182,7 +211,19 @@ namespace galsim {
     SBProfile::SBProfile(SBProfileImpl* pimpl) : _pimpl(pimpl) {}
 
     SBProfile::SBProfileImpl::SBProfileImpl(const GSParamsPtr& gsparams) :
-        gsparams(gsparams ? gsparams : GSParamsPtr::getDefault()) {}
+        gsparams(gsparams ? gsparams : GSParamsPtr::getDefault())
+    {
+#ifdef _OPENMP
+        omp_init_lock(&_radial_ktab_lock);
+#endif
+    }
+
+    SBProfile::SBProfileImpl::~SBProfileImpl()
+    {
+#ifdef _OPENMP
+        omp_destroy_lock(&_radial_ktab_lock);
+#endif
+    }
 
     SBProfile::SBProfileImpl* SBProfile::GetImpl(const SBProfile& rhs)
     { return rhs._pimpl.get(); }
@@ -215,10 +256,211 @@ namespace galsim {
     double SBProfile::draw(ImageView<T> img, double gain, double wmult) const
     {
         dbg<<"Start draw ImageView"<<std::endl;
-        if (isAnalyticX())
+        if (_pimpl->gsparams->gaussian_mixture) {
+            // Convolutions of Gaussian mixtures simplify to sums of Gaussians, which are
+            // drawn directly in real space, even if the cost model would prefer an FFT.
+            SBProfile s = simplify();
+            if (GetImpl(s) != _pimpl.get()) {
+                if (s.isAnalyticX()) return s.plainDraw(img, gain);
+                else return s.draw(img, gain, wmult);
+            }
+        }
+        if (!isAnalyticX())
+            return fourierDraw(img, gain, wmult);
+        else if (!isAnalyticK() || !_pimpl->gsparams->choose_draw_method)
             return plainDraw(img, gain);
-        else
+
+        DrawMethodChoice choice = chooseDrawMethod(img.getBounds(), wmult);
+        if (choice.method == DrawMethodChoice::FOURIER)
             return fourierDraw(img, gain, wmult);
+        else
+            return plainDraw(img, gain);
+    }
+
+    // All access to this goes through a critical section, since draw() may be called from
+    // several threads while another one sets or calibrates the model.
+    static DrawCostModel draw_cost_model;
+
+    void SetDrawCostModel(const DrawCostModel& model)
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_draw_cost_model)
+#endif
+        draw_cost_model = model;
+    }
+
+    DrawCostModel GetDrawCostModel()
+    {
+        DrawCostModel model;
+#ifdef _OPENMP
+#pragma omp critical (galsim_draw_cost_model)
+#endif
+        model = draw_cost_model;
+        return model;
+    }
+
+    // Run f.run() repeatedly until at least min_time seconds have passed, and return the
+    // time per call.
+    template <class F>
+    static double TimePerCall(F& f, double min_time)
+    {
+        Stopwatch timer;
+        int ncalls = 0;
+        do {
+            timer.start();
+            f.run();
+            timer.stop();
+            ++ncalls;
+        } while (double(timer) < min_time);
+        return double(timer) / ncalls;
+    }
+
+    struct PlainDrawBenchmark
+    {
+        PlainDrawBenchmark(const SBProfile& p, ImageView<double> im) : prof(p), image(im) {}
+        void run() { prof.plainDraw(image, 1.); }
+        const SBProfile& prof;
+        ImageView<double> image;
+    };
+
+    struct PlainDrawKBenchmark
+    {
+        PlainDrawKBenchmark(const SBProfile& p, ImageView<double> r, ImageView<double> i) :
+            prof(p), re(r), im(i) {}
+        void run() { prof.plainDrawK(re, im, 1.); }
+        const SBProfile& prof;
+        ImageView<double> re, im;
+    };
+
+    struct FFTBenchmark
+    {
+        FFTBenchmark(const KTable& k) : kt(k) {}
+        void run() { kt.transform(); }
+        const KTable& kt;
+    };
+
+    struct ShootBenchmark
+    {
+        ShootBenchmark(const SBProfile& p, ImageView<double> im, double n) :
+            prof(p), image(im), N(n), ud(1234) {}
+        void run() { prof.drawShoot(image, N, ud, 1., 0., false, true); }
+        const SBProfile& prof;
+        ImageView<double> image;
+        double N;
+        UniformDeviate ud;
+    };
+
+    DrawCostModel CalibrateDrawCost(bool force)
+    {
+        // The timing is done outside the critical section, so if two threads calibrate at the
+        // same time, they both do the measurement and the last one is kept.
+        DrawCostModel current = GetDrawCostModel();
+        if (current.calibrated && !force) return current;
+        dbg<<"Start CalibrateDrawCost"<<std::endl;
+
+        // Time each kind of drawing of a Gaussian, which is the unit of xValueCost and
+        // kValueCost.  Each one is repeated for at least min_time to average over the
+        // resolution of the timer.
+        const double min_time = 0.02;
+        const int n = 128;
+        const int NFT = 256;
+        const double N = 1.e5;
+        SBGaussian gauss(3., 1., GSParamsPtr::getDefault());
+        Bounds<int> b(-n/2, n/2-1, -n/2, n/2-1);
+        ImageAlloc<double> im1(b), im2(b);
+        KTable kt(NFT, 2.*M_PI/NFT, 1.);
+
+        DrawCostModel model;
+        PlainDrawBenchmark plain(gauss, im1.view());
+        model.xvalue = TimePerCall(plain, min_time) / (n*n);
+        PlainDrawKBenchmark plaink(gauss, im1.view(), im2.view());
+        model.kvalue = TimePerCall(plaink, min_time) / (n*n);
+        FFTBenchmark fft(kt);
+        model.fft = TimePerCall(fft, min_time) / (NFT*NFT*std::log(double(NFT))/std::log(2.));
+        ShootBenchmark shoot(gauss, im1.view(), N);
+        model.shoot = TimePerCall(shoot, min_time) / N;
+        model.calibrated = true;
+        dbg<<"xvalue = "<<model.xvalue<<", kvalue = "<<model.kvalue<<
+            ", fft = "<<model.fft<<", shoot = "<<model.shoot<<std::endl;
+
+        SetDrawCostModel(model);
+        return model;
+    }
+
+    std::string DrawMethodChoice::getMethodName() const
+    {
+        switch (method) {
+          case PLAIN: return "plainDraw";
+          case FOURIER: return "fourierDraw";
+          default: return "drawShoot";
+        }
+    }
+
+    DrawMethodChoice SBProfile::chooseDrawMethod(const Bounds<int>& b, double wmult,
+                                                 bool allow_shoot, double N) const
+    {
+        dbg<<"Start chooseDrawMethod for bounds "<<b<<std::endl;
+        assert(_pimpl.get());
+        const DrawCostModel model = GetDrawCostModel();
+        DrawMethodChoice choice;
+        choice.plain_cost = choice.fourier_cost = choice.shoot_cost = -1.;
+        choice.NFT = 0;
+        choice.N = 0.;
+
+        if (isAnalyticX()) {
+            const double npix = double(b.getXMax()-b.getXMin()+1) * (b.getYMax()-b.getYMin()+1);
+            choice.plain_cost = model.xvalue * npix * _pimpl->xValueCost();
+        }
+
+        if (isAnalyticK() && !(isAnalyticX() && _pimpl->preferRealSpace())) {
+            try {
+                int NFT, Nk;
+                getFourierDrawSize(b, wmult, NFT, Nk);
+                // fillKGrid calculates the kx >= 0 half of the Nk x Nk grid.
+                const double nk = double(Nk/2+1) * (Nk+1);
+                const double nfft = double(NFT) * NFT * std::log(double(NFT))/std::log(2.);
+                choice.fourier_cost = model.kvalue * nk * _pimpl->kValueCost() + model.fft * nfft;
+                choice.NFT = NFT;
+            } catch (SBError& e) {
+                // The FFT would be too large, so fourierDraw isn't an option.
+                dbg<<"fourierDraw not allowed: "<<e.what()<<std::endl;
+            }
+        }
+
+        if (allow_shoot) {
+            if (N == 0.) {
+                // The same number of photons as drawShoot uses for N = 0.
+                const double posflux = getPositiveFlux();
+                const double negflux = getNegativeFlux();
+                if (posflux + negflux > 0.) {
+                    const double eta_factor = 1.-2.*negflux/(posflux+negflux);
+                    N = std::abs(getFlux()) / (eta_factor*eta_factor);
+                }
+            }
+            choice.N = N;
+            // Each photon goes through each level of the profile, like each kValue.
+            choice.shoot_cost = model.shoot * std::max(N,1.) * _pimpl->kValueCost();
+        }
+
+        // Pick the cheapest of the allowed methods.
+        double best = -1.;
+        if (choice.plain_cost >= 0.) {
+            choice.method = DrawMethodChoice::PLAIN;
+            best = choice.plain_cost;
+        }
+        if (choice.fourier_cost >= 0. && (best < 0. || choice.fourier_cost < best)) {
+            choice.method = DrawMethodChoice::FOURIER;
+            best = choice.fourier_cost;
+        }
+        if (choice.shoot_cost >= 0. && (best < 0. || choice.shoot_cost < best)) {
+            choice.method = DrawMethodChoice::SHOOT;
+            best = choice.shoot_cost;
+        }
+        if (best < 0.)
+            throw SBError("chooseDrawMethod() found no way to draw this profile");
+        dbg<<"plain_cost = "<<choice.plain_cost<<", fourier_cost = "<<choice.fourier_cost<<
+            ", shoot_cost = "<<choice.shoot_cost<<" -> "<<choice.getMethodName()<<std::endl;
+        return choice;
     }
 
     int SBProfile::getGoodImageSize(double dx, double wmult) const
@@ -341,6 +583,18 @@ namespace galsim {
         }
     }
 
+    void SBProfile::SBProfileImpl::xValueMany(const double* x, const double* y, double* val,
+                                              int n) const
+    {
+        for (int i=0;i<n;++i) val[i] = xValue(Position<double>(x[i],y[i]));
+    }
+
+    void SBProfile::SBProfileImpl::kValueMany(const double* kx, const double* ky,
+                                              std::complex<double>* val, int n) const
+    {
+        for (int i=0;i<n;++i) val[i] = kValue(Position<double>(kx[i],ky[i]));
+    }
+
     // Note: Once we have TMV 0.90, this won't be necessary, since arithmetic between different
     // types will be allowed.
     template <typename T>
@@ -392,6 +646,54 @@ namespace galsim {
         return totalflux * gain;
     }
 
+    // Add n values of xt/gain to a row of an image.  Returns the sum of the values added.
+    template <typename T, typename U>
+    static double AddFourierDrawRow(const U* xt, T* I, int n, double gain)
+    {
+        double sum=0.;
+        for (int i=0; i<n; ++i) {
+            double temp = xt[i] / gain;
+            I[i] += T(temp);
+            sum += temp;
+        }
+        return sum;
+    }
+
+    // Add the transformed image xt (an XTable or XTableF) to I, returning the flux added.
+    template <typename T, class XT>
+    static double AddFourierDraw(const XT& xt, ImageView<T> I, double gain)
+    {
+        int Nxt = xt.getN();
+        dbg<<"Nxt = "<<Nxt<<std::endl;
+
+#ifdef OUTPUT_FFT
+        std::ofstream fout("xt.dat");
+        for (int i=0; i<Nxt*Nxt; ++i) fout << xt.getArray()[i] << ((i+1)%Nxt ? " " : "\n");
+        fout.close();
+#endif
+
+        Bounds<int> xb(-Nxt/2, Nxt/2-1, -Nxt/2, Nxt/2-1);
+        if (I.getYMin() < xb.getYMin()
+            || I.getYMax() > xb.getYMax()
+            || I.getXMin() < xb.getXMin()
+            || I.getXMax() > xb.getXMax()) {
+            dbg << "Bounds error!! target image bounds " << I.getBounds()
+                << " and FFT range " << xb << std::endl;
+            throw SBError("fourierDraw() FT bounds do not cover target image");
+        }
+        // Copy the rows directly, rather than going through xt.xval(x,y) for each pixel.
+        const int nx = I.getXMax() - I.getXMin() + 1;
+        const int Nxto2 = Nxt/2;
+        double sum=0.;
+        for (int y = I.getYMin(); y <= I.getYMax(); y++) {
+            const int iy = y - I.getYMin();
+            sum += AddFourierDrawRow(xt.getArray() + (y+Nxto2)*Nxt + (I.getXMin()+Nxto2),
+                                     I.getData() + iy*I.getStride(), nx, gain);
+        }
+
+        return sum * gain;
+    }
+
     // Now the more complex case: real space via FT from k space.
     // Will enforce image size is power of 2 or 3x2^n.
     // Aliasing will be handled by folding the k values before transforming
@@ -400,10 +702,33 @@ namespace galsim {
     double SBProfile::fourierDraw(ImageView<T> I, double gain, double wmult) const
     {
         dbg<<"Start fourierDraw"<<std::endl;
-        Bounds<int> imgBounds; // Bounds for output image
+        int NFT, Nk;
+        getFourierDrawSize(I.getBounds(), wmult, NFT, Nk);
+        boost::shared_ptr<KTable> kt = makeFourierDrawKTable(NFT, Nk);
+        if (_pimpl->gsparams->single_precision_fft) {
+            dbg<<"Use single precision FFT"<<std::endl;
+            return AddFourierDraw(*kt->transformFloat(), I, gain);
+        } else if (I.getYMax() - I.getYMin() + 1 <= NFT/2 &&
+                   I.getYMin() >= -NFT/2 && I.getYMax() < NFT/2) {
+            // The image only covers a small part of the FFT, so only calculate those rows.
+            dbg<<"Use partial transform for rows "<<I.getYMin()<<".."<<I.getYMax()<<std::endl;
+            XTable xt(NFT, 1.);
+            kt->transform(xt, I.getYMin(), I.getYMax());
+            return AddFourierDraw(xt, I, gain);
+        } else {
+            return AddFourierDraw(*kt->transform(), I, gain);
+        }
+    }
+
+    // Work out the size of the FFT to use for fourierDraw onto an image with bounds b.
+    // If the k values will be aliased, Nk is the (larger) size of the k grid out to maxK,
+    // which is wrapped down to NFT.  Otherwise Nk = NFT.
+    void SBProfile::getFourierDrawSize(const Bounds<int>& b, double wmult,
+                                       int& NFT, int& Nk) const
+    {
         dbg<<"  maxK() = "<<maxK()<<std::endl;
         dbg<<"  stepK() = "<<stepK()<<std::endl;
-        dbg<<"  image bounds = "<<I.getBounds()<<std::endl;
+        dbg<<"  image bounds = "<<b<<std::endl;
         dbg<<"  wmult = "<<wmult<<std::endl;
 
         int Nnofold = getGoodImageSize(1.,wmult);
@@ -411,14 +736,14 @@ namespace galsim {
 
         // We must make something big enough to cover the target image size:
         int xSize, ySize;
-        xSize = I.getXMax()-I.getXMin()+1;
-        ySize = I.getYMax()-I.getYMin()+1;
+        xSize = b.getXMax()-b.getXMin()+1;
+        ySize = b.getYMax()-b.getYMin()+1;
         if (xSize  > Nnofold) Nnofold = xSize;
         if (ySize  > Nnofold) Nnofold = ySize;
         dbg<<" After scale up to image size, Nnofold = "<<Nnofold<<std::endl;
 
         // Round up to a good size for making FFTs:
-        int NFT = goodFFTSize(Nnofold);
+        NFT = goodFFTSize(Nnofold);
         NFT = std::max(NFT,_pimpl->gsparams->minimum_fft_size);
         dbg << " After adjustments: Nnofold " << Nnofold << " NFT " << NFT << std::endl;
 
@@ -428,7 +753,6 @@ namespace galsim {
             " maxK " << dk*NFT/2 << std::endl;
         xdbg<<"dk - stepK() = "<<dk-(stepK()*(1.+1.e-8))<<std::endl;
         xassert(dk <= stepK()*(1. + 1.e-8)); // Add a little slop in case of rounding errors.
-        boost::shared_ptr<XTable> xt;
         if (NFT*dk/2 > maxK()) {
             dbg<<"NFT*dk/2 = "<<NFT*dk/2<<" > maxK() = "<<maxK()<<std::endl;
             dbg<<"Use NFT = "<<NFT<<std::endl;
@@ -436,55 +760,139 @@ namespace galsim {
                 FormatAndThrow<SBError>() <<
                     "fourierDraw() requires an FFT that is too large, " << NFT <<
                     "\nIf you can handle the large FFT, you may update gsparams.maximum_fft_size.";
-            // No aliasing: build KTable and transform
-            KTable kt(NFT,dk);
-            assert(_pimpl.get());
-            _pimpl->fillKGrid(kt);
-            xt = kt.transform();
+            Nk = NFT;
         } else {
             dbg<<"NFT*dk/2 = "<<NFT*dk/2<<" <= maxK() = "<<maxK()<<std::endl;
-            // There will be aliasing.  Construct a KTable out to maxK() and
-            // then wrap it
-            int Nk = int(std::ceil(maxK()/dk)) * 2;
+            // There will be aliasing.  Fill the k values out to maxK() and
+            // wrap them onto the NFT grid.
+            Nk = int(std::ceil(maxK()/dk)) * 2;
             dbg<<"Use Nk = "<<Nk<<std::endl;
             if (Nk > _pimpl->gsparams->maximum_fft_size)
                 FormatAndThrow<SBError>() <<
                     "fourierDraw() requires an FFT that is too large, " << Nk <<
                     "\nIf you can handle the large FFT, you may update gsparams.maximum_fft_size.";
-            KTable kt(Nk, dk);
-            assert(_pimpl.get());
-            _pimpl->fillKGrid(kt);
-            xt = kt.wrap(NFT)->transform();
         }
-        int Nxt = xt->getN();
-        dbg<<"Nxt = "<<Nxt<<std::endl;
+    }
 
-#ifdef OUTPUT_FFT
-        std::ofstream fout("xt.dat");
-        tmv::MatrixView<double> mxt(xt->getArray(),Nxt,Nxt,1,Nxt,tmv::NonConj);
-        fout << tmv::EigenIO() << mxt << std::endl;
-        fout.close();
-#endif
+    // Fill the KTable to transform for fourierDraw, with sizes from getFourierDrawSize.
+    boost::shared_ptr<KTable> SBProfile::makeFourierDrawKTable(int NFT, int Nk) const
+    {
+        assert(_pimpl.get());
+        double dk = 2.*M_PI/NFT;
+        boost::shared_ptr<KTable> kt(new KTable(NFT, dk));
+        // If necessary, this wraps the k values down to NFT as they are calculated.
+        if (Nk != NFT) _pimpl->fillKGrid(*kt, Nk);
+        else _pimpl->fillKGrid(*kt);
+        return kt;
+    }
 
-        Bounds<int> xb(-Nxt/2, Nxt/2-1, -Nxt/2, Nxt/2-1);
-        if (I.getYMin() < xb.getYMin()
-            || I.getYMax() > xb.getYMax()
-            || I.getXMin() < xb.getXMin()
-            || I.getXMax() > xb.getXMax()) {
-            dbg << "Bounds error!! target image bounds " << I.getBounds()
-                << " and FFT range " << xb << std::endl;
-            throw SBError("fourierDraw() FT bounds do not cover target image");
+    // Draw many profiles at once.  The profiles are grouped by the size of FFT they need,
+    // and each group is transformed in batches with KTable::transformMany.
+    template <typename T>
+    std::vector<double> SBProfile::fourierDrawMany(
+        const std::vector<SBProfile>& profs, const std::vector<ImageView<T> >& images,
+        double gain, double wmult)
+    {
+        dbg<<"Start fourierDrawMany for "<<profs.size()<<" profiles"<<std::endl;
+        if (profs.size() != images.size())
+            throw SBError("fourierDrawMany() requires the same number of profiles and images");
+        const int n = profs.size();
+        std::vector<double> sums(n, 0.);
+
+        std::vector<int> Nk(n);
+        std::map<int, std::vector<int> > groups;
+        for (int i=0; i<n; ++i) {
+            // The batched transforms are only done in double precision.
+            if (profs[i]._pimpl->gsparams->single_precision_fft) {
+                sums[i] = profs[i].fourierDraw(images[i], gain, wmult);
+                continue;
+            }
+            int NFT;
+            profs[i].getFourierDrawSize(images[i].getBounds(), wmult, NFT, Nk[i]);
+            groups[NFT].push_back(i);
         }
-        double sum=0.;
-        for (int y = I.getYMin(); y <= I.getYMax(); y++) {
-            for (int x = I.getXMin(); x <= I.getXMax(); x++) {
-                double temp = xt->xval(x,y) / gain;
-                I(x,y) += T(temp);
-                sum += temp;
+
+        std::map<int, std::vector<int> >::const_iterator it;
+        for (it=groups.begin(); it!=groups.end(); ++it) {
+            const int NFT = it->first;
+            const std::vector<int>& index = it->second;
+            // Limit the memory used by each batch.
+            const int max_batch = std::max(1, int(sbp::max_fourier_batch_pixels / (NFT*NFT)));
+            dbg<<"NFT = "<<NFT<<": "<<index.size()<<" profiles, max_batch = "<<max_batch<<"\n";
+            for (size_t k0=0; k0<index.size(); k0+=max_batch) {
+                const size_t nb = std::min(size_t(max_batch), index.size()-k0);
+                std::vector<boost::shared_ptr<KTable> > kt(nb);
+                for (size_t k=0; k<nb; ++k) {
+                    const int i = index[k0+k];
+                    kt[k] = profs[i].makeFourierDrawKTable(NFT, Nk[i]);
+                }
+                std::vector<boost::shared_ptr<XTable> > xt;
+                KTable::transformMany(kt, xt);
+                for (size_t k=0; k<nb; ++k) {
+                    const int i = index[k0+k];
+                    sums[i] = AddFourierDraw(*xt[k], images[i], gain);
+                }
             }
         }
+        return sums;
+    }
 
-        return sum * gain;
+    // Draw this profile at many offsets.  The offsets that need the same size of FFT are
+    // grouped together, and each group fills the unshifted k values just once for all of them.
+    template <typename T>
+    std::vector<double> SBProfile::fourierDrawOffsets(
+        const std::vector<Position<double> >& offsets,
+        const std::vector<ImageView<T> >& images, double gain, double wmult) const
+    {
+        dbg<<"Start fourierDrawOffsets for "<<offsets.size()<<" offsets"<<std::endl;
+        if (offsets.size() != images.size())
+            throw SBError("fourierDrawOffsets() requires the same number of offsets and images");
+        const int n = offsets.size();
+        std::vector<double> sums(n, 0.);
+
+        // The shift makes stepK smaller, so the FFT size has to be found for each offset.
+        std::vector<int> Nk(n);
+        std::map<int, std::vector<int> > groups;
+        for (int i=0; i<n; ++i) {
+            SBProfile shifted = shift(offsets[i]);
+            // The batched transforms are only done in double precision.
+            if (_pimpl->gsparams->single_precision_fft) {
+                sums[i] = shifted.fourierDraw(images[i], gain, wmult);
+                continue;
+            }
+            int NFT;
+            shifted.getFourierDrawSize(images[i].getBounds(), wmult, NFT, Nk[i]);
+            groups[NFT].push_back(i);
+        }
+
+        std::map<int, std::vector<int> >::const_iterator it;
+        for (it=groups.begin(); it!=groups.end(); ++it) {
+            const int NFT = it->first;
+            const std::vector<int>& index = it->second;
+            // Nk only depends on NFT and maxK, which the shifts don't change.
+            const int Nkg = Nk[index[0]];
+            const double dk = 2.*M_PI/NFT;
+            // Limit the memory used by each batch.
+            const int max_batch = std::max(1, int(sbp::max_fourier_batch_pixels / (NFT*NFT)));
+            dbg<<"NFT = "<<NFT<<": "<<index.size()<<" offsets, max_batch = "<<max_batch<<"\n";
+            for (size_t k0=0; k0<index.size(); k0+=max_batch) {
+                const size_t nb = std::min(size_t(max_batch), index.size()-k0);
+                std::vector<boost::shared_ptr<KTable> > kt(nb);
+                std::vector<Position<double> > off(nb);
+                for (size_t k=0; k<nb; ++k) {
+                    kt[k].reset(new KTable(NFT, dk));
+                    off[k] = offsets[index[k0+k]];
+                }
+                _pimpl->fillKGrids(kt, off, Nkg);
+                std::vector<boost::shared_ptr<XTable> > xt;
+                KTable::transformMany(kt, xt);
+                for (size_t k=0; k<nb; ++k) {
+                    const int i = index[k0+k];
+                    sums[i] = AddFourierDraw(*xt[k], images[i], gain);
+                }
+            }
+        }
+        return sums;
     }
 
     template <typename T>
@@ -596,6 +1004,151 @@ namespace galsim {
         }
     }
 
+    // The type of T (real or complex) determines whether FillGrid calls fillXValue or
+    // fillKValue.
+    template <typename T>
+    struct GridHelper
+    {
+        static void fill(const SBProfile::SBProfileImpl& prof, tmv::MatrixView<T> val,
+                         double x0, double dx, int izero, double y0, double dy, int jzero)
+        { prof.fillXValue(val,x0,dx,izero,y0,dy,jzero); }
+    };
+
+    template <typename T>
+    struct GridHelper<std::complex<T> >
+    {
+        static void fill(const SBProfile::SBProfileImpl& prof,
+                         tmv::MatrixView<std::complex<T> > val,
+                         double kx0, double dkx, int izero, double ky0, double dky, int jzero)
+        { prof.fillKValue(val,kx0,dkx,izero,ky0,dky,jzero); }
+    };
+
+    // The grid fills are split into blocks of this many rows, which are filled in parallel
+    // when several FFT threads are set.  Grids with fewer rows than min_threaded_fill_size
+    // are always done in a single thread.
+    static const int fill_block_size = 16;
+    static const int min_threaded_fill_size = 128;
+
+    // Exceptions can't propagate out of an OpenMP region, so the threads save the first one
+    // here and it is rethrown with its original type once the region is done.
+    class ThreadError
+    {
+    public:
+        // Call this from inside a catch(...) block.
+        void save()
+        {
+            boost::shared_ptr<Base> err;
+            try {
+                throw;
+            } catch (FFTOutofRange& e) {
+                err.reset(new Holder<FFTOutofRange>(e));
+            } catch (FFTInvalid& e) {
+                err.reset(new Holder<FFTInvalid>(e));
+            } catch (FFTError& e) {
+                err.reset(new Holder<FFTError>(e));
+            } catch (SBError& e) {
+                err.reset(new Holder<SBError>(e));
+            } catch (ImageError& e) {
+                err.reset(new Holder<ImageError>(e));
+            } catch (std::bad_alloc& e) {
+                err.reset(new Holder<std::bad_alloc>(e));
+            } catch (std::runtime_error& e) {
+                err.reset(new Holder<std::runtime_error>(e));
+            } catch (std::logic_error& e) {
+                err.reset(new Holder<std::logic_error>(e));
+            } catch (std::exception& e) {
+                err.reset(new Holder<std::runtime_error>(std::runtime_error(e.what())));
+            } catch (...) {
+                err.reset(new Holder<std::runtime_error>(std::runtime_error("Unknown exception")));
+            }
+#ifdef _OPENMP
+#pragma omp critical (galsim_thread_error)
+#endif
+            {
+                if (!_err) _err = err;
+            }
+        }
+
+        void rethrow() const { if (_err) _err->raise(); }
+
+    private:
+        struct Base
+        {
+            virtual ~Base() {}
+            virtual void raise() const = 0;
+        };
+
+        template <typename E>
+        struct Holder : public Base
+        {
+            Holder(const E& e) : _e(e) {}
+            void raise() const { throw _e; }
+            E _e;
+        };
+
+        boost::shared_ptr<Base> _err;
+    };
+
+    static int NumFillThreads(int nrows)
+    {
+#ifdef _OPENMP
+        if (omp_in_parallel()) return 1;
+#endif
+        return nrows >= min_threaded_fill_size ? getFFTThreads() : 1;
+    }
+
+    // Fill rows i1 <= i < i2 of val.  Some of the fill functions need val to be contiguous,
+    // so fill a temporary matrix and copy it over.
+    template <typename T>
+    static void FillGridBlock(const SBProfile::SBProfileImpl& prof, tmv::MatrixView<T> val,
+                              int i1, int i2, double x0, double dx, int izero,
+                              double y0, double dy, int jzero)
+    {
+        const int iz = (izero > i1 && izero < i2) ? izero - i1 : 0;
+        tmv::Matrix<T> block(i2-i1, val.rowsize());
+        GridHelper<T>::fill(prof,block.view(),x0+i1*dx,dx,iz,y0,dy,jzero);
+        val.rowRange(i1,i2) = block;
+    }
+
+    // Fill val with the x or k values of prof, with the same arguments as fillXValue or
+    // fillKValue.  With more than one thread, the rows (x values) are split into blocks.
+    // Each block has all the columns (y values), so the profiles can still use any
+    // symmetry in y, and the block that has x = 0 can use the symmetry in x too.
+    template <typename T>
+    static void FillGrid(const SBProfile::SBProfileImpl& prof, tmv::MatrixView<T> val,
+                         double x0, double dx, int izero, double y0, double dy, int jzero,
+                         int nthreads)
+    {
+        const int m = val.colsize();
+        if (nthreads <= 1) {
+            if (val.canLinearize()) GridHelper<T>::fill(prof,val,x0,dx,izero,y0,dy,jzero);
+            else FillGridBlock(prof,val,0,m,x0,dx,izero,y0,dy,jzero);
+            return;
+        }
+        const int nblock = (m + fill_block_size - 1) / fill_block_size;
+        dbg<<"FillGrid: "<<nblock<<" blocks with "<<nthreads<<" threads"<<std::endl;
+
+        // Do the first block before starting the other threads.  Anything the profile builds
+        // the first time it is used (e.g. lookup tables) is safe to build from several threads,
+        // but this way the other threads don't all have to wait for it.
+        FillGridBlock(prof,val,0,std::min(fill_block_size,m),x0,dx,izero,y0,dy,jzero);
+
+        ThreadError err;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+#endif
+        for (int b=1; b<nblock; ++b) {
+            const int i1 = b * fill_block_size;
+            const int i2 = std::min(i1 + fill_block_size, m);
+            try {
+                FillGridBlock(prof,val,i1,i2,x0,dx,izero,y0,dy,jzero);
+            } catch (...) {
+                err.save();
+            }
+        }
+        err.rethrow();
+    }
+
     void SBProfile::SBProfileImpl::fillXGrid(XTable& xt) const
     {
         xdbg<<"Start fillXGrid"<<std::endl;
@@ -608,25 +1161,16 @@ namespace galsim {
 #ifdef DEBUGLOGGING
         val.setAllTo(999.);
 #endif
-        fillXValue(val.view(),-(N/2)*dx,dx,N/2,-(N/2)*dx,dx,N/2);
+        FillGrid(*this,val.view(),-(N/2)*dx,dx,N/2,-(N/2)*dx,dx,N/2,NumFillThreads(N));
 
         tmv::MatrixView<double> mxt(xt.getArray(),N,N,1,N,tmv::NonConj);
         mxt = val;
     }
 
-    void SBProfile::SBProfileImpl::fillKGrid(KTable& kt) const
+    // Copy the k values in val, which has kx = 0..N/2 and ky = -N/2..N/2, into kt.
+    static void CopyKGrid(const tmv::ConstMatrixView<std::complex<double> >& val, KTable& kt)
     {
-        dbg<<"Start fillKGrid\n";
-        int N = kt.getN();
-        double dk = kt.getDk();
-        kt.clearCache();
-
-        tmv::Matrix<std::complex<double> > val(N/2+1,N+1);
-#ifdef DEBUGLOGGING
-        val.setAllTo(999.);
-#endif
-        fillKValue(val.view(),0.,dk,0,-N/2*dk,dk,N/2);
-
+        const int N = kt.getN();
         tmv::MatrixView<std::complex<double> > mkt(kt.getArray(),N/2+1,N,1,N/2+1,tmv::NonConj);
 #ifdef DEBUGLOGGING
         mkt.setAllTo(1.e100);
@@ -662,6 +1206,132 @@ namespace galsim {
 #endif
     }
 
+    // Wrap a block of k values, v, with kx = ix1..ix1+nx-1 and ky = -Nk/2..Nk/2 (times dk),
+    // onto kt.  v is modified in the process.
+    static void WrapKGridBlock(tmv::MatrixView<std::complex<double> > v, int ix1, int Nk,
+                               KTable& kt)
+    {
+        const int Nko2 = Nk/2;
+        const int nx = v.colsize();
+        // Use the same treatment of the Nyquist row and column as fillKGrid.
+        // The ky = -Nk/2 column is the average of the ky = +-Nk/2 values.
+        v.col(0) = 0.5*v.col(0) + 0.5*v.col(Nk);
+        // The kx = Nk/2 values are averaged with the conjugates of their reflections.
+        if (ix1+nx == Nko2+1) {
+            tmv::VectorView<std::complex<double> > nyq = v.row(nx-1);
+            nyq.subVector(Nko2+1,Nk) += nyq.subVector(Nko2-1,0,-1).conjugate();
+            nyq.subVector(Nko2+1,Nk) *= 0.5;
+            nyq.subVector(Nko2-1,0,-1) = nyq.subVector(Nko2+1,Nk).conjugate();
+        }
+
+        // Column j of v has the values for iy = j-Nk/2.  (Skip j = Nk, which is done.)
+        for (int j=0; j<Nk; ++j)
+            kt.accumulateWrapped(v.col(j).cptr(),ix1,ix1+nx,Nk,j-Nko2);
+    }
+
+    // Set shifted = val * exp(-i k.offset), where val has kx = kx0 + i dk, ky = ky0 + j dk.
+    // The phases are separable, so only the kx and ky phases need to be calculated.
+    static void ShiftKGrid(const tmv::ConstMatrixView<std::complex<double> >& val,
+                           tmv::MatrixView<std::complex<double> > shifted,
+                           double kx0, double ky0, double dk, const Position<double>& offset)
+    {
+        const int m = val.colsize();
+        const int n = val.rowsize();
+        tmv::Vector<std::complex<double> > kx_phase(m);
+        tmv::Vector<std::complex<double> > ky_phase(n);
+        for (int i=0;i<m;++i) kx_phase[i] = std::polar(1., -(kx0+i*dk)*offset.x);
+        for (int j=0;j<n;++j) ky_phase[j] = std::polar(1., -(ky0+j*dk)*offset.y);
+        shifted = DiagMatrixViewOf(kx_phase) * val;
+        shifted = shifted * DiagMatrixViewOf(ky_phase);
+    }
+
+    void SBProfile::SBProfileImpl::fillKGrid(KTable& kt) const
+    {
+        dbg<<"Start fillKGrid\n";
+        int N = kt.getN();
+        double dk = kt.getDk();
+        kt.clearCache();
+
+        tmv::Matrix<std::complex<double> > val(N/2+1,N+1);
+#ifdef DEBUGLOGGING
+        val.setAllTo(999.);
+#endif
+        FillGrid(*this,val.view(),0.,dk,0,-N/2*dk,dk,N/2,NumFillThreads(N/2+1));
+        CopyKGrid(val,kt);
+    }
+
+    void SBProfile::SBProfileImpl::fillKGrid(KTable& kt, int Nk) const
+    {
+        dbg<<"Start fillKGrid with Nk = "<<Nk<<std::endl;
+        const int N = kt.getN();
+        const double dk = kt.getDk();
+        Nk = 2*((Nk+1)/2);
+        if (Nk <= N) { fillKGrid(kt); return; }
+        kt.clear();
+
+        // Do blocks of kx values at a time, each with the full range of ky, so the profiles
+        // can still use the symmetry in ky (cf. fillKValueQuadrant).  The blocks are about
+        // the size of the output table.
+        // With several threads, each block is split among them.
+        const int Nko2 = Nk/2;
+        const int nthreads = NumFillThreads(Nko2+1);
+        const int nbx = std::min(Nko2+1, std::max(fill_block_size * nthreads,
+                                                  N*(N/2+1)/(Nk+1)));
+        dbg<<"Use blocks of "<<nbx<<" kx values"<<std::endl;
+        tmv::Matrix<std::complex<double> > val(nbx,Nk+1);
+        for (int ix1=0; ix1<=Nko2; ix1+=nbx) {
+            const int nx = std::min(nbx, Nko2+1-ix1);
+            tmv::MatrixView<std::complex<double> > v = val.rowRange(0,nx);
+#ifdef DEBUGLOGGING
+            v.setAllTo(999.);
+#endif
+            FillGrid(*this,v,ix1*dk,dk,0,-Nko2*dk,dk,Nko2,nthreads);
+            WrapKGridBlock(v,ix1,Nk,kt);
+        }
+    }
+
+    void SBProfile::SBProfileImpl::fillKGrids(
+        const std::vector<boost::shared_ptr<KTable> >& kt,
+        const std::vector<Position<double> >& offsets, int Nk) const
+    {
+        dbg<<"Start fillKGrids for "<<kt.size()<<" offsets, Nk = "<<Nk<<std::endl;
+        assert(kt.size() == offsets.size());
+        if (kt.empty()) return;
+        const int N = kt[0]->getN();
+        const double dk = kt[0]->getDk();
+        Nk = 2*((Nk+1)/2);
+        if (Nk <= N) {
+            tmv::Matrix<std::complex<double> > val(N/2+1,N+1);
+            FillGrid(*this,val.view(),0.,dk,0,-N/2*dk,dk,N/2,NumFillThreads(N/2+1));
+            tmv::Matrix<std::complex<double> > shifted(N/2+1,N+1);
+            for (size_t k=0; k<kt.size(); ++k) {
+                kt[k]->clearCache();
+                ShiftKGrid(val,shifted.view(),0.,-N/2*dk,dk,offsets[k]);
+                CopyKGrid(shifted,*kt[k]);
+            }
+        } else {
+            // As in fillKGrid(kt,Nk), but each block is shifted and wrapped onto every table.
+            for (size_t k=0; k<kt.size(); ++k) kt[k]->clear();
+            const int Nko2 = Nk/2;
+            const int nthreads = NumFillThreads(Nko2+1);
+            const int nbx = std::min(Nko2+1, std::max(fill_block_size * nthreads,
+                                                      N*(N/2+1)/(Nk+1)));
+            dbg<<"Use blocks of "<<nbx<<" kx values"<<std::endl;
+            tmv::Matrix<std::complex<double> > val(nbx,Nk+1);
+            tmv::Matrix<std::complex<double> > shifted(nbx,Nk+1);
+            for (int ix1=0; ix1<=Nko2; ix1+=nbx) {
+                const int nx = std::min(nbx, Nko2+1-ix1);
+                tmv::MatrixView<std::complex<double> > v = val.rowRange(0,nx);
+                tmv::MatrixView<std::complex<double> > sv = shifted.rowRange(0,nx);
+                FillGrid(*this,v,ix1*dk,dk,0,-Nko2*dk,dk,Nko2,nthreads);
+                for (size_t k=0; k<kt.size(); ++k) {
+                    ShiftKGrid(v,sv,ix1*dk,-Nko2*dk,dk,offsets[k]);
+                    WrapKGridBlock(sv,ix1,Nk,*kt[k]);
+                }
+            }
+        }
+    }
+
     // The type of T (real or complex) determines whether the call-back is to
     // fillXValue or fillKValue.
     template <typename T>
@@ -768,10 +1438,218 @@ namespace galsim {
         FillQuadrant(*this,val,kx0,dkx,nkx1,ky0,dky,nky1);
     }
 
+    // Only use the radial table if the grid has at least this many columns.  The decision
+    // doesn't depend on the number of rows, so the row blocks of a threaded fillKGrid make
+    // the same choice as a serial fill of the whole grid.
+    static const int radial_table_min_cols = 64;
+    // The largest number of knots in a radial table.  Points with larger |k| use kValue.
+    static const int radial_table_max_size = 1<<16;
+    // Points with |k| less than this many knot spacings use kValue, so the interpolation
+    // doesn't have to follow a cusp at k=0 (e.g. Kolmogorov has f ~ exp(-k^5/3)).
+    static const int radial_table_direct = 2;
+
+    // kValue at |k| = i h for 0 <= i < size()+2, and the coefficients of the cubic through
+    // the 4 nearest knots for each interval i h <= |k| < (i+1) h, in terms of t = |k|/h - i.
+    // A table is never changed once it is made, so threads can keep using one while another
+    // thread extends it.
+    class SBProfile::SBProfileImpl::RadialKTable
+    {
+    public:
+        RadialKTable(const SBProfileImpl& prof, double h, int n, const RadialKTable* prev) :
+            _h(h), _invh(1./h), _n(n), _f(n+2), _coef(4*n)
+        {
+            int i0 = 0;
+            if (prev) {
+                assert(prev->_h == h);
+                i0 = prev->_f.size();
+                std::copy(prev->_f.begin(), prev->_f.end(), _f.begin());
+            }
+            for (int i=i0; i<n+2; ++i) _f[i] = prof.kValue(Position<double>(i*h, 0.)).real();
+            for (int i=1; i<n; ++i) {
+                const double fm = _f[i-1], f0 = _f[i], f1 = _f[i+1], f2 = _f[i+2];
+                double* c = &_coef[4*i];
+                c[0] = f0;
+                c[1] = f1 - (2.*fm + 3.*f0 + f2) / 6.;
+                c[2] = 0.5 * (fm + f1) - f0;
+                c[3] = (f2 - fm) / 6. + 0.5 * (f0 - f1);
+            }
+        }
+
+        double getSpacing() const { return _h; }
+        int size() const { return _n; }
+
+        double operator()(const SBProfileImpl& prof, double kx, double ky) const
+        {
+            double t = std::sqrt(kx*kx + ky*ky) * _invh;
+            if (t < radial_table_direct || t >= _n)
+                return prof.kValue(Position<double>(kx,ky)).real();
+            int it = int(t);
+            t -= it;
+            const double* c = &_coef[4*it];
+            return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+        }
+
+    private:
+        double _h, _invh;
+        int _n;
+        std::vector<double> _f;
+        std::vector<double> _coef;
+    };
+
+    boost::shared_ptr<const SBProfile::SBProfileImpl::RadialKTable>
+    SBProfile::SBProfileImpl::getRadialKTable(double kmax) const
+    {
+        boost::shared_ptr<const RadialKTable> tab;
+#ifdef _OPENMP
+        omp_set_lock(&_radial_ktab_lock);
+        try {
+#endif
+            // The error of the cubic interpolation is at most 0.0234 h^4 |f''''|.  For a
+            // profile that extends to about R = pi/stepK, |f''''| <~ R^4 f(0), so use
+            // h = (kvalue_accuracy/0.0234)^1/4 / R.
+            const double h = _radial_ktab ? _radial_ktab->getSpacing() :
+                std::pow(gsparams->kvalue_accuracy / 0.0234, 0.25) * stepK() / M_PI;
+            const int old_size = _radial_ktab ? _radial_ktab->size() : 0;
+            const int need = int(std::min(kmax / h + 1., double(radial_table_max_size)));
+            if (need > old_size) {
+                // Grow by at least a factor of 2, so a grid whose blocks need larger and
+                // larger |k| only extends the table a few times.
+                const int n = std::min(std::max(need, 2*old_size), radial_table_max_size);
+                dbg<<"Extend radial k table from "<<old_size<<" to "<<n<<" knots"<<std::endl;
+                _radial_ktab.reset(new RadialKTable(*this, h, n, _radial_ktab.get()));
+            }
+            tab = _radial_ktab;
+#ifdef _OPENMP
+        } catch (...) {
+            omp_unset_lock(&_radial_ktab_lock);
+            throw;
+        }
+        omp_unset_lock(&_radial_ktab_lock);
+#endif
+        return tab;
+    }
+
+    bool SBProfile::SBProfileImpl::fillKValueRadial(
+        tmv::MatrixView<std::complex<double> > val,
+        double kx0, double dkx, double ky0, double dky) const
+    {
+        assert(isAxisymmetric());
+        assert(val.stepi() == 1);
+        const int m = val.colsize();
+        const int n = val.rowsize();
+        if (n < radial_table_min_cols) return false;
+
+        const double kx1 = kx0 + (m-1)*dkx;
+        const double ky1 = ky0 + (n-1)*dky;
+        const double kmax = std::sqrt(std::max(kx0*kx0,kx1*kx1) + std::max(ky0*ky0,ky1*ky1));
+        boost::shared_ptr<const RadialKTable> tab = getRadialKTable(kmax);
+        dbg<<"fillKValueRadial: m,n = "<<m<<','<<n<<", ntab = "<<tab->size()<<std::endl;
+
+        for (int j=0; j<n; ++j, ky0+=dky) {
+            double kx = kx0;
+            std::complex<double>* valj = val.col(j).ptr();
+            for (int i=0; i<m; ++i, kx+=dkx) valj[i] = (*tab)(*this, kx, ky0);
+        }
+        return true;
+    }
+
+    bool SBProfile::SBProfileImpl::fillKValueRadial(
+        tmv::MatrixView<std::complex<double> > val,
+        double kx0, double dkx, double dkxy, double ky0, double dky, double dkyx) const
+    {
+        assert(isAxisymmetric());
+        assert(val.stepi() == 1);
+        const int m = val.colsize();
+        const int n = val.rowsize();
+        if (n < radial_table_min_cols) return false;
+
+        // The largest |k| is at one of the corners.
+        double ksqmax = 0.;
+        for (int c=0; c<4; ++c) {
+            const int i = (c & 1) ? m-1 : 0;
+            const int j = (c & 2) ? n-1 : 0;
+            const double kx = kx0 + i*dkx + j*dkxy;
+            const double ky = ky0 + i*dkyx + j*dky;
+            ksqmax = std::max(ksqmax, kx*kx + ky*ky);
+        }
+        boost::shared_ptr<const RadialKTable> tab = getRadialKTable(std::sqrt(ksqmax));
+        dbg<<"fillKValueRadial: m,n = "<<m<<','<<n<<", ntab = "<<tab->size()<<std::endl;
+
+        for (int j=0; j<n; ++j, kx0+=dkxy, ky0+=dky) {
+            double kx = kx0;
+            double ky = ky0;
+            std::complex<double>* valj = val.col(j).ptr();
+            for (int i=0; i<m; ++i, kx+=dkx, ky+=dkyx) valj[i] = (*tab)(*this, kx, ky);
+        }
+        return true;
+    }
+
+    // Seed for the random number stream of batch ibatch of a drawShoot.
+    // The hash (the splitmix64 finalizer) decorrelates the streams of neighboring batches.
+    // It is a bijection, so different batches always get different seeds.
+    static unsigned long long BatchSeed(unsigned long long key, long ibatch)
+    {
+        unsigned long long h = key + (unsigned long long)(ibatch) * 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    // Shoot N photons in batches of at most maxN, using up to nthreads threads.
+    // Each batch gets its own UniformDeviate, seeded from a 64-bit key drawn from u and the
+    // batch index, so the photons don't depend on which thread shoots which batch.  The
+    // batches are then added to the image in order, so the result is independent of nthreads.
+    template <class T>
+    static double ShootInBatches(
+        const SBProfile& prof, ImageView<T>& img, double N, UniformDeviate u,
+        double flux_scaling, int nthreads, int maxN)
+    {
+#ifdef _OPENMP
+        if (nthreads <= 0) nthreads = omp_get_max_threads();
+#else
+        nthreads = 1;
+#endif
+        const long Ntot = long(N+0.5);
+        const long nbatch = (Ntot + maxN - 1) / maxN;
+        // raw() gives 32 random bits, so use two of them for the key.
+        unsigned long long key = (unsigned long long)(u.raw()) & 0xffffffffULL;
+        key = (key << 32) | ((unsigned long long)(u.raw()) & 0xffffffffULL);
+        dbg<<"ShootInBatches: Ntot = "<<Ntot<<", nbatch = "<<nbatch<<std::endl;
+
+        double added_flux = 0.;
+        // Only keep nthreads batches in memory at a time.
+        std::vector<boost::shared_ptr<PhotonArray> > arrays(nthreads);
+        for (long ibatch0 = 0; ibatch0 < nbatch; ibatch0 += nthreads) {
+            const int nb = int(std::min(long(nthreads), nbatch - ibatch0));
+            ThreadError err;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+#endif
+            for (int k=0; k<nb; ++k) {
+                try {
+                    const long ibatch = ibatch0 + k;
+                    const int thisN = int(std::min(long(maxN), Ntot - ibatch*maxN));
+                    UniformDeviate ud(1);
+                    ud.seed64(BatchSeed(key, ibatch));
+                    arrays[k] = prof.shoot(thisN, ud);
+                    arrays[k]->scaleFlux(flux_scaling * thisN / N);
+                } catch (...) {
+                    err.save();
+                }
+            }
+            err.rethrow();
+            for (int k=0; k<nb; ++k) {
+                added_flux += arrays[k]->addTo(img, nthreads);
+                arrays[k].reset();
+            }
+        }
+        return added_flux;
+    }
+
     template <class T>
     double SBProfile::drawShoot(
         ImageView<T> img, double N, UniformDeviate u, double gain, double max_extra_noise,
-        bool poisson_flux, bool add_to_image) const
+        bool poisson_flux, bool add_to_image, int nthreads) const
     {
         // If N = 0, this routine will try to end up with an image with the number of real
         // photons = flux that has the corresponding Poisson noise. For profiles that are
@@ -837,6 +1715,7 @@ namespace galsim {
         dbg<<"gain = "<<gain<<std::endl;
         dbg<<"max_extra_noise = "<<max_extra_noise<<std::endl;
         dbg<<"poisson = "<<poisson_flux<<std::endl;
+        dbg<<"nthreads = "<<nthreads<<std::endl;
 
         // Don't do more than this at a time to keep the  memory usage reasonable.
         const int maxN = 100000;
@@ -895,6 +1774,16 @@ namespace galsim {
         // If not adding to the current image, zero it out:
         if (!add_to_image) img.setZero();
 
+        // With a fixed number of photons, the batches are independent, so they can be shot
+        // in parallel.  They are shot the same way for any nthreads (including 1), so the
+        // image doesn't depend on the number of threads.  The adaptive max_extra_noise
+        // calculation below is inherently serial.
+        if (max_extra_noise == 0.) {
+            double added_flux = ShootInBatches(*this, img, N, u, flux_scaling, nthreads, maxN);
+            dbg<<"Added flux (falling within image bounds) = "<<added_flux*gain<<std::endl;
+            return added_flux * gain;
+        }
+
         // (The image should already be centered by the python layer.)
         dbg<<"On input, image has central value = "<<img(0,0)<<std::endl;
 
@@ -941,7 +1830,7 @@ namespace galsim {
                 arrays.push_back(pa);
             } else {
                 // Otherwise, we can go ahead and apply it here.
-                added_flux += pa->addTo(img);
+                added_flux += pa->addTo(img, nthreads);
 #ifdef DEBUGLOGGING
                 realized_flux += pa->getTotalFlux();
                 for(int i=0; i<pa->size(); ++i) {
@@ -1027,7 +1916,7 @@ namespace galsim {
             assert(added_flux == 0.);
             for (size_t k=0; k<arrays.size(); ++k) {
                 PhotonArray* pa = arrays[k].get();
-                added_flux += pa->addTo(img);
+                added_flux += pa->addTo(img, nthreads);
 #ifdef DEBUGLOGGING
                 realized_flux += pa->getTotalFlux();
                 for(int i=0; i<pa->size(); ++i) {
@@ -1063,10 +1952,10 @@ namespace galsim {
 
     template double SBProfile::drawShoot(
         ImageView<float> image, double N, UniformDeviate ud, double gain,
-        double max_extra_noise, bool poisson_flux, bool add_to_image) const;
+        double max_extra_noise, bool poisson_flux, bool add_to_image, int nthreads) const;
     template double SBProfile::drawShoot(
         ImageView<double> image, double N, UniformDeviate ud, double gain,
-        double max_extra_noise, bool poisson_flux, bool add_to_image) const;
+        double max_extra_noise, bool poisson_flux, bool add_to_image, int nthreads) const;
 
     template double SBProfile::draw(ImageView<float> img, double gain, double wmult) const;
     template double SBProfile::draw(ImageView<double> img, double gain, double wmult) const;
@@ -1077,6 +1966,19 @@ namespace galsim {
     template double SBProfile::fourierDraw(ImageView<float> I, double gain, double wmult) const;
     template double SBProfile::fourierDraw(ImageView<double> I, double gain, double wmult) const;
 
+    template std::vector<double> SBProfile::fourierDrawMany(
+        const std::vector<SBProfile>& profs, const std::vector<ImageView<float> >& images,
+        double gain, double wmult);
+    template std::vector<double> SBProfile::fourierDrawMany(
+        const std::vector<SBProfile>& profs, const std::vector<ImageView<double> >& images,
+        double gain, double wmult);
+    template std::vector<double> SBProfile::fourierDrawOffsets(
+        const std::vector<Position<double> >& offsets,
+        const std::vector<ImageView<float> >& images, double gain, double wmult) const;
+    template std::vector<double> SBProfile::fourierDrawOffsets(
+        const std::vector<Position<double> >& offsets,
+        const std::vector<ImageView<double> >& images, double gain, double wmult) const;
+
     template void SBProfile::drawK(
         ImageView<float> Re, ImageView<float> Im, double gain, double wmult) const;
     template void SBProfile::drawK(
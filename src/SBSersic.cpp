@@ -24,12 +24,17 @@
 #define BOOST_NO_CXX11_SMART_PTR
 #include <boost/math/special_functions/gamma.hpp>
 #include <boost/math/special_functions/bessel.hpp>
+#include <limits>
+#include <algorithm>
 
 #include "SBSersic.h"
 #include "SBSersicImpl.h"
-#include "integ/Int.h"
+#include "SBGaussian.h"
+#include "SBAdd.h"
 #include "Solve.h"
-#include "bessel/Roots.h"
+#include "Hankel.h"
+#include "TableCache.h"
+#include "VectorMath.h"
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -72,6 +77,12 @@ namespace galsim {
         return static_cast<const SBSersicImpl&>(*_pimpl).getTrunc();
     }
 
+    double SBSersic::getMixtureError() const
+    {
+        assert(dynamic_cast<const SBSersicImpl*>(_pimpl.get()));
+        return static_cast<const SBSersicImpl&>(*_pimpl).getMixtureError();
+    }
+
     // NB.  This function is virtually wrapped by repr() in SBProfile.cpp
     std::string SBSersic::SBSersicImpl::serialize() const
     {
@@ -95,7 +106,7 @@ namespace galsim {
     }
 
     LRUCache< boost::tuple<double, double, GSParamsPtr >, SersicInfo >
-        SBSersic::SBSersicImpl::cache(sbp::max_sersic_cache);
+        SBSersic::SBSersicImpl::cache(sbp::max_sersic_cache, "sersic");
 
     SBSersic::SBSersicImpl::SBSersicImpl(double n,  double size, RadiusType rType, double flux,
                                          double trunc, bool flux_untruncated,
@@ -103,7 +114,8 @@ namespace galsim {
         SBProfileImpl(gsparams),
         _n(n), _flux(flux), _trunc(trunc), _trunc_sq(trunc*trunc),
         // Start with untruncated SersicInfo regardless of value of trunc
-        _info(cache.get(boost::make_tuple(_n, 0., this->gsparams.duplicate())))
+        _info(cache.get(boost::make_tuple(_n, 0., this->gsparams.duplicate()))),
+        _mixture_err(0.)
     {
         dbg<<"Start SBSersic constructor:\n";
         dbg<<"n = "<<_n<<std::endl;
@@ -174,24 +186,59 @@ namespace galsim {
         _shootnorm = _flux * _info->getXNorm(); // For shooting, we don't need the 1/r0^2 factor.
         _xnorm = _shootnorm * _inv_r0_sq;
         dbg<<"norms = "<<_xnorm<<", "<<_shootnorm<<std::endl;
+
+        // The Gaussian mixture only needs the HLR from _info, which doesn't need the Hankel
+        // transform, so the expensive part of the SersicInfo setup is skipped.
+        _use_mixture = this->gsparams->gaussian_mixture && !_truncated &&
+            _n >= sbp::minimum_mixture_n && _n <= sbp::maximum_mixture_n;
+        if (_use_mixture) {
+            _mixture = MakeSersicGaussianMixture(_n, _re, _flux, this->gsparams, _mixture_err);
+            dbg<<"Using Gaussian mixture with error "<<_mixture_err<<std::endl;
+        }
     }
 
     double SBSersic::SBSersicImpl::xValue(const Position<double>& p) const
     {
+        if (_use_mixture) return _mixture.xValue(p);
         double rsq = (p.x*p.x+p.y*p.y)*_inv_r0_sq;
         return _xnorm * _info->xValue(rsq);
     }
 
     std::complex<double> SBSersic::SBSersicImpl::kValue(const Position<double>& k) const
     {
+        if (_use_mixture) return _mixture.kValue(k);
         double ksq = (k.x*k.x + k.y*k.y)*_r0_sq;
         return _flux * _info->kValue(ksq);
     }
 
+    void SBSersic::SBSersicImpl::xValueMany(const double* x, const double* y, double* val,
+                                            int n) const
+    {
+        if (_use_mixture) { _mixture.xValueMany(x,y,val,n); return; }
+        for (int i=0;i<n;++i) val[i] = (x[i]*x[i]+y[i]*y[i])*_inv_r0_sq;
+        _info->xValueMany(val, n);
+        for (int i=0;i<n;++i) val[i] *= _xnorm;
+    }
+
+    void SBSersic::SBSersicImpl::kValueMany(const double* kx, const double* ky,
+                                            std::complex<double>* val, int n) const
+    {
+        if (_use_mixture) { _mixture.kValueMany(kx,ky,val,n); return; }
+        const SersicInfo& info = *_info;
+        for (int i=0;i<n;++i) {
+            double ksq = (kx[i]*kx[i] + ky[i]*ky[i])*_r0_sq;
+            val[i] = _flux * info.kValue(ksq);
+        }
+    }
+
     void SBSersic::SBSersicImpl::fillXValue(tmv::MatrixView<double> val,
                                             double x0, double dx, int izero,
                                             double y0, double dy, int jzero) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillXValue(val,x0,dx,izero,y0,dy,jzero);
+            return;
+        }
         dbg<<"SBSersic fillXValue\n";
         dbg<<"x = "<<x0<<" + i * "<<dx<<", izero = "<<izero<<std::endl;
         dbg<<"y = "<<y0<<" + j * "<<dy<<", jzero = "<<jzero<<std::endl;
@@ -211,7 +258,6 @@ namespace galsim {
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
-            typedef tmv::VIt<double,1,tmv::NonConj> It;
 
             x0 *= _inv_r0;
             dx *= _inv_r0;
@@ -221,11 +267,10 @@ namespace galsim {
             for (int j=0;j<n;++j,y0+=dy) {
                 double x = x0;
                 double ysq = y0*y0;
-                It valit = val.col(j).begin();
-                for (int i=0;i<m;++i,x+=dx) {
-                    double rsq = x*x + ysq;
-                    *valit++ = _xnorm * _info->xValue(rsq);
-                }
+                double* valj = val.col(j).ptr();
+                for (int i=0;i<m;++i,x+=dx) valj[i] = x*x + ysq;
+                _info->xValueMany(valj, m);
+                for (int i=0;i<m;++i) valj[i] *= _xnorm;
             }
         }
     }
@@ -234,6 +279,10 @@ namespace galsim {
                                             double kx0, double dkx, int izero,
                                             double ky0, double dky, int jzero) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillKValue(val,kx0,dkx,izero,ky0,dky,jzero);
+            return;
+        }
         dbg<<"SBSersic fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<", izero = "<<izero<<std::endl;
         dbg<<"ky = "<<ky0<<" + j * "<<dky<<", jzero = "<<jzero<<std::endl;
@@ -242,6 +291,7 @@ namespace galsim {
             fillKValueQuadrant(val,kx0,dkx,izero,ky0,dky,jzero);
         } else {
             xdbg<<"Non-Quadrant\n";
+            if (fillKValueRadial(val,kx0,dkx,ky0,dky)) return;
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
@@ -268,6 +318,10 @@ namespace galsim {
                                             double x0, double dx, double dxy,
                                             double y0, double dy, double dyx) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillXValue(val,x0,dx,dxy,y0,dy,dyx);
+            return;
+        }
         dbg<<"SBSersic fillXValue\n";
         dbg<<"x = "<<x0<<" + i * "<<dx<<" + j * "<<dxy<<std::endl;
         dbg<<"y = "<<y0<<" + i * "<<dyx<<" + j * "<<dy<<std::endl;
@@ -275,7 +329,6 @@ namespace galsim {
         assert(val.canLinearize());
         const int m = val.colsize();
         const int n = val.rowsize();
-        typedef tmv::VIt<double,1,tmv::NonConj> It;
 
         x0 *= _inv_r0;
         dx *= _inv_r0;
@@ -284,16 +337,15 @@ namespace galsim {
         dy *= _inv_r0;
         dyx *= _inv_r0;
 
-        It valit = val.linearView().begin();
         double x00 = x0; // Preserve the originals for below.
         double y00 = y0;
         for (int j=0;j<n;++j,x0+=dxy,y0+=dy) {
             double x = x0;
             double y = y0;
-            for (int i=0;i<m;++i,x+=dx,y+=dyx) {
-                double rsq = x*x + y*y;
-                *valit++ = _xnorm * _info->xValue(rsq);
-            }
+            double* valj = val.col(j).ptr();
+            for (int i=0;i<m;++i,x+=dx,y+=dyx) valj[i] = x*x + y*y;
+            _info->xValueMany(valj, m);
+            for (int i=0;i<m;++i) valj[i] *= _xnorm;
         }
 
         // Check if one of these points is really (0,0) in disguise and fix it up
@@ -338,9 +390,14 @@ namespace galsim {
                                             double kx0, double dkx, double dkxy,
                                             double ky0, double dky, double dkyx) const
     {
+        if (_use_mixture) {
+            GetImpl(_mixture)->fillKValue(val,kx0,dkx,dkxy,ky0,dky,dkyx);
+            return;
+        }
         dbg<<"SBSersic fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
+        if (fillKValueRadial(val,kx0,dkx,dkxy,ky0,dky,dkyx)) return;
         assert(val.stepi() == 1);
         assert(val.canLinearize());
         const int m = val.colsize();
@@ -365,22 +422,37 @@ namespace galsim {
         }
     }
 
-    double SBSersic::SBSersicImpl::maxK() const { return _info->maxK() * _inv_r0; }
-    double SBSersic::SBSersicImpl::stepK() const { return _info->stepK() * _inv_r0; }
+    double SBSersic::SBSersicImpl::maxK() const
+    { return _use_mixture ? _mixture.maxK() : _info->maxK() * _inv_r0; }
+    double SBSersic::SBSersicImpl::stepK() const
+    { return _use_mixture ? _mixture.stepK() : _info->stepK() * _inv_r0; }
 
-    SersicInfo::SersicInfo(double n, double trunc, const GSParamsPtr& gsparams) :
+    SersicInfo::SersicInfo(double n, double trunc, const GSParamsPtr& gsparams,
+                           bool use_table) :
         _n(n), _trunc(trunc), _gsparams(gsparams),
         _invn(1./_n), _inv2n(0.5*_invn),
         _trunc_sq(_trunc*_trunc), _truncated(_trunc > 0.),
         _gamma2n(boost::math::tgamma(2.*_n)),
         _maxk(0.), _stepk(0.), _re(0.), _flux(0.),
-        _ft(Table<double,double>::spline)
+        _ft_ready(false), _ft(Table<double,double>::spline)
     {
         dbg<<"Start SersicInfo constructor for n = "<<_n<<std::endl;
         dbg<<"trunc = "<<_trunc<<std::endl;
 
         if (_n < sbp::minimum_sersic_n || _n > sbp::maximum_sersic_n)
             throw SBError("Requested Sersic index out of range");
+
+        if (use_table && !_truncated) _table = SersicTable::get(_gsparams);
+#ifdef _OPENMP
+        omp_init_lock(&_ft_lock);
+#endif
+    }
+
+    SersicInfo::~SersicInfo()
+    {
+#ifdef _OPENMP
+        omp_destroy_lock(&_ft_lock);
+#endif
     }
 
     double SersicInfo::stepK() const
@@ -401,10 +473,33 @@ namespace galsim {
 
     double SersicInfo::maxK() const
     {
-        if (_maxk == 0.) buildFT();
+        checkFT();
         return _maxk;
     }
 
+    void SersicInfo::checkFT() const
+    {
+        // SersicInfo objects are shared, so several threads may need the Fourier transform
+        // at the same time.  Only let one of them build it, and have the others wait for it.
+        // (This uses a lock rather than a critical section, so any exception can propagate.)
+        if (ReadReadyFlag(_ft_ready)) return;
+#ifdef _OPENMP
+        omp_set_lock(&_ft_lock);
+        try {
+#endif
+            if (!_ft_ready) {
+                buildFT();
+                SetReadyFlag(_ft_ready);
+            }
+#ifdef _OPENMP
+        } catch (...) {
+            omp_unset_lock(&_ft_lock);
+            throw;
+        }
+        omp_unset_lock(&_ft_lock);
+#endif
+    }
+
     double SersicInfo::getHLR() const
     {
         if (_re == 0.) calculateHLR();
@@ -438,10 +533,25 @@ namespace galsim {
         else return std::exp(-std::pow(rsq,_inv2n));
     }
 
+    void SersicInfo::xValueMany(double* val, int n) const
+    {
+        // exp(-rsq^(1/2n)) = exp(-exp(log(rsq)/2n)).
+        // Points beyond the truncation radius get rsq = inf, which comes out as 0.
+        if (_truncated) {
+            const double inf = std::numeric_limits<double>::infinity();
+            for (int i=0;i<n;++i) if (val[i] > _trunc_sq) val[i] = inf;
+        }
+        math::LogMany(val, val, n);
+        for (int i=0;i<n;++i) val[i] *= _inv2n;
+        math::ExpMany(val, val, n);
+        for (int i=0;i<n;++i) val[i] = -val[i];
+        math::ExpMany(val, val, n);
+    }
+
     double SersicInfo::kValue(double ksq) const
     {
         assert(ksq >= 0.);
-        if (_ft.size() == 0) buildFT();
+        checkFT();
 
         if (ksq>=_ksq_max)
             return (_highk_a + _highk_b/sqrt(ksq))/ksq; // high-k asymptote
@@ -453,22 +563,49 @@ namespace galsim {
         }
     }
 
-    // Integrand class for the Hankel transform of Sersic
-    class SersicHankel : public std::unary_function<double,double>
+    // The radial profile of a Sersic, which buildFT Hankel transforms.
+    class SersicRadial : public std::unary_function<double,double>
     {
     public:
-        SersicHankel(double invn, double k): _invn(invn), _k(k) {}
+        SersicRadial(double invn): _invn(invn) {}
 
         double operator()(double r) const
-        { return r*std::exp(-std::pow(r, _invn))*j0(_k*r); }
+        { return std::exp(-std::pow(r, _invn)); }
 
     private:
         double _invn;
-        double _k;
     };
 
+    // The version of the layout of the Hankel table in the on-disk cache.  Increment this
+    // whenever the layout or the calculation of the table changes.
+    static const int sersic_table_version = 2;
+
     void SersicInfo::buildFT() const
     {
+        // The table is fairly expensive to build, so check whether another process has
+        // already saved it in the on-disk cache.  (Not if it is interpolated from _table,
+        // which is cheap, and n is rarely repeated exactly.)
+        std::ostringstream key;
+        key.precision(17);
+        key << "n=" << _n << " trunc=" << _trunc << " " << TableCache::makeKey(*_gsparams);
+        std::vector<double> cached;
+        const int nscalar = 7;
+        if (!_table && TableCache::read("sersic", sersic_table_version, key.str(), cached) &&
+            int(cached.size()) > nscalar && (cached.size() - nscalar) % 2 == 0) {
+            dbg<<"Using cached Hankel table for n = "<<_n<<std::endl;
+            const int nentry = (int(cached.size()) - nscalar) / 2;
+            _maxk = cached[0];
+            _kderiv2 = cached[1];
+            _kderiv4 = cached[2];
+            _ksq_min = cached[3];
+            _ksq_max = cached[4];
+            _highk_a = cached[5];
+            _highk_b = cached[6];
+            for (int i=0; i<nentry; ++i)
+                _ft.addEntry(cached[nscalar+i], cached[nscalar+nentry+i]);
+            return;
+        }
+
         // The small-k expansion of the Hankel transform is (normalized to have flux=1):
         // 1 - Gamma(4n) / 4 Gamma(2n) + Gamma(6n) / 64 Gamma(2n) - Gamma(8n) / 2304 Gamma(2n)
         // from the series summation J_0(x) = Sum^inf_{m=0} (-1)^m (m!)^-2 (x/2)^2m
@@ -504,17 +641,6 @@ namespace galsim {
         double hankel_norm = getFluxFraction()*_n*_gamma2n;
         dbg<<"hankel_norm = "<<hankel_norm<<std::endl;
 
-        double integ_maxr;
-        if (!_truncated) {
-            //integ_maxr = calculateMissingFluxRadius(_gsparams->kvalue_accuracy);
-            integ_maxr = integ::MOCK_INF;
-        } else {
-            //integ_maxr = calculateMissingFluxRadius(_gsparams->kvalue_accuracy);
-            //if (_trunc < integ_maxr) integ_maxr = _trunc;
-            integ_maxr = _trunc;
-        }
-        dbg<<"integ_maxr = "<<integ_maxr<<std::endl;
-
         // We use a cubic spline for the interpolation, which has an error of O(h^4) max(f'''').
         // The fourth derivative is a bit tough to estimate of course, but doing it numerically
         // for a few different values of n, we find 10 to be a reasonably conservative estimate.
@@ -524,6 +650,21 @@ namespace galsim {
         dbg<<"n = "<<_n<<std::endl;
         dbg<<"Using dlogk = "<<dlogk<<std::endl;
 
+        // Do the whole Hankel transform at once on a grid in log(k), rather than a separate
+        // integral for each k in the loop below.  If untruncated, the profile is cut off where
+        // the missing flux is well below the required accuracy.
+        boost::shared_ptr<HankelTransform> hankel;
+        if (!_table) {
+            double kmin_ht = std::exp(std::log(kmin)-0.001);
+            double maxr = _truncated ? _trunc :
+                calculateMissingFluxRadius(0.01 * _gsparams->integration_abserr);
+            dbg<<"Hankel transform for r <= "<<maxr<<std::endl;
+            hankel.reset(new HankelTransform(
+                    SersicRadial(_invn), 1.e-10 * maxr, maxr, _truncated, kmin_ht, 500.,
+                    _gsparams->integration_abserr * hankel_norm));
+            dbg<<"Hankel transform error = "<<hankel->getError()/hankel_norm<<std::endl;
+        }
+
         // As we go, build up the high k approximation f(k) = a/k^2 + b/k^3, based on the last
         // 10 items. Keep going until the predicted value is accurate enough for 5 items in a row.
         // Once we're past the maxk value, we try to stop if the approximation is within
@@ -540,27 +681,13 @@ namespace galsim {
         for (double logk = std::log(kmin)-0.001; logk < std::log(500.); logk += dlogk) {
             double k = std::exp(logk);
             double ksq = k*k;
-            SersicHankel I(_invn, k);
-
-#ifdef DEBUGLOGGING
-            std::ostream* integ_dbgout = verbose_level >= 3 ? dbgout : 0;
-            integ::IntRegion<double> reg(0, integ_maxr, integ_dbgout);
-#else
-            integ::IntRegion<double> reg(0, integ_maxr);
-#endif
-
-            // Add explicit splits at first several roots of J0.
-            // This tends to make the integral more accurate.
-            for (int s=1; s<=10; ++s) {
-                double root = bessel::getBesselRoot0(s);
-                if (root > k * integ_maxr) break;
-                reg.addSplit(root/k);
+            double val;
+            if (_table) {
+                // Interpolate from the neighbouring nodes in n at the same k*re.
+                val = _table->kValue(_n, k*getHLR());
+            } else {
+                val = (*hankel)(k) / hankel_norm;
             }
-
-            double val = integ::int1d(I, reg,
-                                      _gsparams->integration_relerr,
-                                      _gsparams->integration_abserr*hankel_norm);
-            val /= hankel_norm;
             xdbg<<"logk = "<<logk<<", ft("<<exp(logk)<<") = "<<val<<"   "<<val*ksq<<std::endl;
 
             double f0 = val * ksq;
@@ -635,6 +762,20 @@ namespace galsim {
                 xdbg<<"maxk => "<<_maxk<<std::endl;
             }
         }
+
+        if (_table) return;
+
+        // Save the results for other processes.
+        cached.push_back(_maxk);
+        cached.push_back(_kderiv2);
+        cached.push_back(_kderiv4);
+        cached.push_back(_ksq_min);
+        cached.push_back(_ksq_max);
+        cached.push_back(_highk_a);
+        cached.push_back(_highk_b);
+        cached.insert(cached.end(), _ft.getArgs().begin(), _ft.getArgs().end());
+        cached.insert(cached.end(), _ft.getVals().begin(), _ft.getVals().end());
+        TableCache::write("sersic", sersic_table_version, key.str(), cached);
     }
 
     // Function object for finding the r that encloses all except a particular flux fraction.
@@ -680,6 +821,14 @@ namespace galsim {
         // z = -ln(x Gamma(2n) + (2n-1) ln(z) + (2n-1)/z + (2n-1)(2n-3)/(2*z^2) + O(z^3)
         // Use this as a starting point.  Then switch to a Brent method solver.
         dbg<<"Find maxr for missing_flux_frac = "<<missing_flux_frac<<std::endl;
+        if (_table) {
+            // The table gives a very good starting guess, so just refine it.
+            double s = std::log((1.-missing_flux_frac)/missing_flux_frac);
+            double z = refineMissingFluxZ(std::exp(_table->logFluxRadius(_n, s)),
+                                          missing_flux_frac);
+            dbg<<"From table: z => "<<z<<std::endl;
+            return std::pow(z,_n);
+        }
         double missing_flux = missing_flux_frac * _gamma2n;
         // Just do one round of update here.
         double z1 = -std::log(missing_flux);
@@ -721,9 +870,35 @@ namespace galsim {
         return R;
     }
 
+    // Refine an estimate of z = R^(1/n) for the radius R outside of which there is a fraction
+    // missing_flux_frac of the flux of an untruncated profile.
+    double SersicInfo::refineMissingFluxZ(double z, double missing_flux_frac) const
+    {
+        // Newton's method on log(Gamma(2n,z)/Gamma(2n)), which is nearly linear in z at
+        // large z, so this converges in 2 or 3 steps from a good estimate.
+        const double log_target = std::log(missing_flux_frac);
+        for (int iter=0; iter<20; ++iter) {
+            double q = boost::math::gamma_q(2.*_n, z);
+            double dqdz = -boost::math::gamma_p_derivative(2.*_n, z);
+            double dz = (std::log(q) - log_target) * q / dqdz;
+            xdbg<<"z = "<<z<<", q = "<<q<<", dz = "<<dz<<std::endl;
+            if (dz >= z) z *= 0.5;  // Don't let z go negative.
+            else z -= dz;
+            if (std::abs(dz) < 1.e-14 * z) break;
+        }
+        return z;
+    }
+
     void SersicInfo::calculateHLR() const
     {
         dbg<<"Find HLR for (n,gamma2n) = ("<<_n<<","<<_gamma2n<<")"<<std::endl;
+        if (_table) {
+            // s = 0 is the half-light radius.
+            _b = refineMissingFluxZ(std::exp(_table->logFluxRadius(_n, 0.)), 0.5);
+            _re = std::pow(_b,_n);
+            dbg<<"From table: b = "<<_b<<", re = "<<_re<<std::endl;
+            return;
+        }
         // Find solution to gamma(2n,re^(1/n)) = gamma2n / 2
         // where gamma2n is the truncated gamma function Gamma(2n,trunc^(1/n))
         // We initially solve for b = re^1/n, and then calculate re from that.
@@ -860,6 +1035,32 @@ namespace galsim {
         dbg<<"SersicInfo shoot: N = "<<N<<std::endl;
         dbg<<"Target flux = 1.0\n";
 
+        if (_table) {
+            // Invert the enclosed flux directly, using the table interpolated in n.
+            boost::shared_ptr<PhotonArray> result(new PhotonArray(N));
+            double fluxPerPhoton = 1. / (getXNorm() * N);
+            for (int i=0; i<N; ++i) {
+                double u = ud();
+                double r = 0.;
+                if (u > 0.) r = std::exp(_n * _table->logFluxRadius(_n, std::log(u/(1.-u))));
+                double xu, yu, rsq;
+                do {
+                    xu = 2. * ud() - 1.;
+                    yu = 2. * ud() - 1.;
+                    rsq = xu*xu+yu*yu;
+                } while (rsq >= 1. || rsq == 0.);
+                double rFactor = r / std::sqrt(rsq);
+                result->setPhoton(i, rFactor * xu, rFactor * yu, fluxPerPhoton);
+            }
+            dbg<<"SersicInfo Realized flux = "<<result->getTotalFlux()<<std::endl;
+            return result;
+        }
+
+        // The sampler is built on first use.  drawShoot may call this from several threads
+        // at once, so only let one of them build it.
+#ifdef _OPENMP
+#pragma omp critical (galsim_sersic_sampler)
+#endif
         if (!_sampler) {
             // Set up the classes for photon shooting
             _radial.reset(new SersicRadialFunction(_invn));
@@ -876,10 +1077,126 @@ namespace galsim {
         return result;
     }
 
+    LRUCache<GSParamsPtr, SersicTable> SersicTable::cache(sbp::max_sersic_table_cache,
+                                                          "sersic_table");
+
+    boost::shared_ptr<SersicTable> SersicTable::get(const GSParamsPtr& gsparams)
+    { return cache.get(gsparams); }
+
+    SersicTable::SersicTable(const GSParamsPtr& gsparams) :
+        _gsparams(gsparams.duplicate())
+    {
+        _gsparams->kvalue_accuracy *= 0.5;
+        _logn_min = std::log(sbp::minimum_sersic_n);
+        double logn_range = std::log(sbp::maximum_sersic_n) - _logn_min;
+        _nnode = int(std::ceil(logn_range / sbp::sersic_table_dlogn)) + 1;
+        _dlogn = logn_range / (_nnode - 1);
+        dbg<<"SersicTable with "<<_nnode<<" nodes, dlogn = "<<_dlogn<<std::endl;
+        _nodes.resize(_nnode);
+        _radii.resize(_nnode);
+    }
+
+    // Get the Lagrange weights w[0..3] for the nodes i0..i0+3 at index n.
+    void SersicTable::getWeights(double n, int& i0, double* w) const
+    {
+        double x = (std::log(n) - _logn_min) / _dlogn;
+        i0 = std::min(std::max(int(std::floor(x)) - 1, 0), _nnode - 4);
+        x -= i0;
+        // The nodes are at x = 0,1,2,3.
+        w[0] = -(x-1.)*(x-2.)*(x-3.) / 6.;
+        w[1] = x*(x-2.)*(x-3.) / 2.;
+        w[2] = -x*(x-1.)*(x-3.) / 2.;
+        w[3] = x*(x-1.)*(x-2.) / 6.;
+    }
+
+    double SersicTable::getNodeN(int i) const
+    {
+        double n = std::exp(_logn_min + i * _dlogn);
+        // Make sure rounding doesn't take the end nodes out of the allowed range.
+        return std::min(std::max(n, sbp::minimum_sersic_n), sbp::maximum_sersic_n);
+    }
+
+    const SersicInfo& SersicTable::getNode(int i) const
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_sersic_table)
+#endif
+        if (!_nodes[i]) {
+            dbg<<"Build SersicTable node "<<i<<" with n = "<<getNodeN(i)<<std::endl;
+            _nodes[i].reset(new SersicInfo(getNodeN(i), 0., _gsparams, false));
+        }
+        return *_nodes[i];
+    }
+
+    const Table<double,double>& SersicTable::getRadii(int i) const
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_sersic_table_radii)
+#endif
+        if (!_radii[i]) {
+            double twon = 2.*getNodeN(i);
+            boost::shared_ptr<Table<double,double> > radii(
+                new Table<double,double>(Table<double,double>::spline));
+            // At small z, the enclosed flux is z^2n/Gamma(2n+1), so s ~= 2n log(z) - const.
+            // At large z, s ~= z.  Step in log(z) so the steps in s are about ds.
+            const double ds = 0.05;
+            const double s_min = -25.;
+            const double s_max = 35.;
+            double logz = (s_min + boost::math::lgamma(twon+1.)) / twon;
+            double s = s_min;
+            while (s < s_max) {
+                double z = std::exp(logz);
+                double q = boost::math::gamma_q(twon, z);
+                if (q <= 0.) break;
+                s = std::log(boost::math::gamma_p(twon, z)) - std::log(q);
+                radii->addEntry(s, logz);
+                logz += ds / std::max(twon, z);
+            }
+            _radii[i] = radii;
+        }
+        return *_radii[i];
+    }
+
+    double SersicTable::kValue(double n, double kre) const
+    {
+        int i0;
+        double w[4];
+        getWeights(n, i0, w);
+        double val = 0.;
+        for (int j=0; j<4; ++j) {
+            const SersicInfo& node = getNode(i0+j);
+            double k = kre / node.getHLR();
+            val += w[j] * node.kValue(k*k);
+        }
+        return val;
+    }
+
+    double SersicTable::logFluxRadius(double n, double s) const
+    {
+        int i0;
+        double w[4];
+        getWeights(n, i0, w);
+        double logz = 0.;
+        for (int j=0; j<4; ++j) {
+            const Table<double,double>& radii = getRadii(i0+j);
+            if (s < radii.argMin()) {
+                // Use the small-z limit s = 2n log(z) - log(Gamma(2n+1)).
+                double twon = 2. * getNodeN(i0+j);
+                logz += w[j] * (s + boost::math::lgamma(twon+1.)) / twon;
+            } else if (s > radii.argMax()) {
+                logz += w[j] * radii(radii.argMax());
+            } else {
+                logz += w[j] * radii(s);
+            }
+        }
+        return logz;
+    }
+
     boost::shared_ptr<PhotonArray> SBSersic::SBSersicImpl::shoot(int N, UniformDeviate ud) const
     {
         dbg<<"Sersic shoot: N = "<<N<<std::endl;
         dbg<<"Target flux = "<<getFlux()<<std::endl;
+        if (_use_mixture) return GetImpl(_mixture)->shoot(N,ud);
         // Get photons from the SersicInfo structure, rescale flux and size for this instance
         boost::shared_ptr<PhotonArray> result = _info->shoot(N,ud);
         result->scaleFlux(_shootnorm);
@@ -887,4 +1204,251 @@ namespace galsim {
         dbg<<"Sersic Realized flux = "<<result->getTotalFlux()<<std::endl;
         return result;
     }
+
+    // Gaussian mixture approximations to the Sersic profile, fit by least squares to
+    // 2pi r^2 I(r) on a log-spaced grid of radii for a unit-flux profile with re = 1.
+    // The fits at neighbouring n were started from each other, so the parameters vary
+    // smoothly with n and can be linearly interpolated.  Row i has the amplitudes (which
+    // sum to 1) and variances (in units of re^2) for n = sersic_mixture_n[i].
+    const int sersic_mixture_nn = 46;
+    const int sersic_mixture_ng = 10;
+    const double sersic_mixture_n[sersic_mixture_nn] = {
+        0.55, 0.60, 0.65, 0.70, 0.75, 0.80, 0.85, 0.90, 0.95, 1.00,
+        1.05, 1.10, 1.15, 1.20, 1.25, 1.30, 1.35, 1.40, 1.45, 1.50,
+        1.55, 1.60, 1.65, 1.70, 1.75, 1.80, 1.85, 1.90, 1.95, 2.00,
+        2.25, 2.50, 2.75, 3.00, 3.25, 3.50, 3.75, 4.00, 4.25, 4.50,
+        4.75, 5.00, 5.25, 5.50, 5.75, 6.00
+    };
+    const double sersic_mixture_amp[sersic_mixture_nn][sersic_mixture_ng] = {
+        { 1.181675593e-05, 1.092755072e-04, 6.704504796e-04, 3.476996849e-03, 1.696420495e-02,
+          7.578863397e-02, 2.294263433e-01, 3.860995176e-01, 2.541711748e-01, 3.328158581e-02 },
+        { 5.996775581e-05, 5.187204100e-04, 2.277569381e-03, 3.147625863e-03, 1.918038382e-02,
+          7.881593453e-02, 2.267827295e-01, 3.840809660e-01, 2.526427486e-01, 3.249335417e-02 },
+        { 2.678318724e-05, 2.210766206e-04, 1.216530755e-03, 5.497332898e-03, 2.210637765e-02,
+          7.920356235e-02, 2.250810102e-01, 3.825501006e-01, 2.516749841e-01, 3.242224161e-02 },
+        { 3.859591698e-05, 3.047325807e-04, 1.611089304e-03, 6.949543590e-03, 2.628596620e-02,
+          8.706246097e-02, 2.283655756e-01, 3.707614112e-01, 2.456806386e-01, 3.293998598e-02 },
+        { 5.622766374e-05, 4.273596976e-04, 2.181221439e-03, 9.018473425e-03, 3.218158054e-02,
+          9.840013214e-02, 2.351108070e-01, 3.549837378e-01, 2.335611871e-01, 3.407927309e-02 },
+        { 8.029575496e-05, 5.888110775e-04, 2.905772733e-03, 1.154048743e-02, 3.904313851e-02,
+          1.113233422e-01, 2.451430086e-01, 3.429696922e-01, 2.151329244e-01, 3.127252716e-02 },
+        { 1.131295864e-04, 8.022458531e-04, 3.833164409e-03, 1.464055252e-02, 4.703432329e-02,
+          1.253071897e-01, 2.545790636e-01, 3.293776439e-01, 1.960245996e-01, 2.828808746e-02 },
+        { 1.530985845e-04, 1.051692867e-03, 4.869982717e-03, 1.791193972e-02, 5.481371837e-02,
+          1.373492417e-01, 2.602950242e-01, 3.159585789e-01, 1.812086370e-01, 2.638808591e-02 },
+        { 2.098993752e-04, 1.396559029e-03, 6.264365530e-03, 2.218015802e-02, 6.465047915e-02,
+          1.522905699e-01, 2.681639382e-01, 3.011811221e-01, 1.612414109e-01, 2.242149787e-02 },
+        { 2.689128912e-04, 1.736836495e-03, 7.561240820e-03, 2.584827961e-02, 7.218761738e-02,
+          1.616889989e-01, 2.698086692e-01, 2.890292454e-01, 1.507072159e-01, 2.116298340e-02 },
+        { 3.412924757e-04, 2.141100407e-03, 9.050877091e-03, 2.990080063e-02, 8.015069366e-02,
+          1.711430202e-01, 2.712454317e-01, 2.769420182e-01, 1.396179488e-01, 1.946681680e-02 },
+        { 4.194306531e-04, 2.559294387e-03, 1.051996872e-02, 3.366232010e-02, 8.694891035e-02,
+          1.781173097e-01, 2.706229062e-01, 2.666032121e-01, 1.319382842e-01, 1.860836359e-02 },
+        { 5.049772590e-04, 3.000169846e-03, 1.200603365e-02, 3.728002397e-02, 9.306602420e-02,
+          1.837090229e-01, 2.690975708e-01, 2.574257665e-01, 1.258476907e-01, 1.806272029e-02 },
+        { 6.035066802e-04, 3.493264813e-03, 1.361849307e-02, 4.107808354e-02, 9.926619983e-02,
+          1.891754234e-01, 2.675609095e-01, 2.484606068e-01, 1.194738458e-01, 1.726966660e-02 },
+        { 7.074633161e-04, 3.993966534e-03, 1.518856507e-02, 4.459040882e-02, 1.046071648e-01,
+          1.932480393e-01, 2.653177043e-01, 2.407327455e-01, 1.147491817e-01, 1.686476076e-02 },
+        { 8.186492162e-04, 4.511665392e-03, 1.675447166e-02, 4.794782104e-02, 1.094370632e-01,
+          1.965372436e-01, 2.628074482e-01, 2.337892327e-01, 1.107999894e-01, 1.659641568e-02 },
+        { 9.403545292e-04, 5.062405534e-03, 1.837266218e-02, 5.131000405e-02, 1.141061297e-01,
+          1.995522224e-01, 2.602987049e-01, 2.271864872e-01, 1.069204341e-01, 1.625059530e-02 },
+        { 1.067711063e-03, 5.619827462e-03, 1.995360317e-02, 5.445981882e-02, 1.182358161e-01,
+          2.018609136e-01, 2.576200121e-01, 2.213259130e-01, 1.037903418e-01, 1.606604296e-02 },
+        { 1.201786620e-03, 6.189139645e-03, 2.151840128e-02, 5.746738070e-02, 1.219969690e-01,
+          2.037218335e-01, 2.549055459e-01, 2.159843333e-01, 1.010700743e-01, 1.594453573e-02 },
+        { 1.341748919e-03, 6.765989310e-03, 2.305588196e-02, 6.031958433e-02, 1.253968658e-01,
+          2.051769781e-01, 2.521848594e-01, 2.111317142e-01, 9.873611408e-02, 1.589026387e-02 },
+        { 1.491276129e-03, 7.367422800e-03, 2.462152426e-02, 6.315528187e-02, 1.286935279e-01,
+          2.065310883e-01, 2.495539318e-01, 2.064608788e-01, 9.636355327e-02, 1.576151485e-02 },
+        { 1.644753257e-03, 7.966608117e-03, 2.613379085e-02, 6.579584549e-02, 1.316029172e-01,
+          2.074897562e-01, 2.469287577e-01, 2.022785720e-01, 9.442506995e-02, 1.573392927e-02 },
+        { 1.803628973e-03, 8.570561895e-03, 2.761779269e-02, 6.830989110e-02, 1.342598256e-01,
+          2.082156108e-01, 2.443596838e-01, 1.984223923e-01, 9.270298416e-02, 1.573762865e-02 },
+        { 1.968700134e-03, 9.182877718e-03, 2.908663385e-02, 7.073427080e-02, 1.367368418e-01,
+          2.087925642e-01, 2.418648611e-01, 1.948033176e-01, 9.109113987e-02, 1.573879282e-02 },
+        { 2.138203217e-03, 9.795765445e-03, 3.051967495e-02, 7.303155679e-02, 1.389863017e-01,
+          2.091801450e-01, 2.394344225e-01, 1.914675757e-01, 8.967241619e-02, 1.577393855e-02 },
+        { 2.312307350e-03, 1.041027345e-02, 3.192269104e-02, 7.522157700e-02, 1.410501023e-01,
+          2.094267176e-01, 2.370768205e-01, 1.883635112e-01, 8.838985022e-02, 1.582614929e-02 },
+        { 2.490871858e-03, 1.102609311e-02, 3.329727498e-02, 7.731405552e-02, 1.429518373e-01,
+          2.095596534e-01, 2.347945890e-01, 1.854611445e-01, 8.721596874e-02, 1.588851158e-02 },
+        { 2.673421662e-03, 1.164142341e-02, 3.464031166e-02, 7.930769891e-02, 1.446962849e-01,
+          2.095861427e-01, 2.325854007e-01, 1.827514226e-01, 8.615236311e-02, 1.596553037e-02 },
+        { 2.859722696e-03, 1.225568477e-02, 3.595252700e-02, 8.120932344e-02, 1.463001048e-01,
+          2.095244574e-01, 2.304494326e-01, 1.802136026e-01, 8.518183486e-02, 1.605330984e-02 },
+        { 3.049491781e-03, 1.286808726e-02, 3.723381942e-02, 8.302328423e-02, 1.477749299e-01,
+          2.093868814e-01, 2.283852591e-01, 1.778328009e-01, 8.429474484e-02, 1.615070120e-02 },
+        { 4.041994492e-03, 1.588291277e-02, 4.318928622e-02, 9.093267332e-02, 1.535684155e-01,
+          2.078981556e-01, 2.190703839e-01, 1.678477396e-01, 8.082800413e-02, 1.674043458e-02 },
+        { 5.087937662e-03, 1.878247019e-02, 4.843746562e-02, 9.723892938e-02, 1.574011029e-01,
+          2.056348383e-01, 2.112131498e-01, 1.602526926e-01, 7.850516549e-02, 1.744624812e-02 },
+        { 6.166247242e-03, 2.153934929e-02, 5.305823404e-02, 1.023125364e-01, 1.599201580e-01,
+          2.030504487e-01, 2.045323556e-01, 1.542959024e-01, 7.690919552e-02, 1.821557279e-02 },
+        { 7.261277570e-03, 2.414370616e-02, 5.713423827e-02, 1.064313585e-01, 1.615387706e-01,
+          2.003732076e-01, 1.987938579e-01, 1.495062933e-01, 7.579831878e-02, 1.901897134e-02 },
+        { 8.361511604e-03, 2.659549011e-02, 6.074136346e-02, 1.098032431e-01, 1.625280918e-01,
+          1.977194664e-01, 1.938137142e-01, 1.455750944e-01, 7.502333955e-02, 1.983868533e-02 },
+        { 9.458533627e-03, 2.889992862e-02, 6.394588875e-02, 1.125845094e-01, 1.630704704e-01,
+          1.951475954e-01, 1.894494588e-01, 1.422922587e-01, 7.448781037e-02, 2.066354595e-02 },
+        { 1.054623881e-02, 3.106489753e-02, 6.680438691e-02, 1.148937976e-01, 1.632912714e-01,
+          1.926850952e-01, 1.855906530e-01, 1.395103326e-01, 7.412699983e-02, 2.148632713e-02 },
+        { 1.162024347e-02, 3.309940951e-02, 6.936466258e-02, 1.168221140e-01, 1.632783974e-01,
+          1.903427733e-01, 1.821510749e-01, 1.371229677e-01, 7.389608992e-02, 2.230226722e-02 },
+        { 1.267744333e-02, 3.501274576e-02, 7.166695964e-02, 1.184400217e-01, 1.630945529e-01,
+          1.881223875e-01, 1.790627732e-01, 1.350516645e-01, 7.376324385e-02, 2.310820755e-02 },
+        { 1.371569383e-02, 3.681398990e-02, 7.374517652e-02, 1.198028370e-01, 1.627851645e-01,
+          1.860208664e-01, 1.762716265e-01, 1.332372688e-01, 7.370532577e-02, 2.390205080e-02 },
+        { 1.473356246e-02, 3.851176160e-02, 7.562790898e-02, 1.209543468e-01, 1.623835673e-01,
+          1.840326769e-01, 1.737340959e-01, 1.316344237e-01, 7.370522241e-02, 2.468243390e-02 },
+        { 1.573015184e-02, 4.011410375e-02, 7.733936618e-02, 1.219295529e-01, 1.619145110e-01,
+          1.821511655e-01, 1.714147979e-01, 1.302077888e-01, 7.375006155e-02, 2.544850063e-02 },
+        { 1.670496494e-02, 4.162843957e-02, 7.890012258e-02, 1.227566843e-01, 1.613965529e-01,
+          1.803693160e-01, 1.692847036e-01, 1.289294384e-01, 7.383002498e-02, 2.619975265e-02 },
+        { 1.765780628e-02, 4.306157881e-02, 8.032774302e-02, 1.234587038e-01, 1.608437279e-01,
+          1.786801720e-01, 1.673197803e-01, 1.277770189e-01, 7.393752570e-02, 2.693594339e-02 },
+        { 1.858869932e-02, 4.441973160e-02, 8.163727267e-02, 1.240544198e-01, 1.602667156e-01,
+          1.770770652e-01, 1.654999765e-01, 1.267324503e-01, 7.406665365e-02, 2.765701525e-02 },
+        { 1.949783558e-02, 4.570856001e-02, 8.284166953e-02, 1.245593637e-01, 1.596736970e-01,
+          1.755537275e-01, 1.638084213e-01, 1.257809404e-01, 7.421274685e-02, 2.836303801e-02 }
+    };
+    const double sersic_mixture_var[sersic_mixture_nn][sersic_mixture_ng] = {
+        { 4.751647777e-03, 1.821500383e-02, 4.996078381e-02, 1.155411735e-01, 2.355587991e-01,
+          4.184059788e-01, 6.202399918e-01, 7.859715475e-01, 9.212470459e-01, 1.025753958e+00 },
+        { 6.281146394e-03, 2.448391603e-02, 6.384565626e-02, 1.043764960e-01, 1.817341832e-01,
+          3.430543847e-01, 5.640348117e-01, 8.101413994e-01, 1.059301674e+00, 1.305710808e+00 },
+        { 2.650073962e-03, 1.065387813e-02, 3.031098879e-02, 7.253270811e-02, 1.545941284e-01,
+          2.990758961e-01, 5.240624333e-01, 8.263192823e-01, 1.184005622e+00, 1.591977138e+00 },
+        { 2.286252610e-03, 9.378996445e-03, 2.710215343e-02, 6.576148445e-02, 1.422945842e-01,
+          2.812637556e-01, 5.107451043e-01, 8.504318171e-01, 1.304718011e+00, 1.889814331e+00 },
+        { 2.092512443e-03, 8.764582178e-03, 2.570912043e-02, 6.318031219e-02, 1.384057790e-01,
+          2.776243741e-01, 5.152094354e-01, 8.875035040e-01, 1.428149407e+00, 2.195548912e+00 },
+        { 1.973908000e-03, 8.418540197e-03, 2.503185420e-02, 6.225115289e-02, 1.379998886e-01,
+          2.807983109e-01, 5.317802602e-01, 9.437307149e-01, 1.581537648e+00, 2.559298141e+00 },
+        { 1.907548473e-03, 8.273884125e-03, 2.491994925e-02, 6.268209330e-02, 1.405310213e-01,
+          2.896433123e-01, 5.578339213e-01, 1.013683814e+00, 1.755442102e+00, 2.967712813e+00 },
+        { 1.845031481e-03, 8.133027773e-03, 2.480148997e-02, 6.308542214e-02, 1.430303518e-01,
+          2.985367918e-01, 5.841789417e-01, 1.084721532e+00, 1.935003395e+00, 3.405826024e+00 },
+        { 1.844592624e-03, 8.235373324e-03, 2.539099290e-02, 6.526040376e-02, 1.495582728e-01,
+          3.159569888e-01, 6.274650967e-01, 1.187572371e+00, 2.172750765e+00, 3.957066551e+00 },
+        { 1.794721300e-03, 8.125457479e-03, 2.533983432e-02, 6.583427474e-02, 1.525654629e-01,
+          3.263812712e-01, 6.581108701e-01, 1.270119717e+00, 2.384443625e+00, 4.497406921e+00 },
+        { 1.764340150e-03, 8.089876763e-03, 2.550493308e-02, 6.696359982e-02, 1.569019567e-01,
+          3.398395731e-01, 6.954470135e-01, 1.367205666e+00, 2.628752244e+00, 5.120627337e+00 },
+        { 1.719616685e-03, 7.985882539e-03, 2.545193046e-02, 6.753133031e-02, 1.599875391e-01,
+          3.508198175e-01, 7.284342472e-01, 1.458035779e+00, 2.868989226e+00, 5.766946991e+00 },
+        { 1.671910445e-03, 7.861816439e-03, 2.532631726e-02, 6.790294982e-02, 1.626384322e-01,
+          3.609944278e-01, 7.602684401e-01, 1.548331917e+00, 3.114752578e+00, 6.452397299e+00 },
+        { 1.635020512e-03, 7.779258095e-03, 2.532252792e-02, 6.859376880e-02, 1.660813833e-01,
+          3.730859974e-01, 7.967193035e-01, 1.649946785e+00, 3.389866765e+00, 7.225268770e+00 },
+        { 1.591488433e-03, 7.661455604e-03, 2.519821426e-02, 6.895638192e-02, 1.687567121e-01,
+          3.835913401e-01, 8.303057990e-01, 1.747525303e+00, 3.663959145e+00, 8.028098708e+00 },
+        { 1.547424065e-03, 7.535661713e-03, 2.503870339e-02, 6.921394681e-02, 1.711865042e-01,
+          3.936445279e-01, 8.633693963e-01, 1.845729185e+00, 3.946086649e+00, 8.879162182e+00 },
+        { 1.508111864e-03, 7.426599433e-03, 2.492494331e-02, 6.958849348e-02, 1.739190972e-01,
+          4.045157794e-01, 8.987494479e-01, 1.950816388e+00, 4.250109805e+00, 9.810828934e+00 },
+        { 1.467021864e-03, 7.304422497e-03, 2.475914632e-02, 6.980839992e-02, 1.762714611e-01,
+          4.145941540e-01, 9.328000114e-01, 2.054744795e+00, 4.558608328e+00, 1.078630687e+01 },
+        { 1.426509445e-03, 7.180278647e-03, 2.457771400e-02, 6.997251247e-02, 1.784840081e-01,
+          4.244259135e-01, 9.667156330e-01, 2.160089829e+00, 4.877207262e+00, 1.181922117e+01 },
+        { 1.386319543e-03, 7.053162837e-03, 2.437709874e-02, 7.006905758e-02, 1.805204559e-01,
+          4.339073757e-01, 1.000218999e+00, 2.266150075e+00, 5.204249360e+00, 1.290665376e+01 },
+        { 1.349868880e-03, 6.939886874e-03, 2.421505742e-02, 7.026453977e-02, 1.828145833e-01,
+          4.441043498e-01, 1.035858494e+00, 2.379019434e+00, 5.554719058e+00, 1.408861592e+01 },
+        { 1.312674327e-03, 6.818915708e-03, 2.401788461e-02, 7.034508402e-02, 1.848027653e-01,
+          4.536149952e-01, 1.070253532e+00, 2.490619859e+00, 5.909154759e+00, 1.531719849e+01 },
+        { 1.276373265e-03, 6.698422346e-03, 2.381368647e-02, 7.039125714e-02, 1.866927420e-01,
+          4.629427965e-01, 1.104589324e+00, 2.603743293e+00, 6.274363959e+00, 1.661102830e+01 },
+        { 1.241639646e-03, 6.582097253e-03, 2.361584783e-02, 7.044298264e-02, 1.885911771e-01,
+          4.723561551e-01, 1.139527633e+00, 2.720052115e+00, 6.654805999e+00, 1.798425224e+01 },
+        { 1.207634144e-03, 6.465718934e-03, 2.340929829e-02, 7.045438635e-02, 1.903705874e-01,
+          4.815195066e-01, 1.174210470e+00, 2.837372457e+00, 7.044949614e+00, 1.942298089e+01 },
+        { 1.174637760e-03, 6.350997217e-03, 2.320044903e-02, 7.044471531e-02, 1.920819173e-01,
+          4.905585868e-01, 1.208941021e+00, 2.956456619e+00, 7.446857864e+00, 2.093456620e+01 },
+        { 1.142687460e-03, 6.238427740e-03, 2.299151453e-02, 7.042104645e-02, 1.937441997e-01,
+          4.995201930e-01, 1.243832650e+00, 3.077602588e+00, 7.861493489e+00, 2.252364716e+01 },
+        { 1.111739894e-03, 6.127720793e-03, 2.278126878e-02, 7.037882172e-02, 1.953419034e-01,
+          5.083552329e-01, 1.278740012e+00, 3.200405471e+00, 8.287823247e+00, 2.418852001e+01 },
+        { 1.081769900e-03, 6.019039069e-03, 2.257073717e-02, 7.032160021e-02, 1.968846212e-01,
+          5.170862325e-01, 1.313714186e+00, 3.324998346e+00, 8.726347363e+00, 2.593241375e+01 },
+        { 1.052751382e-03, 5.912408554e-03, 2.236025186e-02, 7.025048524e-02, 1.983745102e-01,
+          5.257148642e-01, 1.348749408e+00, 3.451357840e+00, 9.177114709e+00, 2.775710053e+01 },
+        { 9.210868999e-04, 5.411003410e-03, 2.132100192e-02, 6.973180786e-02, 2.051389439e-01,
+          5.674985856e-01, 1.525011569e+00, 4.109929305e+00, 1.161958144e+01, 3.816682933e+01 },
+        { 8.094664673e-04, 4.961518194e-03, 2.032070796e-02, 6.901334206e-02, 2.109285891e-01,
+          6.072157397e-01, 1.702896957e+00, 4.812051257e+00, 1.438358669e+01, 5.089648492e+01 },
+        { 7.146498578e-04, 4.560030840e-03, 1.937176157e-02, 6.816748148e-02, 2.159351847e-01,
+          6.451464129e-01, 1.882379470e+00, 5.557095180e+00, 1.748123008e+01, 6.620123114e+01 },
+        { 6.338152984e-04, 4.201567496e-03, 1.847841786e-02, 6.724140101e-02, 2.203000658e-01,
+          6.815100513e-01, 2.063429137e+00, 6.344544452e+00, 2.092460489e+01, 8.434387935e+01 },
+        { 5.645897219e-04, 3.881096505e-03, 1.764074963e-02, 6.626673347e-02, 2.241309253e-01,
+          7.164849714e-01, 2.246023626e+00, 7.174008723e+00, 2.472595563e+01, 1.055958788e+02 },
+        { 5.050176022e-04, 3.593956153e-03, 1.685674224e-02, 6.526514052e-02, 2.275117128e-01,
+          7.502185496e-01, 2.430145713e+00, 8.045196414e+00, 2.889765929e+01, 1.302374944e+02 },
+        { 4.535003764e-04, 3.335993613e-03, 1.612339629e-02, 6.425166481e-02, 2.305090518e-01,
+          7.828341516e-01, 2.615781181e+00, 8.957893177e+00, 3.345220761e+01, 1.585579399e+02 },
+        { 4.087338929e-04, 3.103580558e-03, 1.543732577e-02, 6.323685928e-02, 2.331766693e-01,
+          8.144363342e-01, 2.802918035e+00, 9.911947520e+00, 3.840219969e+01, 1.908555175e+02 },
+        { 3.696525479e-04, 2.893575492e-03, 1.479507374e-02, 6.222814657e-02, 2.355584195e-01,
+          8.451144305e-01, 2.991545190e+00, 1.090725724e+01, 4.376032756e+01, 2.274376995e+02 },
+        { 3.353830797e-04, 2.703271154e-03, 1.419329080e-02, 6.123077330e-02, 2.376906265e-01,
+          8.749458281e-01, 3.181653405e+00, 1.194376505e+01, 4.953938766e+01, 2.686213133e+02 },
+        { 3.052065835e-04, 2.530335003e-03, 1.362880940e-02, 6.024839600e-02, 2.396035717e-01,
+          9.039977039e-01, 3.373233495e+00, 1.302144669e+01, 5.575225952e+01, 3.147325613e+02 },
+        { 2.785285410e-04, 2.372756646e-03, 1.309868604e-02, 5.928353612e-02, 2.413227790e-01,
+          9.323289623e-01, 3.566276865e+00, 1.414030772e+01, 6.241191160e+01, 3.661071552e+02 },
+        { 2.548548588e-04, 2.228800106e-03, 1.260021126e-02, 5.833788544e-02, 2.428699338e-01,
+          9.599915711e-01, 3.760775315e+00, 1.530037883e+01, 6.953139905e+01, 4.230904087e+02 },
+        { 2.337729076e-04, 2.096963101e-03, 1.213090794e-02, 5.741253728e-02, 2.442636398e-01,
+          9.870318205e-01, 3.956721629e+00, 1.650171496e+01, 7.712387439e+01, 4.860373990e+02 },
+        { 2.149362541e-04, 1.975940724e-03, 1.168851234e-02, 5.650811454e-02, 2.455198498e-01,
+          1.013490724e+00, 4.154107742e+00, 1.774438537e+01, 8.520255717e+01, 5.553128866e+02 },
+        { 1.980527888e-04, 1.864597334e-03, 1.127096650e-02, 5.562492104e-02, 2.466524401e-01,
+          1.039405240e+00, 4.352926590e+00, 1.902847862e+01, 9.378076563e+01, 6.312915915e+02 }
+    };
+    // The maximum error in the enclosed flux fraction at any radius for n between
+    // sersic_mixture_n[i] and sersic_mixture_n[i+1], including the interpolation error.
+    const double sersic_mixture_err[sersic_mixture_nn-1] = {
+        4.1e-04, 2.4e-04, 2.1e-04, 1.9e-04, 2.4e-04, 2.2e-04, 1.7e-04, 2.3e-04, 1.3e-04,
+        1.3e-04, 9.7e-05, 8.0e-05, 8.2e-05, 6.5e-05, 5.9e-05, 5.8e-05, 5.9e-05, 6.9e-05,
+        7.9e-05, 9.1e-05, 1.0e-04, 1.2e-04, 1.3e-04, 1.4e-04, 1.6e-04, 1.8e-04, 1.9e-04,
+        2.1e-04, 2.3e-04, 3.8e-04, 4.7e-04, 6.2e-04, 7.9e-04, 9.7e-04, 1.2e-03, 1.4e-03,
+        1.6e-03, 1.9e-03, 2.1e-03, 2.4e-03, 2.6e-03, 2.9e-03, 3.2e-03, 3.5e-03, 3.8e-03
+    };
+
+    SBProfile MakeSersicGaussianMixture(double n, double re, double flux,
+                                        const GSParamsPtr& gsparams, double& error)
+    {
+        dbg<<"MakeSersicGaussianMixture: n = "<<n<<", re = "<<re<<", flux = "<<flux<<std::endl;
+        if (n < sersic_mixture_n[0] || n > sersic_mixture_n[sersic_mixture_nn-1])
+            throw SBError("Sersic index n is outside the range of the Gaussian mixture table");
+
+        // Find the interval that contains n.
+        int i = std::upper_bound(sersic_mixture_n, sersic_mixture_n + sersic_mixture_nn, n)
+            - sersic_mixture_n - 1;
+        if (i == sersic_mixture_nn-1) --i;
+        double f = (n - sersic_mixture_n[i]) / (sersic_mixture_n[i+1] - sersic_mixture_n[i]);
+        error = sersic_mixture_err[i];
+        xdbg<<"i = "<<i<<", f = "<<f<<", error = "<<error<<std::endl;
+
+        // Interpolate the amplitudes linearly and the variances linearly in log(var).
+        // The tabulated amplitudes only sum to 1 to the precision they are given with, so
+        // renormalize to get the flux exactly right.
+        double amp[sersic_mixture_ng];
+        double sumamp = 0.;
+        for (int j=0; j<sersic_mixture_ng; ++j) {
+            amp[j] = (1.-f) * sersic_mixture_amp[i][j] + f * sersic_mixture_amp[i+1][j];
+            sumamp += amp[j];
+        }
+        std::list<SBProfile> gaussians;
+        double re_sq = re*re;
+        for (int j=0; j<sersic_mixture_ng; ++j) {
+            double var = std::pow(sersic_mixture_var[i][j], 1.-f) *
+                std::pow(sersic_mixture_var[i+1][j], f);
+            gaussians.push_back(SBGaussian(std::sqrt(var * re_sq), amp[j] * flux / sumamp,
+                                           gsparams));
+        }
+        return SBAdd(gaussians, gsparams);
+    }
 }
@@ -25,6 +25,7 @@
 #include <boost/math/special_functions/gamma.hpp>
 #include "Solve.h"
 #include "bessel/Roots.h"
+#include "TableCache.h"
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -84,7 +85,7 @@ namespace galsim {
     }
 
     LRUCache<boost::tuple<double,GSParamsPtr>,SpergelInfo> SBSpergel::SBSpergelImpl::cache(
-        sbp::max_spergel_cache);
+        sbp::max_spergel_cache, "spergel");
 
     SBSpergel::SBSpergelImpl::SBSpergelImpl(double nu, double size, RadiusType rType,
                                             double flux, const GSParamsPtr& gsparams) :
@@ -189,6 +190,7 @@ namespace galsim {
             fillKValueQuadrant(val,kx0,dkx,izero,ky0,dky,jzero);
         } else {
             xdbg<<"Non-Quadrant\n";
+            if (fillKValueRadial(val,kx0,dkx,ky0,dky)) return;
             assert(val.stepi() == 1);
             const int m = val.colsize();
             const int n = val.rowsize();
@@ -249,6 +251,7 @@ namespace galsim {
         dbg<<"SBSpergel fillKValue\n";
         dbg<<"kx = "<<kx0<<" + i * "<<dkx<<" + j * "<<dkxy<<std::endl;
         dbg<<"ky = "<<ky0<<" + i * "<<dkyx<<" + j * "<<dky<<std::endl;
+        if (fillKValueRadial(val,kx0,dkx,dkxy,ky0,dky,dkyx)) return;
         assert(val.stepi() == 1);
         assert(val.canLinearize());
         const int m = val.colsize();
@@ -353,16 +356,43 @@ namespace galsim {
         return func(r);
     }
 
-    double SpergelInfo::stepK() const
+    // The version of the layout of the values in the on-disk cache.  Increment this
+    // whenever the layout or the calculation of the values changes.
+    static const int spergel_table_version = 1;
+
+    void SpergelInfo::calculateRadii() const
     {
-        if (_stepk == 0.) {
-            double R = calculateFluxRadius(1.0 - _gsparams->folding_threshold);
-            // Go to at least 5*re
-            R = std::max(R,_gsparams->stepk_minimum_hlr);
-            dbg<<"R => "<<R<<std::endl;
-            _stepk = M_PI / R;
-            dbg<<"stepk = "<<_stepk<<std::endl;
+        // These both need a root solve, so check whether another process has already
+        // saved them in the on-disk cache.
+        std::ostringstream key;
+        key.precision(17);
+        key << "nu=" << _nu << " " << TableCache::makeKey(*_gsparams);
+        std::vector<double> cached;
+        if (TableCache::read("spergel", spergel_table_version, key.str(), cached) &&
+            cached.size() == 2) {
+            _stepk = cached[0];
+            _re = cached[1];
+            dbg<<"Using cached stepk = "<<_stepk<<", re = "<<_re<<std::endl;
+            return;
         }
+
+        double R = calculateFluxRadius(1.0 - _gsparams->folding_threshold);
+        // Go to at least 5*re
+        R = std::max(R,_gsparams->stepk_minimum_hlr);
+        dbg<<"R => "<<R<<std::endl;
+        _stepk = M_PI / R;
+        dbg<<"stepk = "<<_stepk<<std::endl;
+        _re = calculateFluxRadius(0.5);
+
+        cached.resize(2);
+        cached[0] = _stepk;
+        cached[1] = _re;
+        TableCache::write("spergel", spergel_table_version, key.str(), cached);
+    }
+
+    double SpergelInfo::stepK() const
+    {
+        if (_stepk == 0.) calculateRadii();
         return _stepk;
     }
 
@@ -380,7 +410,7 @@ namespace galsim {
 
     double SpergelInfo::getHLR() const
     {
-        if (_re == 0.0) _re = calculateFluxRadius(0.5);
+        if (_re == 0.0) calculateRadii();
         return _re;
     }
 
@@ -434,6 +464,11 @@ namespace galsim {
         dbg<<"SpergelInfo shoot: N = "<<N<<std::endl;
         dbg<<"Target flux = 1.0\n";
 
+        // The sampler is built on first use.  drawShoot may call this from several threads
+        // at once, so only let one of them build it.
+#ifdef _OPENMP
+#pragma omp critical (galsim_spergel_sampler)
+#endif
         if (!_sampler) {
             // Set up the classes for photon shooting
             double shoot_rmax = calculateFluxRadius(1. - _gsparams->shoot_accuracy);
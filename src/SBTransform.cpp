@@ -22,6 +22,7 @@
 #include "TMV.h"
 #include "SBTransform.h"
 #include "SBTransformImpl.h"
+#include "SBGaussian.h"
 
 #ifdef DEBUGLOGGING
 #include <fstream>
@@ -56,6 +57,72 @@ namespace galsim {
         return oss.str();
     }
 
+    bool SBTransform::SBTransformImpl::simplify(SBProfile& result) const
+    {
+        const bool ident = (_mA == 1. && _mB == 0. && _mC == 0. && _mD == 1.);
+        const bool noshift = (_cen.x == 0. && _cen.y == 0.);
+
+        // A transformed Gaussian is just an elliptical Gaussian.  Only remake it if that is
+        // actually simpler, i.e. if it comes out circular, or if the transformation here has
+        // more than a shift.
+        double flux, cxx, cxy, cyy;
+        Position<double> cen;
+        if (getGaussian(flux,cxx,cxy,cyy,cen)) {
+            SBProfile g = MakeEllipticalGaussian(flux,cxx,cxy,cyy,cen,gsparams);
+            if (GetImpl(g)->getGaussian(flux,cxx,cxy,cyy,cen) && cxy == 0. && cxx == cyy) {
+                // g is circular, so it's either a bare SBGaussian or a shifted one.
+                if (noshift || !ident || _fluxScaling != 1.) {
+                    result = g;
+                    return true;
+                }
+            }
+        }
+
+        SBProfile adaptee = _adaptee.simplify();
+        if (ident && noshift) {
+            // Just a flux scaling, which can often be folded into the adaptee.
+            if (_fluxScaling == 1.) {
+                result = adaptee;
+                return true;
+            }
+            if (GetImpl(adaptee)->foldFluxScaling(_fluxScaling,result)) return true;
+        }
+        if (GetImpl(adaptee) == GetImpl(_adaptee)) return false;
+        // The constructor combines this with the adaptee if it simplified to an SBTransform.
+        result = SBTransform(adaptee,_mA,_mB,_mC,_mD,_cen,_fluxScaling,gsparams);
+        return true;
+    }
+
+    bool SBTransform::SBTransformImpl::getGaussian(double& flux, double& cxx, double& cxy,
+                                                   double& cyy, Position<double>& cen) const
+    {
+        double cxx0, cxy0, cyy0;
+        Position<double> cen0;
+        if (!GetImpl(_adaptee)->getGaussian(flux,cxx0,cxy0,cyy0,cen0)) return false;
+        // The transformed profile has covariance M C M^T, center M cen + _cen.
+        const double ax = _mA*cxx0 + _mB*cxy0;
+        const double ay = _mA*cxy0 + _mB*cyy0;
+        const double bx = _mC*cxx0 + _mD*cxy0;
+        const double by = _mC*cxy0 + _mD*cyy0;
+        cxx = ax*_mA + ay*_mB;
+        cxy = ax*_mC + ay*_mD;
+        cyy = bx*_mC + by*_mD;
+        cen = _cen + fwd(cen0);
+        flux *= _absdet;
+        return true;
+    }
+
+    bool SBTransform::SBTransformImpl::getGaussianSum(std::list<SBProfile>& terms) const
+    {
+        // A transformed sum of Gaussians is the sum of the transformed Gaussians.
+        std::list<SBProfile> adaptee_terms;
+        if (!GetImpl(_adaptee)->getGaussianSum(adaptee_terms)) return false;
+        typedef std::list<SBProfile>::const_iterator ConstIter;
+        for (ConstIter tptr = adaptee_terms.begin(); tptr != adaptee_terms.end(); ++tptr)
+            terms.push_back(SBTransform(*tptr,_mA,_mB,_mC,_mD,_cen,_fluxScaling,gsparams));
+        return true;
+    }
+
     SBProfile SBTransform::getObj() const
     {
         assert(dynamic_cast<const SBTransformImpl*>(_pimpl.get()));
@@ -497,6 +564,42 @@ namespace galsim {
     std::complex<double> SBTransform::SBTransformImpl::kValue(const Position<double>& k) const
     { return _kValue(_adaptee,fwdT(k),_absdet,k,_cen); }
 
+    void SBTransform::SBTransformImpl::xValueMany(const double* x, const double* y,
+                                                  double* val, int n) const
+    {
+        // Apply inv to (x-cen, y-cen).  (For the identity, this reproduces x,y exactly.)
+        std::vector<double> xinv(n), yinv(n);
+        for (int i=0;i<n;++i) {
+            double xx = x[i] - _cen.x;
+            double yy = y[i] - _cen.y;
+            xinv[i] = _invdet*(_mD*xx - _mB*yy);
+            yinv[i] = _invdet*(-_mC*xx + _mA*yy);
+        }
+        if (n > 0) GetImpl(_adaptee)->xValueMany(&xinv[0],&yinv[0],val,n);
+        for (int i=0;i<n;++i) val[i] *= _fluxScaling;
+    }
+
+    void SBTransform::SBTransformImpl::kValueMany(const double* kx, const double* ky,
+                                                  std::complex<double>* val, int n) const
+    {
+        // Apply fwdT to kx,ky
+        std::vector<double> kxfwd(n), kyfwd(n);
+        for (int i=0;i<n;++i) {
+            kxfwd[i] = _mA*kx[i] + _mC*ky[i];
+            kyfwd[i] = _mB*kx[i] + _mD*ky[i];
+        }
+        if (n > 0) GetImpl(_adaptee)->kValueMany(&kxfwd[0],&kyfwd[0],val,n);
+
+        // Apply phases
+        if (_zeroCen) {
+            // Match kValue, which skips the multiplication when absdet ~= 1.
+            if (_kValueNoPhase == &SBTransform::SBTransformImpl::_kValueNoPhaseWithDet)
+                for (int i=0;i<n;++i) val[i] *= _absdet;
+        } else {
+            for (int i=0;i<n;++i) val[i] *= std::polar(_absdet, -kx[i]*_cen.x-ky[i]*_cen.y);
+        }
+    }
+
     std::complex<double> SBTransform::SBTransformImpl::kValueNoPhase(
         const Position<double>& k) const
     { return _kValueNoPhase(_adaptee,fwdT(k),_absdet,k,_cen); }
@@ -29,32 +29,76 @@
 
 namespace galsim {
 
+    namespace {
+
+        // Tables may be used from several threads at once (e.g. by the threaded fills in
+        // SBProfile), so the lastIndex hint may be read and written by several threads.
+        // It only needs to be read and written whole.  Without atomics, don't share it
+        // between threads, and always start the search from the beginning.
+        inline int ReadHint(const int& hint)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201107)
+            int i;
+#pragma omp atomic read
+            i = hint;
+            return i;
+#elif defined(_OPENMP)
+            return 1;
+#else
+            return hint;
+#endif
+        }
+
+        inline void WriteHint(int& hint, int i)
+        {
+#if defined(_OPENMP) && (_OPENMP >= 201107)
+#pragma omp atomic write
+            hint = i;
+#elif !defined(_OPENMP)
+            hint = i;
+#endif
+        }
+
+    }
+
     // ArgVec
 
     template<class A>
     void ArgVec<A>::setup() const
     {
-        int N = vec.size();
-        const double tolerance = 0.01;
-        da = (vec.back() - vec.front()) / (N-1);
-        if (da == 0.) throw TableError("First and last arguments are equal.");
-        equalSpaced = true;
-        for (int i=1; i<N; i++) {
-            if (std::abs((vec[i] - vec.front())/da - i) > tolerance) equalSpaced = false;
-            if (vec[i] <= vec[i-1])
-                throw TableError("Table arguments not strictly increasing.");
+        // Tables may be used from several threads at once, so only let one of them do the
+        // setup, and publish it with SetReadyFlag.  Exceptions can't propagate out of the
+        // critical section, so they are rethrown afterwards.
+        std::string err;
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_args_setup)
+#endif
+        if (!isReady) {
+            int N = vec.size();
+            const double tolerance = 0.01;
+            da = (vec.back() - vec.front()) / (N-1);
+            if (da == 0.) err = "First and last arguments are equal.";
+            equalSpaced = true;
+            for (int i=1; i<N && err == ""; i++) {
+                if (std::abs((vec[i] - vec.front())/da - i) > tolerance) equalSpaced = false;
+                if (vec[i] <= vec[i-1])
+                    err = "Table arguments not strictly increasing.";
+            }
+            if (err == "") {
+                WriteHint(lastIndex, 1);
+                lower_slop = (vec[1]-vec[0]) * 1.e-6;
+                upper_slop = (vec[N-1]-vec[N-2]) * 1.e-6;
+                SetReadyFlag(isReady);
+            }
         }
-        lastIndex = 1;
-        lower_slop = (vec[1]-vec[0]) * 1.e-6;
-        upper_slop = (vec[N-1]-vec[N-2]) * 1.e-6;
-        isReady = true;
+        if (err != "") throw TableError(err);
     }
 
     // Look up an index.  Use STL binary search.
     template<class A>
     int ArgVec<A>::upperIndex(const A a) const
     {
-        if (!isReady) setup();
+        if (!ReadReadyFlag(isReady)) setup();
         if (a<vec.front()-lower_slop || a>vec.back()+upper_slop)
             throw TableOutOfRange(a,vec.front(),vec.back());
         // check for slop
@@ -70,37 +114,38 @@ namespace galsim {
             while (a < vec[i-1]) --i;
             return i;
         } else {
-            xassert(lastIndex >= 1);
-            xassert(lastIndex < vec.size());
-
-            if ( a < vec[lastIndex-1] ) {
-                xassert(lastIndex-2 >= 0);
+            // lastIndex is just a hint for where to start looking.  Work with a local copy,
+            // since other threads may be changing it.
+            int i = ReadHint(lastIndex);
+            xassert(i >= 1);
+            xassert(i < vec.size());
+
+            if ( a < vec[i-1] ) {
+                xassert(i-2 >= 0);
                 // Check to see if the previous one is it.
-                if (a >= vec[lastIndex-2]) return --lastIndex;
+                if (a >= vec[i-2]) --i;
                 else {
-                    // Look for the entry from 0..lastIndex-1:
-                    citer p = std::upper_bound(vec.begin(), vec.begin()+lastIndex-1, a);
+                    // Look for the entry from 0..i-1:
+                    citer p = std::upper_bound(vec.begin(), vec.begin()+i-1, a);
                     xassert(p != vec.begin());
-                    xassert(p != vec.begin()+lastIndex-1);
-                    lastIndex = p-vec.begin();
-                    return lastIndex;
+                    xassert(p != vec.begin()+i-1);
+                    i = p-vec.begin();
                 }
-            } else if (a > vec[lastIndex]) {
-                xassert(lastIndex+1 < vec.size());
+            } else if (a > vec[i]) {
+                xassert(i+1 < vec.size());
                 // Check to see if the next one is it.
-                if (a <= vec[lastIndex+1]) return ++lastIndex;
+                if (a <= vec[i+1]) ++i;
                 else {
-                    // Look for the entry from lastIndex..end
-                    citer p = std::lower_bound(vec.begin()+lastIndex+1, vec.end(), a);
-                    xassert(p != vec.begin()+lastIndex+1);
+                    // Look for the entry from i..end
+                    citer p = std::lower_bound(vec.begin()+i+1, vec.end(), a);
+                    xassert(p != vec.begin()+i+1);
                     xassert(p != vec.end());
-                    lastIndex = p-vec.begin();
-                    return lastIndex;
+                    i = p-vec.begin();
                 }
-            } else {
-                // Then lastIndex is correct.
-                return lastIndex;
             }
+            // Else i is already correct.
+            WriteHint(lastIndex, i);
+            return i;
         }
     }
 
@@ -128,7 +173,7 @@ namespace galsim {
     template<class V, class A>
     void Table<V,A>::setup() const
     {
-        if (isReady) return;
+        if (ReadReadyFlag(isReady)) return;
 
         if (vals.size() != args.size())
             throw TableError("args and vals lengths don't match");
@@ -137,27 +182,34 @@ namespace galsim {
         if (vals.size() < 2 && (iType == linear || iType == ceil || iType == floor
                               || iType == nearest))
             throw TableError("input vectors are too short for interpolation");
-        switch (iType) {
-          case linear:
-               interpolate = &Table<V,A>::linearInterpolate;
-               break;
-          case floor:
-               interpolate = &Table<V,A>::floorInterpolate;
-               break;
-          case ceil:
-               interpolate = &Table<V,A>::ceilInterpolate;
-               break;
-          case nearest:
-               interpolate = &Table<V,A>::nearestInterpolate;
-               break;
-          case spline:
-               interpolate = &Table<V,A>::splineInterpolate;
-               break;
-          default:
-               throw TableError("interpolation method not yet implemented");
+        if (iType != linear && iType != floor && iType != ceil && iType != nearest &&
+            iType != spline)
+            throw TableError("interpolation method not yet implemented");
+
+        // Only let one thread do the rest.
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_setup)
+#endif
+        if (!isReady) {
+            switch (iType) {
+              case linear:
+                   interpolate = &Table<V,A>::linearInterpolate;
+                   break;
+              case floor:
+                   interpolate = &Table<V,A>::floorInterpolate;
+                   break;
+              case ceil:
+                   interpolate = &Table<V,A>::ceilInterpolate;
+                   break;
+              case nearest:
+                   interpolate = &Table<V,A>::nearestInterpolate;
+                   break;
+              default:
+                   interpolate = &Table<V,A>::splineInterpolate;
+                   setupSpline();
+            }
+            SetReadyFlag(isReady);
         }
-        if (iType == spline) setupSpline();
-        isReady = true;
     }
 
     //lookup and interpolate function value.
@@ -0,0 +1,251 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+//#define DEBUGLOGGING
+
+#include "TableCache.h"
+#include "Version.h"
+#include "Std.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace galsim {
+
+    namespace {
+
+        // Increment this whenever the file layout changes.
+        const unsigned int table_cache_format = 2;
+
+        // The file header.  The key follows immediately, padded to a multiple of 8 bytes,
+        // and then the data.
+        struct TableCacheHeader
+        {
+            char magic[8];
+            unsigned int format;
+            unsigned int version;
+            unsigned long long key_size;
+            unsigned long long data_size;
+        };
+
+        const char table_cache_magic[8] = { 'G','S','T','A','B','L','E','\0' };
+
+        size_t PaddedKeySize(size_t key_size)
+        { return (key_size + 7) & ~size_t(7); }
+
+        // The hash of the key, used for the file name.  (The full key is also stored
+        // in the file and checked on reading, so collisions are harmless.)
+        std::string HashKey(const std::string& key)
+        {
+            char buf[17];
+            std::sprintf(buf, "%016llx", HashString(key));
+            return buf;
+        }
+
+        std::string FileName(const std::string& dir, const std::string& kind,
+                             const std::string& key)
+        { return dir + "/" + kind + "_" + HashKey(key) + ".dat"; }
+
+        std::string& CacheDir()
+        {
+            static bool initialized = false;
+            static std::string dir;
+            if (!initialized) {
+                const char* env = std::getenv("GALSIM_TABLE_CACHE_DIR");
+                if (env) dir = env;
+                initialized = true;
+            }
+            return dir;
+        }
+
+        TableCacheStats table_cache_stats;
+
+        void CountRead(bool found)
+        {
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_stats)
+#endif
+            {
+                if (found) ++table_cache_stats.hits;
+                else ++table_cache_stats.misses;
+            }
+        }
+
+    }
+
+    void TableCache::setDir(const std::string& dir)
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_dir)
+#endif
+        CacheDir() = dir;
+    }
+
+    std::string TableCache::getDir()
+    {
+        std::string dir;
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_dir)
+#endif
+        dir = CacheDir();
+        return dir;
+    }
+
+    TableCacheStats TableCache::getStats()
+    {
+        TableCacheStats stats;
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_stats)
+#endif
+        stats = table_cache_stats;
+        return stats;
+    }
+
+    void TableCache::resetStats()
+    {
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_stats)
+#endif
+        table_cache_stats = TableCacheStats();
+    }
+
+    std::string TableCache::makeKey(const GSParams& gsparams)
+    {
+        std::ostringstream oss;
+        oss.precision(17);
+        oss << "GalSim " << version() << " GSParams(";
+        oss << gsparams.minimum_fft_size << "," << gsparams.maximum_fft_size << ","
+            << gsparams.folding_threshold << "," << gsparams.stepk_minimum_hlr << ","
+            << gsparams.maxk_threshold << ","
+            << gsparams.kvalue_accuracy << "," << gsparams.xvalue_accuracy << ","
+            << gsparams.table_spacing << ","
+            << gsparams.realspace_relerr << "," << gsparams.realspace_abserr << ","
+            << gsparams.integration_relerr << "," << gsparams.integration_abserr << ","
+            << gsparams.shoot_accuracy << ","
+            << gsparams.allowed_flux_variation << "," << gsparams.range_division_for_extrema << ","
+            << gsparams.small_fraction_of_flux << ")";
+        return oss.str();
+    }
+
+    bool TableCache::read(const std::string& kind, int version, const std::string& key,
+                          std::vector<double>& data)
+    {
+        std::string dir = getDir();
+        if (dir == "") return false;
+        std::string file_name = FileName(dir, kind, key);
+        dbg<<"TableCache::read "<<file_name<<std::endl;
+
+        int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            dbg<<"Not found"<<std::endl;
+            CountRead(false);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(TableCacheHeader)) {
+            close(fd);
+            CountRead(false);
+            return false;
+        }
+        size_t file_size = st.st_size;
+        void* map = mmap(0, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            CountRead(false);
+            return false;
+        }
+
+        const char* p = static_cast<const char*>(map);
+        const TableCacheHeader* header = reinterpret_cast<const TableCacheHeader*>(p);
+        bool found =
+            std::memcmp(header->magic, table_cache_magic, sizeof(table_cache_magic)) == 0 &&
+            header->format == table_cache_format &&
+            header->version == (unsigned int)(version) &&
+            header->key_size == key.size() &&
+            file_size == sizeof(TableCacheHeader) + PaddedKeySize(key.size()) +
+                         header->data_size * sizeof(double) &&
+            std::memcmp(p + sizeof(TableCacheHeader), key.data(), key.size()) == 0;
+        if (found) {
+            const double* d = reinterpret_cast<const double*>(
+                p + sizeof(TableCacheHeader) + PaddedKeySize(key.size()));
+            data.assign(d, d + header->data_size);
+            dbg<<"Read "<<data.size()<<" values"<<std::endl;
+        } else {
+            dbg<<"File does not match key "<<key<<std::endl;
+        }
+        munmap(map, file_size);
+        CountRead(found);
+        return found;
+    }
+
+    void TableCache::write(const std::string& kind, int version, const std::string& key,
+                           const std::vector<double>& data)
+    {
+        std::string dir = getDir();
+        if (dir == "") return;
+        // Make the directory if necessary.  If this fails, so will fopen below.
+        mkdir(dir.c_str(), 0777);
+        std::string file_name = FileName(dir, kind, key);
+        dbg<<"TableCache::write "<<file_name<<std::endl;
+
+        // Write to a temporary file first and then rename it, so other processes never
+        // see a partially written file.
+        std::ostringstream tmp_name;
+        tmp_name << file_name << "." << getpid() << ".tmp";
+        std::FILE* f = std::fopen(tmp_name.str().c_str(), "wb");
+        if (!f) {
+            dbg<<"Unable to open "<<tmp_name.str()<<std::endl;
+            return;
+        }
+
+        TableCacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, table_cache_magic, sizeof(table_cache_magic));
+        header.format = table_cache_format;
+        header.version = version;
+        header.key_size = key.size();
+        header.data_size = data.size();
+        std::vector<char> padded_key(PaddedKeySize(key.size()), '\0');
+        std::copy(key.begin(), key.end(), padded_key.begin());
+
+        bool ok =
+            std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+            std::fwrite(&padded_key[0], 1, padded_key.size(), f) == padded_key.size() &&
+            (data.empty() ||
+             std::fwrite(&data[0], sizeof(double), data.size(), f) == data.size());
+        ok = (std::fclose(f) == 0) && ok;
+        if (!ok || std::rename(tmp_name.str().c_str(), file_name.c_str()) != 0) {
+            dbg<<"Failed to write "<<file_name<<std::endl;
+            std::remove(tmp_name.str().c_str());
+        } else {
+#ifdef _OPENMP
+#pragma omp critical (galsim_table_cache_stats)
+#endif
+            ++table_cache_stats.writes;
+        }
+    }
+
+}
@@ -0,0 +1,166 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#include "VectorMath.h"
+
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+// With gcc on x86-64 Linux, build each kernel for several instruction sets.  The dynamic
+// loader picks the best one that the current machine supports.  We also turn on the
+// vectorizer explicitly, since -O2 doesn't (fully) enable it unless OpenMP is being used.
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) && \
+    (__GNUC__ >= 6) && defined(__x86_64__) && defined(__linux__)
+#define GALSIM_TARGET_CLONES \
+    __attribute__((target_clones("avx512f","avx2","default"), \
+                   optimize("tree-vectorize","vect-cost-model=dynamic")))
+#else
+#define GALSIM_TARGET_CLONES
+#endif
+
+namespace galsim {
+namespace math {
+
+    namespace {
+
+        // Reinterpret the bits of a double as an integer and vice versa.  (memcpy is the
+        // portable way to do this, and compilers turn it into a simple register move.)
+        inline uint64_t AsBits(double x)
+        { uint64_t b; std::memcpy(&b, &x, sizeof(b)); return b; }
+        inline double AsDouble(uint64_t b)
+        { double x; std::memcpy(&x, &b, sizeof(x)); return x; }
+
+        const double ln2_hi = 6.93147180369123816490e-01;  // The top 32 bits of ln(2)
+        const double ln2_lo = 1.90821492927058770002e-10;  // ln(2) - ln2_hi
+        const double log2e = 1.44269504088896338700e+00;   // 1/ln(2)
+
+        // Adding and subtracting 1.5 * 2^52 rounds a double (of modest size) to the nearest
+        // integer.  The integer also ends up in the low bits of the intermediate sum.
+        const double round_shift = 6755399441055744.;
+
+        // Beyond these limits, exp overflows to inf or underflows to 0.
+        const double exp_hi = 7.09782712893383973096e+02;
+        const double exp_lo = -7.45133219101941108420e+02;
+
+        // Below this, the result is denormal, so 2^k cannot be built directly from its
+        // exponent bits.  Instead build 2^(k+64) and scale by 2^-64 at the end.
+        const double exp_denorm = -708.;
+        const double two_m64 = 5.42101086242752217004e-20;  // 2^-64
+    }
+
+    GALSIM_TARGET_CLONES
+    void ExpMany(const double* x, double* y, int n)
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp simd
+#endif
+        for (int i=0; i<n; ++i) {
+            const double xi = x[i];
+            // Clamp so the exponent arithmetic below cannot overflow.  Values outside the
+            // range are fixed up at the end.
+            double xc = xi < exp_lo ? exp_lo : xi;
+            xc = xc > exp_hi ? exp_hi : xc;
+
+            // Write exp(x) = 2^k exp(r), with k an integer and |r| <= ln(2)/2.
+            const double t = xc * log2e + round_shift;
+            const double k = t - round_shift;
+            const double r = (xc - k * ln2_hi) - k * ln2_lo;
+
+            // exp(r) from its Taylor series.  For |r| <= ln(2)/2, 13 terms are enough for
+            // double precision.
+            double p = 1./6227020800.;
+            p = p * r + 1./479001600.;
+            p = p * r + 1./39916800.;
+            p = p * r + 1./3628800.;
+            p = p * r + 1./362880.;
+            p = p * r + 1./40320.;
+            p = p * r + 1./5040.;
+            p = p * r + 1./720.;
+            p = p * r + 1./120.;
+            p = p * r + 1./24.;
+            p = p * r + 1./6.;
+            p = p * r + 0.5;
+            p = p * r + 1.;
+            p = p * r + 1.;
+
+            // Build 2^(k-1) directly from its exponent bits.  (k is in the low bits of t.)
+            // Using k-1 rather than k keeps the biased exponent in range for x near exp_hi.
+            const bool denorm = xc < exp_denorm;
+            const uint64_t bias = denorm ? 1022 + 64 : 1022;
+            const double scale = AsDouble((AsBits(t) + bias) << 52);
+            double res = 2. * (p * scale);
+            res = denorm ? res * two_m64 : res;
+
+            y[i] = xi > exp_hi ? inf : (xi < exp_lo ? 0. : res);
+        }
+    }
+
+    GALSIM_TARGET_CLONES
+    void LogMany(const double* x, double* y, int n)
+    {
+        const double inf = std::numeric_limits<double>::infinity();
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double min_normal = std::numeric_limits<double>::min();
+        const double two52 = 4503599627370496.;  // 2^52
+        const double sqrt2 = 1.41421356237309504880;
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#pragma omp simd
+#endif
+        for (int i=0; i<n; ++i) {
+            const double xi = x[i];
+            // Scale up denormals so they have a normal exponent.
+            const bool denorm = xi < min_normal;
+            const double xs = denorm ? xi * two52 : xi;
+
+            // Write x = 2^e m with m in [1,2), then adjust to have m in [sqrt(1/2), sqrt(2)).
+            const uint64_t bits = AsBits(xs);
+            double m = AsDouble((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+            // The biased exponent as a double, using the same trick as in ExpMany.
+            double e = AsDouble((bits >> 52) | 0x4330000000000000ULL) - (two52 + 1023.);
+            e = denorm ? e - 52. : e;
+            const bool big = m > sqrt2;
+            m = big ? 0.5 * m : m;
+            e = big ? e + 1. : e;
+
+            // log(m) = log((1+s)/(1-s)) = 2 atanh(s), where s = (m-1)/(m+1), so |s| < 0.172.
+            const double f = m - 1.;
+            const double s = f / (2. + f);
+            const double z = s * s;
+            double p = 1./21.;
+            p = p * z + 1./19.;
+            p = p * z + 1./17.;
+            p = p * z + 1./15.;
+            p = p * z + 1./13.;
+            p = p * z + 1./11.;
+            p = p * z + 1./9.;
+            p = p * z + 1./7.;
+            p = p * z + 1./5.;
+            p = p * z + 1./3.;
+            // log(m) = 2s + 2s z p = f - s (f - 2 z p) is a bit more accurate than 2s(1+zp).
+            const double logm = f - s * (f - 2. * z * p);
+            const double res = e * ln2_hi + (logm + e * ln2_lo);
+
+            y[i] = xi > 0. ? (xi == inf ? inf : res) : (xi == 0. ? -inf : nan);
+        }
+    }
+
+}
+}
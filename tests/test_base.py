@@ -134,7 +134,8 @@ def test_gaussian():
         realspace_relerr = 6.e-1,
         realspace_abserr = 7.e-1,
         integration_relerr = 8.e-1,
-        integration_abserr = 9.e-1))
+        integration_abserr = 9.e-1,
+        single_precision_fft = True))
     do_pickle(gauss.SBProfile, lambda x: (x.getSigma(), x.getFlux(), x.getGSParams()))
     do_pickle(gauss, lambda x: x.drawImage(method='no_pixel'))
     do_pickle(gauss)
@@ -925,6 +926,226 @@ def test_sersic_1():
         np.testing.assert_almost_equal(sersic.kValue(pos), expon.kValue(pos), decimal=5)
 
 
+@timer
+def test_sersic_gaussian_mixture():
+    """Test the Gaussian mixture approximation to Sersic and Exponential profiles.
+    """
+    gsp = galsim.GSParams(gaussian_mixture=True)
+    assert gsp.gaussian_mixture
+    assert not galsim.GSParams().gaussian_mixture
+    do_pickle(gsp)
+
+    hlr = 1.3
+    flux = 2.
+    # Check the enclosed flux of each profile by integrating xValue in log(r).
+    r = np.logspace(-6, 1, 20001) * hlr
+    radii = np.array([0.01, 0.1, 0.5, 1., 2., 5.]) * hlr
+    def enclosed_flux(obj):
+        f = 2. * np.pi * r**2 * obj.xValueMany(r, np.zeros_like(r))
+        enc = np.concatenate(([0.], np.cumsum(0.5 * (f[1:] + f[:-1]) * np.diff(np.log(r)))))
+        return np.interp(radii, r, enc)
+
+    for n in [0.7, 1.5, 2.5, 4.0, 5.7]:
+        exact = galsim.Sersic(n=n, half_light_radius=hlr, flux=flux)
+        mix = galsim.Sersic(n=n, half_light_radius=hlr, flux=flux, gsparams=gsp)
+        assert exact.getMixtureError() == 0.
+        err = mix.getMixtureError()
+        print('n = ',n,' mixture error = ',err)
+        assert 0. < err < 4.e-3
+        np.testing.assert_almost_equal(mix.getFlux(), flux)
+        np.testing.assert_almost_equal(mix.getHalfLightRadius(), hlr)
+        np.testing.assert_almost_equal(mix.kValue(0,0), flux)
+        diff = np.abs(enclosed_flux(mix) - enclosed_flux(exact)) / flux
+        print('enclosed flux diff = ',diff)
+        assert np.all(diff < err + 2.e-5)
+        do_pickle(mix)
+
+    # Profiles outside the tabulated range, or truncated ones, are not approximated.
+    assert galsim.Sersic(n=0.4, half_light_radius=hlr, gsparams=gsp).getMixtureError() == 0.
+    assert galsim.Sersic(n=6.1, half_light_radius=hlr, gsparams=gsp).getMixtureError() == 0.
+    assert galsim.Sersic(n=2., half_light_radius=hlr, trunc=5.,
+                         gsparams=gsp).getMixtureError() == 0.
+
+    # An Exponential uses the n=1 mixture.
+    exp = galsim.Exponential(half_light_radius=hlr, flux=flux, gsparams=gsp)
+    sersic = galsim.Sersic(n=1., half_light_radius=hlr, flux=flux, gsparams=gsp)
+    assert galsim.Exponential(half_light_radius=hlr).getMixtureError() == 0.
+    assert exp.getMixtureError() == sersic.getMixtureError()
+    np.testing.assert_allclose(enclosed_flux(exp), enclosed_flux(sersic), rtol=1.e-8)
+    do_pickle(exp)
+
+    # Convolving with a sum of Gaussians simplifies to a sum of Gaussians, so it is drawn
+    # without an FFT.  This should match the FFT drawing of the same mixture.
+    psf = galsim.Gaussian(sigma=0.6, flux=0.7) + galsim.Gaussian(sigma=1.2, flux=0.3)
+    gal = galsim.Sersic(n=2.5, half_light_radius=hlr, flux=flux, gsparams=gsp).shear(g1=0.2)
+    conv = galsim.Convolve(gal, psf)
+    assert not conv.isAnalyticX()
+    assert conv.simplify().isAnalyticX()
+    im1 = conv.drawImage(nx=64, ny=64, scale=0.2, method='no_pixel')
+    # With the PSF first, the convolution has the default GSParams, so it is drawn with an FFT.
+    im2 = galsim.Convolve(psf, gal).drawImage(nx=64, ny=64, scale=0.2, method='no_pixel')
+    np.testing.assert_allclose(im1.array, im2.array, rtol=0, atol=1.e-3 * im1.array.max())
+    np.testing.assert_almost_equal(im1.added_flux, im2.added_flux, decimal=3)
+
+    # The sum of Gaussians is drawn in real space even if the cost model would choose an FFT.
+    gsp2 = galsim.GSParams(gaussian_mixture=True, choose_draw_method=True)
+    gal2 = galsim.Sersic(n=2.5, half_light_radius=hlr, flux=flux, gsparams=gsp2).shear(g1=0.2)
+    conv2 = galsim.Convolve(gal2, psf)
+    orig_model = galsim.utilities.get_draw_cost_model()
+    try:
+        galsim.utilities.set_draw_cost_model(xvalue=1., kvalue=orig_model['kvalue'],
+                                             fft=orig_model['fft'], shoot=orig_model['shoot'])
+        assert conv2.simplify().chooseDrawMethod(im1, method='no_pixel')['method'] == 'fourierDraw'
+        im3 = conv2.drawImage(nx=64, ny=64, scale=0.2, method='no_pixel')
+        np.testing.assert_array_equal(im3.array, im1.array,
+                                      err_msg="Simplified Gaussian mixture wasn't drawn in real "
+                                      "space")
+    finally:
+        galsim.utilities.set_draw_cost_model(orig_model['xvalue'], orig_model['kvalue'],
+                                             orig_model['fft'], orig_model['shoot'])
+
+
+@timer
+def test_sersic_interpolated_n():
+    """Test that untruncated Sersic profiles interpolated in n match exact calculations.
+    """
+    import math
+    def j0(x):
+        # J0(x) = 1/pi int_0^pi cos(x sin t) dt for x < 25, and its asymptotic series above that.
+        x = np.asarray(x, dtype=float)
+        out = np.empty_like(x)
+        small = np.where(x < 25.)[0]
+        sint = np.sin((np.arange(64) + 0.5) * np.pi / 64)
+        for i in range(0, len(small), 100000):
+            ii = small[i:i+100000]
+            out[ii] = np.mean(np.cos(np.outer(x[ii], sint)), axis=1)
+        large = np.where(x >= 25.)[0]
+        xl = x[large]
+        y = 1. / xl**2
+        p = 1. - 9./128*y + 3675./32768*y**2 - 2401245./4194304*y**3
+        q = (-1./8 + 75./1024*y - 59535./262144*y**2 + 57972915./33554432*y**3) / xl
+        out[large] = np.sqrt(2./(np.pi*xl)) * (p*np.cos(xl-np.pi/4) - q*np.sin(xl-np.pi/4))
+        return out
+
+    def sersic_kvalue(n, k):
+        # The Fourier transform of a unit-flux Sersic profile with unit scale radius,
+        # int_0^inf exp(-r^(1/n)) J0(kr) r dr / (n Gamma(2n)), by Gauss-Legendre quadrature
+        # in panels small enough to follow the oscillations of J0.  For n >= 1, this is done
+        # in z = r^(1/n), which is cut off where the integrand is below 1.e-12.
+        x, w = np.polynomial.legendre.leggauss(16)
+        zmax = 2.*n
+        while -zmax + (2.*n-1) * np.log(zmax) - math.lgamma(2.*n) > np.log(1.e-12): zmax += 1.
+        if n < 1.:
+            rmax = zmax**n
+            edges = np.linspace(0., rmax, int(np.ceil(rmax / min(0.01, 0.5/k))) + 1)
+        else:
+            edges = [0.]
+            while edges[-1] < zmax:
+                z = edges[-1]
+                h = min(0.05 if z < 2. else 0.5, 1.5 / (k*n*max(z,1.)**(n-1)))
+                edges.append(min(z+h, zmax))
+            edges = np.array(edges)
+        h = np.diff(edges)[:,None]
+        u = (edges[:-1,None] + h * (x+1)/2).ravel()
+        wu = (h * w/2).ravel()
+        if n < 1.:
+            f = np.exp(-u**(1./n)) * u / (n * math.gamma(2.*n))
+            return np.sum(wu * f * j0(k*u))
+        else:
+            f = np.exp(-u + (2.*n-1) * np.log(u) - math.lgamma(2.*n))
+            return np.sum(wu * f * j0(k*u**n))
+
+    # A profile truncated far out is computed exactly for its own n, rather than interpolated
+    # from the table of untruncated profiles.  At 1000 hlr, the truncation is negligible.
+    kvalue_accuracy = galsim.GSParams().kvalue_accuracy
+    r0 = 0.7
+    for n in [0.37, 0.8, 1.23, 2.7, 3.9, 5.1]:
+        sersic = galsim.Sersic(n=n, scale_radius=r0, flux=test_flux)
+        hlr = sersic.getHalfLightRadius()
+        exact = galsim.Sersic(n=n, scale_radius=r0, flux=test_flux, trunc=1000.*hlr,
+                              flux_untruncated=True)
+        print('n = ',n,' hlr = ',hlr,exact.getHalfLightRadius())
+        np.testing.assert_allclose(hlr, exact.getHalfLightRadius(), rtol=1.e-5)
+        np.testing.assert_allclose(sersic.stepK(), exact.stepK(), rtol=1.e-5)
+
+        # Both Fourier transforms should be good to kvalue_accuracy.  Check them against the
+        # direct integral, which doesn't use either the table in n or the Hankel transform
+        # that builds the tables.
+        kx = np.logspace(-2, 1.5, 15) / hlr
+        kv = np.array([ sersic_kvalue(n, k*r0) for k in kx ]) * test_flux
+        kv1 = sersic.kValueMany(kx, np.zeros_like(kx))
+        kv2 = exact.kValueMany(kx, np.zeros_like(kx))
+        err1 = np.max(np.abs(kv1-kv)) / test_flux
+        err2 = np.max(np.abs(kv2-kv)) / test_flux
+        print('max kvalue error = ',err1,err2)
+        assert err1 < kvalue_accuracy
+        assert err2 < kvalue_accuracy
+
+        # Photons are shot from the interpolated enclosed flux.
+        im = sersic.drawImage(nx=200, ny=200, scale=0.05*hlr, method='phot', n_photons=1.e6,
+                              rng=galsim.BaseDeviate(1234), poisson_flux=False)
+        np.testing.assert_allclose(im.calculateHLR(flux=test_flux), hlr, rtol=0.01)
+
+
+@timer
+def test_hankel_tables():
+    """Test the profiles whose lookup tables are built with a fast Hankel transform against
+    direct numerical integration.
+    """
+    def hankel(f, k, rmax, n=20000):
+        # int_0^rmax f(r) J0(kr) r dr by Simpson's rule, with J0(x) = 1/pi int_0^pi cos(x sin t) dt
+        r = np.linspace(0., rmax, n+1)
+        w = np.ones(n+1)
+        w[1:-1:2] = 4.
+        w[2:-1:2] = 2.
+        w *= rmax / (3.*n)
+        t = (np.arange(200) + 0.5) * np.pi / 200
+        fr = f(r) * r * w
+        return np.array([ np.dot(fr, np.mean(np.cos(kk * np.outer(r, np.sin(t))), axis=1))
+                          for kk in k ])
+
+    k = np.array([0.03, 0.3, 1., 2.7, 6., 11.])
+    gsp = galsim.GSParams()
+
+    # Truncated profiles are the hard case, since the profile has an edge.
+    for n, trunc in [ (0.5, 1.7), (1.5, 5.), (4., 12.) ]:
+        sersic = galsim.Sersic(n=n, scale_radius=1., trunc=trunc)
+        f = lambda r: np.exp(-r**(1./n))
+        direct = hankel(f, k, trunc) / hankel(f, [0.], trunc)
+        kv = sersic.kValueMany(k, np.zeros_like(k))
+        print('Sersic n = ',n,' max error = ',np.max(np.abs(kv-direct)))
+        np.testing.assert_allclose(kv, direct, rtol=0, atol=gsp.kvalue_accuracy,
+                                   err_msg="Truncated Sersic kValue disagrees with direct integral")
+
+    for beta, trunc in [ (1.5, 4.), (2.5, 3.), (4., 8.) ]:
+        moffat = galsim.Moffat(beta=beta, scale_radius=1., trunc=trunc)
+        f = lambda r: (1.+r*r)**(-beta)
+        direct = hankel(f, k, trunc) / hankel(f, [0.], trunc)
+        kv = moffat.kValueMany(k, np.zeros_like(k))
+        print('Moffat beta = ',beta,' max error = ',np.max(np.abs(kv-direct)))
+        np.testing.assert_allclose(kv, direct, rtol=0, atol=gsp.kvalue_accuracy,
+                                   err_msg="Truncated Moffat kValue disagrees with direct integral")
+
+    # With this lam_over_r0, the Kolmogorov kValue is exp(-k^5/3).
+    kolm = galsim.Kolmogorov(lam_over_r0=2.992934)
+    r = np.array([0., 0.3, 1., 1.9, 3.])
+    direct = hankel(lambda k: np.exp(-k**(5./3.)), r, 8.) / (2.*np.pi)
+    xv = kolm.xValueMany(r, np.zeros_like(r))
+    print('Kolmogorov max error = ',np.max(np.abs(xv-direct)))
+    np.testing.assert_allclose(xv, direct, rtol=0, atol=gsp.xvalue_accuracy,
+                               err_msg="Kolmogorov xValue disagrees with direct integral")
+
+    # If the requested accuracy cannot be reached, this should raise an exception rather than
+    # silently use an inaccurate table.
+    gsp = galsim.GSParams(integration_abserr=1.e-14)
+    try:
+        np.testing.assert_raises(
+                RuntimeError,
+                lambda: galsim.Moffat(beta=2.5, scale_radius=1., trunc=3., gsparams=gsp).maxK())
+    except ImportError:
+        print('The assert_raises tests require nose')
+
+
 @timer
 def test_airy():
     """Test the generation of a specific Airy profile against a known result.
@@ -2066,6 +2287,47 @@ def test_spergel_05():
         np.testing.assert_almost_equal(spergel.kValue(pos), expon.kValue(pos), decimal=5)
 
 
+@timer
+def test_value_many():
+    """Test that xValueMany and kValueMany match xValue and kValue.
+    """
+    objs = [ galsim.Gaussian(sigma=1.7, flux=test_flux),
+             galsim.Exponential(half_light_radius=0.8, flux=test_flux),
+             galsim.Sersic(n=2.3, half_light_radius=1.1, flux=test_flux),
+             galsim.Sersic(n=3.1, half_light_radius=1.1, trunc=4.5, flux=test_flux),
+             galsim.Moffat(beta=3.2, fwhm=1.4, flux=test_flux),
+             galsim.Moffat(beta=2.5, fwhm=1.4, trunc=3.9, flux=test_flux),
+             galsim.Airy(lam_over_diam=0.7, obscuration=0.2, flux=test_flux),
+             galsim.Gaussian(sigma=0.9).shear(g1=0.2, g2=-0.1).shift(0.3, -0.2) * 1.7,
+             galsim.Sersic(n=1.3, half_light_radius=0.9).dilate(1.2).rotate(0.3*galsim.radians),
+             galsim.Exponential(scale_radius=0.6).shift(0.1, 0.2) ]
+
+    rng = np.random.RandomState(1234)
+    x = rng.uniform(-3., 3., size=50)
+    y = rng.uniform(-3., 3., size=50)
+    x[0] = y[0] = 0.
+    for obj in objs:
+        xv = obj.xValueMany(x, y)
+        kv = obj.kValueMany(x, y)
+        xv1 = [ obj.xValue(xx, yy) for xx,yy in zip(x,y) ]
+        kv1 = [ obj.kValue(xx, yy) for xx,yy in zip(x,y) ]
+        np.testing.assert_allclose(xv, xv1, rtol=1.e-12, atol=1.e-300,
+                                   err_msg="xValueMany disagrees with xValue for %r"%obj)
+        np.testing.assert_allclose(kv, kv1, rtol=1.e-12, atol=1.e-300,
+                                   err_msg="kValueMany disagrees with kValue for %r"%obj)
+
+    # The output has the same shape as the input.
+    obj = objs[0]
+    xv = obj.xValueMany(x.reshape(5,10), y.reshape(5,10))
+    np.testing.assert_equal(xv.shape, (5,10))
+    np.testing.assert_array_equal(xv.ravel(), obj.xValueMany(x, y))
+    try:
+        np.testing.assert_raises(ValueError, obj.xValueMany, x, y[:10])
+        np.testing.assert_raises(ValueError, obj.kValueMany, x[:10], y)
+    except ImportError:
+        pass
+
+
 @timer
 def test_ne():
     """Test base.py GSObjects for not-equals."""
@@ -2209,6 +2471,9 @@ if __name__ == "__main__":
     test_sersic_flux_scaling()
     test_sersic_05()
     test_sersic_1()
+    test_sersic_gaussian_mixture()
+    test_sersic_interpolated_n()
+    test_hankel_tables()
     test_airy()
     test_airy_radii()
     test_airy_flux_scaling()
@@ -2227,4 +2492,5 @@ if __name__ == "__main__":
     test_spergel_radii()
     test_spergel_flux_scaling()
     test_spergel_05()
+    test_value_many()
     test_ne()
@@ -806,6 +806,160 @@ def test_sum_transform():
         do_pickle(gal2)  # And this.
 
 
+@timer
+def test_convolve_kgrid():
+    """Test that drawKImage of a convolution matches the product of the component kValues.
+    """
+    # Large enough that the product is done in several tiles of rows.
+    gal = galsim.Sersic(n=2.5, half_light_radius=1.2, flux=1.7).shear(g1=0.2, g2=-0.1)
+    psf = galsim.Moffat(beta=2.5, fwhm=0.7)
+    pix = galsim.Pixel(scale=0.2)
+    # The components of the last few aren't symmetric in kx, so the product can't be
+    # reflected about kx = 0 either.
+    for obj in [galsim.Convolve(gal, psf, pix),
+                galsim.Convolve(gal, psf, pix).shear(g1=-0.1, g2=0.3),
+                galsim.Convolve(gal, galsim.Convolve(psf, pix).rotate(20 * galsim.degrees)),
+                galsim.Convolve(psf, psf.shear(g2=0.3)),
+                galsim.Convolve(psf, psf.shift(0.3, -0.2)),
+                galsim.Convolve(gal.shear(g2=0.2).shift(0.1, 0.4), psf, pix)]:
+        for n in [301, 300]:
+            scale = 0.05
+            re, im = obj.drawKImage(nx=n, ny=n, scale=scale)
+            x, y = np.meshgrid(np.arange(re.bounds.xmin, re.bounds.xmax+1),
+                               np.arange(re.bounds.ymin, re.bounds.ymax+1))
+            kx = (x - re.center().x) * scale
+            ky = (y - re.center().y) * scale
+            kval = obj.kValueMany(kx, ky)
+            np.testing.assert_allclose(
+                re.array, kval.real, rtol=0, atol=1.e-5 * obj.getFlux(),
+                err_msg="Convolve drawKImage real part doesn't match kValue")
+            np.testing.assert_allclose(
+                im.array, kval.imag, rtol=0, atol=1.e-5 * obj.getFlux(),
+                err_msg="Convolve drawKImage imag part doesn't match kValue")
+
+
+@timer
+def test_simplify():
+    """Test that simplify() gives an equivalent, shallower profile.
+    """
+    gauss1 = galsim.Gaussian(sigma=1.3, flux=1.7)
+    gauss2 = galsim.Gaussian(fwhm=0.7).shear(g1=0.2, g2=-0.1).shift(0.3, 0.1)
+    gauss3 = galsim.Gaussian(sigma=0.4)
+    exp = galsim.Exponential(half_light_radius=0.8, flux=2.3)
+    moffat = galsim.Moffat(beta=2.5, fwhm=0.9, trunc=3.)
+
+    # Convolved Gaussians become a single Gaussian.
+    obj = galsim.Convolve(gauss1.shear(g1=0.1, g2=0.3), gauss2, gauss3.rotate(30*galsim.degrees))
+    simp = obj.simplify()
+    assert simp.SBProfile.serialize().count('SBGaussian') == 1
+    assert 'SBConvolve' not in simp.SBProfile.serialize()
+    # And circular ones with no shift become a plain Gaussian.
+    simp = galsim.Convolve(gauss1, gauss3.withFlux(2.)).simplify()
+    assert 'SBTransform' not in simp.SBProfile.serialize()
+    np.testing.assert_almost_equal(simp.getFlux(), 3.4)
+
+    # Convolutions of sums of Gaussians are distributed into a sum of Gaussians.
+    simp = galsim.Convolve(gauss1 + gauss2, gauss3).simplify()
+    assert 'SBConvolve' not in simp.SBProfile.serialize()
+    assert simp.SBProfile.serialize().count('SBGaussian') == 2
+
+    # Flux scalings are folded into the profiles.
+    simp = (exp * 3.).simplify()
+    assert 'SBTransform' not in simp.SBProfile.serialize()
+    np.testing.assert_almost_equal(simp.getFlux(), 6.9)
+    simp = moffat.withScaledFlux(0.5).simplify()
+    assert 'SBTransform' not in simp.SBProfile.serialize()
+
+    # Things that can't be simplified are left alone.
+    obj = galsim.Convolve(exp.shear(g1=0.3, g2=0.2), moffat)
+    assert obj.simplify().SBProfile.serialize() == obj.SBProfile.serialize()
+
+    # All of these should draw the same as the originals.
+    objs = [ galsim.Convolve(gauss1.shear(g1=0.1, g2=0.3), gauss2,
+                             gauss3.rotate(30*galsim.degrees)),
+             galsim.Convolve(gauss1, gauss3 * 2.),
+             galsim.Convolve(exp * 3., gauss1, galsim.Convolve(gauss2, moffat)),
+             galsim.Add(exp * 0.3, galsim.Add(gauss1, moffat).shift(0.1, 0.2)) * 1.5,
+             galsim.Convolve(galsim.Add(gauss1 * 2., gauss2), gauss3, exp).shear(g1=0.2, g2=0.1),
+             gauss2.shear(g1=-0.2, g2=0.1).dilate(1.2),
+             galsim.Convolve(gauss1 + gauss2, (gauss3 + gauss1).shear(g1=0.1, g2=0.2)) ]
+    for obj in objs:
+        simp = obj.simplify()
+        np.testing.assert_almost_equal(simp.getFlux(), obj.getFlux(), decimal=12)
+        np.testing.assert_almost_equal(simp.centroid().x, obj.centroid().x, decimal=12)
+        np.testing.assert_almost_equal(simp.centroid().y, obj.centroid().y, decimal=12)
+        im1 = obj.drawImage(nx=64, ny=64, scale=0.2, method='no_pixel')
+        im2 = simp.drawImage(nx=64, ny=64, scale=0.2, method='no_pixel')
+        np.testing.assert_allclose(im2.array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                                   err_msg="Simplified object doesn't draw the same as %s"%obj)
+        kx = np.linspace(-3., 3., 7)
+        ky = np.linspace(-2., 4., 7)
+        np.testing.assert_allclose(simp.kValueMany(kx, ky), obj.kValueMany(kx, ky),
+                                   rtol=0, atol=1.e-10 * obj.getFlux(),
+                                   err_msg="Simplified object has different kValue for %s"%obj)
+
+
+@timer
+def test_shared_convolve():
+    """Test convolutions that share the cached k values of a component.
+    """
+    psf = galsim.Convolve(galsim.Kolmogorov(fwhm=0.7), galsim.Airy(lam_over_diam=0.2))
+    gals = [ galsim.Sersic(n=1.5, half_light_radius=0.6).shear(g1=0.1, g2=0.2),
+             galsim.Exponential(half_light_radius=0.6).shear(g1=-0.3, g2=0.1) ]
+    orig_budget = galsim.utilities.get_kgrid_cache_budget()
+    try:
+        galsim.utilities.clear_kgrid_cache()
+        galsim.utilities.reset_cache_stats()
+        for i, gal in enumerate(gals):
+            conv1 = galsim.Convolve(gal, psf)
+            conv2 = galsim.Convolve(gal, psf, shared=[psf])
+            im1 = conv1.drawImage(nx=48, ny=48, scale=0.2)
+            im2 = conv2.drawImage(nx=48, ny=48, scale=0.2)
+            np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-10, atol=1.e-14,
+                                       err_msg="Shared convolution drew a different image")
+            stats = galsim.utilities.get_cache_stats()['kgrid']
+            # The psf values are saved for the first galaxy and used again for the second.
+            if i == 0:
+                assert stats['misses'] >= 1
+                assert stats['hits'] == 0
+            else:
+                assert stats['hits'] >= 1
+            assert 0 < stats['size'] <= stats['max_size']
+            do_pickle(conv2)
+
+        # A different psf doesn't use the values saved for the first one, even on the same grid.
+        # (Equal psfs made separately do, since the key is made from the serialization.)
+        psf2 = galsim.Convolve(galsim.Kolmogorov(fwhm=0.8), galsim.Airy(lam_over_diam=0.2))
+        psf3 = galsim.Convolve(galsim.Kolmogorov(fwhm=0.7), galsim.Airy(lam_over_diam=0.2))
+        for p, expect_hit in [(psf2, False), (psf3, True)]:
+            galsim.utilities.reset_cache_stats()
+            im1 = galsim.Convolve(gals[0], p).drawImage(nx=48, ny=48, scale=0.2)
+            im2 = galsim.Convolve(gals[0], p, shared=[p]).drawImage(nx=48, ny=48, scale=0.2)
+            np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-10, atol=1.e-14,
+                                       err_msg="Shared convolution drew a different image")
+            stats = galsim.utilities.get_cache_stats()['kgrid']
+            if expect_hit:
+                assert stats['hits'] >= 1 and stats['misses'] == 0
+            else:
+                assert stats['hits'] == 0 and stats['misses'] >= 1
+
+        # The shared objects have to be among the ones being convolved.
+        try:
+            np.testing.assert_raises(ValueError, galsim.Convolve, gals[0], psf, shared=[gals[1]])
+        except ImportError:
+            pass
+
+        # With no budget, nothing is saved.
+        galsim.utilities.set_kgrid_cache_budget(0)
+        assert galsim.utilities.get_cache_stats()['kgrid']['size'] == 0
+        galsim.utilities.reset_cache_stats()
+        galsim.Convolve(gals[0], psf, shared=[psf]).drawImage(nx=48, ny=48, scale=0.2)
+        stats = galsim.utilities.get_cache_stats()['kgrid']
+        assert stats['hits'] == 0 and stats['misses'] == 0
+    finally:
+        galsim.utilities.set_kgrid_cache_budget(orig_budget)
+
+
 if __name__ == "__main__":
     test_convolve()
     test_convolve_flux_scaling()
@@ -820,3 +974,6 @@ if __name__ == "__main__":
     test_ne()
     test_fourier_sqrt()
     test_sum_transform()
+    test_convolve_kgrid()
+    test_simplify()
+    test_shared_convolve()
@@ -1012,6 +1012,384 @@ def test_shoot():
     image2 += 100
     np.testing.assert_almost_equal(image1.array, image2.array, decimal=12)
 
+    # The photons are shot in batches with their own random number streams, so the image
+    # doesn't depend on the number of threads.
+    image3 = galsim.ImageF(32,32)
+    rng = galsim.BaseDeviate(1234)
+    obj.drawImage(image3, method='phot', poisson_flux=False, rng=rng, n_threads=4)
+    image4 = galsim.ImageF(32,32)
+    rng = galsim.BaseDeviate(1234)
+    obj.drawImage(image4, method='phot', poisson_flux=False, rng=rng, n_threads=2)
+    np.testing.assert_array_equal(image3.array, image4.array,
+                                  err_msg="drawImage with n_threads=4 and 2 gave different images")
+    image5 = galsim.ImageF(32,32)
+    rng = galsim.BaseDeviate(1234)
+    obj.drawImage(image5, method='phot', poisson_flux=False, rng=rng, n_threads=0)
+    np.testing.assert_array_equal(image3.array, image5.array,
+                                  err_msg="drawImage with n_threads=4 and 0 gave different images")
+    image3 += 100
+    np.testing.assert_array_equal(image3.array, image2.array,
+                                  err_msg="drawImage with n_threads=4 gave a different image")
+    try:
+        np.testing.assert_raises(ValueError, obj.drawImage, image3, n_threads=4)
+    except ImportError:
+        print('The assert_raises tests require nose')
+
+
+@timer
+def test_draw_many():
+    """Test drawImageMany, which draws several objects with batched FFTs.
+    """
+    psf = galsim.Moffat(beta=3, fwhm=0.7)
+    objs = [ galsim.Convolve(galsim.Exponential(half_light_radius=0.3 + 0.1*i)
+                             .shear(g1=0.05*i, g2=-0.03*i), psf)
+             for i in range(6) ]
+    objs.append(galsim.Convolve(galsim.Sersic(n=2.5, half_light_radius=1.1), psf))
+    objs.append(galsim.Kolmogorov(fwhm=0.8, flux=17.))
+    sizes = [ 32, 32, 32, 48, 48, 64, 64, 32 ]
+    dtypes = [ np.float32, np.float64 ] * 4
+    offsets = [ (0.3*i - 1.0, 0.2 - 0.1*i) for i in range(len(objs)) ]
+
+    images1 = [ galsim.Image(n, n, scale=0.2, dtype=t) for n,t in zip(sizes,dtypes) ]
+    for obj, im, offset in zip(objs, images1, offsets):
+        obj.drawImage(im, method='fft', offset=offset)
+    images2 = [ galsim.Image(n, n, scale=0.2, dtype=t) for n,t in zip(sizes,dtypes) ]
+    ret = galsim.drawImageMany(objs, images2, offsets=offsets)
+    assert all([ r is im for r, im in zip(ret, images2) ])
+    for im1, im2 in zip(images1, images2):
+        np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-5, atol=1.e-8,
+                                   err_msg="drawImageMany gave a different image than drawImage")
+        np.testing.assert_allclose(im2.added_flux, im1.added_flux, rtol=1.e-5,
+                                   err_msg="drawImageMany gave a different added_flux")
+
+    # method='no_pixel' and add_to_image.  Compare with drawing each one separately onto a
+    # copy of the same initial image.
+    images3 = [ galsim.Image(n, n, scale=0.2, dtype=t, init_value=1.)
+                for n,t in zip(sizes,dtypes) ]
+    separate = [ im3.copy() for im3 in images3 ]
+    for obj, im1 in zip(objs, separate):
+        obj.drawImage(im1, method='no_pixel', gain=2., add_to_image=True)
+    galsim.drawImageMany(objs, images3, method='no_pixel', add_to_image=True, gain=2.)
+    for im1, im3 in zip(separate, images3):
+        # drawImage draws the Kolmogorov directly in real space, but drawImageMany always uses
+        # an FFT, so these only agree to about kvalue_accuracy relative to the peak.
+        atol = 1.e-4 * (im1.array.max() - 1.)
+        print('max diff = ',np.max(np.abs(im3.array - im1.array)),' atol = ',atol)
+        np.testing.assert_allclose(im3.array, im1.array, rtol=1.e-5, atol=atol,
+                                   err_msg="drawImageMany with no_pixel gave a different image")
+        np.testing.assert_allclose(
+            im3.added_flux, im1.added_flux, rtol=1.e-3,
+            err_msg="drawImageMany with no_pixel gave a different added_flux")
+
+    # The batches can also be split among threads.
+    images4 = [ galsim.Image(n, n, scale=0.2, dtype=t) for n,t in zip(sizes,dtypes) ]
+    try:
+        galsim.utilities.set_fft_threads(4)
+        galsim.drawImageMany(objs, images4, offsets=offsets)
+    finally:
+        galsim.utilities.set_fft_threads(1)
+    for im1, im4 in zip(images1, images4):
+        np.testing.assert_allclose(im4.array, im1.array, rtol=1.e-5, atol=1.e-8,
+                                   err_msg="drawImageMany with threads gave a different image")
+
+    try:
+        np.testing.assert_raises(ValueError, galsim.drawImageMany, objs, images2[:3])
+        np.testing.assert_raises(ValueError, galsim.drawImageMany, objs, images2, offsets=[])
+        np.testing.assert_raises(ValueError, galsim.drawImageMany, objs, images2, method='phot')
+        np.testing.assert_raises(ValueError, galsim.drawImageMany, objs[:1],
+                                 [galsim.ImageI(32,32,scale=0.2)])
+    except ImportError:
+        print('The assert_raises tests require nose')
+
+
+@timer
+def test_single_precision_fft():
+    """Test drawing with GSParams(single_precision_fft=True).
+    """
+    gsp = galsim.GSParams(single_precision_fft=True)
+    assert gsp.single_precision_fft
+    assert not galsim.GSParams().single_precision_fft
+    assert gsp != galsim.GSParams()
+
+    gal = galsim.Sersic(n=1.5, half_light_radius=0.8).shear(g1=0.2, g2=0.1).shift(0.1, -0.2)
+    psf = galsim.Moffat(beta=2.5, fwhm=0.7)
+    obj1 = galsim.Convolve(gal, psf)
+    obj2 = galsim.Convolve(gal, psf, gsparams=gsp)
+    for dtype in [np.float32, np.float64]:
+        im1 = obj1.drawImage(nx=64, ny=64, scale=0.2, method='fft', dtype=dtype)
+        im2 = obj2.drawImage(nx=64, ny=64, scale=0.2, method='fft', dtype=dtype)
+        np.testing.assert_allclose(im2.array, im1.array, rtol=0, atol=1.e-6 * im1.array.max(),
+                                   err_msg="single_precision_fft image differs by too much")
+        np.testing.assert_allclose(im2.added_flux, im1.added_flux, rtol=1.e-6)
+
+    # The repr (as used for pickling SBProfiles) preserves the setting.
+    do_pickle(obj2.SBProfile)
+    do_pickle(obj2, lambda x: x.drawImage(nx=32, ny=32, scale=0.2, method='fft'))
+    assert obj2.SBProfile.getGSParams().single_precision_fft
+
+    # drawImageMany draws these individually.
+    im3 = galsim.ImageF(64, 64, scale=0.2)
+    galsim.drawImageMany([obj2], [im3])
+    im2 = obj2.drawImage(nx=64, ny=64, scale=0.2, method='fft')
+    np.testing.assert_array_equal(im3.array, im2.array)
+
+
+@timer
+def test_aliased_fft():
+    """Test FFT drawing of profiles whose k values need to be wrapped onto the FFT grid.
+    """
+    # A profile much smaller than a pixel has maxK well beyond the Nyquist frequency of the
+    # image, so fourierDraw has to alias the k values.  The result should match the real-space
+    # values at the pixel centers.  The shear and shift make sure the parts of the wrapping
+    # that use the conjugate values are right too.
+    gal = galsim.Gaussian(sigma=0.3, flux=1.7).shear(g1=0.3, g2=-0.2).shift(0.2, 0.1)
+    im1 = gal.drawImage(nx=24, ny=24, scale=1., method='no_pixel')
+    # Convolving by a tiny Gaussian forces the FFT method, with almost no other change.
+    conv = galsim.Convolve(gal, galsim.Gaussian(sigma=1.e-3))
+    assert conv.maxK() > 2. * np.pi
+    im2 = conv.drawImage(nx=24, ny=24, scale=1., method='no_pixel')
+    np.testing.assert_allclose(im2.array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                               err_msg="Aliased FFT draw doesn't match real-space draw")
+
+    # Same thing for an odd-sized image with non-square pixels.
+    wcs = galsim.JacobianWCS(0.9, 0.1, -0.05, 1.1)
+    im1 = gal.drawImage(nx=19, ny=21, wcs=wcs, method='no_pixel')
+    im2 = conv.drawImage(nx=19, ny=21, wcs=wcs, method='no_pixel')
+    np.testing.assert_allclose(im2.array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                               err_msg="Aliased FFT draw doesn't match real-space draw")
+
+
+@timer
+def test_small_stamp_fft():
+    """Test FFT drawing onto images much smaller than the FFT.
+    """
+    # Only the rows of the FFT that are in the image are calculated in this case.
+    gal = galsim.Gaussian(sigma=2.3, flux=1.7).shear(g1=0.3, g2=-0.2)
+    conv = galsim.Convolve(gal, galsim.Gaussian(sigma=1.e-3))
+    for nx, ny in [(12, 9), (9, 12), (15, 15)]:
+        for offset in [None, (0.3, -0.1)]:
+            im1 = gal.drawImage(nx=nx, ny=ny, scale=1., method='no_pixel', offset=offset)
+            im2 = conv.drawImage(nx=nx, ny=ny, scale=1., method='no_pixel', offset=offset)
+            np.testing.assert_allclose(
+                im2.array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                err_msg="FFT draw onto small stamp doesn't match real-space draw")
+            im3 = conv.drawImage(nx=nx, ny=ny, scale=1., method='no_pixel', offset=offset,
+                                 wmult=4)
+            np.testing.assert_allclose(
+                im3.array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                err_msg="FFT draw onto small stamp with wmult=4 doesn't match real-space draw")
+
+    # Also check drawing into part of a larger image, where the rows are not contiguous.
+    big = galsim.ImageD(40, 40, scale=1.)
+    b = galsim.BoundsI(11, 22, 15, 23)
+    conv.drawImage(big[b], method='no_pixel')
+    im1 = gal.drawImage(galsim.ImageD(b, scale=1.), method='no_pixel')
+    np.testing.assert_allclose(big[b].array, im1.array, rtol=0, atol=1.e-4 * im1.array.max(),
+                               err_msg="FFT draw onto sub-image doesn't match real-space draw")
+    np.testing.assert_equal(big.array.sum(), big[b].array.sum())
+
+
+@timer
+def test_threaded_fill():
+    """Test that filling the k and x grids with several threads gives the same answer.
+    """
+    gal = galsim.Sersic(n=2.3, half_light_radius=1.7).shear(g1=0.2, g2=0.1)
+    psf = galsim.Moffat(beta=3, fwhm=0.8)
+    obj1 = galsim.Convolve(gal, psf)
+    im = galsim.ImageD(64, 64, scale=0.2)
+    psf.drawImage(im, method='no_pixel')
+    obj2 = galsim.Convolve(gal, galsim.InterpolatedImage(im))
+    # Aliased, so fillKGrid has to wrap the k values onto the FFT grid.
+    obj3 = galsim.Convolve(gal, psf, gsparams=galsim.GSParams(maximum_fft_size=256))
+
+    orig_nthreads = galsim.utilities.get_fft_threads()
+    try:
+        for obj in [obj1, obj2, obj3]:
+            galsim.utilities.set_fft_threads(1)
+            im1 = obj.drawImage(nx=200, ny=200, scale=0.05)
+            re1, im1k = obj.drawKImage(nx=200, ny=200, scale=0.1)
+            galsim.utilities.set_fft_threads(4)
+            im2 = obj.drawImage(nx=200, ny=200, scale=0.05)
+            re2, im2k = obj.drawKImage(nx=200, ny=200, scale=0.1)
+            np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-12, atol=1.e-15,
+                                       err_msg="Threaded grid fill doesn't match serial")
+            np.testing.assert_allclose(re2.array, re1.array, rtol=1.e-12, atol=1.e-15,
+                                       err_msg="Threaded drawKImage doesn't match serial")
+            np.testing.assert_allclose(im2k.array, im1k.array, rtol=1.e-12, atol=1.e-15,
+                                       err_msg="Threaded drawKImage doesn't match serial")
+    finally:
+        galsim.utilities.set_fft_threads(orig_nthreads)
+
+
+@timer
+def test_radial_kgrid():
+    """Test that large k-space grids of axisymmetric profiles match kValue.
+    """
+    # For large enough grids, these are filled by interpolating from a 1D table in |k|,
+    # so check that this is accurate, including near k = 0 and at the edge of the grid.
+    # The sheared versions go through the fillKValue function for a general affine grid.
+    objs = [ galsim.Sersic(n=3.1, half_light_radius=1.3, flux=1.7),
+             galsim.Sersic(n=1.7, half_light_radius=0.8, trunc=4.),
+             galsim.Spergel(nu=-0.4, half_light_radius=1.1),
+             galsim.Moffat(beta=1.5, scale_radius=1.4, flux=2.2),
+             galsim.Moffat(beta=3.5, fwhm=0.9, trunc=3.),
+             galsim.Kolmogorov(fwhm=0.7),
+             galsim.Airy(lam_over_diam=0.6, obscuration=0.3) ]
+    objs += [ obj.shear(g1=0.2, g2=-0.3) for obj in objs ]
+    for obj in objs:
+        kvalue_accuracy = obj.gsparams.kvalue_accuracy
+        scale = obj.stepK() / 2.
+        re, im = obj.drawKImage(nx=161, ny=161, scale=scale)
+        x, y = np.meshgrid(np.arange(re.bounds.xmin, re.bounds.xmax+1),
+                           np.arange(re.bounds.ymin, re.bounds.ymax+1))
+        kx = (x - re.center().x) * scale
+        ky = (y - re.center().y) * scale
+        kval = obj.kValueMany(kx, ky)
+        np.testing.assert_allclose(
+            re.array, kval.real, rtol=0, atol=kvalue_accuracy * obj.getFlux(),
+            err_msg="drawKImage doesn't match kValue for %s"%obj)
+        np.testing.assert_allclose(
+            im.array, 0., rtol=0, atol=kvalue_accuracy * obj.getFlux(),
+            err_msg="drawKImage has non-zero imaginary part for %s"%obj)
+
+        # The table is kept with the profile and extended when a grid reaches larger k.
+        # Extending it doesn't change the values interpolated from the existing part.
+        obj.drawKImage(nx=161, ny=161, scale=3.*scale)
+        re2, im2 = obj.drawKImage(nx=161, ny=161, scale=scale)
+        np.testing.assert_array_equal(
+            re2.array, re.array,
+            err_msg="drawKImage changed after extending the radial table for %s"%obj)
+
+
+@timer
+def test_draw_offsets():
+    """Test drawImageOffsets, which draws one object at many offsets with one k-space fill.
+    """
+    psf = galsim.Moffat(beta=3, fwhm=0.7)
+    gal = galsim.Sersic(n=2.5, half_light_radius=0.5).shear(g1=0.2, g2=-0.1)
+    obj = galsim.Convolve(gal, psf)
+    sizes = [ 32, 32, 31, 48, 32 ]
+    dtypes = [ np.float32, np.float64, np.float64, np.float32, np.float64 ]
+    offsets = [ (0.,0.), (0.25,-0.1), (-0.4,0.35), (0.5,0.5), (1.3,-2.7) ]
+
+    for method in ['fft', 'no_pixel']:
+        images1 = [ obj.drawImage(galsim.Image(n, n, scale=0.2, dtype=t), method=method,
+                                  offset=offset)
+                    for n,t,offset in zip(sizes,dtypes,offsets) ]
+        images2 = [ galsim.Image(n, n, scale=0.2, dtype=t) for n,t in zip(sizes,dtypes) ]
+        ret = obj.drawImageOffsets(images2, offsets, method=method)
+        assert all([ r is im for r, im in zip(ret, images2) ])
+        for im1, im2 in zip(images1, images2):
+            np.testing.assert_allclose(
+                im2.array, im1.array, rtol=1.e-5, atol=1.e-8,
+                err_msg="drawImageOffsets gave a different image than drawImage")
+            np.testing.assert_allclose(im2.added_flux, im1.added_flux, rtol=1.e-5,
+                                       err_msg="drawImageOffsets gave a different added_flux")
+
+    # add_to_image and gain
+    images3 = [ galsim.Image(n, n, scale=0.2, dtype=t, init_value=1.)
+                for n,t in zip(sizes,dtypes) ]
+    obj.drawImageOffsets(images3, offsets, add_to_image=True, gain=2., use_true_center=False)
+    for im3, offset in zip(images3, offsets):
+        im1 = obj.drawImage(im3.copy(), gain=2., add_to_image=True, offset=offset,
+                            use_true_center=False)
+        np.testing.assert_allclose(im3.array, im1.array, rtol=1.e-5, atol=1.e-8,
+                                   err_msg="drawImageOffsets with add_to_image gave a different "
+                                   "image")
+
+    try:
+        np.testing.assert_raises(ValueError, obj.drawImageOffsets, images2, offsets[:3])
+        np.testing.assert_raises(ValueError, obj.drawImageOffsets, images2, offsets,
+                                 method='phot')
+        np.testing.assert_raises(ValueError, obj.drawImageOffsets,
+                                 [galsim.ImageI(32,32,scale=0.2)], offsets[:1])
+        np.testing.assert_raises(ValueError, obj.drawImageOffsets,
+                                 [galsim.ImageF(32,32,scale=0.2), galsim.ImageF(32,32,scale=0.3)],
+                                 offsets[:2])
+    except ImportError:
+        print('The assert_raises tests require nose')
+
+
+@timer
+def test_draw_method_choice():
+    """Test the cost model that chooses between drawing in real space, with FFTs or by shooting.
+    """
+    im = galsim.ImageD(64, 64, scale=0.2)
+    gauss = galsim.Gaussian(sigma=0.5, flux=100.)
+    choice = gauss.chooseDrawMethod(im, method='no_pixel')
+    print('gauss choice = ',choice)
+    assert choice['method'] == 'plainDraw'
+    assert 0. < choice['plainDraw'] < choice['fourierDraw']
+    assert choice['drawShoot'] is None
+    assert choice['NFT'] >= 64
+
+    # Profiles that need an FFT only have that option.
+    conv = galsim.Convolve(galsim.Exponential(half_light_radius=0.5), galsim.Moffat(3, fwhm=0.7))
+    choice = conv.chooseDrawMethod(im)
+    print('conv choice = ',choice)
+    assert choice['method'] == 'fourierDraw'
+    assert choice['plainDraw'] is None
+
+    # Hard edges are drawn in real space.
+    box = galsim.Box(0.6, 0.4)
+    choice = box.chooseDrawMethod(im, method='no_pixel')
+    assert choice['method'] == 'plainDraw'
+    assert choice['fourierDraw'] is None
+
+    # Shooting a few photons is cheapest, but only if it is allowed.
+    choice = conv.chooseDrawMethod(im, n_photons=10, allow_phot=True)
+    print('conv choice with phot = ',choice)
+    assert choice['method'] == 'drawShoot'
+    assert choice['N'] == 10
+    choice = gauss.chooseDrawMethod(im, method='no_pixel', allow_phot=True)
+    np.testing.assert_almost_equal(choice['N'], 100.)
+
+    # The model is only used by drawImage if the gsparams ask for it.
+    assert not gauss.gsparams.choose_draw_method
+    gsp = galsim.GSParams(choose_draw_method=True)
+    assert gsp.choose_draw_method
+    assert gsp != galsim.GSParams()
+    assert eval(repr(gsp)) == gsp
+    gauss2 = galsim.Gaussian(sigma=0.5, flux=100., gsparams=gsp)
+
+    orig_model = galsim.utilities.get_draw_cost_model()
+    try:
+        # If evaluating x values were very slow, the model would pick an FFT for the Gaussian.
+        im1 = gauss.drawImage(im.copy(), method='no_pixel')
+        galsim.utilities.set_draw_cost_model(xvalue=1., kvalue=orig_model['kvalue'],
+                                             fft=orig_model['fft'], shoot=orig_model['shoot'])
+        assert not galsim.utilities.get_draw_cost_model()['calibrated']
+        choice = gauss.chooseDrawMethod(im, method='no_pixel')
+        assert choice['method'] == 'fourierDraw'
+        # By default, drawImage still draws it in real space, so the image doesn't change.
+        im2 = gauss.drawImage(im.copy(), method='no_pixel')
+        np.testing.assert_array_equal(im2.array, im1.array,
+                                      err_msg="Default draw changed with the cost model")
+        # With choose_draw_method, it uses the FFT.
+        im3 = gauss2.drawImage(im.copy(), method='no_pixel')
+        assert not np.array_equal(im3.array, im1.array)
+        np.testing.assert_allclose(im3.array, im1.array, rtol=0, atol=1.e-3*im1.array.max(),
+                                   err_msg="Gaussian drawn with FFT disagrees with real space")
+        # But a hard-edged profile is still drawn in real space.
+        assert box.chooseDrawMethod(im, method='no_pixel')['method'] == 'plainDraw'
+
+        model = galsim.utilities.calibrate_draw_cost(force=True)
+        print('calibrated model = ',model)
+        assert model['calibrated']
+        for key in ['xvalue', 'kvalue', 'fft', 'shoot']:
+            assert model[key] > 0.
+        assert galsim.utilities.calibrate_draw_cost() == model
+        assert galsim.utilities.get_draw_cost_model() == model
+    finally:
+        galsim.utilities.set_draw_cost_model(orig_model['xvalue'], orig_model['kvalue'],
+                                             orig_model['fft'], orig_model['shoot'])
+
+    try:
+        np.testing.assert_raises(ValueError, gauss.chooseDrawMethod, im, method='phot')
+        np.testing.assert_raises(ValueError, gauss.chooseDrawMethod, galsim.ImageD())
+    except ImportError:
+        print('The assert_raises tests require nose')
+
 
 if __name__ == "__main__":
     test_drawImage()
@@ -1021,3 +1399,11 @@ if __name__ == "__main__":
     test_drawKImage_Exponential_Moffat()
     test_offset()
     test_shoot()
+    test_draw_many()
+    test_single_precision_fft()
+    test_aliased_fft()
+    test_small_stamp_fft()
+    test_threaded_fill()
+    test_radial_kgrid()
+    test_draw_offsets()
+    test_draw_method_choice()
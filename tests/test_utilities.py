@@ -461,6 +461,200 @@ def test_python_LRU_Cache():
         assert (newsize - (i - 1),) not in cache.cache
 
 
+@timer
+def test_table_cache():
+    """Test the on-disk cache of profile lookup tables.
+    """
+    import os
+    import shutil
+    import subprocess
+    import sys
+
+    cache_dir = os.path.join('output', 'table_cache')
+    if os.path.exists(cache_dir):
+        shutil.rmtree(cache_dir)
+    assert galsim.utilities.get_table_cache_dir() is None
+
+    # Use a non-default gsparams so these don't come from the in-memory cache.
+    gsp = galsim.GSParams(kvalue_accuracy=2.e-5)
+    k = [0., 0.3, 1.7, 5.2, 13.1, 40.]
+
+    galsim.utilities.set_table_cache_dir(cache_dir)
+    assert galsim.utilities.get_table_cache_dir() == cache_dir
+    galsim.utilities.reset_table_cache_stats()
+    try:
+        objs = [ galsim.Sersic(n=2.7, half_light_radius=1.2, gsparams=gsp),
+                 galsim.Sersic(n=1.3, half_light_radius=1.2, trunc=4.5, gsparams=gsp),
+                 galsim.Spergel(nu=0.3, half_light_radius=1.2, gsparams=gsp),
+                 galsim.Kolmogorov(fwhm=0.8, gsparams=gsp) ]
+        vals = [ [ obj.kValue(kk,0.).real for kk in k ] + [ obj.stepK(), obj.maxK() ]
+                 for obj in objs ]
+    finally:
+        galsim.utilities.set_table_cache_dir(None)
+    assert galsim.utilities.get_table_cache_dir() is None
+    stats = galsim.utilities.get_table_cache_stats()
+    print('stats = ',stats)
+    assert stats['hits'] == 0
+    assert stats['writes'] >= 3
+    assert stats['writes'] == stats['misses']
+    assert len(os.listdir(cache_dir)) == stats['writes']
+
+    # A new process should read these values back in from the cache, rather than recompute
+    # them, and get exactly the same answers.
+    script = '\n'.join([
+        'import galsim',
+        'gsp = galsim.GSParams(kvalue_accuracy=2.e-5)',
+        'objs = [ galsim.Sersic(n=2.7, half_light_radius=1.2, gsparams=gsp),',
+        '         galsim.Sersic(n=1.3, half_light_radius=1.2, trunc=4.5, gsparams=gsp),',
+        '         galsim.Spergel(nu=0.3, half_light_radius=1.2, gsparams=gsp),',
+        '         galsim.Kolmogorov(fwhm=0.8, gsparams=gsp) ]',
+        'k = %r'%k,
+        'print(repr([ [ obj.kValue(kk,0.).real for kk in k ] + [ obj.stepK(), obj.maxK() ]',
+        '             for obj in objs ]))',
+        'print(repr(galsim.utilities.get_table_cache_stats()))' ])
+    env = dict(os.environ)
+    env['GALSIM_TABLE_CACHE_DIR'] = cache_dir
+    p = subprocess.Popen([sys.executable, '-c', script], stdout=subprocess.PIPE, env=env)
+    out = p.communicate()[0]
+    assert p.returncode == 0
+    out_vals, out_stats = out.decode().strip().split('\n')
+    vals2 = eval(out_vals)
+    np.testing.assert_array_equal(vals2, vals, err_msg="Cached tables gave different values")
+    stats2 = eval(out_stats)
+    print('stats2 = ',stats2)
+    assert stats2['hits'] == stats['writes']
+    assert stats2['misses'] == 0
+    assert stats2['writes'] == 0
+
+    # A file written with a different table version should be ignored.
+    for name in os.listdir(cache_dir):
+        with open(os.path.join(cache_dir, name), 'r+b') as f:
+            f.seek(12)
+            f.write(b'\xff')
+    p = subprocess.Popen([sys.executable, '-c', script], stdout=subprocess.PIPE, env=env)
+    out = p.communicate()[0]
+    assert p.returncode == 0
+    out_vals, out_stats = out.decode().strip().split('\n')
+    np.testing.assert_array_equal(eval(out_vals), vals,
+                                  err_msg="Recomputed tables gave different values")
+    stats3 = eval(out_stats)
+    print('stats3 = ',stats3)
+    assert stats3['hits'] == 0
+    assert stats3['misses'] == stats['writes']
+    assert stats3['writes'] == stats['writes']
+
+
+@timer
+def test_cache_stats():
+    """Test the usage statistics of the C++ profile caches.
+    """
+    galsim.utilities.reset_cache_stats()
+    stats = galsim.utilities.get_cache_stats()
+    for name in ['sersic', 'spergel', 'kolmogorov', 'airy', 'exponential', 'moffat']:
+        assert name in stats
+        for key in ['hits', 'misses', 'waits', 'evictions']:
+            assert stats[name][key] == 0
+        assert stats[name]['build_time'] == 0.
+        assert stats[name]['max_size'] > 0
+
+    # Use a unique gsparams, so the first one is a miss, and the rest are hits.
+    gsp = galsim.GSParams(folding_threshold=4.1e-3)
+    for i in range(5):
+        galsim.Sersic(n=1.7, half_light_radius=1.3, gsparams=gsp)
+    stats = galsim.utilities.get_cache_stats()['sersic']
+    assert stats['misses'] == 1
+    assert stats['hits'] == 4
+    assert stats['build_time'] > 0.
+    assert stats['size'] >= 1
+    assert stats['size'] <= stats['max_size']
+
+    # Truncated Moffats with the same beta and trunc/scale_radius share a single table,
+    # regardless of their size or flux.
+    for i in range(4):
+        m = galsim.Moffat(beta=2.7, scale_radius=0.5*(i+1), trunc=2.*(i+1), flux=i+1,
+                          gsparams=gsp)
+        m.kValue(galsim.PositionD(0.3, 0.2))
+    stats = galsim.utilities.get_cache_stats()['moffat']
+    assert stats['misses'] == 1
+    assert stats['hits'] == 3
+
+    galsim.utilities.reset_cache_stats()
+    stats = galsim.utilities.get_cache_stats()['sersic']
+    assert stats['misses'] == 0
+    assert stats['hits'] == 0
+    assert stats['size'] >= 1
+
+
+@timer
+def test_fftw_wisdom():
+    """Test making, saving and loading FFTW wisdom.
+    """
+    import os
+    obj = galsim.Convolve(galsim.Gaussian(sigma=1.7), galsim.Exponential(half_light_radius=2.3))
+    im1 = obj.drawImage(nx=64, ny=64, scale=0.3, method='fft')
+
+    galsim.utilities.fftw_measure(128)
+    im2 = obj.drawImage(nx=64, ny=64, scale=0.3, method='fft')
+    np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-10, atol=1.e-14,
+                               err_msg="Measured FFTW plans gave a different image")
+
+    file_name = os.path.join('output', 'fftw_wisdom.txt')
+    if os.path.exists(file_name):
+        os.remove(file_name)
+    galsim.utilities.export_fftw_wisdom(file_name)
+    assert os.path.exists(file_name)
+    assert os.path.getsize(file_name) > 0
+    galsim.utilities.import_fftw_wisdom(file_name)
+    im3 = obj.drawImage(nx=64, ny=64, scale=0.3, method='fft')
+    np.testing.assert_allclose(im3.array, im1.array, rtol=1.e-10, atol=1.e-14,
+                               err_msg="Imported FFTW wisdom gave a different image")
+
+    try:
+        np.testing.assert_raises(IOError, galsim.utilities.import_fftw_wisdom,
+                                 os.path.join('output', 'no_such_wisdom.txt'))
+        np.testing.assert_raises(IOError, galsim.utilities.export_fftw_wisdom,
+                                 os.path.join('no_such_dir', 'fftw_wisdom.txt'))
+    except ImportError:
+        pass
+
+
+@timer
+def test_fft_threads():
+    """Test that threaded FFTs give the same answer as unthreaded ones.
+    """
+    assert galsim.utilities.get_fft_threads() == 1
+    obj = galsim.Convolve(galsim.Gaussian(sigma=0.3), galsim.Exponential(half_light_radius=0.2))
+    obj = obj.shear(g1=0.2, g2=-0.1).shift(0.3, 0.1)
+    im1 = obj.drawImage(nx=400, ny=400, scale=0.02, method='fft')
+    # Only transforms of size 512 and larger are threaded, so make sure this one is.
+    # The FFT is at least as large as the image, rounded up to a good FFT size.
+    nft = galsim._galsim.goodFFTSize(im1.array.shape[0])
+    print('NFT = ',nft)
+    assert nft >= 512
+
+    try:
+        galsim.utilities.set_fft_threads(4)
+        nt = galsim.utilities.get_fft_threads()
+        assert nt == 4 or nt == 1
+        im2 = obj.drawImage(nx=400, ny=400, scale=0.02, method='fft')
+        np.testing.assert_allclose(im2.array, im1.array, rtol=1.e-10, atol=1.e-12 * im1.array.max(),
+                                   err_msg="Threaded FFT gave a different image")
+
+        # The x->k direction is used by InterpolatedImage.  With the default pad_factor=4,
+        # this transform is at least 1600 x 1600.
+        ii = galsim.InterpolatedImage(im1, calculate_stepk=False, calculate_maxk=False)
+        galsim.utilities.set_fft_threads(1)
+        k2 = ii.drawKImage(nx=64, ny=64, scale=0.3)
+        galsim.utilities.set_fft_threads(0)
+        assert galsim.utilities.get_fft_threads() >= 1
+        k3 = ii.drawKImage(nx=64, ny=64, scale=0.3)
+        for a,b in zip(k3, k2):
+            np.testing.assert_allclose(a.array, b.array, rtol=1.e-10, atol=1.e-12,
+                                       err_msg="Threaded FFT gave a different kimage")
+    finally:
+        galsim.utilities.set_fft_threads(1)
+
+
 if __name__ == "__main__":
     test_roll2d_circularity()
     test_roll2d_fwdbck()
@@ -471,3 +665,7 @@ if __name__ == "__main__":
     test_deInterleaveImage()
     test_interleaveImages()
     test_python_LRU_Cache()
+    test_table_cache()
+    test_cache_stats()
+    test_fftw_wisdom()
+    test_fft_threads()
@@ -0,0 +1,132 @@
+/* -*- c++ -*-
+ * Copyright (c) 2012-2016 by the GalSim developers team on GitHub
+ * https://github.com/GalSim-developers
+ *
+ * This file is part of GalSim: The modular galaxy image simulation toolkit.
+ * https://github.com/GalSim-developers/GalSim
+ *
+ * GalSim is free software: redistribution and use in source and binary forms,
+ * with or without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions, and the disclaimer given in the accompanying LICENSE
+ *    file.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions, and the disclaimer given in the documentation
+ *    and/or other materials provided with the distribution.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+#include "galsim/VectorMath.h"
+
+#define BOOST_TEST_DYN_LINK
+
+#include "galsim/IgnoreWarnings.h"
+
+#define BOOST_NO_CXX11_SMART_PTR
+#include <boost/test/unit_test.hpp>
+
+const int test_max_ulp = 4;     // the accuracy (in units of the last place) at which to test
+
+// The number of representable doubles between two non-negative values.  This works the same
+// way for normal and denormal numbers, so it also tests the accuracy of denormal results.
+int64_t UlpDiff(double a, double b)
+{
+    int64_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(a));
+    std::memcpy(&ib, &b, sizeof(b));
+    return ia > ib ? ia - ib : ib - ia;
+}
+
+BOOST_AUTO_TEST_SUITE(vectormath_tests);
+
+BOOST_AUTO_TEST_CASE( TestExpMany )
+{
+    // Step through the whole range where the result is finite and nonzero, including the
+    // range -745.13 < x < -708 where it is denormal.
+    std::vector<double> x;
+    for (double xx = -745.13; xx < 709.78; xx += 0.0137) x.push_back(xx);
+    const int n = x.size();
+    std::vector<double> y(n);
+    galsim::math::ExpMany(&x[0], &y[0], n);
+    int64_t max_diff = 0;
+    for (int i=0; i<n; ++i) {
+        int64_t diff = UlpDiff(y[i], std::exp(x[i]));
+        if (diff > max_diff) max_diff = diff;
+    }
+    BOOST_CHECK_MESSAGE(max_diff <= test_max_ulp,
+                        "ExpMany differs from std::exp by "<<max_diff<<" ulp");
+
+    // Special values.
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double special[] = { 0., 1., -1., -708.5, -745.2, -1.e4, -inf, 709.7, 709.8, 1.e4, inf,
+                         nan };
+    double expected[] = { 1., std::exp(1.), std::exp(-1.), std::exp(-708.5), 0., 0., 0.,
+                          std::exp(709.7), inf, inf, inf, nan };
+    const int nspecial = sizeof(special) / sizeof(double);
+    // This also checks that the input and output may be the same array.
+    galsim::math::ExpMany(special, special, nspecial);
+    for (int i=0; i<nspecial; ++i) {
+        if (expected[i] != expected[i]) {
+            BOOST_CHECK_MESSAGE(special[i] != special[i], "ExpMany(nan) = "<<special[i]);
+        } else {
+            BOOST_CHECK_MESSAGE(UlpDiff(special[i], expected[i]) <= test_max_ulp,
+                                "ExpMany gave "<<special[i]<<" rather than "<<expected[i]);
+        }
+    }
+    BOOST_CHECK(special[4] == 0. && special[5] == 0. && special[6] == 0.);
+    BOOST_CHECK(special[3] > 0. && special[3] < std::numeric_limits<double>::min());
+}
+
+BOOST_AUTO_TEST_CASE( TestLogMany )
+{
+    // Step by a factor that is not a power of 2 from deep in the denormals to the largest
+    // double, so the mantissas cover their range too.
+    std::vector<double> x;
+    const double denorm_min = std::numeric_limits<double>::denorm_min();
+    const double max = std::numeric_limits<double>::max();
+    for (int i=1; i<100; ++i) x.push_back(i * denorm_min);
+    for (double xx = 100. * denorm_min; xx < max / 1.0173; xx *= 1.0173) x.push_back(xx);
+    x.push_back(max);
+    // Also values very close to 1, where the result is small.
+    for (int i=1; i<=1000; ++i) {
+        x.push_back(1. + i * 1.e-9);
+        x.push_back(1. - i * 1.e-9);
+    }
+    const int n = x.size();
+    std::vector<double> y(n);
+    galsim::math::LogMany(&x[0], &y[0], n);
+    int64_t max_diff = 0;
+    for (int i=0; i<n; ++i) {
+        // The results have both signs, so compare the absolute values.
+        double ref = std::log(x[i]);
+        BOOST_CHECK((y[i] < 0.) == (ref < 0.));
+        int64_t diff = UlpDiff(std::abs(y[i]), std::abs(ref));
+        if (diff > max_diff) max_diff = diff;
+    }
+    BOOST_CHECK_MESSAGE(max_diff <= test_max_ulp,
+                        "LogMany differs from std::log by "<<max_diff<<" ulp");
+
+    // Special values.
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double special[] = { 1., 2., 0., -0., -1., inf, -inf, nan };
+    const int nspecial = sizeof(special) / sizeof(double);
+    galsim::math::LogMany(special, special, nspecial);
+    BOOST_CHECK(special[0] == 0.);
+    BOOST_CHECK(UlpDiff(special[1], std::log(2.)) <= test_max_ulp);
+    BOOST_CHECK(special[2] == -inf);
+    BOOST_CHECK(special[3] == -inf);
+    BOOST_CHECK(special[4] != special[4]);
+    BOOST_CHECK(special[5] == inf);
+    BOOST_CHECK(special[6] != special[6]);
+    BOOST_CHECK(special[7] != special[7]);
+}
+
+BOOST_AUTO_TEST_SUITE_END();